@@ -19,7 +19,7 @@ case $OS in
         }
         {
             if ($1 == "parser") {
-                print "extern quic_err_t " $3 "(quic_frame_t **const, quic_buf_t *const);";
+                print "extern quic_err_t " $3 "(quic_frame_t **const, quic_buf_t *const, quic_frame_pool_t *const);";
                 parser[strtonum($2)] = $3;
             }
         }
@@ -37,7 +37,7 @@ case $OS in
         }
         {
             if ($1 == "parser") {
-                print "extern quic_err_t " $3 "(quic_frame_t **const, quic_buf_t *const);";
+                print "extern quic_err_t " $3 "(quic_frame_t **const, quic_buf_t *const, quic_frame_pool_t *const);";
                 parser[$2+0] = $3;
             }
         }
@@ -25,5 +25,6 @@ END {
     for (module in modules) print "    &" modules[module] ",";
     print "    NULL";
     print "};";
+    print "_Static_assert(sizeof(quic_modules) / sizeof(quic_modules[0]) - 1 <= QUIC_MODULES_MAX, \"a session tracks at most QUIC_MODULES_MAX modules\");";
 }
 ' $@ > gen/modules.c
@@ -16,6 +16,7 @@ const quic_config_t quic_client_default_config = {
     .is_cli = true,
     .stream_recv_timeout = 0,
     .active_connid_count = 2,
+    .congestion = quic_congestion_algorithm_cubic,
     .disable_prr = false,
     .initial_cwnd = 1460,
     .min_cwnd = 1460,
@@ -34,8 +35,19 @@ const quic_config_t quic_client_default_config = {
     .tls_verify_client_ca = NULL,
     .tls_ca = NULL,
     .tls_capath = NULL,
+    .tls_ctx = NULL,
+    .tls_server_name = NULL,
+    .tls_ticket_cache = NULL,
+    .tls_early_data = false,
+    .tls_offload = NULL,
     .stream_destory_timeout = 0,
     .disable_migrate = false,
+    .send_burst_size = 16,
+    .idle_timeout = 30 * 1000,
+    .idle_keepalive_percent = 0,
+    .ack_packet_tolerance = 2,
+    .ack_max_delay = 25 * 1000,
+    .ack_frequency = true,
 };
 
 static int quic_client_session_free_st_cb(void *const args);
@@ -71,7 +83,13 @@ quic_err_t quic_client_init(quic_client_t *const client, const size_t extends_si
 
     liteco_eloop_init(&client->eloop);
     liteco_runtime_init(&client->eloop, &client->rt);
-    quic_transmission_init(&client->transmission, &client->rt);
+    if (quic_timer_service_init(&client->timers, &client->eloop, &client->rt) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    if (quic_transmission_init(&client->transmission, &client->rt, QUIC_TRANSMISSION_DEFAULT_BACKEND) != quic_err_success) {
+        quic_timer_service_destory(&client->timers);
+        return quic_err_internal_error;
+    }
     quic_transmission_recv(&client->transmission, quic_client_transmission_recv_cb);
 
     client->session = quic_session_create(&client->transmission, quic_client_default_config, extends_size);
@@ -88,7 +106,7 @@ quic_err_t quic_client_init(quic_client_t *const client, const size_t extends_si
     }
     quic_buf_setpl(dst);
 
-    quic_session_init(client->session, &client->eloop, &client->rt, st, st_size);
+    quic_session_init(client->session, &client->eloop, &client->rt, &client->timers, st, st_size);
     quic_session_finished(client->session, quic_client_session_free_st_cb, st);
 
     liteco_runtime_join(&client->rt, &client->session->co);
@@ -112,6 +130,7 @@ quic_err_t quic_client_start_loop(quic_client_t *const client) {
             break;
         }
     }
+    quic_timer_service_destory(&client->timers);
     return quic_err_success;
 }
 
@@ -139,6 +158,44 @@ quic_err_t quic_client_key_file(quic_client_t *const client, const char *const k
     return quic_session_key_file(client->session, key_file);
 }
 
+quic_err_t quic_client_server_name(quic_client_t *const client, const char *const server_name) {
+    client->session->cfg.tls_server_name = server_name;
+    return quic_err_success;
+}
+
+quic_err_t quic_client_ticket_cache(quic_client_t *const client, quic_tls_ticket_cache_t *const cache) {
+    client->session->cfg.tls_ticket_cache = cache;
+    return quic_err_success;
+}
+
+quic_err_t quic_client_early_data(quic_client_t *const client, const bool enable) {
+    client->session->cfg.tls_early_data = enable;
+    return quic_err_success;
+}
+
+quic_err_t quic_client_idle_timeout(quic_client_t *const client, const uint64_t timeout, const uint32_t keepalive_percent) {
+    client->session->cfg.idle_timeout = timeout;
+    client->session->cfg.idle_keepalive_percent = keepalive_percent;
+    return quic_err_success;
+}
+
+quic_err_t quic_client_congestion(quic_client_t *const client, const quic_congestion_algorithm_t algorithm, const uint64_t initial_cwnd, const uint64_t max_cwnd) {
+    client->session->cfg.congestion = algorithm;
+    client->session->cfg.initial_cwnd = initial_cwnd;
+    client->session->cfg.max_cwnd = max_cwnd;
+    return quic_err_success;
+}
+
+quic_err_t quic_client_ack_policy(quic_client_t *const client, const uint32_t packet_tolerance, const uint64_t max_delay, const bool ack_frequency) {
+    if (max_delay >= QUIC_TRANS_PARAM_MAX_ACK_DELAY_MAX * 1000) {
+        return quic_err_bad_format;
+    }
+    client->session->cfg.ack_packet_tolerance = packet_tolerance;
+    client->session->cfg.ack_max_delay = max_delay;
+    client->session->cfg.ack_frequency = ack_frequency;
+    return quic_err_success;
+}
+
 quic_err_t quic_client_accept(quic_client_t *const client, const size_t extends_size, quic_err_t (*accept_cb) (quic_stream_t *const)) {
     return quic_session_accept(client->session, extends_size, accept_cb);
 }
@@ -178,7 +235,9 @@ static void quic_client_eloop_close_cb(liteco_async_t *const event) {
 static void quic_client_session_replace_close_cb(quic_session_t *const session, const quic_buf_t pkt) {
     quic_client_t *const client = ((void *) session->transmission) - offsetof(quic_client_t, transmission);
 
-    quic_transmission_send(&client->transmission, session->path, pkt.buf, quic_buf_size(&pkt));
+    if (!quic_buf_empty(&pkt)) {
+        quic_transmission_send(&client->transmission, session->path, pkt.buf, quic_buf_size(&pkt));
+    }
     liteco_async_send(&client->closed_event);
 }
 
@@ -12,6 +12,7 @@
 #include "session.h"
 #include "transmission.h"
 #include "modules/migrate.h"
+#include "modules/sealer.h"
 #include "utils/rbt_extend.h"
 #include "liteco.h"
 
@@ -22,6 +23,7 @@ typedef struct quic_client_s quic_client_t;
 struct quic_client_s {
     liteco_eloop_t eloop;
     liteco_runtime_t rt;
+    quic_timer_service_t timers;
 
     bool closed;
     liteco_async_t closed_event;
@@ -44,6 +46,25 @@ quic_err_t quic_client_path_target_use(quic_client_t *const client, const liteco
 quic_err_t quic_client_cert_file(quic_client_t *const client, const char *const cert_file);
 quic_err_t quic_client_key_file(quic_client_t *const client, const char *const key_file);
 
+/*
+ * resume from (and store new tickets into) cache under server_name, which is also sent as SNI.
+ * with early_data, streams opened and written before the handshake completes are sent in 0-RTT packets
+ * (see quic_session_in_early_data), they are retransmitted in 1-RTT packets if the server rejects them.
+ * 0-RTT data may be replayed, only idempotent requests belong to it. must be called before the first packet is sent
+ */
+quic_err_t quic_client_server_name(quic_client_t *const client, const char *const server_name);
+quic_err_t quic_client_ticket_cache(quic_client_t *const client, quic_tls_ticket_cache_t *const cache);
+quic_err_t quic_client_early_data(quic_client_t *const client, const bool enable);
+
+// timeout (ms, 0 disables) and keepalive_percent as quic_server_idle_timeout, must be called before the first packet is sent
+quic_err_t quic_client_idle_timeout(quic_client_t *const client, const uint64_t timeout, const uint32_t keepalive_percent);
+
+// algorithm, initial_cwnd and max_cwnd (bytes) as quic_server_congestion, must be called before the first packet is sent
+quic_err_t quic_client_congestion(quic_client_t *const client, const quic_congestion_algorithm_t algorithm, const uint64_t initial_cwnd, const uint64_t max_cwnd);
+
+// packet_tolerance, max_delay (us) and ack_frequency as quic_server_ack_policy, must be called before the first packet is sent
+quic_err_t quic_client_ack_policy(quic_client_t *const client, const uint32_t packet_tolerance, const uint64_t max_delay, const bool ack_frequency);
+
 quic_err_t quic_client_accept(quic_client_t *const client, const size_t extends_size, quic_err_t (*accept_cb) (quic_stream_t *const));
 quic_stream_t *quic_client_open(quic_client_t *const client, const size_t extends_size, bool bidi);
 quic_err_t quic_client_handshake_done(quic_client_t *const client, quic_err_t (*handshake_done_cb) (quic_session_t *const));
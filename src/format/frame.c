@@ -11,12 +11,12 @@
 #include "utils/buf.h"
 #include "utils/varint.h"
 
-#define quic_frame_alloc(frame, _first_byte, size)  \
-    if ((*(frame) = quic_malloc((size))) == NULL) { \
-        return quic_err_internal_error;             \
-    }                                               \
-    (**(frame)).first_byte = (_first_byte);         \
-    (**(frame)).ref_count = 1;                      \
+#define quic_frame_alloc(frame, _first_byte, size)                  \
+    if ((*(frame) = quic_frame_pool_alloc(pool, (size))) == NULL) { \
+        return quic_err_internal_error;                             \
+    }                                                               \
+    (**(frame)).first_byte = (_first_byte);                         \
+    (**(frame)).ref_count = 1;                                      \
     (**(frame)).next = NULL
 
 #define quic_first_byte(buf) \
@@ -29,6 +29,13 @@
     (target) = quic_varint_r((buf)->pos);                         \
     (buf)->pos += quic_varint_len((buf)->pos)
     
+#define quic_ref_data(frame, len, buf)      \
+    if ((buf)->pos + (len) > (buf)->last) { \
+        return quic_err_bad_format;         \
+    }                                       \
+    (frame).ref = (buf)->pos;               \
+    (buf)->pos += (len)
+
 #define quic_extend_data(frame, len, buf)    \
     if ((buf)->pos + (len) > (buf)->last) {  \
         return quic_err_bad_format;          \
@@ -56,7 +63,23 @@
     memcpy((buf)->pos, (data), (len));    \
     (buf)->pos += (len)
 
-quic_err_t quic_ping_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_padding_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
+    *frame = NULL;
+    uint8_t first;
+    uint64_t len = 0;
+
+    first = quic_first_byte(buf);
+    for (len = 1; buf->pos < buf->last && *(uint8_t *) buf->pos == quic_frame_padding_type; len++) {
+        buf->pos++;
+    }
+
+    quic_frame_alloc(frame, first, sizeof(quic_frame_padding_t));
+    ((quic_frame_padding_t *) *frame)->len = len;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_ping_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     uint8_t first;
 
@@ -67,7 +90,7 @@ quic_err_t quic_ping_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
     return quic_err_success;
 }
 
-quic_err_t quic_ack_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_ack_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_ack_t ref;
     quic_frame_init(&ref, 0);
@@ -99,7 +122,7 @@ quic_err_t quic_ack_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
     return quic_err_success;
 }
 
-quic_err_t quic_reset_stream_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_reset_stream_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_reset_stream_t ref;
     quic_frame_init(&ref, 0);
@@ -115,7 +138,7 @@ quic_err_t quic_reset_stream_parse(quic_frame_t **const frame, quic_buf_t *const
     return quic_err_success;
 }
 
-quic_err_t quic_stop_sending_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_stop_sending_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_stop_sending_t ref;
     quic_frame_init(&ref, 0);
@@ -130,7 +153,7 @@ quic_err_t quic_stop_sending_parse(quic_frame_t **const frame, quic_buf_t *const
     return quic_err_success;
 }
 
-quic_err_t quic_crypto_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_crypto_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_crypto_t ref;
     quic_frame_init(&ref, 0);
@@ -139,15 +162,15 @@ quic_err_t quic_crypto_parse(quic_frame_t **const frame, quic_buf_t *const buf)
     quic_varint(ref.off, buf);
     quic_varint(ref.len, buf);
 
-    quic_frame_alloc(frame, ref.first_byte, sizeof(quic_frame_crypto_t) + ref.len);
+    quic_frame_alloc(frame, ref.first_byte, sizeof(quic_frame_crypto_t));
     *(quic_frame_crypto_t *) *frame = ref;
 
-    quic_extend_data(*(quic_frame_crypto_t *) *frame, ref.len, buf);
+    quic_ref_data(*(quic_frame_crypto_t *) *frame, ref.len, buf);
 
     return quic_err_success;
 }
 
-quic_err_t quic_new_token_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_new_token_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_new_token_t ref;
     quic_frame_init(&ref, 0);
@@ -163,7 +186,7 @@ quic_err_t quic_new_token_parse(quic_frame_t **const frame, quic_buf_t *const bu
     return quic_err_success;
 }
 
-quic_err_t quic_stream_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_stream_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_stream_t ref;
     quic_frame_init(&ref, 0);
@@ -185,15 +208,15 @@ quic_err_t quic_stream_parse(quic_frame_t **const frame, quic_buf_t *const buf)
         ref.len = buf->last - buf->pos;
     }
 
-    quic_frame_alloc(frame, ref.first_byte, sizeof(quic_frame_stream_t) + ref.len);
+    quic_frame_alloc(frame, ref.first_byte, sizeof(quic_frame_stream_t));
     *(quic_frame_stream_t *) *frame = ref;
 
-    quic_extend_data(*(quic_frame_stream_t *) *frame, ref.len, buf);
+    quic_ref_data(*(quic_frame_stream_t *) *frame, ref.len, buf);
 
     return quic_err_success;
 }
 
-quic_err_t quic_max_data_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_max_data_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_max_data_t ref;
     quic_frame_init(&ref, 0);
@@ -207,7 +230,7 @@ quic_err_t quic_max_data_parse(quic_frame_t **const frame, quic_buf_t *const buf
     return quic_err_success;
 }
 
-quic_err_t quic_max_stream_data_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_max_stream_data_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_max_stream_data_t ref;
     quic_frame_init(&ref, 0);
@@ -222,7 +245,7 @@ quic_err_t quic_max_stream_data_parse(quic_frame_t **const frame, quic_buf_t *co
     return quic_err_success;
 }
 
-quic_err_t quic_max_streams_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_max_streams_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_max_streams_t ref;
     quic_frame_init(&ref, 0);
@@ -236,7 +259,7 @@ quic_err_t quic_max_streams_parse(quic_frame_t **const frame, quic_buf_t *const
     return quic_err_success;
 }
 
-quic_err_t quic_data_blocked_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_data_blocked_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_data_blocked_t ref;
     quic_frame_init(&ref, 0);
@@ -250,7 +273,7 @@ quic_err_t quic_data_blocked_parse(quic_frame_t **const frame, quic_buf_t *const
     return quic_err_success;
 }
 
-quic_err_t quic_stream_data_blocked_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_stream_data_blocked_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_stream_data_blocked_t ref;
     quic_frame_init(&ref, 0);
@@ -265,7 +288,7 @@ quic_err_t quic_stream_data_blocked_parse(quic_frame_t **const frame, quic_buf_t
     return quic_err_success;
 }
 
-quic_err_t quic_streams_blocked_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_streams_blocked_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_streams_blocked_t ref;
     quic_frame_init(&ref, 0);
@@ -279,7 +302,7 @@ quic_err_t quic_streams_blocked_parse(quic_frame_t **const frame, quic_buf_t *co
     return quic_err_success;
 }
 
-quic_err_t quic_new_connection_id_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_new_connection_id_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_new_connection_id_t ref;
     quic_frame_init(&ref, 0);
@@ -305,7 +328,7 @@ quic_err_t quic_new_connection_id_parse(quic_frame_t **const frame, quic_buf_t *
     return quic_err_success;
 }
 
-quic_err_t quic_retire_connection_id_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_retire_connection_id_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_retire_connection_id_t ref;
     quic_frame_init(&ref, 0);
@@ -319,7 +342,7 @@ quic_err_t quic_retire_connection_id_parse(quic_frame_t **const frame, quic_buf_
     return quic_err_success;
 }
 
-quic_err_t quic_path_challenge_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_path_challenge_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_path_challenge_t ref;
     quic_frame_init(&ref, 0);
@@ -337,7 +360,7 @@ quic_err_t quic_path_challenge_parse(quic_frame_t **const frame, quic_buf_t *con
     return quic_err_success;
 }
 
-quic_err_t quic_path_response_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_path_response_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_path_response_t ref;
     quic_frame_init(&ref, 0);
@@ -355,7 +378,7 @@ quic_err_t quic_path_response_parse(quic_frame_t **const frame, quic_buf_t *cons
     return quic_err_success;
 }
 
-quic_err_t quic_connection_close_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_connection_close_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     quic_frame_connection_close_t ref;
     quic_frame_init(&ref, 0);
@@ -375,7 +398,7 @@ quic_err_t quic_connection_close_parse(quic_frame_t **const frame, quic_buf_t *c
     return quic_err_success;
 }
 
-quic_err_t quic_handshake_done_parse(quic_frame_t **const frame, quic_buf_t *const buf) {
+quic_err_t quic_handshake_done_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     *frame = NULL;
     uint8_t first;
     
@@ -386,6 +409,52 @@ quic_err_t quic_handshake_done_parse(quic_frame_t **const frame, quic_buf_t *con
     return quic_err_success;
 }
 
+quic_err_t quic_immediate_ack_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
+    *frame = NULL;
+    uint8_t first;
+
+    first = quic_first_byte(buf);
+
+    quic_frame_alloc(frame, first, sizeof(quic_frame_immediate_ack_t));
+
+    return quic_err_success;
+}
+
+quic_err_t quic_ack_frequency_parse(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
+    *frame = NULL;
+    quic_frame_ack_frequency_t ref;
+    quic_frame_init(&ref, 0);
+
+    // the parser is registered on the first byte of the varint frame type
+    uint64_t type = 0;
+    quic_varint(type, buf);
+    if (type != quic_frame_ack_frequency_type) {
+        return quic_err_bad_format;
+    }
+    ref.first_byte = quic_frame_ack_frequency_type;
+
+    quic_varint(ref.seq, buf);
+    quic_varint(ref.packet_tolerance, buf);
+    quic_varint(ref.max_ack_delay, buf);
+    quic_varint(ref.reorder_threshold, buf);
+
+    quic_frame_alloc(frame, ref.first_byte, sizeof(quic_frame_ack_frequency_t));
+    *(quic_frame_ack_frequency_t *) *frame = ref;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_padding_format(quic_buf_t *const buf, const quic_frame_t *const frame) {
+    const quic_frame_padding_t *const ref = (quic_frame_padding_t *) frame;
+    if (buf->pos + ref->len > buf->last) {
+        return quic_err_bad_format;
+    }
+    memset(buf->pos, quic_frame_padding_type, ref->len);
+    buf->pos += ref->len;
+
+    return quic_err_success;
+}
+
 quic_err_t quic_ping_format(quic_buf_t *const buf, const quic_frame_t *const frame) {
     quic_put_byte(buf, frame->first_byte);
 
@@ -593,6 +662,28 @@ quic_err_t quic_handshake_done_format(quic_buf_t *const buf, const quic_frame_t
     return quic_err_success;
 }
 
+quic_err_t quic_immediate_ack_format(quic_buf_t *const buf, const quic_frame_t *const frame) {
+    quic_put_byte(buf, frame->first_byte);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_ack_frequency_format(quic_buf_t *const buf, const quic_frame_t *const frame) {
+    const quic_frame_ack_frequency_t *const ref = (quic_frame_ack_frequency_t *) frame;
+    quic_put_varint(buf, (uint64_t) quic_frame_ack_frequency_type);
+
+    quic_put_varint(buf, ref->seq);
+    quic_put_varint(buf, ref->packet_tolerance);
+    quic_put_varint(buf, ref->max_ack_delay);
+    quic_put_varint(buf, ref->reorder_threshold);
+
+    return quic_err_success;
+}
+
+uint64_t quic_padding_size(const quic_frame_t *const frame) {
+    return ((quic_frame_padding_t *) frame)->len;
+}
+
 uint64_t quic_ping_size(const quic_frame_t *const frame) {
     (void) frame;
     return 1;
@@ -747,3 +838,93 @@ uint64_t quic_handshake_done_size(const quic_frame_t *const frame) {
     (void) frame;
     return 1;
 }
+
+uint64_t quic_immediate_ack_size(const quic_frame_t *const frame) {
+    (void) frame;
+    return 1;
+}
+
+uint64_t quic_ack_frequency_size(const quic_frame_t *const frame) {
+    const quic_frame_ack_frequency_t *const ref = (quic_frame_ack_frequency_t *) frame;
+
+    return quic_varint_format_len((uint64_t) quic_frame_ack_frequency_type)
+        + quic_varint_format_len(ref->seq)
+        + quic_varint_format_len(ref->packet_tolerance)
+        + quic_varint_format_len(ref->max_ack_delay)
+        + quic_varint_format_len(ref->reorder_threshold);
+}
+
+quic_err_t quic_frame_pool_init(quic_frame_pool_t *const pool) {
+    uint32_t i;
+    for (i = 0; i < QUIC_FRAME_POOL_CLASSES; i++) {
+        pool->free_list[i] = NULL;
+        pool->cached[i] = 0;
+    }
+    pool->hit = 0;
+    pool->miss = 0;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_frame_pool_destory(quic_frame_pool_t *const pool) {
+    uint32_t i;
+    for (i = 0; i < QUIC_FRAME_POOL_CLASSES; i++) {
+        while (pool->free_list[i]) {
+            quic_frame_pool_block_t *const block = pool->free_list[i];
+            pool->free_list[i] = block->next;
+            quic_free(block);
+        }
+        pool->cached[i] = 0;
+    }
+
+    return quic_err_success;
+}
+
+void *quic_frame_pool_alloc(quic_frame_pool_t *const pool, const size_t size) {
+    quic_frame_pool_block_t *block = NULL;
+    uint32_t cls = 0;
+
+    while (cls < QUIC_FRAME_POOL_CLASSES && ((size_t) QUIC_FRAME_POOL_MIN_SIZE << cls) < size) {
+        cls++;
+    }
+
+    if (pool && cls < QUIC_FRAME_POOL_CLASSES && pool->free_list[cls]) {
+        block = pool->free_list[cls];
+        pool->free_list[cls] = block->next;
+        pool->cached[cls]--;
+        pool->hit++;
+    }
+    else {
+        block = quic_malloc(sizeof(quic_frame_pool_block_t) + (cls < QUIC_FRAME_POOL_CLASSES ? ((size_t) QUIC_FRAME_POOL_MIN_SIZE << cls) : size));
+        if (!block) {
+            return NULL;
+        }
+        if (pool) {
+            pool->miss++;
+        }
+    }
+
+    block->pool = pool;
+    block->next = NULL;
+    block->cls = cls;
+
+    return block->data;
+}
+
+void quic_frame_pool_free(void *const frame) {
+    if (!frame) {
+        return;
+    }
+
+    quic_frame_pool_block_t *const block = (quic_frame_pool_block_t *) ((uint8_t *) frame - offsetof(quic_frame_pool_block_t, data));
+    quic_frame_pool_t *const pool = block->pool;
+
+    if (!pool || block->cls >= QUIC_FRAME_POOL_CLASSES || pool->cached[block->cls] >= QUIC_FRAME_POOL_CACHED_MAX) {
+        quic_free(block);
+        return;
+    }
+
+    block->next = pool->free_list[block->cls];
+    pool->free_list[block->cls] = block;
+    pool->cached[block->cls]++;
+}
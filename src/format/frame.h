@@ -44,6 +44,9 @@
 #define quic_frame_quic_connection_close_type 0x1c
 #define quic_frame_app_connection_close_type  0x1d
 #define quic_frame_handshake_done_type        0x1e
+// draft-ietf-quic-ack-frequency, ACK_FREQUENCY is a two byte varint on the wire (0x40 0xaf)
+#define quic_frame_immediate_ack_type         0x1f
+#define quic_frame_ack_frequency_type         0xaf
 
 #define QUIC_FRAME_FIELDS                                                            \
     LITECO_LINKNODE_BASE                                                             \
@@ -78,6 +81,65 @@ struct quic_frame_s {
     QUIC_FRAME_FIELDS
 };
 
+#ifndef QUIC_FRAME_POOL_CLASSES
+#define QUIC_FRAME_POOL_CLASSES 6
+#endif
+
+#ifndef QUIC_FRAME_POOL_MIN_SIZE
+#define QUIC_FRAME_POOL_MIN_SIZE 64
+#endif
+
+#ifndef QUIC_FRAME_POOL_CACHED_MAX
+#define QUIC_FRAME_POOL_CACHED_MAX 256
+#endif
+
+/*
+ * size-class free lists for frame objects. each class holds blocks of QUIC_FRAME_POOL_MIN_SIZE << class bytes,
+ * larger frames fall back to malloc. a pool is owned by one session and only touched by its coroutine
+ */
+typedef struct quic_frame_pool_s quic_frame_pool_t;
+typedef struct quic_frame_pool_block_s quic_frame_pool_block_t;
+
+struct quic_frame_pool_block_s {
+    quic_frame_pool_t *pool;
+    quic_frame_pool_block_t *next;
+    uint32_t cls;
+    uint8_t data[0] __attribute__((aligned(8)));
+};
+
+struct quic_frame_pool_s {
+    quic_frame_pool_block_t *free_list[QUIC_FRAME_POOL_CLASSES];
+    uint32_t cached[QUIC_FRAME_POOL_CLASSES];
+
+    uint64_t hit;
+    uint64_t miss;
+};
+
+quic_err_t quic_frame_pool_init(quic_frame_pool_t *const pool);
+quic_err_t quic_frame_pool_destory(quic_frame_pool_t *const pool);
+
+// pool may be NULL, the frame is then allocated by malloc but still released by quic_frame_free
+void *quic_frame_pool_alloc(quic_frame_pool_t *const pool, const size_t size);
+void quic_frame_pool_free(void *const frame);
+
+#define quic_frame_free(frame) \
+    quic_frame_pool_free((void *) (frame))
+
+#define quic_frame_create(frame, pool, type, size) {          \
+    if (((frame) = quic_frame_pool_alloc((pool), (size)))) { \
+        quic_frame_init((frame), (type));                     \
+        (frame)->ref_count = 1;                               \
+    }                                                         \
+}
+
+// a run of len PADDING bytes
+typedef struct quic_frame_padding_s quic_frame_padding_t;
+struct quic_frame_padding_s {
+    QUIC_FRAME_FIELDS
+
+    uint64_t len;
+};
+
 typedef struct quic_frame_ping_s quic_frame_ping_t;
 struct quic_frame_ping_s {
     QUIC_FRAME_FIELDS
@@ -133,6 +195,7 @@ struct quic_frame_crypto_s {
     uint64_t off;
     uint64_t len;
 
+    const uint8_t *ref; /* see quic_frame_payload */
     uint8_t data[0];
 };
 
@@ -153,9 +216,17 @@ struct quic_frame_stream_s {
     uint64_t off;
     uint64_t len;
 
+    const uint8_t *ref; /* see quic_frame_payload */
     uint8_t data[0];
 };
 
+/*
+ * payload of a STREAM or CRYPTO frame. parsed frames reference the payload inside the received packet (ref),
+ * so they are only valid while that packet is alive; locally generated frames carry it in data (ref is NULL)
+ */
+#define quic_frame_payload(frame) \
+    ((frame)->ref ? (frame)->ref : (frame)->data)
+
 typedef struct quic_frame_max_data_s quic_frame_max_data_t;
 struct quic_frame_max_data_s {
     QUIC_FRAME_FIELDS
@@ -247,7 +318,22 @@ struct quic_frame_handshake_done_s {
     QUIC_FRAME_FIELDS;
 };
 
-typedef quic_err_t (*quic_frame_parser_t)(quic_frame_t **const frame, quic_buf_t *const buf);
+typedef struct quic_frame_immediate_ack_s quic_frame_immediate_ack_t;
+struct quic_frame_immediate_ack_s {
+    QUIC_FRAME_FIELDS
+};
+
+typedef struct quic_frame_ack_frequency_s quic_frame_ack_frequency_t;
+struct quic_frame_ack_frequency_s {
+    QUIC_FRAME_FIELDS
+
+    uint64_t seq;
+    uint64_t packet_tolerance;
+    uint64_t max_ack_delay;
+    uint64_t reorder_threshold;
+};
+
+typedef quic_err_t (*quic_frame_parser_t)(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool);
 typedef quic_err_t (*quic_frame_formatter_t)(quic_buf_t *const buf, const quic_frame_t *const frame);
 typedef uint64_t (*quic_frame_sizer_t)(const quic_frame_t *const frame);
 
@@ -266,15 +352,15 @@ __quic_header_inline quic_err_t quic_frame_format_inner(quic_buf_t *const buf, q
     return quic_frame_formatter[frame->first_byte](buf, frame);
 }
 
-#define quic_frame_parse(frame, buf) \
-    quic_frame_parse_inner((quic_frame_t **) &frame, (buf))
+#define quic_frame_parse(frame, buf, pool) \
+    quic_frame_parse_inner((quic_frame_t **) &frame, (buf), (pool))
 
-__quic_header_inline quic_err_t quic_frame_parse_inner(quic_frame_t **const frame, quic_buf_t *const buf) {
+__quic_header_inline quic_err_t quic_frame_parse_inner(quic_frame_t **const frame, quic_buf_t *const buf, quic_frame_pool_t *const pool) {
     if (!quic_frame_parser[*(uint8_t *) buf->pos]) {
         return quic_err_not_implemented;
     }
 
-    return quic_frame_parser[*(uint8_t *) buf->pos](frame, buf);
+    return quic_frame_parser[*(uint8_t *) buf->pos](frame, buf, pool);
 }
 
 #define quic_frame_size(frame) \
@@ -14,10 +14,22 @@
 #include "platform/platform.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef uint32_t quic_version_t;
 typedef uint32_t quic_packet_number_t;
 
+// the version written into (and accepted from) long headers
+#define QUIC_VERSION 0x00000000
+
+#define QUIC_CONNID_MAX_LEN 20
+
+// a datagram carrying a client Initial packet is padded to at least this size (amplification limit of the server)
+#define QUIC_INITIAL_DATAGRAM_MIN_SIZE 1200
+
+// length of the Retry Integrity Tag at the end of a Retry packet
+#define QUIC_RETRY_INTEGRITY_TAG_LEN 16
+
 #define QUIC_HEADER_FIELDS       \
     uint8_t first_byte;
 
@@ -166,6 +178,37 @@ __quic_header_inline quic_initial_header_t quic_initial_header(quic_header_t *co
     return initial;
 }
 
+/*
+ * sanity of a long header before anything else reads it: the connection id lengths are in range and
+ * the fixed fields fit in the datagram. it says nothing about the payload
+ */
+__quic_header_inline bool quic_long_header_check(const uint8_t *const buf, const size_t size) {
+    if (size < 1 + 4 + 1 || buf[1 + 4] > QUIC_CONNID_MAX_LEN || size < 1 + 4 + 1 + (size_t) buf[1 + 4] + 1) {
+        return false;
+    }
+    const size_t src_len_off = 1 + 4 + 1 + buf[1 + 4];
+
+    return buf[src_len_off] <= QUIC_CONNID_MAX_LEN && src_len_off + 1 + buf[src_len_off] <= size;
+}
+
+typedef struct quic_retry_header_s quic_retry_header_t;
+struct quic_retry_header_s {
+    quic_buf_t token;
+    const uint8_t *tag;
+};
+
+// the caller checks quic_long_header_check and that size leaves room for the tag
+__quic_header_inline quic_retry_header_t quic_retry_header(quic_header_t *const header, const size_t size) {
+    quic_retry_header_t retry = { .token = { .ref = true } };
+
+    retry.token.buf = quic_long_header_payload(header);
+    retry.token.capa = ((uint8_t *) header) + size - QUIC_RETRY_INTEGRITY_TAG_LEN - (uint8_t *) retry.token.buf;
+    quic_buf_setpl(&retry.token);
+    retry.tag = retry.token.last;
+
+    return retry;
+}
+
 typedef struct quic_0rtt_header_s quic_0rtt_header_t;
 struct quic_0rtt_header_s {
     QUIC_PAYLOAD_FIELDS
@@ -261,6 +304,13 @@ __quic_header_inline uint8_t *quic_header_packet_number_off(const uint8_t *const
         case quic_packet_handshake_type:
             payload = quic_long_header_payload(hdr);
 
+            // payload len
+            payload += quic_varint_len(payload);
+            break;
+
+        case quic_packet_0rtt_type:
+            payload = quic_long_header_payload(hdr);
+
             // payload len
             payload += quic_varint_len(payload);
             break;
@@ -273,4 +323,65 @@ __quic_header_inline uint8_t *quic_header_packet_number_off(const uint8_t *const
     return payload;
 }
 
+// the varint at payload is complete inside the size bytes of buf
+__quic_header_inline bool quic_header_varint_inside(const uint8_t *const buf, const uint8_t *const payload, const size_t size) {
+    return (size_t) (payload - buf) < size && (size_t) (payload - buf) + quic_varint_len(payload) <= size;
+}
+
+/* size of the packet which starts at buf, long header packets carry a length field, so several of them
+ * can be coalesced into one datagram. a short header packet always extends to the end of the datagram */
+__quic_header_inline size_t quic_header_packet_size(const uint8_t *const buf, const size_t size) {
+    quic_header_t *const hdr = (quic_header_t *) buf;
+    const uint8_t *payload = NULL;
+    uint64_t len = 0;
+
+    if (!size || !quic_header_is_long(hdr)) {
+        return size;
+    }
+
+    switch (quic_packet_type(hdr)) {
+    case quic_packet_initial_type:
+    case quic_packet_0rtt_type:
+    case quic_packet_handshake_type:
+        break;
+
+    default:
+        return size;
+    }
+
+    // first byte, version and the two connection ids, each length byte is read once it is inside the buffer
+    if (size < 1 + 4 + 1 || size < 1 + 4 + 1 + (size_t) quic_long_header_dst_conn_len(hdr) + 1) {
+        return 0;
+    }
+    if (size < quic_long_header_len(hdr)) {
+        return 0;
+    }
+    payload = quic_long_header_payload(hdr);
+
+    if (quic_packet_type(hdr) == quic_packet_initial_type) {
+        // token
+        if (!quic_header_varint_inside(buf, payload, size)) {
+            return 0;
+        }
+        len = quic_varint_r(payload);
+        payload += quic_varint_len(payload);
+        if (len > size - (payload - buf)) {
+            return 0;
+        }
+        payload += len;
+    }
+
+    if (!quic_header_varint_inside(buf, payload, size)) {
+        return 0;
+    }
+    len = quic_varint_r(payload);
+    payload += quic_varint_len(payload);
+
+    if (len > size - (payload - buf)) {
+        return 0;
+    }
+
+    return (payload - buf) + len;
+}
+
 #endif
@@ -31,6 +31,9 @@ enum quic_transport_parameter_type_e {
     quic_trans_param_max_ack_delay = 0x0b,
     quic_trans_param_disable_migration = 0x0c,
     quic_trans_param_active_connid_limit = 0x0e,
+    quic_trans_param_retry_connid = 0x10,
+    // draft-ietf-quic-ack-frequency
+    quic_trans_param_min_ack_delay = 0xde1a,
 };
 
 typedef struct quic_transport_parameter_s quic_transport_parameter_t;
@@ -49,10 +52,16 @@ struct quic_transport_parameter_s {
     uint64_t max_ack_delay;
     bool disable_migration;
     uint64_t active_connid;
+    quic_buf_t retry_connid;
+    // us, 0 when ACK_FREQUENCY frames are not supported
+    uint64_t min_ack_delay;
 };
 
 #define QUIC_TRANS_PARAM_ACK_DELAY_EXPONENT_DEFAULT 3
-#define QUIC_TRANS_PARAM_MAX_ACK_DELAY_DEFAULT 25000
+// ms
+#define QUIC_TRANS_PARAM_MAX_ACK_DELAY_DEFAULT 25
+// ms, values of 2^14 or greater are invalid
+#define QUIC_TRANS_PARAM_MAX_ACK_DELAY_MAX (1 << 14)
 
 static inline quic_err_t quic_transport_parameter_init(quic_transport_parameter_t *const params) {
     quic_buf_init(&params->original_connid);
@@ -69,7 +78,9 @@ static inline quic_err_t quic_transport_parameter_init(quic_transport_parameter_
     params->max_ack_delay = QUIC_TRANS_PARAM_MAX_ACK_DELAY_DEFAULT;
     params->disable_migration = false;
     params->active_connid = 0;
-    
+    quic_buf_init(&params->retry_connid);
+    params->min_ack_delay = 0;
+
     return quic_err_success;
 }
 
@@ -86,9 +97,11 @@ __quic_header_inline size_t quic_transport_parameter_size(const quic_transport_p
         + 4 + quic_varint_format_len(params.max_ack_delay)
         + 4 + quic_varint_format_len((uint64_t) params.ack_delay_exponent)
         + 4 + quic_varint_format_len(params.active_connid / 1000)
+        + (params.min_ack_delay ? 4 + quic_varint_format_len(params.min_ack_delay) : 0)
         + (params.disable_migration ? 4 : 0)
         + (quic_buf_size(&params.stateless_reset_token) != 0 ? 4 + quic_buf_size(&params.stateless_reset_token) : 0)
-        + (quic_buf_size(&params.original_connid) != 0 ? 4 + quic_buf_size(&params.original_connid) : 0);
+        + (quic_buf_size(&params.original_connid) != 0 ? 4 + quic_buf_size(&params.original_connid) : 0)
+        + (quic_buf_size(&params.retry_connid) != 0 ? 4 + quic_buf_size(&params.retry_connid) : 0);
 }
 
 __quic_header_inline bool quic_transport_parameter_varint_format(quic_buf_t *const buf, uint16_t id, uint64_t value) {
@@ -153,7 +166,9 @@ __quic_header_inline quic_err_t quic_transport_parameter_format(quic_buf_t *cons
         && quic_transport_parameter_varint_format(buf, quic_trans_param_active_connid_limit, params.active_connid)
         && quic_transport_parameter_string_format(buf, quic_trans_param_original_connid, params.original_connid)
         && quic_transport_parameter_string_format(buf, quic_trans_param_stateless_reset_token, params.stateless_reset_token)
-        && quic_transport_parameter_bool_format(buf, quic_trans_param_disable_migration, params.disable_migration);
+        && quic_transport_parameter_string_format(buf, quic_trans_param_retry_connid, params.retry_connid)
+        && quic_transport_parameter_bool_format(buf, quic_trans_param_disable_migration, params.disable_migration)
+        && (!params.min_ack_delay || quic_transport_parameter_varint_format(buf, quic_trans_param_min_ack_delay, params.min_ack_delay));
 
     if (!ret) {
         return quic_err_internal_error;
@@ -254,6 +269,15 @@ __quic_header_inline quic_transport_parameter_t quic_transport_parameter_parse(q
         case quic_trans_param_active_connid_limit:
             ret.active_connid = quic_transport_parameter_varint_parse(buf);
             break;
+        case quic_trans_param_retry_connid:
+            ret.retry_connid = quic_transport_parameter_string_parse(buf);
+            break;
+        case quic_trans_param_min_ack_delay:
+            ret.min_ack_delay = quic_transport_parameter_varint_parse(buf);
+            break;
+        default:
+            // unknown parameters are skipped
+            buf->pos += 2 + quic_bswap_16(*(uint16_t *) buf->pos);
         }
     }
 
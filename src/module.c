@@ -17,6 +17,7 @@ uint32_t quic_modules_size() {
     if (!inited) {
         for (i = 0; quic_modules[i]; i++) {
             quic_modules[i]->off = result;
+            quic_modules[i]->index = i;
             result += quic_modules[i]->module_size;
         }
     }
@@ -13,6 +13,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+// bound of quic_modules, a session tracks its modules in 64 bits bitmaps (checked by the generated gen/modules.c)
+#define QUIC_MODULES_MAX 64
+
 typedef struct quic_session_s quic_session_t;
 
 typedef struct quic_module_s quic_module_t;
@@ -26,6 +29,8 @@ struct quic_module_s {
     quic_err_t (*loop) (void *const module, const uint64_t now);
 
     uint32_t off;
+    // position in quic_modules, the bit of the module in the activation bitmaps of a session
+    uint32_t index;
 };
 
 #define QUIC_MODULE_FIELDS \
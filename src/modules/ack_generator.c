@@ -7,174 +7,348 @@
  */
 
 #include "modules/ack_generator.h"
+#include "modules/congestion.h"
+#include "modules/framer.h"
+#include "modules/retransmission.h"
+#include "modules/sender.h"
 #include "utils/time.h"
 #include "platform/platform.h"
+#include "session.h"
 
 static quic_err_t quic_ack_generator_init(void *const module);
+static quic_err_t quic_ack_generator_start(void *const module);
+static quic_err_t quic_ack_generator_loop(void *const module, const uint64_t now);
 static quic_err_t quic_ack_generator_destory(void *const module);
 
-bool quic_ack_generator_insert_ranges(quic_ack_generator_module_t *const module, const uint64_t num) {
-    quic_ack_generator_range_t *range = NULL;
+static quic_err_t quic_ack_generator_ack_frequency_on_acked(void *const acked_obj, const quic_frame_t *const frame);
+static quic_err_t quic_ack_generator_ack_frequency_on_lost(void *const lost_obj, const quic_frame_t *const frame);
 
-    liteco_link_foreach(range, &module->ranges) {
-        if (range->start <= num && num <= range->end) {
-            return false;
-        }
+// only the application space delays its ACKs, the ack_delay deadline belongs to it
+static inline bool quic_ack_generator_delayed(quic_ack_generator_module_t *const module) {
+    return module->module_declare == &quic_app_ack_generator_module;
+}
 
-        bool extends = false;
-        if (range->end + 1 == num) {
-            extends = true;
-            range->end++;
-        }
-        else if (range->start - 1 == num) {
-            extends = true;
-            range->start--;
+static bool quic_ack_generator_insert_range(quic_ack_generator_module_t *const module, uint32_t idx, const uint64_t num);
+static void quic_ack_generator_remove_range(quic_ack_generator_module_t *const module, const uint32_t idx);
+
+static bool quic_ack_generator_insert_range(quic_ack_generator_module_t *const module, uint32_t idx, const uint64_t num) {
+    uint32_t i;
+
+    if (module->ranges_count == QUIC_ACK_GENERATOR_MAX_RANGES) {
+        // the new range would be the one given up
+        if (idx == 0) {
+            return false;
         }
 
-        if (extends) {
-            if ((liteco_linknode_t *) liteco_link_prev(range) != &module->ranges && liteco_link_prev(range)->end + 1 == range->start) {
-                liteco_link_prev(range)->end = range->end;
-                liteco_link_remove(range);
-                quic_free(range);
+        module->ignore_threhold = quic_ack_generator_range(module, 0)->end + 1;
+        module->ranges_head = (module->ranges_head + 1) & (QUIC_ACK_GENERATOR_MAX_RANGES - 1);
+        module->ranges_count--;
+        module->ranges_evicted++;
+        idx--;
+    }
 
-                module->ranges_count--;
-            }
-            if ((liteco_linknode_t *) liteco_link_next(range) != &module->ranges && liteco_link_next(range)->start - 1 == range->end) {
-                liteco_link_next(range)->start = range->start;
-                liteco_link_remove(range);
-                quic_free(range);
+    for (i = module->ranges_count; i > idx; i--) {
+        *quic_ack_generator_range(module, i) = *quic_ack_generator_range(module, i - 1);
+    }
+    quic_ack_generator_range(module, idx)->start = num;
+    quic_ack_generator_range(module, idx)->end = num;
+    module->ranges_count++;
 
-                module->ranges_count--;
-            }
+    return true;
+}
 
-            return true;
-        }
+static void quic_ack_generator_remove_range(quic_ack_generator_module_t *const module, const uint32_t idx) {
+    uint32_t i;
 
-        if (num < range->start) {
-            quic_ack_generator_range_t *new_range = quic_malloc(sizeof(quic_ack_generator_range_t));
-            if (new_range == NULL) {
-                return false;
-            }
-            liteco_link_init(new_range);
-            new_range->start = new_range->end = num;
+    for (i = idx; i + 1 < module->ranges_count; i++) {
+        *quic_ack_generator_range(module, i) = *quic_ack_generator_range(module, i + 1);
+    }
+    module->ranges_count--;
+}
 
-            liteco_link_insert_before(range, new_range);
-            module->ranges_count++;
+bool quic_ack_generator_insert_ranges(quic_ack_generator_module_t *const module, const uint64_t num) {
+    if (!module->ranges_count) {
+        return quic_ack_generator_insert_range(module, 0, num);
+    }
 
+    // packets mostly arrive in order, they extend the largest range or open a new one above it
+    quic_ack_generator_range_t *const largest = quic_ack_generator_range(module, module->ranges_count - 1);
+    if (num > largest->end) {
+        if (largest->end + 1 == num) {
+            largest->end = num;
             return true;
         }
+        return quic_ack_generator_insert_range(module, module->ranges_count, num);
     }
 
-    if ((range = quic_malloc(sizeof(quic_ack_generator_range_t))) == NULL) {
+    // a reordered packet, the gap it falls into is searched from the top
+    uint32_t upper = module->ranges_count - 1;
+    while (upper > 0 && quic_ack_generator_range(module, upper - 1)->end >= num) {
+        upper--;
+    }
+    quic_ack_generator_range_t *const upper_range = quic_ack_generator_range(module, upper);
+    if (upper_range->start <= num) {
         return false;
     }
-    liteco_link_init(range);
-    range->start = range->end = num;
+    quic_ack_generator_range_t *const lower_range = upper ? quic_ack_generator_range(module, upper - 1) : NULL;
 
-    liteco_link_insert_before(&module->ranges, range);
-    module->ranges_count++;
+    const bool joins_lower = lower_range && lower_range->end + 1 == num;
+    const bool joins_upper = upper_range->start == num + 1;
+    if (joins_lower && joins_upper) {
+        lower_range->end = upper_range->end;
+        quic_ack_generator_remove_range(module, upper);
+    }
+    else if (joins_lower) {
+        lower_range->end = num;
+    }
+    else if (joins_upper) {
+        upper_range->start = num;
+    }
+    else {
+        return quic_ack_generator_insert_range(module, upper, num);
+    }
 
     return true;
 }
 
 quic_err_t quic_ack_generator_ignore(quic_ack_generator_module_t *const module) {
-    quic_ack_generator_range_t *range = NULL;
-
-    liteco_link_foreach(range, &module->ranges) {
+    while (module->ranges_count) {
+        quic_ack_generator_range_t *const range = quic_ack_generator_range(module, 0);
         if (module->ignore_threhold <= range->start) {
-            return quic_err_success;
-        }
-
-        if (module->ignore_threhold > range->end) {
-            liteco_linknode_t *prev = range->prev;
-
-            liteco_link_remove(range);
-            quic_free(range);
-
-            range = (quic_ack_generator_range_t *) prev;
+            break;
         }
-        else {
+        if (module->ignore_threhold <= range->end) {
             range->start = module->ignore_threhold;
-            return quic_err_success;
+            break;
         }
+
+        module->ranges_head = (module->ranges_head + 1) & (QUIC_ACK_GENERATOR_MAX_RANGES - 1);
+        module->ranges_count--;
     }
 
     return quic_err_success;
 }
 
 quic_frame_ack_t *quic_ack_generator_generate(quic_ack_generator_module_t *const module) {
-    if (module->dropped) {
+    if (module->dropped || !module->ranges_count) {
         return NULL;
     }
 
+    // an ACK rides along any packet sent while ack-eliciting packets wait for it
     uint64_t now = quic_now();
-    if (!module->should_send && (module->alarm == 0 || now < module->alarm)) {
+    if (!module->should_send && !module->unacked_eliciting && (module->alarm == 0 || now < module->alarm)) {
         return NULL;
     }
 
-    quic_frame_ack_t *frame = quic_malloc(sizeof(quic_frame_ack_t) + sizeof(quic_ack_range_t) * (module->ranges_count - 1));
+    quic_frame_ack_t *frame = NULL;
+    quic_frame_create(frame, &quic_module_of_session(module)->frame_pool, quic_frame_ack_type,
+                      sizeof(quic_frame_ack_t) + sizeof(quic_ack_range_t) * (module->ranges_count - 1));
     if (frame == NULL) {
         return NULL;
     }
-    quic_frame_init(frame, quic_frame_ack_type);
     frame->ect0 = 0;
     frame->ect1 = 0;
     frame->ect_ce = 0;
     frame->ranges.count = module->ranges_count - 1;
     frame->ranges.size = sizeof(quic_ack_range_t);
 
-    uint64_t smallest = 0;
-    bool first = true;
-    quic_ack_generator_range_t *range = NULL;
-    uint32_t rangeidx = 0;
-    liteco_link_rforeach(range, &module->ranges) {
-        if (first) {
-            first = false;
+    // the frame is serialized from the largest range down
+    const quic_ack_generator_range_t *range = quic_ack_generator_range(module, module->ranges_count - 1);
+    frame->largest_ack = range->end;
+    frame->first_range = range->end - range->start;
 
-            frame->largest_ack = range->end;
-            frame->first_range = range->end - range->start;
+    uint64_t smallest = range->start;
+    uint32_t rangeidx;
+    for (rangeidx = 0; rangeidx < frame->ranges.count; rangeidx++) {
+        range = quic_ack_generator_range(module, module->ranges_count - 2 - rangeidx);
 
-            smallest = range->start;
-        }
-        else {
-            quic_arr(&frame->ranges, rangeidx, quic_ack_range_t)->gap = smallest - range->end - 2;
-            quic_arr(&frame->ranges, rangeidx, quic_ack_range_t)->len = range->end - range->start;
-            smallest = range->start;
-            rangeidx++;
-        }
+        quic_arr(&frame->ranges, rangeidx, quic_ack_range_t)->gap = smallest - range->end - 2;
+        quic_arr(&frame->ranges, rangeidx, quic_ack_range_t)->len = range->end - range->start;
+        smallest = range->start;
     }
     frame->delay = now - module->lg_obtime;
 
+    if (module->alarm && quic_ack_generator_delayed(module)) {
+        quic_session_set_deadline(quic_module_of_session(module), quic_session_deadline_ack_delay, 0);
+    }
     module->alarm = 0;
     module->should_send = false;
+    module->unacked_eliciting = 0;
 
     return frame;
 }
 
 bool quic_ack_generator_check_is_lost(quic_ack_generator_module_t *const module, const uint64_t num) {
-    quic_ack_generator_range_t *range = NULL;
-    if (num <= module->ignore_threhold || num >= ((quic_ack_generator_range_t *) liteco_link_prev(&module->ranges))->start) {
+    if (!module->ranges_count || num <= module->ignore_threhold || num >= quic_ack_generator_range(module, module->ranges_count - 1)->start) {
         return false;
     }
 
-    liteco_link_foreach(range, &module->ranges) {
-        if (num < range->start) {
+    // below the largest range, the packet fills a gap unless a range already holds it
+    uint32_t i = module->ranges_count - 1;
+    while (i > 0) {
+        const quic_ack_generator_range_t *const range = quic_ack_generator_range(module, --i);
+        if (range->end < num) {
             return true;
         }
-        if (range->start <= num && num <= range->end) {
+        if (range->start <= num) {
             return false;
         }
     }
 
-    return false;
+    return true;
 }
 
-quic_err_t quic_ack_generator_drop(quic_ack_generator_module_t *const module) {
-    while (!liteco_link_empty(&module->ranges)) {
-        quic_ack_generator_range_t *range = (quic_ack_generator_range_t *) liteco_link_next(&module->ranges);
-        liteco_link_remove(range);
-        quic_free(range);
+quic_err_t quic_ack_generator_module_received(quic_ack_generator_module_t *const module, const uint64_t num, const uint64_t recv_time, const bool should_ack) {
+    if (num < module->ignore_threhold || module->dropped) {
+        return quic_err_success;
+    }
+
+    // a packet filling a gap, or opening one above the largest received
+    const bool reordered = quic_ack_generator_check_is_lost(module, num) || (module->ranges_count && num > module->lg_obnum + 1);
+
+    if (num >= module->lg_obnum) {
+        module->lg_obnum = num;
+        module->lg_obtime = recv_time;
+    }
+
+    if (!quic_ack_generator_insert_ranges(module, num) || !should_ack) {
+        return quic_err_success;
+    }
+    module->unacked_eliciting++;
+
+    if ((reordered && module->reorder_threshold) || module->unacked_eliciting >= module->packet_tolerance || !module->max_ack_delay) {
+        module->should_send = true;
+        return quic_err_success;
+    }
+    if (!module->alarm) {
+        module->alarm = recv_time + module->max_ack_delay;
+        quic_session_set_deadline(quic_module_of_session(module), quic_session_deadline_ack_delay, module->alarm);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_ack_generator_negotiate(quic_ack_generator_module_t *const module, const uint64_t peer_min_ack_delay) {
+    quic_session_t *const session = quic_module_of_session(module);
+
+    module->peer_min_ack_delay = session->cfg.ack_frequency ? peer_min_ack_delay : 0;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_ack_generator_tune_peer(quic_ack_generator_module_t *const module) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
+    quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
+    quic_retransmission_module_t *const r_module = quic_session_module(session, quic_app_retransmission_module);
+
+    if (!module->peer_min_ack_delay || module->dropped) {
+        return quic_err_success;
     }
+
+    // about four ACKs per congestion window, each one delayed a quarter of the RTT at most
+    const uint64_t srtt = quic_congestion_smoothed_rtt(c_module);
+    uint64_t tolerance = quic_congestion_cwnd(c_module) / (1460 << 2);
+    tolerance = tolerance < 2 ? 2 : tolerance;
+    tolerance = tolerance > QUIC_ACK_GENERATOR_PEER_MAX_TOLERANCE ? QUIC_ACK_GENERATOR_PEER_MAX_TOLERANCE : tolerance;
+    uint64_t max_ack_delay = srtt >> 2;
+    max_ack_delay = max_ack_delay > session->cfg.ack_max_delay ? session->cfg.ack_max_delay : max_ack_delay;
+    max_ack_delay = max_ack_delay < module->peer_min_ack_delay ? module->peer_min_ack_delay : max_ack_delay;
+
+    // at most one update per RTT
+    const uint64_t now = quic_now();
+    if ((tolerance == module->peer_tolerance && max_ack_delay == module->peer_max_ack_delay) || now < module->peer_tuned_at + srtt) {
+        return quic_err_success;
+    }
+
+    quic_frame_ack_frequency_t *frame = NULL;
+    quic_frame_create(frame, &session->frame_pool, quic_frame_ack_frequency_type, sizeof(quic_frame_ack_frequency_t));
+    if (!frame) {
+        return quic_err_internal_error;
+    }
+    frame->seq = module->peer_seq++;
+    frame->packet_tolerance = tolerance;
+    frame->max_ack_delay = max_ack_delay;
+    frame->reorder_threshold = 1;
+    frame->acked_obj = module;
+    frame->on_acked = quic_ack_generator_ack_frequency_on_acked;
+    frame->lost_obj = module;
+    frame->on_lost = quic_ack_generator_ack_frequency_on_lost;
+
+    // until the frame is acknowledged the peer may still delay by the old value, a longer one counts at once
+    if (max_ack_delay > r_module->max_delay) {
+        quic_retransmission_max_delay(r_module, max_ack_delay);
+    }
+
+    module->peer_tolerance = tolerance;
+    module->peer_max_ack_delay = max_ack_delay;
+    module->peer_tuned_at = now;
+
+    quic_framer_ctrl(f_module, (quic_frame_t *) frame);
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_ack_generator_ack_frequency_on_acked(void *const acked_obj, const quic_frame_t *const frame) {
+    quic_ack_generator_module_t *const module = acked_obj;
+    quic_session_t *const session = quic_module_of_session(module);
+
+    // the peer now delays its ACKs by the latest requested value, which bounds the probe timeout
+    const quic_frame_ack_frequency_t *const af_frame = (const quic_frame_ack_frequency_t *) frame;
+    if (af_frame->seq + 1 == module->peer_seq) {
+        quic_retransmission_max_delay(quic_session_module(session, quic_app_retransmission_module), af_frame->max_ack_delay);
+    }
+    quic_frame_free(frame);
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_ack_generator_ack_frequency_on_lost(void *const lost_obj, const quic_frame_t *const frame) {
+    quic_ack_generator_module_t *const module = lost_obj;
+
+    // only the latest policy matters, the next tuning sends it again
+    if (((const quic_frame_ack_frequency_t *) frame)->seq + 1 == module->peer_seq) {
+        module->peer_tolerance = 0;
+        module->peer_tuned_at = 0;
+    }
+    quic_frame_free(frame);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_session_handle_ack_frequency_frame(quic_session_t *const session, const quic_frame_t *const frame) {
+    const quic_frame_ack_frequency_t *const af_frame = (const quic_frame_ack_frequency_t *) frame;
+    quic_ack_generator_module_t *const module = quic_session_module(session, quic_app_ack_generator_module);
+
+    if (!session->cfg.ack_frequency) {
+        return quic_err_bad_format;
+    }
+    if (af_frame->seq < module->ack_frequency_seq) {
+        return quic_err_success;
+    }
+    module->ack_frequency_seq = af_frame->seq + 1;
+
+    module->packet_tolerance = af_frame->packet_tolerance ? af_frame->packet_tolerance : 1;
+    module->max_ack_delay = af_frame->max_ack_delay < QUIC_ACK_GENERATOR_MIN_ACK_DELAY ? QUIC_ACK_GENERATOR_MIN_ACK_DELAY : af_frame->max_ack_delay;
+    module->reorder_threshold = af_frame->reorder_threshold;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_session_handle_immediate_ack_frame(quic_session_t *const session, const quic_frame_t *const frame) {
+    quic_ack_generator_module_t *const module = quic_session_module(session, quic_app_ack_generator_module);
+    (void) frame;
+
+    if (!session->cfg.ack_frequency) {
+        return quic_err_bad_format;
+    }
+    module->should_send = true;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_ack_generator_drop(quic_ack_generator_module_t *const module) {
+    module->ranges_head = 0;
     module->ranges_count = 0;
 
     module->dropped = true;
@@ -184,8 +358,9 @@ quic_err_t quic_ack_generator_drop(quic_ack_generator_module_t *const module) {
 static quic_err_t quic_ack_generator_init(void *const module) {
     quic_ack_generator_module_t *const ag_module = module;
     ag_module->ignore_threhold = 0;
+    ag_module->ranges_head = 0;
     ag_module->ranges_count = 0;
-    liteco_link_init(&ag_module->ranges);
+    ag_module->ranges_evicted = 0;
 
     ag_module->lg_obnum = 0;
     ag_module->lg_obtime = 0;
@@ -195,6 +370,50 @@ static quic_err_t quic_ack_generator_init(void *const module) {
     ag_module->alarm = 0;
     ag_module->dropped = false;
 
+    // Initial and Handshake packets are acknowledged at once
+    ag_module->packet_tolerance = 1;
+    ag_module->max_ack_delay = 0;
+    ag_module->reorder_threshold = 1;
+    ag_module->unacked_eliciting = 0;
+    ag_module->ack_frequency_seq = 0;
+
+    ag_module->peer_min_ack_delay = 0;
+    ag_module->peer_seq = 0;
+    ag_module->peer_tolerance = 0;
+    ag_module->peer_max_ack_delay = 0;
+    ag_module->peer_tuned_at = 0;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_ack_generator_start(void *const module) {
+    quic_ack_generator_module_t *const ag_module = module;
+    quic_session_t *const session = quic_module_of_session(ag_module);
+
+    if (quic_ack_generator_delayed(ag_module)) {
+        ag_module->packet_tolerance = session->cfg.ack_packet_tolerance ? session->cfg.ack_packet_tolerance : 1;
+        ag_module->max_ack_delay = session->cfg.ack_max_delay;
+    }
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_ack_generator_loop(void *const module, const uint64_t now) {
+    quic_ack_generator_module_t *const ag_module = module;
+    quic_session_t *const session = quic_module_of_session(ag_module);
+
+    if (!ag_module->alarm || ag_module->dropped) {
+        return quic_err_success;
+    }
+    if (now < ag_module->alarm) {
+        quic_session_set_deadline(session, quic_session_deadline_ack_delay, ag_module->alarm);
+        return quic_err_success;
+    }
+
+    // max_ack_delay passed since the first ack-eliciting packet not yet acknowledged
+    ag_module->should_send = true;
+    quic_module_activate(session, quic_sender_module);
+
     return quic_err_success;
 }
 
@@ -206,9 +425,9 @@ quic_module_t quic_initial_ack_generator_module = {
     .name        = "initial_ack_generator",
     .module_size = sizeof(quic_ack_generator_module_t),
     .init        = quic_ack_generator_init,
-    .start       = NULL,
+    .start       = quic_ack_generator_start,
     .process     = NULL,
-    .loop        = NULL,
+    .loop        = quic_ack_generator_loop,
     .destory     = quic_ack_generator_destory
 };
 
@@ -216,9 +435,9 @@ quic_module_t quic_handshake_ack_generator_module = {
     .name        = "handshake_ack_generator",
     .module_size = sizeof(quic_ack_generator_module_t),
     .init        = quic_ack_generator_init,
-    .start       = NULL,
+    .start       = quic_ack_generator_start,
     .process     = NULL,
-    .loop        = NULL,
+    .loop        = quic_ack_generator_loop,
     .destory     = quic_ack_generator_destory
 };
 
@@ -226,8 +445,8 @@ quic_module_t quic_app_ack_generator_module = {
     .name        = "app_ack_generator",
     .module_size = sizeof(quic_ack_generator_module_t),
     .init        = quic_ack_generator_init,
-    .start       = NULL,
+    .start       = quic_ack_generator_start,
     .process     = NULL,
-    .loop        = NULL,
+    .loop        = quic_ack_generator_loop,
     .destory     = quic_ack_generator_destory
 };
@@ -14,10 +14,24 @@
 #include "module.h"
 #include "platform/platform.h"
 
+// ranges of received packet numbers kept per packet number space, a power of two. when a new gap
+// would exceed it, the smallest range is given up and its packets are no longer acknowledged
+#ifndef QUIC_ACK_GENERATOR_MAX_RANGES
+#define QUIC_ACK_GENERATOR_MAX_RANGES 32
+#endif
+
+// the smallest max_ack_delay (us) accepted from ACK_FREQUENCY frames, the tick of the session timers
+#ifndef QUIC_ACK_GENERATOR_MIN_ACK_DELAY
+#define QUIC_ACK_GENERATOR_MIN_ACK_DELAY 1000
+#endif
+
+// bounds of the packet tolerance requested from the peer, about a quarter of the congestion window
+#ifndef QUIC_ACK_GENERATOR_PEER_MAX_TOLERANCE
+#define QUIC_ACK_GENERATOR_PEER_MAX_TOLERANCE 10
+#endif
+
 typedef struct quic_ack_generator_range_s quic_ack_generator_range_t;
 struct quic_ack_generator_range_s {
-    LITECO_LINKNODE_BASE
-
     uint64_t start;
     uint64_t end;
 };
@@ -26,9 +40,12 @@ typedef struct quic_ack_generator_module_s quic_ack_generator_module_t;
 struct quic_ack_generator_module_s {
     QUIC_MODULE_FIELDS
 
-    liteco_linknode_t ranges;
-
+    // disjoint ascending ranges stored in a ring, ranges_head is the slot of the smallest one
+    quic_ack_generator_range_t ranges[QUIC_ACK_GENERATOR_MAX_RANGES];
+    uint32_t ranges_head;
     uint32_t ranges_count;
+    uint64_t ranges_evicted;
+
     uint64_t ignore_threhold;
 
     uint64_t lg_obtime;
@@ -39,6 +56,22 @@ struct quic_ack_generator_module_s {
 
     bool dropped;
     uint64_t alarm;
+
+    // delayed ACK policy: an ACK is due after packet_tolerance ack-eliciting packets or at alarm,
+    // max_ack_delay after the first of them. reorder_threshold 0 ignores reordering
+    uint64_t packet_tolerance;
+    uint64_t max_ack_delay;
+    uint64_t reorder_threshold;
+    uint64_t unacked_eliciting;
+    // ACK_FREQUENCY frames of the peer below it are stale
+    uint64_t ack_frequency_seq;
+
+    // the policy requested from the peer, peer_min_ack_delay is 0 when it takes no ACK_FREQUENCY frames
+    uint64_t peer_min_ack_delay;
+    uint64_t peer_seq;
+    uint64_t peer_tolerance;
+    uint64_t peer_max_ack_delay;
+    uint64_t peer_tuned_at;
 };
 
 extern quic_module_t quic_initial_ack_generator_module;
@@ -50,14 +83,26 @@ quic_err_t quic_ack_generator_ignore(quic_ack_generator_module_t *const module);
 quic_frame_ack_t *quic_ack_generator_generate(quic_ack_generator_module_t *const module);
 bool quic_ack_generator_check_is_lost(quic_ack_generator_module_t *const module, const uint64_t num);
 quic_err_t quic_ack_generator_drop(quic_ack_generator_module_t *const module);
+quic_err_t quic_ack_generator_module_received(quic_ack_generator_module_t *const module, const uint64_t num, const uint64_t recv_time, const bool should_ack);
+
+// min_ack_delay (us) of the peer transport parameters, 0 when it does not support ACK_FREQUENCY frames
+quic_err_t quic_ack_generator_negotiate(quic_ack_generator_module_t *const module, const uint64_t peer_min_ack_delay);
+
+// sends an ACK_FREQUENCY frame when the policy derived from cwnd and RTT changed, called on each 1-RTT ACK frame
+quic_err_t quic_ack_generator_tune_peer(quic_ack_generator_module_t *const module);
+
+// the i-th smallest range
+__quic_header_inline quic_ack_generator_range_t *quic_ack_generator_range(quic_ack_generator_module_t *const module, const uint32_t i) {
+    return &module->ranges[(module->ranges_head + i) & (QUIC_ACK_GENERATOR_MAX_RANGES - 1)];
+}
 
 __quic_header_inline bool quic_ack_generator_contains_lost(quic_ack_generator_module_t *const module) {
-    if (module->dropped) {
+    if (module->dropped || !module->ranges_count) {
         return false;
     }
 
     return module->ranges_count > 1
-        || ((quic_ack_generator_range_t *) liteco_link_next(&module->ranges))->start > module->ignore_threhold;
+        || quic_ack_generator_range(module, 0)->start > module->ignore_threhold;
 }
 
 __quic_header_inline bool quic_ack_generator_should_send(quic_ack_generator_module_t *const module) {
@@ -68,27 +113,6 @@ __quic_header_inline bool quic_ack_generator_should_send(quic_ack_generator_modu
     return module->should_send;
 }
 
-__quic_header_inline quic_err_t quic_ack_generator_module_received(quic_ack_generator_module_t *const module, const uint64_t num, const uint64_t recv_time, const bool should_ack) {
-    if (num < module->ignore_threhold || module->dropped) {
-        return quic_err_success;
-    }
-
-    bool lost = quic_ack_generator_check_is_lost(module, num);
-
-    if (num >= module->lg_obnum) {
-        module->lg_obnum = num;
-        module->lg_obtime = recv_time;
-    }
-
-    if (quic_ack_generator_insert_ranges(module, num) && should_ack) {
-        module->should_send = true;
-    }
-    if (lost && should_ack) {
-        module->should_send = true;
-    }
-    return quic_err_success;
-}
-
 __quic_header_inline quic_err_t quic_ack_generator_set_ignore_threhold(quic_ack_generator_module_t *const module, const uint64_t num) {
     if (num <= module->ignore_threhold) {
         return quic_err_success;
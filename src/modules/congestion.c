@@ -73,6 +73,113 @@ struct quic_congestion_rtt_s {
     uint64_t smoothed_rtt;
     uint64_t rttvar;
     uint64_t latest_simple;
+    uint64_t latest_rtt;
+};
+
+typedef struct quic_congestion_minmax_sample_s quic_congestion_minmax_sample_t;
+struct quic_congestion_minmax_sample_s {
+    uint64_t round;
+    uint64_t val;
+};
+
+// windowed max filter (Kathleen Nichols' algorithm), the best, second best and third best samples of the window
+typedef struct quic_congestion_minmax_s quic_congestion_minmax_t;
+struct quic_congestion_minmax_s {
+    quic_congestion_minmax_sample_t s[3];
+};
+
+typedef struct quic_congestion_rate_packet_s quic_congestion_rate_packet_t;
+struct quic_congestion_rate_packet_s {
+    quic_space_t space;
+    uint64_t num;
+    uint64_t sent_time;
+
+    // delivery state of the path when the packet was sent
+    uint64_t delivered;
+    uint64_t delivered_time;
+    uint64_t first_sent_time;
+    uint64_t inflight;
+    bool app_limited;
+
+    bool in_flight;
+};
+
+/*
+ * delivery rate sampler, an acknowledged packet samples the rate at which the path delivered the bytes
+ * acknowledged while it was in flight. packets are indexed by their number and matched by their packet number
+ * space too, a slot taken by a packet of another space is overwritten and that sample is skipped. the sampler
+ * grows only when two packets of the same space collide
+ */
+typedef struct quic_congestion_rate_s quic_congestion_rate_t;
+struct quic_congestion_rate_s {
+    quic_congestion_rate_packet_t *pkts;
+    uint32_t capa;
+
+    uint64_t delivered;
+    uint64_t delivered_time;
+    uint64_t first_sent_time;
+    // samples are application limited until delivered passes it, 0 when the sender is not
+    uint64_t app_limited;
+    uint64_t inflight;
+};
+
+typedef struct quic_congestion_rate_sample_s quic_congestion_rate_sample_t;
+struct quic_congestion_rate_sample_s {
+    uint64_t bw;
+    uint64_t prior_delivered;
+    bool app_limited;
+};
+
+typedef enum quic_congestion_bbr_state_e quic_congestion_bbr_state_t;
+enum quic_congestion_bbr_state_e {
+    quic_congestion_bbr_startup = 0,
+    quic_congestion_bbr_drain,
+    quic_congestion_bbr_probe_bw_down,
+    quic_congestion_bbr_probe_bw_cruise,
+    quic_congestion_bbr_probe_bw_refill,
+    quic_congestion_bbr_probe_bw_up,
+    quic_congestion_bbr_probe_rtt,
+};
+
+typedef struct quic_congestion_bbr_s quic_congestion_bbr_t;
+struct quic_congestion_bbr_s {
+    quic_congestion_bbr_state_t state;
+    // percent
+    uint32_t pacing_gain;
+    uint32_t cwnd_gain;
+
+    // bytes per second, the window is counted in rounds
+    quic_congestion_minmax_t max_bw;
+
+    uint64_t min_rtt;
+    uint64_t min_rtt_stamp;
+    uint64_t probe_rtt_min;
+    uint64_t probe_rtt_min_stamp;
+    bool probe_rtt_expired;
+    uint64_t probe_rtt_done_stamp;
+    bool probe_rtt_round_done;
+    uint64_t prior_cwnd;
+
+    uint64_t round_count;
+    uint64_t next_round_delivered;
+    bool round_start;
+
+    bool filled_pipe;
+    uint64_t full_bw;
+    uint32_t full_bw_count;
+
+    // the inflight at which a round lost too much, 0 until it happened
+    uint64_t inflight_hi;
+    uint32_t probe_up_rounds;
+    uint64_t round_delivered;
+    uint64_t round_lost;
+    bool loss_in_round;
+
+    uint64_t cycle_stamp;
+    uint64_t cycle_rounds;
+
+    uint64_t pacing_rate;
+    uint64_t next_send_time;
 };
 
 typedef struct quic_congestion_status_store_s quic_congestion_status_store_t;
@@ -85,6 +192,9 @@ struct quic_congestion_status_store_s {
     quic_congestion_prr_t prr;
     quic_congestion_tbp_t tbp;
     quic_congestion_rtt_t rtt;
+
+    quic_congestion_rate_t rate;
+    quic_congestion_bbr_t bbr;
 };
 
 typedef struct quic_congestion_instance_s quic_congestion_instance_t;
@@ -100,15 +210,17 @@ struct quic_congestion_instance_s {
 /*}*/
 
 static quic_err_t quic_congestion_module_init(void *const module);
+static quic_err_t quic_congestion_module_start(void *const module);
 static quic_err_t quic_congestion_module_destory(void *const module);
 
-static quic_err_t quic_congestion_module_on_acked(quic_congestion_module_t *const module, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time);
-static quic_err_t quic_congestion_module_on_sent(quic_congestion_module_t *const module, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool included_unacked);
-static quic_err_t quic_congestion_module_on_lost(quic_congestion_module_t *const module, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes);
+static quic_err_t quic_congestion_module_on_acked(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time);
+static quic_err_t quic_congestion_module_on_sent(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool included_unacked);
+static quic_err_t quic_congestion_module_on_lost(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes);
 static quic_err_t quic_congestion_module_update(quic_congestion_module_t *const module, const uint64_t recv_time, const uint64_t sent_time, const uint64_t delay);
 static bool quic_congestion_module_allow_send(quic_congestion_module_t *const module, const uint64_t unacked_bytes);
 static uint64_t quic_congestion_module_next_send_time(quic_congestion_module_t *const module, const uint64_t unacked_bytes);
 static bool quic_congestion_module_has_budget(quic_congestion_module_t *const module);
+static uint64_t quic_congestion_module_cwnd(quic_congestion_module_t *const module);
 static quic_err_t quic_congestion_module_migrate(quic_congestion_module_t *const module, const quic_path_t path);
 
 static inline quic_err_t quic_congestion_module_increase_cwnd(quic_congestion_module_t *const module, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time);
@@ -138,23 +250,60 @@ static inline quic_err_t quic_congestion_rtt_init(quic_congestion_module_t *cons
 static inline quic_err_t quic_congestion_rtt_update(quic_congestion_module_t *const module, const uint64_t recv_time, const uint64_t send_time, const uint64_t ack_delay);
 static uint64_t quic_congestion_rtt_pto(quic_congestion_module_t *const module, const uint64_t max_ack_delay);
 static uint64_t quic_congestion_rtt_smoothed_rtt(quic_congestion_module_t *const module);
+static uint64_t quic_congestion_rtt_latest_rtt(quic_congestion_module_t *const module);
 
 static inline quic_err_t quic_congestion_instance_init(quic_congestion_module_t *const module);
 
+static inline uint64_t quic_congestion_minmax_reset(quic_congestion_minmax_t *const minmax, const uint64_t round, const uint64_t val);
+static inline uint64_t quic_congestion_minmax_running_max(quic_congestion_minmax_t *const minmax, const uint64_t win, const uint64_t round, const uint64_t val);
+
+static inline quic_err_t quic_congestion_rate_init(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status);
+static inline quic_err_t quic_congestion_rate_grow(quic_congestion_rate_t *const rate);
+static inline quic_congestion_rate_packet_t *quic_congestion_rate_find(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t num);
+static inline quic_err_t quic_congestion_rate_on_sent(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes);
+static inline bool quic_congestion_rate_on_acked(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t event_time, const uint64_t min_rtt, quic_congestion_rate_sample_t *const sample);
+static inline uint64_t quic_congestion_rate_on_lost(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes);
+static inline quic_err_t quic_congestion_rate_discard(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t discarded_bytes);
+
+static inline quic_err_t quic_congestion_bbr_init(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status);
+static inline quic_err_t quic_congestion_bbr_enter(quic_congestion_bbr_t *const bbr, const quic_congestion_bbr_state_t state, const uint64_t now);
+static inline uint64_t quic_congestion_bbr_bw(quic_congestion_bbr_t *const bbr);
+static inline uint64_t quic_congestion_bbr_bdp(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint32_t gain);
+static inline quic_err_t quic_congestion_bbr_update_round(quic_congestion_status_store_t *const status, const quic_congestion_rate_sample_t *const sample);
+static inline quic_err_t quic_congestion_bbr_check_full_pipe(quic_congestion_bbr_t *const bbr, const quic_congestion_rate_sample_t *const sample);
+static inline quic_err_t quic_congestion_bbr_update_state(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint64_t now);
+static inline quic_err_t quic_congestion_bbr_check_probe_rtt(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint64_t now);
+static inline quic_err_t quic_congestion_bbr_update_pacing_rate(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status);
+static inline quic_err_t quic_congestion_bbr_update_cwnd(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint64_t acked_bytes);
+
+static quic_err_t quic_congestion_bbr_on_sent(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool included_unacked);
+static quic_err_t quic_congestion_bbr_on_acked(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time);
+static quic_err_t quic_congestion_bbr_on_lost(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes);
+static quic_err_t quic_congestion_bbr_on_discarded(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t discarded_bytes);
+static quic_err_t quic_congestion_bbr_on_app_limited(quic_congestion_module_t *const module);
+static quic_err_t quic_congestion_bbr_update(quic_congestion_module_t *const module, const uint64_t recv_time, const uint64_t sent_time, const uint64_t delay);
+static bool quic_congestion_bbr_allow_send(quic_congestion_module_t *const module, const uint64_t unacked_bytes);
+static uint64_t quic_congestion_bbr_next_send_time(quic_congestion_module_t *const module, const uint64_t unacked_bytes);
+static bool quic_congestion_bbr_has_budget(quic_congestion_module_t *const module);
+
 static quic_err_t quic_congestion_module_init(void *const module) {
     quic_congestion_module_t *const c_module = module;
 
     c_module->on_acked = quic_congestion_module_on_acked;
     c_module->on_sent = quic_congestion_module_on_sent;
     c_module->on_lost = quic_congestion_module_on_lost;
+    c_module->on_discarded = NULL;
+    c_module->on_app_limited = NULL;
     c_module->allow_send = quic_congestion_module_allow_send;
     c_module->update = quic_congestion_module_update;
     c_module->next_send_time = quic_congestion_module_next_send_time;
 
     c_module->has_budget = quic_congestion_module_has_budget;
+    c_module->cwnd = quic_congestion_module_cwnd;
 
     c_module->pto = quic_congestion_rtt_pto;
     c_module->smoothed_rtt = quic_congestion_rtt_smoothed_rtt;
+    c_module->latest_rtt = quic_congestion_rtt_latest_rtt;
 
     c_module->migrate = quic_congestion_module_migrate;
 
@@ -163,6 +312,26 @@ static quic_err_t quic_congestion_module_init(void *const module) {
     return quic_err_success;
 }
 
+static quic_err_t quic_congestion_module_start(void *const module) {
+    quic_congestion_module_t *const c_module = module;
+    quic_session_t *const session = quic_module_of_session(c_module);
+
+    // the RTT estimator, cwnd and migrate are shared, the status stores keep the state of both algorithms
+    if (session->cfg.congestion == quic_congestion_algorithm_bbr) {
+        c_module->on_acked = quic_congestion_bbr_on_acked;
+        c_module->on_sent = quic_congestion_bbr_on_sent;
+        c_module->on_lost = quic_congestion_bbr_on_lost;
+        c_module->on_discarded = quic_congestion_bbr_on_discarded;
+        c_module->on_app_limited = quic_congestion_bbr_on_app_limited;
+        c_module->allow_send = quic_congestion_bbr_allow_send;
+        c_module->update = quic_congestion_bbr_update;
+        c_module->next_send_time = quic_congestion_bbr_next_send_time;
+        c_module->has_budget = quic_congestion_bbr_has_budget;
+    }
+
+    return quic_err_success;
+}
+
 static inline quic_err_t quic_congestion_instance_init(quic_congestion_module_t *const module) {
     liteco_rbt_init(quic_congestion_instance(module)->store);
     liteco_rbt_init(quic_congestion_instance(module)->active_instance);
@@ -299,11 +468,12 @@ static inline uint64_t quic_congestion_cubic_on_lost(quic_congestion_cubic_t *co
     return cwnd * 7 / 10;
 }
 
-static quic_err_t quic_congestion_module_on_sent(quic_congestion_module_t *const module, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool included_unacked) {
+static quic_err_t quic_congestion_module_on_sent(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool included_unacked) {
     quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
     quic_congestion_base_t *const base = &status->base;
     quic_congestion_slowstart_t *const slowstart = &status->slowstart;
     quic_congestion_prr_t *const prr = &status->prr;
+    (void) space;
 
     quic_congestion_tbp_sent_packet(module, sent_time, sent_bytes);
 
@@ -321,13 +491,14 @@ static quic_err_t quic_congestion_module_on_sent(quic_congestion_module_t *const
     return quic_err_success;
 }
 
-static quic_err_t quic_congestion_module_on_lost(quic_congestion_module_t *const module, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes) {
+static quic_err_t quic_congestion_module_on_lost(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes) {
     quic_session_t *const session = quic_module_of_session(module);
     quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
     quic_congestion_base_t *const base = &status->base;
     quic_congestion_slowstart_t *const slowstart = &status->slowstart;
     quic_congestion_prr_t *const prr = &status->prr;
     quic_congestion_cubic_t *const cubic = &status->cubic;
+    (void) space;
 
     if (base->lost && num <= base->at_loss_largest_sent_num) {
         if (base->at_loss_in_slowstart) {
@@ -382,12 +553,13 @@ static bool quic_congestion_module_allow_send(quic_congestion_module_t *const mo
     return unacked_bytes < base->cwnd;
 }
 
-static quic_err_t quic_congestion_module_on_acked(quic_congestion_module_t *const module, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time) {
+static quic_err_t quic_congestion_module_on_acked(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time) {
     quic_session_t *const session = quic_module_of_session(module);
     quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
     quic_congestion_base_t *const base = &status->base;
     quic_congestion_prr_t *const prr = &status->prr;
     quic_congestion_slowstart_t *const slowstart = &status->slowstart;
+    (void) space;
 
     if (!base->acked) {
         base->acked = true;
@@ -524,6 +696,7 @@ static inline quic_err_t quic_congestion_rtt_init(quic_congestion_module_t *cons
     status->rtt.smoothed_rtt = 333 * 1000;
     status->rtt.rttvar = 333 * 1000 >> 2;
     status->rtt.latest_simple = 0;
+    status->rtt.latest_rtt = 0;
 
     return quic_err_success;
 }
@@ -533,6 +706,7 @@ static inline quic_err_t quic_congestion_rtt_update(quic_congestion_module_t *co
     quic_congestion_rtt_t *const rtt = &status->rtt;
 
     const uint64_t latest_rtt = recv_time - send_time;
+    rtt->latest_rtt = latest_rtt;
 
     if (rtt->min_rtt == 0) {
         rtt->min_rtt = latest_rtt;
@@ -574,6 +748,13 @@ static uint64_t quic_congestion_rtt_smoothed_rtt(quic_congestion_module_t *const
     return rtt->smoothed_rtt;
 }
 
+static uint64_t quic_congestion_rtt_latest_rtt(quic_congestion_module_t *const module) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    quic_congestion_rtt_t *const rtt = &status->rtt;
+
+    return rtt->latest_rtt;
+}
+
 static quic_err_t quic_congestion_module_update(quic_congestion_module_t *const module, const uint64_t recv_time, const uint64_t sent_time, const uint64_t delay) {
     quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
     quic_congestion_base_t *const base = &status->base;
@@ -630,6 +811,619 @@ static bool quic_congestion_module_has_budget(quic_congestion_module_t *const mo
     return quic_congestion_tbp_budget(module, quic_now()) >= 14600;
 }
 
+static uint64_t quic_congestion_module_cwnd(quic_congestion_module_t *const module) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+
+    return status->base.cwnd;
+}
+
+static inline uint64_t quic_congestion_minmax_reset(quic_congestion_minmax_t *const minmax, const uint64_t round, const uint64_t val) {
+    minmax->s[0].round = round;
+    minmax->s[0].val = val;
+    minmax->s[1] = minmax->s[0];
+    minmax->s[2] = minmax->s[0];
+
+    return val;
+}
+
+static inline uint64_t quic_congestion_minmax_running_max(quic_congestion_minmax_t *const minmax, const uint64_t win, const uint64_t round, const uint64_t val) {
+    const quic_congestion_minmax_sample_t sample = { .round = round, .val = val };
+
+    // a new max, or nothing left in the window
+    if (val >= minmax->s[0].val || round - minmax->s[2].round > win) {
+        return quic_congestion_minmax_reset(minmax, round, val);
+    }
+    if (val >= minmax->s[1].val) {
+        minmax->s[1] = sample;
+        minmax->s[2] = sample;
+    }
+    else if (val >= minmax->s[2].val) {
+        minmax->s[2] = sample;
+    }
+
+    // the best sample passed the window, or the later ones are kept a quarter and a half of the window apart
+    const uint64_t dt = round - minmax->s[0].round;
+    if (dt > win) {
+        minmax->s[0] = minmax->s[1];
+        minmax->s[1] = minmax->s[2];
+        minmax->s[2] = sample;
+        if (round - minmax->s[0].round > win) {
+            minmax->s[0] = minmax->s[1];
+            minmax->s[1] = minmax->s[2];
+            minmax->s[2] = sample;
+        }
+    }
+    else if (minmax->s[1].round == minmax->s[0].round && dt > win / 4) {
+        minmax->s[1] = sample;
+        minmax->s[2] = sample;
+    }
+    else if (minmax->s[2].round == minmax->s[1].round && dt > win / 2) {
+        minmax->s[2] = sample;
+    }
+
+    return minmax->s[0].val;
+}
+
+static inline quic_err_t quic_congestion_rate_init(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status) {
+    (void) module;
+
+    status->rate.pkts = NULL;
+    status->rate.capa = 0;
+
+    status->rate.delivered = 0;
+    status->rate.delivered_time = 0;
+    status->rate.first_sent_time = 0;
+    status->rate.app_limited = 0;
+    status->rate.inflight = 0;
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_rate_grow(quic_congestion_rate_t *const rate) {
+    const uint32_t capa = rate->capa ? rate->capa << 1 : QUIC_CONGESTION_RATE_INIT_CAPA;
+    if (capa > QUIC_CONGESTION_RATE_MAX_CAPA) {
+        return quic_err_internal_error;
+    }
+
+    quic_congestion_rate_packet_t *const pkts = malloc(sizeof(quic_congestion_rate_packet_t) * capa);
+    if (!pkts) {
+        return quic_err_internal_error;
+    }
+
+    uint32_t i;
+    for (i = 0; i < capa; i++) {
+        pkts[i].in_flight = false;
+    }
+    for (i = 0; i < rate->capa; i++) {
+        if (rate->pkts[i].in_flight) {
+            pkts[rate->pkts[i].num & (capa - 1)] = rate->pkts[i];
+        }
+    }
+
+    if (rate->pkts) {
+        free(rate->pkts);
+    }
+    rate->pkts = pkts;
+    rate->capa = capa;
+
+    return quic_err_success;
+}
+
+static inline quic_congestion_rate_packet_t *quic_congestion_rate_find(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t num) {
+    if (!rate->capa) {
+        return NULL;
+    }
+    quic_congestion_rate_packet_t *const pkt = &rate->pkts[num & (rate->capa - 1)];
+
+    return pkt->in_flight && pkt->space == space && pkt->num == num ? pkt : NULL;
+}
+
+static inline quic_err_t quic_congestion_rate_on_sent(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes) {
+    // the path was idle, the next samples start from this packet
+    if (!rate->inflight) {
+        rate->first_sent_time = sent_time;
+        rate->delivered_time = sent_time;
+    }
+    rate->inflight += sent_bytes;
+
+    quic_congestion_rate_packet_t *pkt = rate->capa ? &rate->pkts[num & (rate->capa - 1)] : NULL;
+    if ((!pkt || (pkt->in_flight && pkt->space == space && pkt->num != num)) && quic_congestion_rate_grow(rate) == quic_err_success) {
+        pkt = &rate->pkts[num & (rate->capa - 1)];
+    }
+    if (!pkt) {
+        return quic_err_internal_error;
+    }
+
+    pkt->space = space;
+    pkt->num = num;
+    pkt->sent_time = sent_time;
+    pkt->delivered = rate->delivered;
+    pkt->delivered_time = rate->delivered_time;
+    pkt->first_sent_time = rate->first_sent_time;
+    pkt->inflight = rate->inflight;
+    pkt->app_limited = rate->app_limited != 0;
+    pkt->in_flight = true;
+
+    return quic_err_success;
+}
+
+static inline bool quic_congestion_rate_on_acked(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t event_time, const uint64_t min_rtt, quic_congestion_rate_sample_t *const sample) {
+    quic_congestion_rate_packet_t *const pkt = quic_congestion_rate_find(rate, space, num);
+
+    rate->delivered += acked_bytes;
+    rate->delivered_time = event_time;
+    rate->inflight = rate->inflight > acked_bytes ? rate->inflight - acked_bytes : 0;
+    if (rate->app_limited && rate->delivered > rate->app_limited) {
+        rate->app_limited = 0;
+    }
+    if (!pkt) {
+        return false;
+    }
+    pkt->in_flight = false;
+
+    sample->prior_delivered = pkt->delivered;
+    sample->app_limited = pkt->app_limited;
+    sample->bw = 0;
+    rate->first_sent_time = pkt->sent_time;
+
+    // the slower of the send and the ack rates, an ACK compressed below min_rtt gives no sample
+    const uint64_t send_elapsed = pkt->sent_time - pkt->first_sent_time;
+    const uint64_t ack_elapsed = event_time > pkt->delivered_time ? event_time - pkt->delivered_time : 0;
+    const uint64_t interval = send_elapsed > ack_elapsed ? send_elapsed : ack_elapsed;
+    if (interval && interval >= min_rtt) {
+        sample->bw = (rate->delivered - pkt->delivered) * 1000 * 1000 / interval;
+    }
+
+    return true;
+}
+
+static inline uint64_t quic_congestion_rate_on_lost(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes) {
+    quic_congestion_rate_packet_t *const pkt = quic_congestion_rate_find(rate, space, num);
+    const uint64_t inflight = rate->inflight;
+
+    rate->inflight = rate->inflight > lost_bytes ? rate->inflight - lost_bytes : 0;
+    if (!pkt) {
+        return inflight;
+    }
+    pkt->in_flight = false;
+
+    return pkt->inflight;
+}
+
+static inline quic_err_t quic_congestion_rate_discard(quic_congestion_rate_t *const rate, const quic_space_t space, const uint64_t discarded_bytes) {
+    rate->inflight = rate->inflight > discarded_bytes ? rate->inflight - discarded_bytes : 0;
+
+    uint32_t i;
+    for (i = 0; i < rate->capa; i++) {
+        if (rate->pkts[i].in_flight && rate->pkts[i].space == space) {
+            rate->pkts[i].in_flight = false;
+        }
+    }
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_init(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+
+    quic_congestion_bbr_enter(bbr, quic_congestion_bbr_startup, 0);
+
+    quic_congestion_minmax_reset(&bbr->max_bw, 0, 0);
+
+    bbr->min_rtt = 0;
+    bbr->min_rtt_stamp = 0;
+    bbr->probe_rtt_min = 0;
+    bbr->probe_rtt_min_stamp = 0;
+    bbr->probe_rtt_expired = false;
+    bbr->probe_rtt_done_stamp = 0;
+    bbr->probe_rtt_round_done = false;
+    bbr->prior_cwnd = 0;
+
+    bbr->round_count = 0;
+    bbr->next_round_delivered = 0;
+    bbr->round_start = false;
+
+    bbr->filled_pipe = false;
+    bbr->full_bw = 0;
+    bbr->full_bw_count = 0;
+
+    bbr->inflight_hi = 0;
+    bbr->probe_up_rounds = 0;
+    bbr->round_delivered = 0;
+    bbr->round_lost = 0;
+    bbr->loss_in_round = false;
+
+    bbr->cycle_stamp = 0;
+    bbr->cycle_rounds = 0;
+
+    // no RTT sample yet, the initial window is paced over 1ms
+    bbr->pacing_rate = session->cfg.initial_cwnd * 1000 * 277 / 100;
+    bbr->next_send_time = 0;
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_enter(quic_congestion_bbr_t *const bbr, const quic_congestion_bbr_state_t state, const uint64_t now) {
+    bbr->state = state;
+
+    switch (state) {
+    case quic_congestion_bbr_startup:
+        // 2/ln(2), doubles the delivery rate every round
+        bbr->pacing_gain = 277;
+        bbr->cwnd_gain = 200;
+        break;
+    case quic_congestion_bbr_drain:
+        bbr->pacing_gain = 35;
+        bbr->cwnd_gain = 200;
+        break;
+    case quic_congestion_bbr_probe_bw_down:
+        bbr->pacing_gain = 90;
+        bbr->cwnd_gain = 200;
+        bbr->cycle_stamp = now;
+        bbr->cycle_rounds = 0;
+        break;
+    case quic_congestion_bbr_probe_bw_cruise:
+    case quic_congestion_bbr_probe_bw_refill:
+        bbr->pacing_gain = 100;
+        bbr->cwnd_gain = 200;
+        break;
+    case quic_congestion_bbr_probe_bw_up:
+        bbr->pacing_gain = 125;
+        bbr->cwnd_gain = 225;
+        bbr->cycle_rounds = 0;
+        bbr->probe_up_rounds = 0;
+        break;
+    case quic_congestion_bbr_probe_rtt:
+        bbr->pacing_gain = 100;
+        bbr->cwnd_gain = 50;
+        break;
+    }
+
+    return quic_err_success;
+}
+
+static inline uint64_t quic_congestion_bbr_bw(quic_congestion_bbr_t *const bbr) {
+    return bbr->max_bw.s[0].val;
+}
+
+static inline uint64_t quic_congestion_bbr_bdp(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint32_t gain) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+
+    const uint64_t bw = quic_congestion_bbr_bw(bbr);
+    if (!bw || !bbr->min_rtt) {
+        return session->cfg.initial_cwnd * gain / 100;
+    }
+    return bw * bbr->min_rtt / (1000 * 1000) * gain / 100;
+}
+
+static inline quic_err_t quic_congestion_bbr_update_round(quic_congestion_status_store_t *const status, const quic_congestion_rate_sample_t *const sample) {
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+
+    // a round ends once a packet sent after its start is acknowledged
+    bbr->round_start = sample->prior_delivered >= bbr->next_round_delivered;
+    if (!bbr->round_start) {
+        return quic_err_success;
+    }
+    bbr->next_round_delivered = status->rate.delivered;
+    bbr->round_count++;
+    bbr->cycle_rounds++;
+
+    bbr->round_delivered = 0;
+    bbr->round_lost = 0;
+    bbr->loss_in_round = false;
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_check_full_pipe(quic_congestion_bbr_t *const bbr, const quic_congestion_rate_sample_t *const sample) {
+    if (bbr->filled_pipe || !bbr->round_start || sample->app_limited) {
+        return quic_err_success;
+    }
+
+    // the pipe is full once the bandwidth grew less than 25% in three rounds
+    const uint64_t bw = quic_congestion_bbr_bw(bbr);
+    if (bw >= bbr->full_bw * 125 / 100) {
+        bbr->full_bw = bw;
+        bbr->full_bw_count = 0;
+        return quic_err_success;
+    }
+    if (++bbr->full_bw_count >= 3) {
+        bbr->filled_pipe = true;
+    }
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_update_state(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint64_t now) {
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+    quic_congestion_rate_t *const rate = &status->rate;
+
+    switch (bbr->state) {
+    case quic_congestion_bbr_startup:
+        if (bbr->filled_pipe) {
+            quic_congestion_bbr_enter(bbr, quic_congestion_bbr_drain, now);
+        }
+        break;
+
+    case quic_congestion_bbr_drain:
+        // the queue built in startup is drained
+        if (rate->inflight <= quic_congestion_bbr_bdp(module, status, 100)) {
+            quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_bw_down, now);
+        }
+        break;
+
+    case quic_congestion_bbr_probe_bw_down:
+        if (rate->inflight <= quic_congestion_bbr_bdp(module, status, 100)
+            && (!bbr->inflight_hi || rate->inflight <= bbr->inflight_hi * 85 / 100)) {
+            quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_bw_cruise, now);
+        }
+        break;
+
+    case quic_congestion_bbr_probe_bw_cruise:
+        // the wait in rounds keeps the probes no farther apart than Reno would grow its window
+        if (now >= bbr->cycle_stamp + QUIC_CONGESTION_BBR_PROBE_WAIT || bbr->cycle_rounds >= 63) {
+            quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_bw_refill, now);
+        }
+        break;
+
+    case quic_congestion_bbr_probe_bw_refill:
+        if (bbr->round_start) {
+            quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_bw_up, now);
+        }
+        break;
+
+    case quic_congestion_bbr_probe_bw_up:
+        if (!bbr->round_start) {
+            break;
+        }
+        // inflight_hi is raised exponentially while it limits the window and the probe goes on without losses
+        if (bbr->inflight_hi && status->base.cwnd >= bbr->inflight_hi) {
+            bbr->inflight_hi += 1460UL << (bbr->probe_up_rounds < 30 ? bbr->probe_up_rounds : 30);
+            bbr->probe_up_rounds++;
+        }
+        if (bbr->cycle_rounds > 1 && rate->inflight >= quic_congestion_bbr_bdp(module, status, 125)) {
+            quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_bw_down, now);
+        }
+        break;
+
+    case quic_congestion_bbr_probe_rtt:
+        break;
+    }
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_check_probe_rtt(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint64_t now) {
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+    quic_congestion_base_t *const base = &status->base;
+    quic_congestion_rate_t *const rate = &status->rate;
+
+    if (bbr->state != quic_congestion_bbr_probe_rtt && bbr->probe_rtt_expired) {
+        bbr->prior_cwnd = base->cwnd;
+        bbr->probe_rtt_expired = false;
+        bbr->probe_rtt_done_stamp = 0;
+        quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_rtt, now);
+    }
+    if (bbr->state != quic_congestion_bbr_probe_rtt) {
+        return quic_err_success;
+    }
+
+    // the window is held at half the BDP for QUIC_CONGESTION_BBR_PROBE_RTT_DURATION and one round
+    const uint64_t probe_rtt_cwnd = quic_congestion_bbr_bdp(module, status, bbr->cwnd_gain);
+    if (!bbr->probe_rtt_done_stamp && rate->inflight <= (probe_rtt_cwnd > 4 * 1460 ? probe_rtt_cwnd : 4 * 1460)) {
+        bbr->probe_rtt_done_stamp = now + QUIC_CONGESTION_BBR_PROBE_RTT_DURATION;
+        bbr->probe_rtt_round_done = false;
+        bbr->next_round_delivered = rate->delivered;
+        return quic_err_success;
+    }
+    if (!bbr->probe_rtt_done_stamp) {
+        return quic_err_success;
+    }
+    if (bbr->round_start) {
+        bbr->probe_rtt_round_done = true;
+    }
+    if (bbr->probe_rtt_round_done && now >= bbr->probe_rtt_done_stamp) {
+        bbr->probe_rtt_min_stamp = now;
+        base->cwnd = base->cwnd > bbr->prior_cwnd ? base->cwnd : bbr->prior_cwnd;
+        quic_congestion_bbr_enter(bbr, bbr->filled_pipe ? quic_congestion_bbr_probe_bw_down : quic_congestion_bbr_startup, now);
+    }
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_update_pacing_rate(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+    quic_congestion_rtt_t *const rtt = &status->rtt;
+
+    const uint64_t bw = quic_congestion_bbr_bw(bbr);
+    if (!bw) {
+        const uint64_t srtt = rtt->min_rtt && rtt->smoothed_rtt ? rtt->smoothed_rtt : 1000;
+        bbr->pacing_rate = session->cfg.initial_cwnd * 1000 * 1000 / srtt * 277 / 100;
+        return quic_err_success;
+    }
+
+    // paced 1% below the model, startup only speeds up until the pipe is full
+    const uint64_t pacing_rate = bw * bbr->pacing_gain / 100 * 99 / 100;
+    if (bbr->filled_pipe || pacing_rate > bbr->pacing_rate) {
+        bbr->pacing_rate = pacing_rate;
+    }
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_congestion_bbr_update_cwnd(quic_congestion_module_t *const module, quic_congestion_status_store_t *const status, const uint64_t acked_bytes) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+    quic_congestion_base_t *const base = &status->base;
+
+    // the window leaves room for cwnd_gain times the BDP and three packets of ACK aggregation
+    const uint64_t target = quic_congestion_bbr_bdp(module, status, bbr->cwnd_gain) + 3 * 1460;
+    if (bbr->filled_pipe) {
+        base->cwnd = base->cwnd + acked_bytes < target ? base->cwnd + acked_bytes : target;
+    }
+    else if (base->cwnd < target || status->rate.delivered < session->cfg.initial_cwnd) {
+        base->cwnd += acked_bytes;
+    }
+
+    if (bbr->inflight_hi && base->cwnd > bbr->inflight_hi) {
+        base->cwnd = bbr->inflight_hi;
+    }
+    if (bbr->state == quic_congestion_bbr_probe_rtt) {
+        const uint64_t probe_rtt_cwnd = quic_congestion_bbr_bdp(module, status, bbr->cwnd_gain);
+        base->cwnd = base->cwnd < probe_rtt_cwnd ? base->cwnd : probe_rtt_cwnd;
+    }
+    base->cwnd = base->cwnd < 4 * 1460 ? 4 * 1460 : base->cwnd;
+
+    base->cwnd = base->cwnd < session->cfg.min_cwnd ? session->cfg.min_cwnd : base->cwnd;
+    base->cwnd = base->cwnd > session->cfg.max_cwnd ? session->cfg.max_cwnd : base->cwnd;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_congestion_bbr_on_sent(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool included_unacked) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+
+    // every packet is paced, only ack-eliciting ones are sampled
+    const uint64_t start = bbr->next_send_time > sent_time ? bbr->next_send_time : sent_time;
+    bbr->next_send_time = start + (bbr->pacing_rate ? sent_bytes * 1000 * 1000 / bbr->pacing_rate : 0);
+
+    if (!included_unacked) {
+        return quic_err_success;
+    }
+
+    return quic_congestion_rate_on_sent(&status->rate, space, sent_time, num, sent_bytes);
+}
+
+static quic_err_t quic_congestion_bbr_on_acked(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_bytes, const uint64_t event_time) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+    quic_congestion_rate_sample_t sample;
+    (void) unacked_bytes;
+
+    if (quic_congestion_rate_on_acked(&status->rate, space, num, acked_bytes, event_time, bbr->min_rtt, &sample)) {
+        quic_congestion_bbr_update_round(status, &sample);
+
+        // an application limited sample only shows the bandwidth is at least that
+        if (sample.bw && (!sample.app_limited || sample.bw >= quic_congestion_bbr_bw(bbr))) {
+            quic_congestion_minmax_running_max(&bbr->max_bw, QUIC_CONGESTION_BBR_BW_WINDOW, bbr->round_count, sample.bw);
+        }
+        quic_congestion_bbr_check_full_pipe(bbr, &sample);
+    }
+    else {
+        bbr->round_start = false;
+    }
+    bbr->round_delivered += acked_bytes;
+
+    quic_congestion_bbr_update_state(module, status, event_time);
+    quic_congestion_bbr_check_probe_rtt(module, status, event_time);
+    quic_congestion_bbr_update_pacing_rate(module, status);
+    quic_congestion_bbr_update_cwnd(module, status, acked_bytes);
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_congestion_bbr_on_lost(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+    quic_congestion_base_t *const base = &status->base;
+    (void) unacked_bytes;
+
+    const uint64_t inflight = quic_congestion_rate_on_lost(&status->rate, space, num, lost_bytes);
+    bbr->round_lost += lost_bytes;
+
+    // losses below QUIC_CONGESTION_BBR_LOSS_THRESH percent of the round are not a signal of the model, nor the first
+    // losses of startup, a shallow buffer overflows long before the pipe is full
+    if (bbr->loss_in_round
+        || (bbr->state == quic_congestion_bbr_startup && bbr->round_lost < QUIC_CONGESTION_BBR_STARTUP_LOSSES * 1460)
+        || bbr->round_lost * 100 <= (bbr->round_lost + bbr->round_delivered) * QUIC_CONGESTION_BBR_LOSS_THRESH) {
+        return quic_err_success;
+    }
+    bbr->loss_in_round = true;
+
+    // the inflight the lost packet was sent with is too high, at most 30% below the model
+    const uint64_t floor = quic_congestion_bbr_bdp(module, status, 100) * 7 / 10;
+    bbr->inflight_hi = inflight > floor ? inflight : floor;
+    bbr->inflight_hi = bbr->inflight_hi < 4 * 1460 ? 4 * 1460 : bbr->inflight_hi;
+
+    if (bbr->state == quic_congestion_bbr_startup) {
+        bbr->filled_pipe = true;
+        quic_congestion_bbr_enter(bbr, quic_congestion_bbr_drain, quic_now());
+    }
+    else if (bbr->state == quic_congestion_bbr_probe_bw_up || bbr->state == quic_congestion_bbr_probe_bw_refill) {
+        quic_congestion_bbr_enter(bbr, quic_congestion_bbr_probe_bw_down, quic_now());
+    }
+
+    base->cwnd = base->cwnd < bbr->inflight_hi ? base->cwnd : bbr->inflight_hi;
+    base->cwnd = base->cwnd < session->cfg.min_cwnd ? session->cfg.min_cwnd : base->cwnd;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_congestion_bbr_on_discarded(quic_congestion_module_t *const module, const quic_space_t space, const uint64_t discarded_bytes) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+
+    // the bytes of a dropped packet number space are never acknowledged nor lost
+    return quic_congestion_rate_discard(&status->rate, space, discarded_bytes);
+}
+
+static quic_err_t quic_congestion_bbr_on_app_limited(quic_congestion_module_t *const module) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    quic_congestion_rate_t *const rate = &status->rate;
+
+    // the samples of the packets sent until then underestimate the bandwidth
+    rate->app_limited = rate->delivered + rate->inflight ? rate->delivered + rate->inflight : 1;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_congestion_bbr_update(quic_congestion_module_t *const module, const uint64_t recv_time, const uint64_t sent_time, const uint64_t delay) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    quic_congestion_bbr_t *const bbr = &status->bbr;
+
+    quic_congestion_rtt_update(module, recv_time, sent_time, delay);
+
+    const uint64_t sample = recv_time - sent_time;
+
+    // probe_rtt_min keeps the min of the last interval, PROBE_RTT is entered when no sample reached it again
+    bbr->probe_rtt_expired = bbr->probe_rtt_min_stamp && recv_time > bbr->probe_rtt_min_stamp + QUIC_CONGESTION_BBR_PROBE_RTT_INTERVAL;
+    if (!bbr->probe_rtt_min_stamp || sample < bbr->probe_rtt_min || bbr->probe_rtt_expired) {
+        bbr->probe_rtt_min = sample;
+        bbr->probe_rtt_min_stamp = recv_time;
+    }
+
+    const bool min_rtt_expired = recv_time > bbr->min_rtt_stamp + QUIC_CONGESTION_BBR_MIN_RTT_WINDOW;
+    if (!bbr->min_rtt || bbr->probe_rtt_min < bbr->min_rtt || min_rtt_expired) {
+        bbr->min_rtt = bbr->probe_rtt_min;
+        bbr->min_rtt_stamp = bbr->probe_rtt_min_stamp;
+    }
+
+    return quic_err_success;
+}
+
+static bool quic_congestion_bbr_allow_send(quic_congestion_module_t *const module, const uint64_t unacked_bytes) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+
+    return unacked_bytes < status->base.cwnd;
+}
+
+static uint64_t quic_congestion_bbr_next_send_time(quic_congestion_module_t *const module, const uint64_t unacked_bytes) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    (void) unacked_bytes;
+
+    return status->bbr.next_send_time > QUIC_CONGESTION_BBR_PACING_QUANTUM ? status->bbr.next_send_time - QUIC_CONGESTION_BBR_PACING_QUANTUM : 0;
+}
+
+static bool quic_congestion_bbr_has_budget(quic_congestion_module_t *const module) {
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+
+    return quic_now() + QUIC_CONGESTION_BBR_PACING_QUANTUM >= status->bbr.next_send_time;
+}
+
 static quic_err_t quic_congestion_module_migrate(quic_congestion_module_t *const module, const quic_path_t key) {
     quic_congestion_instance_t *const instance = quic_congestion_instance(module);
     quic_congestion_status_store_t *store = liteco_rbt_find(instance->store, &key);
@@ -647,6 +1441,8 @@ static quic_err_t quic_congestion_module_migrate(quic_congestion_module_t *const
         quic_congestion_prr_init(module, store);
         quic_congestion_tbp_init(module, store);
         quic_congestion_rtt_init(module, store);
+        quic_congestion_rate_init(module, store);
+        quic_congestion_bbr_init(module, store);
 
         liteco_rbt_insert(&instance->store, store);
     }
@@ -662,6 +1458,9 @@ static quic_err_t quic_congestion_module_destory(void *const module) {
     while (liteco_rbt_is_not_nil(instance->store)) {
         quic_congestion_status_store_t *store = instance->store;
         liteco_rbt_remove(&instance->store, &store);
+        if (store->rate.pkts) {
+            free(store->rate.pkts);
+        }
         free(store);
     }
 
@@ -672,7 +1471,7 @@ quic_module_t quic_congestion_module = {
     .name        = "congestion",
     .module_size = sizeof(quic_congestion_module_t) + sizeof(quic_congestion_instance_t),
     .init        = quic_congestion_module_init,
-    .start       = NULL,
+    .start       = quic_congestion_module_start,
     .process     = NULL,
     .loop        = NULL,
     .destory     = quic_congestion_module_destory
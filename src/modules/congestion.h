@@ -11,15 +11,68 @@
 
 #include "module.h"
 #include "utils/addr.h"
+#include "space.h"
 #include <stdbool.h>
 
+// rounds of the windowed max filter of the bottleneck bandwidth
+#ifndef QUIC_CONGESTION_BBR_BW_WINDOW
+#define QUIC_CONGESTION_BBR_BW_WINDOW 10
+#endif
+
+// min_rtt (us) expires after QUIC_CONGESTION_BBR_MIN_RTT_WINDOW, PROBE_RTT runs when no RTT sample reached the
+// minimum of the last QUIC_CONGESTION_BBR_PROBE_RTT_INTERVAL, for QUIC_CONGESTION_BBR_PROBE_RTT_DURATION at least
+#ifndef QUIC_CONGESTION_BBR_MIN_RTT_WINDOW
+#define QUIC_CONGESTION_BBR_MIN_RTT_WINDOW (10 * 1000 * 1000)
+#endif
+
+#ifndef QUIC_CONGESTION_BBR_PROBE_RTT_INTERVAL
+#define QUIC_CONGESTION_BBR_PROBE_RTT_INTERVAL (5 * 1000 * 1000)
+#endif
+
+#ifndef QUIC_CONGESTION_BBR_PROBE_RTT_DURATION
+#define QUIC_CONGESTION_BBR_PROBE_RTT_DURATION (200 * 1000)
+#endif
+
+// PROBE_BW cruises this long (us) between two probes for more bandwidth
+#ifndef QUIC_CONGESTION_BBR_PROBE_WAIT
+#define QUIC_CONGESTION_BBR_PROBE_WAIT (2 * 1000 * 1000)
+#endif
+
+// percent of the bytes of a round lost before inflight_hi bounds the window
+#ifndef QUIC_CONGESTION_BBR_LOSS_THRESH
+#define QUIC_CONGESTION_BBR_LOSS_THRESH 2
+#endif
+
+// packets lost in a round of startup before the loss rate ends it
+#ifndef QUIC_CONGESTION_BBR_STARTUP_LOSSES
+#define QUIC_CONGESTION_BBR_STARTUP_LOSSES 8
+#endif
+
+// the pacer lets packets leave this early (us), the tick of the session timers
+#ifndef QUIC_CONGESTION_BBR_PACING_QUANTUM
+#define QUIC_CONGESTION_BBR_PACING_QUANTUM 1000
+#endif
+
+// delivery rate samples kept per path, the sampler grows up to the max while packets are in flight
+#ifndef QUIC_CONGESTION_RATE_INIT_CAPA
+#define QUIC_CONGESTION_RATE_INIT_CAPA 256
+#endif
+
+#ifndef QUIC_CONGESTION_RATE_MAX_CAPA
+#define QUIC_CONGESTION_RATE_MAX_CAPA 16384
+#endif
+
 typedef struct quic_congestion_module_s quic_congestion_module_t;
 struct quic_congestion_module_s {
     QUIC_MODULE_FIELDS
 
-    quic_err_t (*on_sent) (quic_congestion_module_t *const module, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool include_unacked);
-    quic_err_t (*on_acked) (quic_congestion_module_t *const module, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_unacked, const uint64_t event_time);
-    quic_err_t (*on_lost) (quic_congestion_module_t *const module, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes);
+    quic_err_t (*on_sent) (quic_congestion_module_t *const module, const quic_space_t space, const uint64_t sent_time, const uint64_t num, const uint64_t sent_bytes, const bool include_unacked);
+    quic_err_t (*on_acked) (quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t acked_bytes, const uint64_t unacked_unacked, const uint64_t event_time);
+    quic_err_t (*on_lost) (quic_congestion_module_t *const module, const quic_space_t space, const uint64_t num, const uint64_t lost_bytes, const uint64_t unacked_bytes);
+    // the packets of a packet number space still in flight are given up without being acknowledged or lost
+    quic_err_t (*on_discarded) (quic_congestion_module_t *const module, const quic_space_t space, const uint64_t discarded_bytes);
+    // the sender had nothing to send while the window and the pacer allowed it
+    quic_err_t (*on_app_limited) (quic_congestion_module_t *const module);
 
     quic_err_t (*update) (quic_congestion_module_t *const module, const uint64_t recv_time, const uint64_t sent_time, const uint64_t ack_delay);
     bool (*allow_send) (quic_congestion_module_t *const module, const uint64_t unacked);
@@ -29,6 +82,8 @@ struct quic_congestion_module_s {
 
     uint64_t (*pto) (quic_congestion_module_t *const module, const uint64_t max_delay);
     uint64_t (*smoothed_rtt) (quic_congestion_module_t *const module);
+    uint64_t (*latest_rtt) (quic_congestion_module_t *const module);
+    uint64_t (*cwnd) (quic_congestion_module_t *const module);
 
     quic_err_t (*migrate) (quic_congestion_module_t *const module, const quic_path_t path);
 
@@ -40,19 +95,29 @@ struct quic_congestion_module_s {
         (module)->update((module), (recv_time), (sent_time), (ack_delay)); \
     }
 
-#define quic_congestion_on_sent(module, sent_time, num, sent_bytes, include_unacked)      \
-    if ((module)->on_sent) {                                                              \
-        (module)->on_sent((module), (sent_time), (num), (sent_bytes), (include_unacked)); \
+#define quic_congestion_on_sent(module, space, sent_time, num, sent_bytes, include_unacked)        \
+    if ((module)->on_sent) {                                                                       \
+        (module)->on_sent((module), (space), (sent_time), (num), (sent_bytes), (include_unacked)); \
     }
 
-#define quic_congestion_on_acked(module, num, acked_bytes, unacked_bytes, event_time)      \
-    if ((module)->on_acked) {                                                              \
-        (module)->on_acked((module), (num), (acked_bytes), (unacked_bytes), (event_time)); \
+#define quic_congestion_on_acked(module, space, num, acked_bytes, unacked_bytes, event_time)        \
+    if ((module)->on_acked) {                                                                       \
+        (module)->on_acked((module), (space), (num), (acked_bytes), (unacked_bytes), (event_time)); \
     }
 
-#define quic_congestion_on_lost(module, num, lost_bytes, unacked_bytes)     \
-    if ((module)->on_lost) {                                                \
-        (module)->on_lost((module), (num), (lost_bytes), (unacked_bytes));  \
+#define quic_congestion_on_lost(module, space, num, lost_bytes, unacked_bytes)      \
+    if ((module)->on_lost) {                                                        \
+        (module)->on_lost((module), (space), (num), (lost_bytes), (unacked_bytes)); \
+    }
+
+#define quic_congestion_on_discarded(module, space, discarded_bytes)  \
+    if ((module)->on_discarded) {                                     \
+        (module)->on_discarded((module), (space), (discarded_bytes)); \
+    }
+
+#define quic_congestion_on_app_limited(module) \
+    if ((module)->on_app_limited) {             \
+        (module)->on_app_limited((module));     \
     }
 
 #define quic_congestion_next_send_time(module, unacked_bytes) \
@@ -76,6 +141,12 @@ struct quic_congestion_module_s {
 #define quic_congestion_smoothed_rtt(module) \
     ((module)->smoothed_rtt ? (module)->smoothed_rtt(module) : 0)
 
+#define quic_congestion_latest_rtt(module) \
+    ((module)->latest_rtt ? (module)->latest_rtt(module) : 0)
+
+#define quic_congestion_cwnd(module) \
+    ((module)->cwnd ? (module)->cwnd(module) : 0)
+
 extern quic_module_t quic_congestion_module;
 
 #endif
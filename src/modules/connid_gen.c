@@ -49,6 +49,9 @@ quic_err_t quic_connid_gen_issue_src(quic_connid_gen_module_t *const module) {
         if (quic_connid_gen(&connid) != quic_err_success) {
             return quic_err_internal_error;
         }
+        if (module->worker_id >= 0) {
+            ((uint8_t *) connid.buf)[0] = module->worker_id;
+        }
         if (!module->new_connid) {
             break;
         }
@@ -68,10 +71,10 @@ quic_err_t quic_connid_gen_issue_src(quic_connid_gen_module_t *const module) {
     gened->connid = connid;
     liteco_rbt_insert(&module->srcs, gened);
 
-    if ((frame = quic_malloc(sizeof(quic_frame_new_connection_id_t))) == NULL) {
+    quic_frame_create(frame, &session->frame_pool, quic_frame_new_connection_id_type, sizeof(quic_frame_new_connection_id_t));
+    if (!frame) {
         return quic_err_internal_error;
     }
-    quic_frame_init(frame, quic_frame_new_connection_id_type);
     frame->seq = gened->key;
     frame->retire = 0;
     frame->len = quic_buf_size(&gened->connid);
@@ -118,10 +121,12 @@ static quic_err_t quic_connid_gen_module_init(void *const module) {
     if (session->cfg.is_cli) {
         quic_client_t *const client = ((void *) session->transmission) - offsetof(quic_client_t, transmission);
         c_module->connid_len = client->connid_len;
+        c_module->worker_id = -1;
     }
     else {
         quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
         c_module->connid_len = server->connid_len;
+        c_module->worker_id = server->workers_count > 1 ? (int) server->worker_id : -1;
     }
     c_module->src_hseq = 0;
     c_module->dst_hretire = 0;
@@ -222,11 +227,11 @@ quic_err_t quic_session_handle_new_connection_id_frame(quic_session_t *const ses
     quic_frame_new_connection_id_t *const n_frame = (quic_frame_new_connection_id_t *) frame;
 
     if (n_frame->seq < g_module->dst_hretire) {
-        quic_frame_retire_connection_id_t *const r_frame = quic_malloc(sizeof(quic_frame_retire_connection_id_t));
+        quic_frame_retire_connection_id_t *r_frame = NULL;
+        quic_frame_create(r_frame, &session->frame_pool, quic_frame_retire_connection_id_type, sizeof(quic_frame_retire_connection_id_t));
         if (!r_frame) {
             return quic_err_internal_error;
         }
-        quic_frame_init(r_frame, quic_frame_retire_connection_id_type);
         r_frame->seq = n_frame->seq;
         quic_framer_ctrl(f_module, (quic_frame_t *) r_frame);
 
@@ -239,11 +244,11 @@ quic_err_t quic_session_handle_new_connection_id_frame(quic_session_t *const ses
              liteco_rbt_is_not_nil(retire_gened) && retire_gened->key <= n_frame->retire;
              retire_gened = liteco_rbt_min(g_module->dsts)) {
 
-            quic_frame_retire_connection_id_t *const r_frame = quic_malloc(sizeof(quic_frame_retire_connection_id_t));
+            quic_frame_retire_connection_id_t *r_frame = NULL;
+            quic_frame_create(r_frame, &session->frame_pool, quic_frame_retire_connection_id_type, sizeof(quic_frame_retire_connection_id_t));
             if (!r_frame) {
                 return quic_err_internal_error;
             }
-            quic_frame_init(r_frame, quic_frame_retire_connection_id_type);
             r_frame->seq = retire_gened->key;
             quic_framer_ctrl(f_module, (quic_frame_t *) r_frame);
 
@@ -297,11 +302,11 @@ static inline quic_err_t quic_connid_gen_update_dst(quic_connid_gen_module_t *co
     quic_session_t *const session = quic_module_of_session(module);
     quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
 
-    quic_frame_retire_connection_id_t *const r_frame = quic_malloc(sizeof(quic_frame_retire_connection_id_t));
+    quic_frame_retire_connection_id_t *r_frame = NULL;
+    quic_frame_create(r_frame, &session->frame_pool, quic_frame_retire_connection_id_type, sizeof(quic_frame_retire_connection_id_t));
     if (!r_frame) {
         return quic_err_internal_error;
     }
-    quic_frame_init(r_frame, quic_frame_retire_connection_id_type);
     r_frame->seq = module->dst_active;
     quic_framer_ctrl(f_module, (quic_frame_t *) r_frame);
 
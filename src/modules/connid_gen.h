@@ -25,6 +25,8 @@ struct quic_connid_gen_module_s {
     QUIC_MODULE_FIELDS
 
     int connid_len;
+    // index of the server worker which owns the session, stamped into the first byte of issued connection ids (-1 none)
+    int worker_id;
     uint64_t src_hseq;
     uint64_t dst_hretire;
 
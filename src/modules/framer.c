@@ -121,7 +121,7 @@ static quic_err_t quic_framer_module_destory(void *const module) {
     while (!liteco_link_empty(&f_module->ctrls)) {
         quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&f_module->ctrls);
         liteco_link_remove(frame);
-        free(frame);
+        quic_frame_free(frame);
     }
 
     while (!liteco_rbt_is_nil(f_module->active_set)) {
@@ -43,6 +43,7 @@ extern quic_module_t quic_framer_module;
 
 __quic_header_inline quic_err_t quic_framer_ctrl(quic_framer_module_t *const module, quic_frame_t *const frame) {
     liteco_link_insert_before(&module->ctrls, frame);
+    quic_module_activate(quic_module_of_session(module), quic_sender_module);
     return quic_err_success;
 }
 
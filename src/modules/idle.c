@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "modules/idle.h"
+#include "modules/recver.h"
+#include "modules/retransmission.h"
+#include "modules/congestion.h"
+#include "modules/framer.h"
+#include "modules/sender.h"
+#include "modules/sealer.h"
+#include "utils/time.h"
+
+static quic_err_t quic_idle_module_init(void *const module);
+static quic_err_t quic_idle_module_start(void *const module);
+static quic_err_t quic_idle_module_loop(void *const module, const uint64_t now);
+
+static inline uint64_t quic_idle_last_sent_time(quic_session_t *const session);
+static inline quic_err_t quic_idle_send_keepalive(quic_idle_module_t *const module);
+
+static quic_err_t quic_idle_module_init(void *const module) {
+    quic_idle_module_t *const i_module = module;
+
+    i_module->timeout = 0;
+    i_module->started_at = 0;
+    i_module->last_recv_time = 0;
+    i_module->sent_time = 0;
+    i_module->keepalive_sent = false;
+    i_module->timeouts = 0;
+    i_module->keepalives = 0;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_idle_module_start(void *const module) {
+    quic_idle_module_t *const i_module = module;
+    quic_session_t *const session = quic_module_of_session(i_module);
+
+    i_module->timeout = session->cfg.idle_timeout * 1000;
+    i_module->started_at = quic_now();
+    if (i_module->timeout) {
+        quic_session_set_deadline(session, quic_session_deadline_idle, i_module->started_at + i_module->timeout);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_idle_negotiate(quic_idle_module_t *const module, const uint64_t peer_timeout) {
+    if (peer_timeout && (!module->timeout || peer_timeout * 1000 < module->timeout)) {
+        module->timeout = peer_timeout * 1000;
+        quic_idle_module_loop(module, quic_now());
+    }
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_idle_module_loop(void *const module, const uint64_t now) {
+    quic_idle_module_t *const i_module = module;
+    quic_session_t *const session = quic_module_of_session(i_module);
+    quic_recver_module_t *const r_module = quic_session_module(session, quic_recver_module);
+    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
+    quic_retransmission_module_t *const app_r_module = quic_session_module(session, quic_app_retransmission_module);
+
+    if (!i_module->timeout) {
+        quic_session_set_deadline(session, quic_session_deadline_idle, 0);
+        return quic_err_success;
+    }
+
+    // only called when the deadline fires, which is armed for the latest possible expiry and moved on from here
+    if (r_module->last_recv_time != i_module->last_recv_time) {
+        i_module->last_recv_time = r_module->last_recv_time;
+        i_module->sent_time = 0;
+        i_module->keepalive_sent = false;
+    }
+    const uint64_t last_recv_time = i_module->last_recv_time ? i_module->last_recv_time : i_module->started_at;
+    if (!i_module->sent_time) {
+        const uint64_t sent_time = quic_idle_last_sent_time(session);
+        if (sent_time > last_recv_time) {
+            i_module->sent_time = sent_time;
+        }
+    }
+    const uint64_t active_time = i_module->sent_time > last_recv_time ? i_module->sent_time : last_recv_time;
+
+    uint64_t timeout = i_module->timeout;
+    if (c_module->pto) {
+        const uint64_t pto3 = 3 * quic_congestion_pto(c_module, app_r_module->max_delay);
+        if (pto3 > timeout) {
+            timeout = pto3;
+        }
+    }
+
+    if (now >= active_time + timeout) {
+        i_module->timeouts++;
+        session->silent_closed = true;
+        liteco_chan_close(&session->mod_chan);
+        return quic_err_success;
+    }
+    uint64_t deadline = active_time + timeout;
+
+    // a PING keeps the peer from timing out, and its ACK restarts the timer on this side
+    if (session->cfg.idle_keepalive_percent && !i_module->keepalive_sent) {
+        const uint64_t keepalive_time = last_recv_time + timeout * session->cfg.idle_keepalive_percent / 100;
+        if (now >= keepalive_time) {
+            quic_idle_send_keepalive(i_module);
+        }
+        else if (keepalive_time < deadline) {
+            deadline = keepalive_time;
+        }
+    }
+    quic_session_set_deadline(session, quic_session_deadline_idle, deadline);
+
+    return quic_err_success;
+}
+
+static inline uint64_t quic_idle_last_sent_time(quic_session_t *const session) {
+    quic_retransmission_module_t *const init_r_module = quic_session_module(session, quic_initial_retransmission_module);
+    quic_retransmission_module_t *const hs_r_module = quic_session_module(session, quic_handshake_retransmission_module);
+    quic_retransmission_module_t *const app_r_module = quic_session_module(session, quic_app_retransmission_module);
+    uint64_t sent_time = init_r_module->last_sent_ack_time;
+
+    if (hs_r_module->last_sent_ack_time > sent_time) {
+        sent_time = hs_r_module->last_sent_ack_time;
+    }
+    if (app_r_module->last_sent_ack_time > sent_time) {
+        sent_time = app_r_module->last_sent_ack_time;
+    }
+
+    return sent_time;
+}
+
+static inline quic_err_t quic_idle_send_keepalive(quic_idle_module_t *const module) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
+    quic_sealer_module_t *const s_module = quic_session_module(session, quic_sealer_module);
+    quic_frame_ping_t *frame = NULL;
+
+    // control frames are sent in 1-RTT packets
+    if (s_module->level != ssl_encryption_application) {
+        return quic_err_success;
+    }
+
+    quic_frame_create(frame, &session->frame_pool, quic_frame_ping_type, sizeof(quic_frame_ping_t));
+    if (!frame) {
+        return quic_err_internal_error;
+    }
+    quic_framer_ctrl(f_module, (quic_frame_t *) frame);
+    module->keepalive_sent = true;
+    module->keepalives++;
+
+    quic_module_activate(session, quic_sender_module);
+
+    return quic_err_success;
+}
+
+quic_module_t quic_idle_module = {
+    .name        = "idle",
+    .module_size = sizeof(quic_idle_module_t),
+    .init        = quic_idle_module_init,
+    .start       = quic_idle_module_start,
+    .process     = NULL,
+    .loop        = quic_idle_module_loop,
+    .destory     = NULL
+};
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_IDLE_H__
+#define __OPENQUIC_IDLE_H__
+
+#include "module.h"
+#include "session.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * closes the session silently once nothing was received, or sent after the last receipt, for the idle timeout.
+ * the effective timeout (us) is the smaller of the local and the peer max_idle_timeout, but at least 3 PTO
+ */
+typedef struct quic_idle_module_s quic_idle_module_t;
+struct quic_idle_module_s {
+    QUIC_MODULE_FIELDS
+
+    uint64_t timeout;
+
+    uint64_t started_at;
+    // last receipt seen by the loop, and the first ack-eliciting packet sent after it
+    uint64_t last_recv_time;
+    uint64_t sent_time;
+    bool keepalive_sent;
+
+    uint64_t timeouts;
+    uint64_t keepalives;
+};
+
+extern quic_module_t quic_idle_module;
+
+// peer_timeout is the max_idle_timeout (ms) of the peer transport parameters, 0 means none
+quic_err_t quic_idle_negotiate(quic_idle_module_t *const module, const uint64_t peer_timeout);
+
+#endif
@@ -10,9 +10,15 @@
 #include "format/frame.h"
 #include "modules/ack_generator.h"
 #include "modules/sealer.h"
+#include "modules/retransmission.h"
+#include "modules/sender.h"
+#include "modules/stream.h"
 #include "format/header.h"
+#include <openssl/mem.h>
 
-static quic_err_t quic_recver_handle_packet(quic_recver_module_t *const module);
+static quic_err_t quic_recver_handle_datagram(quic_recver_module_t *const module);
+static quic_err_t quic_recver_handle_packet(quic_recver_module_t *const module, quic_buf_t *const pkt);
+static quic_err_t quic_recver_handle_retry(quic_recver_module_t *const module, quic_buf_t *const pkt);
 static quic_err_t quic_recver_process_packet(quic_session_t *const sess, quic_recver_module_t *const r_module, quic_ack_generator_module_t *const a_module, const quic_payload_t *payload, const uint64_t recv_time);
 static quic_err_t quic_recver_process_packet_payload(quic_session_t *const sess, quic_recver_module_t *const r_module, quic_ack_generator_module_t *const a_module, const quic_payload_t *payload, const uint64_t recv_time);
 
@@ -22,19 +28,42 @@ static quic_err_t quic_recver_module_destory(void *const module);
 
 extern quic_session_handler_t quic_session_handler[256];
 
-static quic_err_t quic_recver_handle_packet(quic_recver_module_t *const module) {
+static quic_err_t quic_recver_handle_datagram(quic_recver_module_t *const module) {
+    uint8_t *buf = module->curr_packet->pkt.buf;
+    size_t remain = module->curr_packet->pkt.ret;
+
+    // a datagram may carry several coalesced packets, each long header one is delimited by its length field
+    while (remain) {
+        const size_t pkt_size = quic_header_packet_size(buf, remain);
+        if (!pkt_size) {
+            break;
+        }
+
+        quic_buf_t pkt = { .buf = buf, .capa = pkt_size };
+        quic_buf_setpl(&pkt);
+        quic_recver_handle_packet(module, &pkt);
+
+        buf += pkt_size;
+        remain -= pkt_size;
+    }
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_recver_handle_packet(quic_recver_module_t *const module, quic_buf_t *const pkt) {
     quic_session_t *const session = quic_module_of_session(module);
     quic_ack_generator_module_t *ag_module = NULL;
     quic_sealer_module_t *const sealer_module = quic_session_module(session, quic_sealer_module);
 
-    quic_err_t err = quic_sealer_open(module->curr_packet, sealer_module, quic_buf_size(&session->src));
+    if (quic_header_is_long((quic_header_t *) pkt->buf) && quic_packet_type((quic_header_t *) pkt->buf) == quic_packet_retry_type) {
+        return quic_recver_handle_retry(module, pkt);
+    }
+
+    quic_err_t err = quic_sealer_open(pkt, sealer_module, quic_buf_size(&session->src));
     if (err != quic_err_success) {
         return err;
     }
 
-    quic_buf_t recv_buf = { .buf = module->curr_packet->pkt.buf, .capa = module->curr_packet->pkt.ret };
-    quic_buf_setpl(&recv_buf);
-
     union {
         quic_initial_header_t initial;
         quic_handshake_header_t handshake;
@@ -42,7 +71,7 @@ static quic_err_t quic_recver_handle_packet(quic_recver_module_t *const module)
         quic_payload_t short_payload;
     } payload;
 
-    quic_header_t *const header = (quic_header_t *) module->curr_packet->pkt.buf;
+    quic_header_t *const header = (quic_header_t *) pkt->buf;
 
     if (session->cfg.is_cli && !module->recv_first && quic_header_is_long(header)) {
         quic_buf_t src = quic_long_header_src_conn(header);
@@ -70,19 +99,59 @@ static quic_err_t quic_recver_handle_packet(quic_recver_module_t *const module)
 
         case quic_packet_0rtt_type:
             payload.zero_rtt = quic_0rtt_header(header);
+            // 0-RTT and 1-RTT packets share the application packet number space
+            ag_module = quic_session_module(session, quic_app_ack_generator_module);
             break;
 
-        case quic_packet_retry_type:
-            return quic_err_not_implemented;
+        default:
+            return quic_err_bad_format;
         }
     }
     else {
         payload.short_payload = quic_short_header(header, quic_buf_size(&session->src));
-        payload.short_payload.payload_len = module->curr_packet->pkt.ret - ((uint8_t *) payload.short_payload.payload - module->curr_packet->pkt.buf);
         ag_module = quic_session_module(session, quic_app_ack_generator_module);
     }
 
-    quic_recver_process_packet(session, module, ag_module, (quic_payload_t *) &payload, module->curr_packet->recv_time);
+    // the length field also covers the packet number and the AEAD tag, so count the opened frames directly
+    quic_payload_t *const common = (quic_payload_t *) &payload;
+    common->payload_len = (uint8_t *) pkt->buf + pkt->capa - (uint8_t *) common->payload;
+
+    quic_recver_process_packet(session, module, ag_module, common, module->curr_packet->recv_time);
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_recver_handle_retry(quic_recver_module_t *const module, quic_buf_t *const pkt) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_sealer_module_t *const sealer_module = quic_session_module(session, quic_sealer_module);
+    quic_header_t *const header = (quic_header_t *) pkt->buf;
+    uint8_t tag[QUIC_RETRY_INTEGRITY_TAG_LEN];
+
+    // a client follows at most one Retry, and none once the server has answered with an Initial
+    if (!session->cfg.is_cli || module->recv_first || !quic_buf_empty(&session->token)) {
+        return quic_err_success;
+    }
+    if (!quic_long_header_check(pkt->buf, pkt->capa) || quic_long_header_len(header) + QUIC_RETRY_INTEGRITY_TAG_LEN >= pkt->capa) {
+        return quic_err_bad_format;
+    }
+
+    const quic_retry_header_t retry = quic_retry_header(header, pkt->capa);
+    if (quic_sealer_retry_integrity_tag(tag, session->dst, pkt->buf, pkt->capa - QUIC_RETRY_INTEGRITY_TAG_LEN) != quic_err_success
+        || CRYPTO_memcmp(tag, retry.tag, QUIC_RETRY_INTEGRITY_TAG_LEN) != 0) {
+        return quic_err_bad_format;
+    }
+
+    quic_buf_t src = quic_long_header_src_conn(header);
+    quic_buf_setpl(&src);
+    quic_buf_copy(&session->token, &retry.token);
+    quic_buf_copy(&session->dst, &src);
+
+    // the ClientHello goes out again, under the Initial keys of the new destination connection id
+    if (quic_sealer_retry(sealer_module) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    quic_retransmission_resend_all(quic_session_module(session, quic_initial_retransmission_module));
+    quic_module_activate(session, quic_sender_module);
 
     return quic_err_success;
 }
@@ -110,7 +179,7 @@ static quic_err_t quic_recver_process_packet_payload(quic_session_t *const sess,
     while (!quic_buf_empty(&buf)) {
         quic_frame_t *frame = NULL;
 
-        if ((err = quic_frame_parse(frame, &buf)) != quic_err_success) {
+        if ((err = quic_frame_parse(frame, &buf, &sess->frame_pool)) != quic_err_success) {
             return err;
         }
 
@@ -128,19 +197,19 @@ static quic_err_t quic_recver_process_packet_payload(quic_session_t *const sess,
 
 
         if (!quic_session_handler[frame->first_byte]) {
-            free(frame);
+            quic_frame_free(frame);
             continue;
         }
         if ((err = quic_session_handler[frame->first_byte](sess, frame)) != quic_err_success) {
-            free(frame);
+            quic_frame_free(frame);
             return err;
         }
 
-        if (frame->first_byte != quic_frame_ack_type && frame->first_byte == quic_frame_ack_ecn_type) {
+        if (frame->first_byte != quic_frame_ack_type && frame->first_byte != quic_frame_ack_ecn_type) {
             r_module->curr_ack_eliciting = true;
         }
 
-        free(frame);
+        quic_frame_free(frame);
     }
 
     if (a_module) {
@@ -166,6 +235,8 @@ static quic_err_t quic_recver_module_init(void *const module) {
 
 static quic_err_t quic_recver_module_process(void *const module) {
     quic_recver_module_t *const ur_module = module;
+    quic_session_t *const session = quic_module_of_session(ur_module);
+    quic_stream_module_t *const s_module = quic_session_module(session, quic_stream_module);
 
     pthread_mutex_lock(&ur_module->mtx);
     while (!liteco_link_empty(&ur_module->queue)) {
@@ -173,7 +244,8 @@ static quic_err_t quic_recver_module_process(void *const module) {
         liteco_link_remove(ur_module->curr_packet);
         pthread_mutex_unlock(&ur_module->mtx);
 
-        quic_recver_handle_packet(module);
+        session->sched_recv_pkts++;
+        quic_recver_handle_datagram(module);
         quic_recv_packet_recovery(ur_module->curr_packet);
         ur_module->curr_packet = NULL;
 
@@ -181,6 +253,11 @@ static quic_err_t quic_recver_module_process(void *const module) {
     }
     pthread_mutex_unlock(&ur_module->mtx);
 
+    // ACKs to send and a congestion window which may have opened, streams waiting for the ACK of their FIN
+    quic_module_activate(session, quic_sender_module);
+    if (liteco_rbt_is_not_nil(s_module->destory_set)) {
+        quic_module_activate(session, quic_stream_module);
+    }
 
     return quic_err_success;
 }
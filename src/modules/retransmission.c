@@ -7,99 +7,106 @@
  */
 
 #include "modules/retransmission.h"
+#include "modules/sender.h"
+#include "modules/framer.h"
+#include "modules/ack_generator.h"
 #include "modules/congestion.h"
 #include "format/header.h"
 #include "utils/time.h"
 #include "session.h"
 
-typedef struct quic_dropped_pkt_s quic_dropped_pkt_t;
-struct quic_dropped_pkt_s {
-    LITECO_LINKNODE_BASE
-
-    quic_sent_packet_rbt_t *pkt;
-};
-
 static quic_err_t quic_retransmission_module_init(void *const module);
 static quic_err_t quic_retransmission_module_loop(void *const module, const uint64_t now);
 static quic_err_t quic_retransmission_module_destory(void *const module);
 
 static quic_err_t quic_retransmission_find_newly_lost(quic_retransmission_module_t *const module);
 static quic_err_t quic_retransmission_find_newly_acked(quic_retransmission_module_t *const module, const quic_frame_ack_t *const frame);
-static quic_err_t quic_retransmission_drop_packet_execute(liteco_linknode_t *const link, liteco_rbt_t **const root);
-
-static inline quic_err_t quic_retransmission_drop_packet(liteco_linknode_t *const link, quic_sent_packet_rbt_t *const pkt) {
-    quic_dropped_pkt_t *const dropped = quic_malloc(sizeof(quic_dropped_pkt_t));
-    if (dropped) {
-        liteco_link_init(dropped);
-        dropped->pkt = pkt;
-        liteco_link_insert_after(link, dropped);
+static quic_err_t quic_retransmission_acked_range(quic_retransmission_module_t *const module, const uint64_t start, const uint64_t end, const uint64_t recv_time, uint64_t *const acked_ack);
+static quic_err_t quic_retransmission_on_pto(quic_retransmission_module_t *const module);
+
+static inline quic_ack_generator_module_t *quic_retransmission_ack_generator(quic_retransmission_module_t *const module) {
+    quic_session_t *const session = quic_module_of_session(module);
+
+    if (module->module_declare == &quic_initial_retransmission_module) {
+        return quic_session_module(session, quic_initial_ack_generator_module);
     }
-    return quic_err_success;
+    if (module->module_declare == &quic_handshake_retransmission_module) {
+        return quic_session_module(session, quic_handshake_ack_generator_module);
+    }
+    return quic_session_module(session, quic_app_ack_generator_module);
 }
 
-static quic_err_t quic_retransmission_drop_packet_execute(liteco_linknode_t *const list, liteco_rbt_t **const root) {
-    while (!liteco_link_empty(list)) {
-        quic_dropped_pkt_t *node = (quic_dropped_pkt_t *) liteco_link_next(list);
-        quic_sent_packet_rbt_t *pkt = node->pkt;
-        liteco_link_remove(node);
-        free(node);
+static quic_err_t quic_retransmission_acked_range(quic_retransmission_module_t *const module, const uint64_t start, const uint64_t end, const uint64_t recv_time, uint64_t *const acked_ack) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
+
+    // only the slots covered by the range are visited
+    uint64_t num = start > module->sent_mem.base ? start : module->sent_mem.base;
+    const uint64_t last = end < module->sent_mem.end ? end : module->sent_mem.end - 1;
+    for (; module->sent_mem.count && num <= last; num++) {
+        quic_sent_packet_t *const pkt = quic_sent_packet_ring_find(&module->sent_mem, num);
+        if (!pkt) {
+            continue;
+        }
+
+        if (pkt->largest_ack > *acked_ack) {
+            *acked_ack = pkt->largest_ack;
+        }
+        if (pkt->included_unacked) {
+            module->unacked_len -= pkt->pkt_len;
+            quic_congestion_on_acked(c_module, quic_retransmission_space(module), pkt->num, pkt->pkt_len, module->unacked_len, recv_time);
+        }
+
+        while (!liteco_link_empty(&pkt->frames)) {
+            quic_frame_t *acked_frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
+            liteco_link_remove(acked_frame);
 
-        liteco_rbt_remove(root, &pkt);
-        free(pkt);
+            if (acked_frame->on_acked) {
+                quic_frame_on_acked(acked_frame);
+            }
+            else {
+                quic_frame_free(acked_frame);
+            }
+        }
+        quic_sent_packet_ring_remove(&module->sent_mem, pkt);
     }
 
     return quic_err_success;
 }
 
 static quic_err_t quic_retransmission_find_newly_acked(quic_retransmission_module_t *const module, const quic_frame_ack_t *const frame) {
-    if (module->dropped) {
+    if (module->dropped || frame->first_range > frame->largest_ack) {
         return quic_err_success;
     }
 
-    quic_session_t *const session = quic_module_of_session(module);
-    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
+    // the largest packet number acknowledged by an ACK frame of ours which the peer has received
+    uint64_t acked_ack = 0;
 
-    quic_sent_packet_rbt_t *pkt = NULL;
-    liteco_linknode_t acked_list;
-
-    liteco_link_init(&acked_list);
-
-    liteco_rbt_foreach(pkt, module->sent_mem) {
-        uint64_t end = frame->largest_ack;
-        uint64_t start = end - frame->first_range;
-
-        bool lost_flag = frame->ranges.count != 0;
-        uint32_t i = 0;
-        do {
-            if (start <= pkt->key && pkt->key <= end) {
-                quic_retransmission_drop_packet(&acked_list, pkt);
-
-                module->sent_pkt_count--;
-                if (pkt->included_unacked) {
-                    module->unacked_len -= pkt->pkt_len;
-                    quic_congestion_on_acked(c_module, pkt->key, pkt->pkt_len, module->unacked_len, frame->recv_time);
-                }
-
-                while (!liteco_link_empty(&pkt->frames)) {
-                    quic_frame_t *acked_frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
-                    liteco_link_remove(acked_frame);
-
-                    if (acked_frame->on_acked) {
-                        quic_frame_on_acked(acked_frame);
-                    }
-                    else {
-                        free(acked_frame);
-                    }
-                }
-            }
+    uint64_t end = frame->largest_ack;
+    uint64_t start = end - frame->first_range;
+    quic_retransmission_acked_range(module, start, end, frame->recv_time, &acked_ack);
 
-            if (lost_flag) {
-                end = start - quic_arr(&frame->ranges, i, quic_ack_range_t)->gap - 2;
-                start = end - quic_arr(&frame->ranges, i, quic_ack_range_t)->len;
-            }
-        } while (++i < frame->ranges.count);
+    uint32_t i;
+    for (i = 0; i < frame->ranges.count && module->sent_mem.count; i++) {
+        const quic_ack_range_t *const range = quic_arr(&frame->ranges, i, quic_ack_range_t);
+        // a malformed range below packet number 0 ends the frame
+        if (start < range->gap + 2 || start - range->gap - 2 < range->len) {
+            break;
+        }
+        end = start - range->gap - 2;
+        start = end - range->len;
+
+        if (end < module->sent_mem.base) {
+            break;
+        }
+        quic_retransmission_acked_range(module, start, end, frame->recv_time, &acked_ack);
+    }
+
+    // the peer knows what that ACK frame reported, those packets are no longer acknowledged
+    if (acked_ack) {
+        quic_ack_generator_set_ignore_threhold(quic_retransmission_ack_generator(module), acked_ack + 1);
     }
-    quic_retransmission_drop_packet_execute(&acked_list, (liteco_rbt_t **) &module->sent_mem);
+
     return quic_err_success;
 }
 
@@ -111,45 +118,93 @@ quic_err_t quic_retransmission_find_newly_lost(quic_retransmission_module_t *con
     quic_session_t *const session = quic_module_of_session(module);
     quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
 
-    liteco_linknode_t lost_list;
-    quic_sent_packet_rbt_t *pkt = NULL;
+    module->loss_time = 0;
+    if (!module->acked) {
+        return quic_err_success;
+    }
 
-    liteco_link_init(&lost_list);
+    // time threshold: 9/8 of the larger of the smoothed and the latest RTT
+    const uint64_t smoothed_rtt = quic_congestion_smoothed_rtt(c_module);
+    const uint64_t latest_rtt = quic_congestion_latest_rtt(c_module);
+    uint64_t lost_delay = smoothed_rtt > latest_rtt ? smoothed_rtt : latest_rtt;
+    lost_delay = (9 * lost_delay) >> 3;
+    lost_delay = lost_delay > QUIC_RETRANSMISSION_GRANULARITY ? lost_delay : QUIC_RETRANSMISSION_GRANULARITY;
+    const uint64_t now = quic_now();
+    const uint64_t lost_send_time = now > lost_delay ? now - lost_delay : 0;
+
+    // only the packets sent before the largest acknowledged one can be lost
+    uint64_t num = module->sent_mem.base;
+    const uint64_t last = module->largest_ack < module->sent_mem.end ? module->largest_ack : module->sent_mem.end - 1;
+    for (; module->sent_mem.count && num <= last; num++) {
+        quic_sent_packet_t *const pkt = quic_sent_packet_ring_find(&module->sent_mem, num);
+        if (!pkt) {
+            continue;
+        }
 
-    module->loss_time = 0;
-    uint64_t max_rtt = quic_congestion_smoothed_rtt(c_module);
-    uint64_t lost_delay = (9 * max_rtt);
-    lost_delay = lost_delay > 1000 ? lost_delay : 1000;
-    lost_delay = 500000 > lost_delay ? 500000 : lost_delay;
-    uint64_t lost_send_time = quic_now() - lost_delay;
-    liteco_rbt_foreach(pkt, module->sent_mem) {
-        if (pkt->sent_time < lost_send_time) {
-            quic_retransmission_drop_packet(&lost_list, pkt);
-
-            module->sent_pkt_count--;
-            if (pkt->included_unacked) {
-                module->unacked_len -= pkt->pkt_len;
-                quic_congestion_on_lost(c_module, pkt->key, pkt->pkt_len, module->unacked_len);
+        if (pkt->sent_time > lost_send_time && num + QUIC_RETRANSMISSION_PACKET_THRESHOLD > module->largest_ack) {
+            // the loss timer fires when the earliest of these packets crosses the time threshold
+            if (!module->loss_time || pkt->sent_time + lost_delay < module->loss_time) {
+                module->loss_time = pkt->sent_time + lost_delay;
             }
+            continue;
+        }
+
+        if (pkt->included_unacked) {
+            module->unacked_len -= pkt->pkt_len;
+            quic_congestion_on_lost(c_module, quic_retransmission_space(module), pkt->num, pkt->pkt_len, module->unacked_len);
+        }
 
-            while (!liteco_link_empty(&pkt->frames)) {
-                quic_frame_t *lost_frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
-                liteco_link_remove(lost_frame);
+        while (!liteco_link_empty(&pkt->frames)) {
+            quic_frame_t *lost_frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
+            liteco_link_remove(lost_frame);
 
-                if (lost_frame->on_lost) {
-                    quic_frame_on_lost(lost_frame);
-                }
-                else {
-                    free(lost_frame);
-                }
+            if (lost_frame->on_lost) {
+                quic_frame_on_lost(lost_frame);
+            }
+            else {
+                quic_frame_free(lost_frame);
             }
         }
-        else if (!module->loss_time || pkt->sent_time + lost_delay < module->loss_time) {
-            module->loss_time = pkt->sent_time + lost_delay;
-            quic_retransmission_update_alarm(module);
+        quic_sent_packet_ring_remove(&module->sent_mem, pkt);
+    }
+    return quic_err_success;
+}
+
+static quic_err_t quic_retransmission_on_pto(quic_retransmission_module_t *const module) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
+
+    module->pto_count++;
+    module->probes = QUIC_RETRANSMISSION_PTO_PROBES;
+
+    // the probes carry new data when there is some, else the data of the oldest packet in flight is sent again.
+    // the packet stays in flight, a PING is sent when it carried nothing worth resending
+    if (!quic_retransmission_empty(module)
+        || (module->module_declare == &quic_app_retransmission_module && !quic_framer_empty(f_module))) {
+        return quic_err_success;
+    }
+    quic_sent_packet_t *const pkt = quic_sent_packet_ring_first(&module->sent_mem);
+    if (!pkt) {
+        return quic_err_success;
+    }
+
+    quic_frame_t *frame = NULL;
+    quic_frame_t *next = NULL;
+    for (frame = (quic_frame_t *) liteco_link_next(&pkt->frames); (liteco_linknode_t *) frame != &pkt->frames; frame = next) {
+        next = (quic_frame_t *) liteco_link_next(frame);
+
+        switch (frame->first_byte) {
+        case quic_frame_padding_type:
+        case quic_frame_ping_type:
+        case quic_frame_ack_type:
+        case quic_frame_ack_ecn_type:
+            break;
+        default:
+            liteco_link_remove(frame);
+            liteco_link_insert_before(&module->retransmission_queue, frame);
         }
     }
-    quic_retransmission_drop_packet_execute(&lost_list, (liteco_rbt_t **) &module->sent_mem);
+
     return quic_err_success;
 }
 
@@ -174,31 +229,73 @@ uint64_t quic_retransmission_append_frame(liteco_linknode_t *const frames, const
     return len;
 }
 
+quic_err_t quic_retransmission_resend_all(quic_retransmission_module_t *const module) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
+
+    if (module->dropped) {
+        return quic_err_success;
+    }
+
+    quic_sent_packet_t *pkt = NULL;
+    quic_sent_packet_ring_foreach(pkt, &module->sent_mem) {
+        while (!liteco_link_empty(&pkt->frames)) {
+            quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
+            liteco_link_remove(frame);
+
+            switch (frame->first_byte) {
+            case quic_frame_padding_type:
+            case quic_frame_ack_type:
+            case quic_frame_ack_ecn_type:
+                quic_frame_free(frame);
+                break;
+            default:
+                liteco_link_insert_before(&module->retransmission_queue, frame);
+            }
+        }
+    }
+    quic_sent_packet_ring_destory(&module->sent_mem);
+
+    // the frames are sent again in new packets, the old ones leave the congestion controller's count
+    quic_congestion_on_discarded(c_module, quic_retransmission_space(module), module->unacked_len);
+    module->unacked_len = 0;
+    module->loss_time = 0;
+    module->acked = false;
+    module->alarm = 0;
+    module->pto_count = 0;
+    module->probes = 0;
+
+    return quic_err_success;
+}
+
 quic_err_t quic_retransmission_drop(quic_retransmission_module_t *const module) {
-    while (liteco_rbt_is_not_nil(module->sent_mem)) {
-        quic_sent_packet_rbt_t *pkt = module->sent_mem;
-        liteco_rbt_remove(&module->sent_mem, &pkt);
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
 
+    quic_sent_packet_t *pkt = NULL;
+    quic_sent_packet_ring_foreach(pkt, &module->sent_mem) {
         while (!liteco_link_empty(&pkt->frames)) {
             quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
             liteco_link_remove(frame);
-            free(frame);
+            quic_frame_free(frame);
         }
-        free(pkt);
     }
+    quic_sent_packet_ring_destory(&module->sent_mem);
     while (!liteco_link_empty(&module->retransmission_queue)) {
         quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&module->retransmission_queue);
         liteco_link_remove(frame);
-        free(frame);
+        quic_frame_free(frame);
     }
 
-    module->sent_pkt_count = 0;
+    quic_congestion_on_discarded(c_module, quic_retransmission_space(module), module->unacked_len);
     module->unacked_len = 0;
     module->max_delay = 0;
     module->loss_time = 0;
     module->last_sent_ack_time = 0;
     module->largest_ack = 0;
+    module->acked = false;
     module->alarm = 0;
+    module->probes = 0;
     module->dropped = true;
     return quic_err_success;
 }
@@ -206,9 +303,7 @@ quic_err_t quic_retransmission_drop(quic_retransmission_module_t *const module)
 static quic_err_t quic_retransmission_module_init(void *const module) {
     quic_retransmission_module_t *const r_module = (quic_retransmission_module_t *) module;
 
-    liteco_rbt_init(r_module->sent_mem);
-
-    r_module->sent_pkt_count = 0;
+    quic_sent_packet_ring_init(&r_module->sent_mem);
     r_module->unacked_len = 0;
 
     r_module->max_delay = 0;
@@ -216,9 +311,11 @@ static quic_err_t quic_retransmission_module_init(void *const module) {
     r_module->loss_time = 0;
     r_module->last_sent_ack_time = 0;
     r_module->largest_ack = 0;
+    r_module->acked = false;
 
     r_module->alarm = 0;
     r_module->pto_count = 0;
+    r_module->probes = 0;
     r_module->dropped = false;
 
     liteco_link_init(&r_module->retransmission_queue);
@@ -234,14 +331,21 @@ static quic_err_t quic_retransmission_module_loop(void *const module, const uint
         return quic_err_success;
     }
     if (now < r_module->alarm) {
-        quic_session_update_loop_deadline(session, r_module->alarm);
+        quic_session_set_deadline(session, quic_retransmission_deadline(r_module), r_module->alarm);
         return quic_err_success;
     }
 
-    if (r_module->unacked_len && r_module->loss_time) {
-        r_module->pto_count++;
+    if (r_module->loss_time) {
+        // the loss timer, packets crossing the time threshold are declared lost
         quic_retransmission_find_newly_lost(r_module);
     }
+    else if (r_module->unacked_len) {
+        // the probe timeout declares nothing lost, it only makes the sender probe
+        quic_retransmission_on_pto(r_module);
+    }
+    // the lost frames and the probes are sent by the sender
+    quic_retransmission_update_alarm(r_module);
+    quic_module_activate(session, quic_sender_module);
 
     return quic_err_success;
 }
@@ -249,10 +353,20 @@ static quic_err_t quic_retransmission_module_loop(void *const module, const uint
 static quic_err_t quic_retransmission_module_destory(void *const module) {
     quic_retransmission_module_t *const r_module = module;
 
+    quic_sent_packet_t *pkt = NULL;
+    quic_sent_packet_ring_foreach(pkt, &r_module->sent_mem) {
+        while (!liteco_link_empty(&pkt->frames)) {
+            quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
+            liteco_link_remove(frame);
+            quic_frame_free(frame);
+        }
+    }
+    quic_sent_packet_ring_destory(&r_module->sent_mem);
+
     while (!liteco_link_empty(&r_module->retransmission_queue)) {
         quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&r_module->retransmission_queue);
         liteco_link_remove(frame);
-        free(frame);
+        quic_frame_free(frame);
     }
 
     return quic_err_success;
@@ -310,16 +424,17 @@ quic_err_t quic_session_handle_ack_frame(quic_session_t *const session, const qu
         return quic_err_success;
     }
 
-    r_module->largest_ack = r_module->largest_ack > ack_frame->largest_ack ? r_module->largest_ack : ack_frame->largest_ack;
+    if (!r_module->acked || r_module->largest_ack < ack_frame->largest_ack) {
+        r_module->largest_ack = ack_frame->largest_ack;
+    }
+    r_module->acked = true;
 
-    quic_sent_packet_rbt_t *pkt = liteco_rbt_find(r_module->sent_mem, &ack_frame->largest_ack);
-    if (liteco_rbt_is_not_nil(pkt)) {
+    quic_sent_packet_t *const pkt = quic_sent_packet_ring_find(&r_module->sent_mem, ack_frame->largest_ack);
+    if (pkt) {
         uint64_t delay = 0;
         if (ack_frame->packet_type == quic_packet_short_type) {
+            // the peer never delays longer than it promised, larger values are not trusted
             delay = ack_frame->delay < r_module->max_delay ? ack_frame->delay : r_module->max_delay;
-            if (delay > r_module->max_delay) {
-                r_module->max_delay = delay;
-            }
         }
 
         quic_congestion_update(c_module, ack_frame->recv_time, pkt->sent_time, delay);
@@ -328,8 +443,14 @@ quic_err_t quic_session_handle_ack_frame(quic_session_t *const session, const qu
     quic_retransmission_find_newly_acked(r_module, ack_frame);
     quic_retransmission_find_newly_lost(r_module);
 
+    // an acknowledgement ends the probing
     r_module->pto_count = 0;
+    r_module->probes = 0;
     quic_retransmission_update_alarm(r_module);
 
+    if (ack_frame->packet_type == quic_packet_short_type) {
+        quic_ack_generator_tune_peer(quic_session_module(session, quic_app_ack_generator_module));
+    }
+
     return quic_err_success;
 }
@@ -14,35 +14,41 @@
 #include "modules/congestion.h"
 #include "module.h"
 #include "session.h"
+#include "utils/sent_packet_ring.h"
 #include "liteco.h"
 
-typedef struct quic_sent_packet_rbt_s quic_sent_packet_rbt_t;
-struct quic_sent_packet_rbt_s {
-    LITECO_RBT_KEY_UINT64_FIELDS
+// a packet is lost once a packet sent this many packet numbers after it has been acknowledged (kPacketThreshold)
+#ifndef QUIC_RETRANSMISSION_PACKET_THRESHOLD
+#define QUIC_RETRANSMISSION_PACKET_THRESHOLD 3
+#endif
 
-    uint64_t largest_ack;
-    uint64_t sent_time;
-    uint32_t pkt_len;
-    bool included_unacked;
-    liteco_linknode_t frames;
-};
+// ack-eliciting packets sent by a space when its probe timeout fires
+#ifndef QUIC_RETRANSMISSION_PTO_PROBES
+#define QUIC_RETRANSMISSION_PTO_PROBES 2
+#endif
+
+// timer granularity (us), the loss delay is never shorter
+#define QUIC_RETRANSMISSION_GRANULARITY 1000
 
 typedef struct quic_retransmission_module_s quic_retransmission_module_t;
 struct quic_retransmission_module_s {
     QUIC_MODULE_FIELDS
 
-    quic_sent_packet_rbt_t *sent_mem;
-    uint32_t sent_pkt_count;
+    quic_sent_packet_ring_t sent_mem;
     uint32_t unacked_len;
 
+    // us, the longest the peer may delay an ACK of this space, part of the probe timeout
     uint64_t max_delay;
 
     uint64_t loss_time;
     uint64_t last_sent_ack_time;
     uint64_t largest_ack;
+    bool acked;
 
     uint64_t alarm;
     uint32_t pto_count;
+    // probe packets the sender still owes after a probe timeout, they are sent ignoring the congestion window
+    uint8_t probes;
     bool dropped;
 
     liteco_linknode_t retransmission_queue;
@@ -55,6 +61,12 @@ extern quic_module_t quic_app_retransmission_module;
 uint64_t quic_retransmission_append_frame(liteco_linknode_t *const frames, const uint64_t capa, quic_retransmission_module_t *const module);
 quic_err_t quic_retransmission_drop(quic_retransmission_module_t *const module);
 
+/*
+ * give up every packet in flight without a congestion event and queue their frames to be sent again,
+ * except ACK and PADDING frames (the Initial packets of a client which were answered by a Retry)
+ */
+quic_err_t quic_retransmission_resend_all(quic_retransmission_module_t *const module);
+
 __quic_header_inline bool quic_retransmission_empty(quic_retransmission_module_t *const module) {
     return liteco_link_empty(&module->retransmission_queue);
 }
@@ -68,6 +80,26 @@ __quic_header_inline quic_err_t quic_retransmission_frame_insert(quic_retransmis
     return quic_err_success;
 }
 
+__quic_header_inline quic_session_deadline_t quic_retransmission_deadline(quic_retransmission_module_t *const module) {
+    if (module->module_declare == &quic_initial_retransmission_module) {
+        return quic_session_deadline_initial_pto;
+    }
+    if (module->module_declare == &quic_handshake_retransmission_module) {
+        return quic_session_deadline_handshake_pto;
+    }
+    return quic_session_deadline_app_pto;
+}
+
+__quic_header_inline quic_space_t quic_retransmission_space(quic_retransmission_module_t *const module) {
+    if (module->module_declare == &quic_initial_retransmission_module) {
+        return quic_space_initial;
+    }
+    if (module->module_declare == &quic_handshake_retransmission_module) {
+        return quic_space_handshake;
+    }
+    return quic_space_app;
+}
+
 __quic_header_inline quic_err_t quic_retransmission_update_alarm(quic_retransmission_module_t *const module) {
     if (module->dropped) {
         return quic_err_success;
@@ -76,34 +108,59 @@ __quic_header_inline quic_err_t quic_retransmission_update_alarm(quic_retransmis
     quic_session_t *const session = quic_module_of_session(module);
     quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
 
+    // the loss timer takes precedence over the probe timeout
+    if (module->loss_time) {
+        module->alarm = module->loss_time;
+        quic_session_set_deadline(session, quic_retransmission_deadline(module), module->alarm);
+        return quic_err_success;
+    }
+
     if (!module->unacked_len) {
         module->alarm = 0;
+        quic_session_set_deadline(session, quic_retransmission_deadline(module), 0);
         return quic_err_success;
     }
 
     module->alarm = module->last_sent_ack_time + (quic_congestion_pto(c_module, module->max_delay) << module->pto_count);
 
-    quic_session_update_loop_deadline(session, module->alarm);
+    quic_session_set_deadline(session, quic_retransmission_deadline(module), module->alarm);
 
     return quic_err_success;
 }
 
-__quic_header_inline quic_err_t quic_retransmission_sent_mem_push(quic_retransmission_module_t *const module, quic_sent_packet_rbt_t *const pkt) {
-    if (module->dropped) {
+// only the application data space has a max_ack_delay, the peer acknowledges handshake packets at once
+__quic_header_inline quic_err_t quic_retransmission_max_delay(quic_retransmission_module_t *const module, const uint64_t max_delay) {
+    if (module->dropped || module->max_delay == max_delay) {
         return quic_err_success;
     }
-    
-    liteco_rbt_insert(&module->sent_mem, pkt);
-    module->sent_pkt_count++;
+    module->max_delay = max_delay;
+
+    return quic_retransmission_update_alarm(module);
+}
+
+// the caller moves the frames of the packet into the returned slot, NULL when the space has been dropped
+__quic_header_inline quic_sent_packet_t *quic_retransmission_sent_mem_push(quic_retransmission_module_t *const module,
+                                                                          const uint64_t num, const uint64_t sent_time, const uint32_t pkt_len, const bool included_unacked) {
+    if (module->dropped) {
+        return NULL;
+    }
 
-    if (pkt->included_unacked) {
-        module->last_sent_ack_time = pkt->sent_time;
-        module->unacked_len += pkt->pkt_len;
+    quic_sent_packet_t *const pkt = quic_sent_packet_ring_push(&module->sent_mem, num);
+    if (!pkt) {
+        return NULL;
+    }
+    pkt->sent_time = sent_time;
+    pkt->pkt_len = pkt_len;
+    pkt->included_unacked = included_unacked;
+
+    if (included_unacked) {
+        module->last_sent_ack_time = sent_time;
+        module->unacked_len += pkt_len;
 
         quic_retransmission_update_alarm(module);
     }
 
-    return quic_err_success;
+    return pkt;
 }
 
 #endif
@@ -10,12 +10,18 @@
 #include "format/header.h"
 #include "modules/sealer.h"
 #include "session.h"
+#include "utils/time.h"
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 #include <openssl/pem.h>
 #include <openssl/bio.h>
 #include <openssl/hkdf.h>
 #include <openssl/digest.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <openssl/mem.h>
+#include <sys/stat.h>
 
 #define QUIC_DEFAULT_TLE_CIPHERS                     \
     "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384:" \
@@ -25,6 +31,7 @@
 
 static quic_err_t quic_sealer_module_init(void *const module);
 static quic_err_t quic_sealer_module_start(void *const module);
+static quic_err_t quic_sealer_module_process(void *const module);
 static quic_err_t quic_sealer_module_destory(void *const module);
 
 static quic_err_t quic_sealer_destory(quic_sealer_t *const sealer);
@@ -38,13 +45,47 @@ static int quic_sealer_flush_flight(SSL *ssl);
 static int quic_sealer_send_alert(SSL *ssl, enum ssl_encryption_level_t level, uint8_t alert);
 static int quic_sealer_alpn_select_proto_cb(SSL *ssl, const uint8_t **out, uint8_t *outlen, const uint8_t *in, uint32_t inlen, void *arg);
 static enum ssl_verify_result_t quic_sealer_custom_verify(SSL *ssl, uint8_t *const alert);
-static inline int quic_sealer_set_chains_and_key(quic_sealer_module_t *const module, const char *const chain_file, const char *const key_file);
+static inline quic_err_t quic_sealer_set_chains_and_key(SSL_CTX *const ssl_ctx, const char *const chain_file, const char *const key_file, EVP_PKEY **const offload_pkey);
 static inline quic_err_t quic_sealer_set_key_iv(quic_buf_t *const key, quic_buf_t *const iv, const EVP_MD *const prf, const uint8_t *secret, size_t secret_len);
 static inline quic_err_t quic_sealer_hkdf_expand_label(uint8_t *out, const size_t outlen, const EVP_MD *prf, const uint8_t *secret, size_t secret_len, const uint8_t *label, size_t label_size);
 static quic_err_t quic_sealer_process_transport_parameters(quic_sealer_module_t *const module);
 static quic_err_t quic_sealer_process_peer_transport_parameters(quic_sealer_module_t *const module);
 
 static quic_err_t quic_sealer_module_openssl_start(quic_sealer_module_t *const module);
+static SSL_CTX *quic_sealer_ssl_ctx_new(const quic_config_t *const cfg);
+static inline bool quic_tls_ctx_file_mtime(const char *const file, struct timespec *const mtime);
+static int quic_sealer_new_session_cb(SSL *ssl, SSL_SESSION *session);
+static inline quic_err_t quic_sealer_set_early_data_context(quic_sealer_module_t *const module);
+
+static quic_err_t quic_tls_ticket_key_generate(quic_tls_ticket_key_t *const key, const uint64_t now);
+static void quic_tls_ctx_rotate_ticket_keys(quic_tls_ctx_t *const tls_ctx, const uint64_t now);
+static int quic_tls_ctx_ticket_key_cb(SSL *ssl, uint8_t *key_name, uint8_t *iv, EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *hmac_ctx, int encrypt);
+static enum ssl_select_cert_result_t quic_tls_ctx_select_certificate_cb(const SSL_CLIENT_HELLO *client_hello);
+
+static enum ssl_private_key_result_t quic_sealer_private_key_sign(SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out, uint16_t sigalg, const uint8_t *in, size_t in_len);
+static enum ssl_private_key_result_t quic_sealer_private_key_decrypt(SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out, const uint8_t *in, size_t in_len);
+static enum ssl_private_key_result_t quic_sealer_private_key_complete(SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out);
+static void quic_sealer_key_op_run(quic_offload_job_t *const job);
+static void quic_sealer_key_op_done(quic_offload_job_t *const job);
+
+/*
+ * a private key operation of a session, handed to the offload pool. the module forgets it when the session
+ * goes away before it is done, then it is freed by quic_sealer_key_op_done
+ */
+struct quic_sealer_key_op_s {
+    quic_offload_job_t job;
+
+    quic_sealer_module_t *module;
+    EVP_PKEY *pkey;
+    uint16_t sigalg;
+
+    bool finished;
+    bool success;
+    size_t in_len;
+    size_t out_len;
+    uint8_t *out;
+    uint8_t in[0];
+};
 
 static inline quic_err_t quic_sealer_initial_compute_security(quic_buf_t *const cli_sec, quic_buf_t *const ser_sec, const quic_buf_t connid);
 static inline quic_err_t quic_sealer_set_header_simple(quic_header_protector_t *const hdr_p, const uint8_t *const simple, const uint32_t simple_len);
@@ -58,6 +99,12 @@ static const uint16_t quic_signalg[] = {
     SSL_SIGN_RSA_PKCS1_SHA256,
 };
 
+static const SSL_PRIVATE_KEY_METHOD quic_sealer_private_key_method = {
+    quic_sealer_private_key_sign,
+    quic_sealer_private_key_decrypt,
+    quic_sealer_private_key_complete
+};
+
 static SSL_QUIC_METHOD ssl_quic_method = {
     quic_sealer_set_read_secret,
     quic_sealer_set_write_secret,
@@ -165,7 +212,7 @@ static int quic_sealer_set_read_secret(SSL *ssl, enum ssl_encryption_level_t lev
         sealer = &s_module->app_sealer;
         break;
     case ssl_encryption_early_data:
-        // ignore early data
+        sealer = &s_module->early_sealer;
         break;
     }
     if (sealer == NULL) {
@@ -175,7 +222,10 @@ static int quic_sealer_set_read_secret(SSL *ssl, enum ssl_encryption_level_t lev
     sealer->r_sec.capa = secret_len;
     memcpy(sealer->r_sec.buf, secret, secret_len);
     quic_buf_setpl(&sealer->r_sec);
-    s_module->r_level = level;
+    // no CRYPTO frames are carried by 0-RTT packets
+    if (level != ssl_encryption_early_data) {
+        s_module->r_level = level;
+    }
 
     switch (cipher_id) {
     case TLS1_CK_AES_128_GCM_SHA256:
@@ -228,7 +278,7 @@ static int quic_sealer_set_write_secret(SSL *ssl, enum ssl_encryption_level_t le
         sealer = &s_module->app_sealer;
         break;
     case ssl_encryption_early_data:
-        // ignore early data
+        sealer = &s_module->early_sealer;
         break;
     }
     if (sealer == NULL) {
@@ -238,7 +288,9 @@ static int quic_sealer_set_write_secret(SSL *ssl, enum ssl_encryption_level_t le
     sealer->w_sec.capa = secret_len;
     memcpy(sealer->w_sec.buf, secret, secret_len);
     quic_buf_setpl(&sealer->w_sec);
-    s_module->w_level = level;
+    if (level != ssl_encryption_early_data) {
+        s_module->w_level = level;
+    }
 
     switch (cipher_id) {
     case TLS1_CK_AES_128_GCM_SHA256:
@@ -282,11 +334,11 @@ static int quic_sealer_write_handshake_data(SSL *ssl, enum ssl_encryption_level_
     switch (level) {
     case ssl_encryption_initial:
         quic_sorter_append(&s_module->initial_w_sorter, len, data);
-        quic_module_activate(session, quic_sealer_module);
+        quic_module_activate(session, quic_sender_module);
         break;
     case ssl_encryption_handshake:
         quic_sorter_append(&s_module->handshake_w_sorter, len, data);
-        quic_module_activate(session, quic_sealer_module);
+        quic_module_activate(session, quic_sender_module);
         break;
     default:
         break;
@@ -319,7 +371,7 @@ static int quic_sealer_alpn_select_proto_cb(SSL *ssl, const uint8_t **out, uint8
     return SSL_TLSEXT_ERR_OK;
 }
 
-static inline int quic_sealer_set_chains_and_key(quic_sealer_module_t *const module, const char *const chain_file, const char *const key_file) {
+static inline quic_err_t quic_sealer_set_chains_and_key(SSL_CTX *const ssl_ctx, const char *const chain_file, const char *const key_file, EVP_PKEY **const offload_pkey) {
     if (!chain_file || !key_file) {
         return quic_err_success;
     }
@@ -330,7 +382,11 @@ static inline int quic_sealer_set_chains_and_key(quic_sealer_module_t *const mod
     uint8_t *data = NULL;
     long data_len = 0;
 
+    if (!chain_bio) {
+        return quic_err_internal_error;
+    }
     if (!PEM_read_bio(chain_bio, &name, &header, &data, &data_len)) {
+        BIO_free(chain_bio);
         return quic_err_internal_error;
     }
     OPENSSL_free(name);
@@ -343,13 +399,153 @@ static inline int quic_sealer_set_chains_and_key(quic_sealer_module_t *const mod
     BIO_free(chain_bio);
 
     BIO * pkey_bio = BIO_new_file(key_file, "r");
-    EVP_PKEY *pkey = PEM_read_bio_PrivateKey(pkey_bio, NULL, NULL, NULL);
+    EVP_PKEY *pkey = pkey_bio ? PEM_read_bio_PrivateKey(pkey_bio, NULL, NULL, NULL) : NULL;
     BIO_free(pkey_bio);
 
-    if (!SSL_CTX_set_chain_and_key(module->ssl_ctx, &chain_buffer, 1, pkey, NULL)) {
-        return quic_err_success;
+    quic_err_t err = quic_err_success;
+    if (offload_pkey) {
+        // the key type is taken from the leaf certificate, signing goes through quic_sealer_private_key_method
+        if (!pkey || !SSL_CTX_set_chain_and_key(ssl_ctx, &chain_buffer, 1, NULL, &quic_sealer_private_key_method)) {
+            err = quic_err_internal_error;
+        }
+        else {
+            *offload_pkey = pkey;
+            pkey = NULL;
+        }
+    }
+    else if (!pkey || !SSL_CTX_set_chain_and_key(ssl_ctx, &chain_buffer, 1, pkey, NULL) || !SSL_CTX_check_private_key(ssl_ctx)) {
+        err = quic_err_internal_error;
+    }
+    CRYPTO_BUFFER_free(chain_buffer);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
+
+static enum ssl_private_key_result_t quic_sealer_private_key_sign(SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out, uint16_t sigalg, const uint8_t *in, size_t in_len) {
+    (void) out;
+    (void) out_len;
+    quic_sealer_module_t *const module = SSL_get_app_data(ssl);
+    quic_session_t *const session = quic_module_of_session(module);
+
+    if (!module->pkey || !session->cfg.tls_offload || module->key_op) {
+        return ssl_private_key_failure;
+    }
+
+    quic_sealer_key_op_t *const op = quic_malloc(sizeof(quic_sealer_key_op_t) + in_len + max_out);
+    if (!op) {
+        return ssl_private_key_failure;
+    }
+    op->job.run = quic_sealer_key_op_run;
+    op->job.done = quic_sealer_key_op_done;
+    op->module = module;
+    op->pkey = module->pkey;
+    EVP_PKEY_up_ref(op->pkey);
+    op->sigalg = sigalg;
+    op->finished = false;
+    op->success = false;
+    op->in_len = in_len;
+    op->out_len = max_out;
+    op->out = op->in + in_len;
+    memcpy(op->in, in, in_len);
+
+    if (quic_offload_submit(session->cfg.tls_offload, &op->job) != quic_err_success) {
+        EVP_PKEY_free(op->pkey);
+        quic_free(op);
+        return ssl_private_key_failure;
+    }
+    module->key_op = op;
+
+    return ssl_private_key_retry;
+}
+
+static enum ssl_private_key_result_t quic_sealer_private_key_decrypt(SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out, const uint8_t *in, size_t in_len) {
+    (void) ssl;
+    (void) out;
+    (void) out_len;
+    (void) max_out;
+    (void) in;
+    (void) in_len;
+
+    // RSA key exchange does not exist in TLS 1.3
+    return ssl_private_key_failure;
+}
+
+static enum ssl_private_key_result_t quic_sealer_private_key_complete(SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out) {
+    quic_sealer_module_t *const module = SSL_get_app_data(ssl);
+    quic_sealer_key_op_t *const op = module->key_op;
+
+    if (!op) {
+        return ssl_private_key_failure;
+    }
+    if (!op->finished) {
+        return ssl_private_key_retry;
+    }
+    module->key_op = NULL;
+
+    enum ssl_private_key_result_t result = ssl_private_key_failure;
+    if (op->success && op->out_len <= max_out) {
+        memcpy(out, op->out, op->out_len);
+        *out_len = op->out_len;
+        result = ssl_private_key_success;
+    }
+    EVP_PKEY_free(op->pkey);
+    quic_free(op);
+
+    return result;
+}
+
+static void quic_sealer_key_op_run(quic_offload_job_t *const job) {
+    quic_sealer_key_op_t *const op = (quic_sealer_key_op_t *) job;
+    EVP_PKEY_CTX *pctx = NULL;
+    EVP_MD_CTX ctx;
+
+    EVP_MD_CTX_init(&ctx);
+    op->success = EVP_DigestSignInit(&ctx, &pctx, SSL_get_signature_algorithm_digest(op->sigalg), NULL, op->pkey)
+        && (!SSL_is_signature_algorithm_rsa_pss(op->sigalg)
+            || (EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) && EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1)))
+        && EVP_DigestSign(&ctx, op->out, &op->out_len, op->in, op->in_len);
+    EVP_MD_CTX_cleanup(&ctx);
+}
+
+static void quic_sealer_key_op_done(quic_offload_job_t *const job) {
+    quic_sealer_key_op_t *const op = (quic_sealer_key_op_t *) job;
+
+    op->finished = true;
+    if (!op->module) {
+        EVP_PKEY_free(op->pkey);
+        quic_free(op);
+        return;
+    }
+
+    // resume the handshake on the session coroutine
+    quic_module_activate(quic_module_of_session(op->module), quic_sealer_module);
+}
+
+static int quic_sealer_new_session_cb(SSL *ssl, SSL_SESSION *session) {
+    quic_sealer_module_t *const module = SSL_get_app_data(ssl);
+    const quic_config_t *const cfg = &quic_module_of_session(module)->cfg;
+
+    if (!cfg->tls_ticket_cache || !cfg->tls_server_name) {
+        return 0;
+    }
+
+    // the cache takes the reference
+    return quic_tls_ticket_cache_put(cfg->tls_ticket_cache, cfg->tls_server_name, session) == quic_err_success;
+}
+
+static inline quic_err_t quic_sealer_set_early_data_context(quic_sealer_module_t *const module) {
+    const quic_config_t *const cfg = &quic_module_of_session(module)->cfg;
+
+    // 0-RTT data is accepted only if the limits the ticket was issued under still hold
+    const uint64_t context[] = {
+        cfg->stream_flowctrl_initial_rwnd,
+        cfg->conn_flowctrl_initial_rwnd,
+        cfg->active_connid_count,
+    };
+    if (!SSL_set_quic_early_data_context(module->ssl, (const uint8_t *) context, sizeof(context))) {
+        return quic_err_internal_error;
     }
-    SSL_CTX_check_private_key(module->ssl_ctx);
 
     return quic_err_success;
 }
@@ -406,6 +602,9 @@ static quic_err_t quic_sealer_module_init(void *const module) {
     s_module->transport_parameter_processed = false;
     s_module->ssl_ctx = NULL;
     s_module->ssl = NULL;
+    s_module->pkey = NULL;
+    s_module->key_op = NULL;
+    s_module->ticket_verified = false;
 
     s_module->tls_alert = 0;
     s_module->off = 0;
@@ -417,6 +616,7 @@ static quic_err_t quic_sealer_module_init(void *const module) {
     quic_sealer_init(&s_module->app_sealer);
     quic_sealer_init(&s_module->handshake_sealer);
     quic_sealer_init(&s_module->initial_sealer);
+    quic_sealer_init(&s_module->early_sealer);
 
     quic_sorter_init(&s_module->initial_r_sorter);
     quic_sorter_init(&s_module->initial_w_sorter);
@@ -428,58 +628,76 @@ static quic_err_t quic_sealer_module_init(void *const module) {
     return quic_err_success;
 }
 
-static quic_err_t quic_sealer_module_openssl_start(quic_sealer_module_t *const module) {
-    quic_session_t *const session = quic_module_of_session(module);
+static SSL_CTX *quic_sealer_ssl_ctx_new(const quic_config_t *const cfg) {
+    SSL_CTX *const ssl_ctx = SSL_CTX_new(TLS_with_buffers_method());
+    if (!ssl_ctx) {
+        return NULL;
+    }
 
-    if (session->cfg.is_cli) {
-        module->ssl_ctx = SSL_CTX_new(TLS_with_buffers_method());
-        SSL_CTX_set_session_cache_mode(module->ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
-        SSL_CTX_set_allow_unknown_alpn_protos(module->ssl_ctx, 1);
-        SSL_CTX_set_custom_verify(module->ssl_ctx, 0, quic_sealer_custom_verify);
+    if (cfg->is_cli) {
+        SSL_CTX_set_session_cache_mode(ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_set_allow_unknown_alpn_protos(ssl_ctx, 1);
+        SSL_CTX_set_custom_verify(ssl_ctx, 0, quic_sealer_custom_verify);
+        SSL_CTX_sess_set_new_cb(ssl_ctx, quic_sealer_new_session_cb);
     }
     else {
-        module->ssl_ctx = SSL_CTX_new(TLS_with_buffers_method());
-        SSL_CTX_set_options(module->ssl_ctx, (SSL_OP_ALL & ~SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS) | SSL_OP_SINGLE_ECDH_USE | SSL_OP_CIPHER_SERVER_PREFERENCE);
-        SSL_CTX_set_mode(module->ssl_ctx, SSL_MODE_RELEASE_BUFFERS);
+        SSL_CTX_set_options(ssl_ctx, (SSL_OP_ALL & ~SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS) | SSL_OP_SINGLE_ECDH_USE | SSL_OP_CIPHER_SERVER_PREFERENCE);
+        SSL_CTX_set_mode(ssl_ctx, SSL_MODE_RELEASE_BUFFERS);
 
-        SSL_CTX_set_alpn_select_cb(module->ssl_ctx, quic_sealer_alpn_select_proto_cb, NULL);
+        SSL_CTX_set_alpn_select_cb(ssl_ctx, quic_sealer_alpn_select_proto_cb, NULL);
     }
 
-    SSL_CTX_set_quic_method(module->ssl_ctx, &ssl_quic_method);
-
-    SSL_CTX_set_session_id_context(module->ssl_ctx, session->dst.buf, quic_buf_size(&session->dst));
+    SSL_CTX_set_quic_method(ssl_ctx, &ssl_quic_method);
 
-    SSL_CTX_set_min_proto_version(module->ssl_ctx, TLS1_3_VERSION);
-    SSL_CTX_set_max_proto_version(module->ssl_ctx, TLS1_3_VERSION);
+    SSL_CTX_set_min_proto_version(ssl_ctx, TLS1_3_VERSION);
+    SSL_CTX_set_max_proto_version(ssl_ctx, TLS1_3_VERSION);
 
-    SSL_CTX_set_verify_algorithm_prefs(module->ssl_ctx, quic_signalg, sizeof(quic_signalg) / sizeof(uint16_t));
+    SSL_CTX_set_verify_algorithm_prefs(ssl_ctx, quic_signalg, sizeof(quic_signalg) / sizeof(uint16_t));
 
-    if (session->cfg.tls_ciphers) {
-        SSL_CTX_set_cipher_list(module->ssl_ctx, session->cfg.tls_ciphers);
+    if (cfg->tls_ciphers) {
+        SSL_CTX_set_cipher_list(ssl_ctx, cfg->tls_ciphers);
     }
     else {
-        SSL_CTX_set_cipher_list(module->ssl_ctx, QUIC_DEFAULT_TLE_CIPHERS);
+        SSL_CTX_set_cipher_list(ssl_ctx, QUIC_DEFAULT_TLE_CIPHERS);
     }
-    if (session->cfg.tls_curve_groups) {
-        SSL_CTX_set1_curves_list(module->ssl_ctx, session->cfg.tls_curve_groups);
+    if (cfg->tls_curve_groups) {
+        SSL_CTX_set1_curves_list(ssl_ctx, cfg->tls_curve_groups);
     }
     else {
-        SSL_CTX_set1_curves_list(module->ssl_ctx, QUIC_DEFAULT_CURVE_GROUPS);
+        SSL_CTX_set1_curves_list(ssl_ctx, QUIC_DEFAULT_CURVE_GROUPS);
     }
 
-    if (session->cfg.tls_verify_client_ca) {
-        STACK_OF(X509_NAME) *certs = SSL_load_client_CA_file(session->cfg.tls_verify_client_ca);
-        SSL_CTX_set_client_CA_list(module->ssl_ctx, certs);
+    if (cfg->tls_verify_client_ca) {
+        STACK_OF(X509_NAME) *certs = SSL_load_client_CA_file(cfg->tls_verify_client_ca);
+        SSL_CTX_set_client_CA_list(ssl_ctx, certs);
     }
 
-    quic_sealer_set_chains_and_key(module, session->cfg.tls_cert_chain_file, session->cfg.tls_key_file);
-
     int i;
-    for (i = 0; session->cfg.tls_ca && session->cfg.tls_ca[i]; i++) {
-        SSL_CTX_load_verify_locations(module->ssl_ctx, session->cfg.tls_ca[i], NULL);
+    for (i = 0; cfg->tls_ca && cfg->tls_ca[i]; i++) {
+        SSL_CTX_load_verify_locations(ssl_ctx, cfg->tls_ca[i], NULL);
     }
-    for (i = 0; session->cfg.tls_capath && session->cfg.tls_capath[i]; i++) {
-        SSL_CTX_load_verify_locations(module->ssl_ctx, NULL, session->cfg.tls_capath[i]);
+    for (i = 0; cfg->tls_capath && cfg->tls_capath[i]; i++) {
+        SSL_CTX_load_verify_locations(ssl_ctx, NULL, cfg->tls_capath[i]);
+    }
+
+    return ssl_ctx;
+}
+
+static quic_err_t quic_sealer_module_openssl_start(quic_sealer_module_t *const module) {
+    quic_session_t *const session = quic_module_of_session(module);
+
+    if (session->cfg.tls_ctx) {
+        module->ssl_ctx = quic_tls_ctx_acquire(session->cfg.tls_ctx, &module->pkey);
+    }
+    else {
+        module->ssl_ctx = quic_sealer_ssl_ctx_new(&session->cfg);
+        if (module->ssl_ctx) {
+            SSL_CTX_set_session_id_context(module->ssl_ctx, session->dst.buf, quic_buf_size(&session->dst));
+            quic_sealer_set_chains_and_key(module->ssl_ctx, session->cfg.tls_cert_chain_file, session->cfg.tls_key_file, NULL);
+        }
+    }
+    if (!module->ssl_ctx) {
+        return quic_err_internal_error;
     }
 
     module->ssl = SSL_new(module->ssl_ctx);
@@ -489,12 +707,28 @@ static quic_err_t quic_sealer_module_openssl_start(quic_sealer_module_t *const m
         static const uint8_t H3_ALPN[] = "\x5h3-29\x5h3-30\x5h3-31\x5h3-32";
         SSL_set_alpn_protos(module->ssl, H3_ALPN, sizeof(H3_ALPN) - 1);
 
+        if (session->cfg.tls_server_name) {
+            SSL_set_tlsext_host_name(module->ssl, session->cfg.tls_server_name);
+        }
+        if (session->cfg.tls_ticket_cache && session->cfg.tls_server_name) {
+            SSL_SESSION *const ticket = quic_tls_ticket_cache_take(session->cfg.tls_ticket_cache, session->cfg.tls_server_name);
+            if (ticket) {
+                SSL_set_session(module->ssl, ticket);
+                SSL_SESSION_free(ticket);
+            }
+        }
+        SSL_set_early_data_enabled(module->ssl, session->cfg.tls_early_data);
+
         quic_sealer_process_transport_parameters(module);
 
         SSL_set_connect_state(module->ssl);
         quic_sealer_handshake_process(module);
     }
     else {
+        if (session->cfg.tls_early_data) {
+            SSL_set_early_data_enabled(module->ssl, 1);
+            quic_sealer_set_early_data_context(module);
+        }
         SSL_set_accept_state(module->ssl);
 
         quic_sealer_process_transport_parameters(module);
@@ -503,16 +737,15 @@ static quic_err_t quic_sealer_module_openssl_start(quic_sealer_module_t *const m
     return quic_err_success;
 }
 
-static quic_err_t quic_sealer_module_start(void *const module) {
-    quic_sealer_module_t *const s_module = module;
-    quic_session_t *const session = quic_module_of_session(module);
+static quic_err_t quic_sealer_initial_setup(quic_sealer_module_t *const s_module) {
+    quic_session_t *const session = quic_module_of_session(s_module);
     quic_buf_t cli_sec;
     quic_buf_t ser_sec;
 
     quic_buf_init(&cli_sec);
     quic_buf_init(&ser_sec);
 
-    quic_sealer_initial_compute_security(&cli_sec, &ser_sec, session->cfg.is_cli ? session->dst : session->src);
+    quic_sealer_initial_compute_security(&cli_sec, &ser_sec, session->cfg.is_cli ? session->dst : session->initial_dst);
 
     s_module->initial_sealer.r_aead = EVP_aead_aes_256_gcm_tls13;
     s_module->initial_sealer.w_aead = EVP_aead_aes_256_gcm_tls13;
@@ -560,11 +793,70 @@ static quic_err_t quic_sealer_module_start(void *const module) {
     quic_sealer_set_header_protector(&s_module->initial_sealer.r_hp, TLS1_CK_AES_256_GCM_SHA384,
                                      s_module->initial_sealer.r_sec.pos, quic_buf_size(&s_module->initial_sealer.r_sec));
 
+    return quic_err_success;
+}
+
+static quic_err_t quic_sealer_module_start(void *const module) {
+    if (quic_sealer_initial_setup(module) != quic_err_success) {
+        return quic_err_internal_error;
+    }
     quic_sealer_module_openssl_start(module);
 
     return quic_err_success;
 }
 
+quic_err_t quic_sealer_retry(quic_sealer_module_t *const module) {
+    quic_sealer_destory(&module->initial_sealer);
+    quic_sealer_init(&module->initial_sealer);
+
+    return quic_sealer_initial_setup(module);
+}
+
+quic_err_t quic_sealer_retry_integrity_tag(uint8_t *const tag, const quic_buf_t original_dst, const uint8_t *const retry, const size_t len) {
+    static const uint8_t key[16] = {
+        0xbe, 0x0c, 0x69, 0x0b, 0x9f, 0x66, 0x57, 0x5a, 0x1d, 0x76, 0x6b, 0x54, 0xe3, 0x68, 0xc8, 0x4e
+    };
+    static const uint8_t nonce[12] = {
+        0x46, 0x15, 0x99, 0xd3, 0x5d, 0x63, 0x2b, 0xf2, 0x23, 0x98, 0x25, 0xbb
+    };
+    uint8_t pseudo[QUIC_SEALER_RETRY_PSEUDO_MAX_SIZE];
+    const size_t pseudo_len = 1 + quic_buf_size(&original_dst) + len;
+    size_t tag_len = 0;
+    EVP_AEAD_CTX ctx;
+
+    if (pseudo_len > sizeof(pseudo)) {
+        return quic_err_bad_format;
+    }
+
+    // Retry Pseudo-Packet: the original destination connection id prepended to the Retry packet without its tag
+    pseudo[0] = quic_buf_size(&original_dst);
+    memcpy(pseudo + 1, original_dst.pos, quic_buf_size(&original_dst));
+    memcpy(pseudo + 1 + quic_buf_size(&original_dst), retry, len);
+
+    if (!EVP_AEAD_CTX_init(&ctx, EVP_aead_aes_128_gcm(), key, sizeof(key), QUIC_RETRY_INTEGRITY_TAG_LEN, NULL)) {
+        return quic_err_internal_error;
+    }
+    const int ret = EVP_AEAD_CTX_seal(&ctx, tag, &tag_len, QUIC_RETRY_INTEGRITY_TAG_LEN, nonce, sizeof(nonce), NULL, 0, pseudo, pseudo_len);
+    EVP_AEAD_CTX_cleanup(&ctx);
+
+    return ret && tag_len == QUIC_RETRY_INTEGRITY_TAG_LEN ? quic_err_success : quic_err_internal_error;
+}
+
+static quic_err_t quic_sealer_module_process(void *const module) {
+    quic_sealer_module_t *const s_module = module;
+
+    // activated by quic_sealer_key_op_done, the parked handshake picks up the signature
+    if (s_module->key_op && s_module->key_op->finished) {
+        quic_sealer_handshake_process(s_module);
+
+        if (!s_module->transport_parameter_processed) {
+            quic_sealer_process_peer_transport_parameters(s_module);
+        }
+    }
+
+    return quic_err_success;
+}
+
 #undef quic_sealer_alloc_buf
 
 static quic_err_t quic_sealer_module_destory(void *const module) {
@@ -573,7 +865,21 @@ static quic_err_t quic_sealer_module_destory(void *const module) {
     SSL_CTX_free(s_module->ssl_ctx);
     SSL_free(s_module->ssl);
 
+    // a pending key operation is freed once the pool is done with it, a finished one is not revisited by the pool
+    if (s_module->key_op) {
+        if (s_module->key_op->finished) {
+            EVP_PKEY_free(s_module->key_op->pkey);
+            quic_free(s_module->key_op);
+        }
+        else {
+            s_module->key_op->module = NULL;
+        }
+        s_module->key_op = NULL;
+    }
+    EVP_PKEY_free(s_module->pkey);
+
     quic_sealer_destory(&s_module->initial_sealer);
+    quic_sealer_destory(&s_module->early_sealer);
     quic_sealer_destory(&s_module->handshake_sealer);
     quic_sealer_destory(&s_module->app_sealer);
 
@@ -661,6 +967,9 @@ static quic_err_t quic_sealer_process_peer_transport_parameters(quic_sealer_modu
     if (params.stateless_reset_token.buf) {
         free(params.stateless_reset_token.buf);
     }
+    if (params.retry_connid.buf) {
+        free(params.retry_connid.buf);
+    }
 
     return quic_err_success;
 }
@@ -670,7 +979,7 @@ quic_module_t quic_sealer_module = {
     .module_size = sizeof(quic_sealer_module_t),
     .init        = quic_sealer_module_init,
     .start       = quic_sealer_module_start,
-    .process     = NULL,
+    .process     = quic_sealer_module_process,
     .loop        = NULL,
     .destory     = quic_sealer_module_destory
 };
@@ -709,52 +1018,54 @@ static quic_err_t quic_sealer_apply_packet_number(quic_header_protector_t *const
 }
 
 quic_err_t quic_sealer_seal(quic_send_packet_t *const pkt, quic_sealer_t *const sealer, const quic_buf_t hdr, const size_t src_len) {
-    uint8_t *pnum_off = quic_header_packet_number_off(hdr.pos, src_len);
-    const size_t pnum_size = quic_packet_number_len(*(uint8_t *) hdr.pos);
+    const size_t hdr_size = quic_buf_size(&hdr);
+    uint8_t *const hdr_off = pkt->buf.pos;
+    uint8_t *const payload_off = hdr_off + hdr_size;
 
-    size_t hdr_size = quic_buf_size(&hdr);
-
-    size_t payload_len = 0;
-    quic_frame_t *frame = NULL;
-    liteco_link_foreach(frame, &pkt->frames) {
-        payload_len += quic_frame_size(frame);
-    }
-    uint8_t *const payload = quic_malloc(payload_len);
-    if (!payload) {
+    if (hdr_off + hdr_size + sealer->w_aead_tag_size > (uint8_t *) pkt->buf.last) {
         return quic_err_internal_error;
     }
-    quic_buf_t payload_buf = { .buf = payload, .capa = payload_len };
+
+    // the header is usually generated in place, otherwise it is copied in front of the payload
+    if (hdr.pos != hdr_off) {
+        memcpy(hdr_off, hdr.pos, hdr_size);
+    }
+
+    // frames are serialized right after the header and sealed in place
+    quic_buf_t payload_buf = { .buf = payload_off, .capa = (uint8_t *) pkt->buf.last - payload_off - sealer->w_aead_tag_size };
     quic_buf_setpl(&payload_buf);
+    quic_frame_t *frame = NULL;
     liteco_link_foreach(frame, &pkt->frames) {
         quic_frame_format(&payload_buf, frame);
     }
-    quic_buf_write_complete(&payload_buf);
+    const size_t payload_len = quic_buf_writed_len(&payload_buf);
 
     // AEAD seal
-    size_t sealed_outlen = quic_buf_size(&payload_buf);
-    EVP_AEAD_CTX_seal(&sealer->w_ctx,
-                      pkt->buf.buf + hdr_size, &sealed_outlen, quic_buf_size(&payload_buf) + sealer->w_aead_tag_size,
-                      sealer->w_iv.pos, quic_buf_size(&sealer->w_iv),
-                      payload_buf.pos, quic_buf_size(&payload_buf),
-                      hdr.pos, hdr_size);
+    size_t sealed_outlen = 0;
+    if (!EVP_AEAD_CTX_seal(&sealer->w_ctx,
+                           payload_off, &sealed_outlen, payload_len + sealer->w_aead_tag_size,
+                           sealer->w_iv.pos, quic_buf_size(&sealer->w_iv),
+                           payload_off, payload_len,
+                           hdr_off, hdr_size)) {
+        return quic_err_internal_error;
+    }
 
     // head protect
-    quic_sealer_set_header_simple(&sealer->w_hp, pkt->buf.pos + hdr_size - pnum_size + 4, 16);
+    uint8_t *const pnum_off = quic_header_packet_number_off(hdr_off, src_len);
+    const size_t pnum_size = quic_packet_number_len(*hdr_off);
+    quic_sealer_set_header_simple(&sealer->w_hp, pnum_off + 4, 16);
 
-    *(uint8_t *) hdr.pos = quic_sealer_apply_first_byte(&sealer->w_hp, *(uint8_t *) hdr.pos);
+    *hdr_off = quic_sealer_apply_first_byte(&sealer->w_hp, *hdr_off);
     quic_sealer_apply_packet_number(&sealer->w_hp, pnum_off, pnum_size);
 
-    memcpy(pkt->buf.pos, hdr.pos, hdr_size);
     pkt->buf.pos += hdr_size + sealed_outlen;
-
     quic_buf_write_complete(&pkt->buf);
 
-    free(payload);
     return quic_err_success;
 }
 
-quic_err_t quic_sealer_open(quic_recv_packet_t *const pkt, quic_sealer_module_t *const module, const size_t src_len) {
-    quic_header_t *const hdr = (quic_header_t *) pkt->pkt.buf;
+quic_err_t quic_sealer_open(quic_buf_t *const pkt, quic_sealer_module_t *const module, const size_t src_len) {
+    quic_header_t *const hdr = (quic_header_t *) pkt->buf;
     quic_sealer_t *sealer = NULL;
 
     if (quic_header_is_long(hdr)) {
@@ -767,6 +1078,14 @@ quic_err_t quic_sealer_open(quic_recv_packet_t *const pkt, quic_sealer_module_t
             sealer = &module->handshake_sealer;
             break;
 
+        case quic_packet_0rtt_type:
+            // 0-RTT packets are dropped unless the early data of the ClientHello was accepted
+            sealer = &module->early_sealer;
+            if (!sealer->r_aead) {
+                return quic_err_internal_error;
+            }
+            break;
+
         default:
             return quic_err_success;
         }
@@ -775,7 +1094,7 @@ quic_err_t quic_sealer_open(quic_recv_packet_t *const pkt, quic_sealer_module_t
         sealer = &module->app_sealer;
     }
 
-    uint8_t *pnum_off = quic_header_packet_number_off(pkt->pkt.buf, src_len);
+    uint8_t *pnum_off = quic_header_packet_number_off(pkt->buf, src_len);
 
     quic_sealer_set_header_simple(&sealer->r_hp, pnum_off + 4, 16);
 
@@ -785,23 +1104,21 @@ quic_err_t quic_sealer_open(quic_recv_packet_t *const pkt, quic_sealer_module_t
     quic_sealer_apply_packet_number(&sealer->r_hp, pnum_off, pnum_size);
 
     uint8_t *payload_off = pnum_off + pnum_size;
-    const size_t hdr_size = payload_off - pkt->pkt.buf;
-    const size_t payload_size = pkt->pkt.ret - hdr_size;
+    const size_t hdr_size = payload_off - (uint8_t *) pkt->buf;
+    const size_t payload_size = pkt->capa - hdr_size;
 
-    uint8_t *opened_payload = quic_malloc(payload_size);
+    // AEAD open, the plaintext overwrites the ciphertext inside the received datagram
     size_t opened_outlen = 0;
-    if (!opened_payload) {
+    if (!EVP_AEAD_CTX_open(&sealer->r_ctx,
+                           payload_off, &opened_outlen, payload_size,
+                           sealer->r_iv.pos, quic_buf_size(&sealer->r_iv),
+                           payload_off, payload_size,
+                           pkt->buf, hdr_size)) {
         return quic_err_internal_error;
     }
-    // AEAD open
-    EVP_AEAD_CTX_open(&sealer->r_ctx,
-                      opened_payload, &opened_outlen, payload_size,
-                      sealer->r_iv.pos, quic_buf_size(&sealer->r_iv),
-                      payload_off, payload_size,
-                      pkt->pkt.buf, hdr_size);
 
-    memcpy(payload_off, opened_payload, opened_outlen);
-    pkt->pkt.ret -= sealer->r_aead_tag_size;
+    pkt->capa = hdr_size + opened_outlen;
+    quic_buf_setpl(pkt);
 
     return quic_err_success;
 }
@@ -824,7 +1141,7 @@ quic_err_t quic_session_handle_crypto_frame(quic_session_t *const session, const
         return quic_err_internal_error;
     }
 
-    quic_sorter_write(sorter, c_frame->off, c_frame->len, c_frame->data);
+    quic_sorter_write(sorter, c_frame->off, c_frame->len, quic_frame_payload(c_frame));
 
     for ( ;; ) {
         uint32_t fragment_size = 0;
@@ -869,3 +1186,352 @@ quic_err_t quic_session_handle_handshake_done_frame(quic_session_t *const sessio
 
     return quic_err_success;
 }
+
+quic_err_t quic_tls_ctx_init(quic_tls_ctx_t *const tls_ctx) {
+    if (quic_tls_ticket_key_generate(&tls_ctx->ticket_keys[0], quic_now()) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    if (quic_tls_ticket_key_generate(&tls_ctx->ticket_keys[1], 0) != quic_err_success) {
+        quic_connid_table_destory(&tls_ctx->ticket_keys[0].strikes);
+        return quic_err_internal_error;
+    }
+
+    pthread_mutex_init(&tls_ctx->mtx, NULL);
+    tls_ctx->ssl_ctx = NULL;
+    tls_ctx->pkey = NULL;
+    tls_ctx->generation = 0;
+    memset(&tls_ctx->cfg, 0, sizeof(quic_config_t));
+    memset(&tls_ctx->cert_mtime, 0, sizeof(struct timespec));
+    memset(&tls_ctx->key_mtime, 0, sizeof(struct timespec));
+    atomic_init(&tls_ctx->checked_at, 0);
+    tls_ctx->resumed = 0;
+    tls_ctx->replayed = 0;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_tls_ticket_key_generate(quic_tls_ticket_key_t *const key, const uint64_t now) {
+    uint8_t secret[16];
+
+    if (RAND_bytes(key->name, sizeof(key->name)) <= 0
+        || RAND_bytes(key->aes_key, sizeof(key->aes_key)) <= 0
+        || RAND_bytes(key->hmac_key, sizeof(key->hmac_key)) <= 0
+        || RAND_bytes(secret, sizeof(secret)) <= 0) {
+        return quic_err_internal_error;
+    }
+    key->created_at = now;
+
+    return quic_connid_table_init(&key->strikes, secret);
+}
+
+static void quic_tls_ctx_rotate_ticket_keys(quic_tls_ctx_t *const tls_ctx, const uint64_t now) {
+    quic_tls_ticket_key_t key;
+
+    if (now < tls_ctx->ticket_keys[0].created_at + QUIC_TLS_TICKET_KEY_LIFETIME) {
+        return;
+    }
+    // keep the current key if no new one can be generated, the rotation is retried by the next ticket
+    if (quic_tls_ticket_key_generate(&key, now) != quic_err_success) {
+        return;
+    }
+
+    quic_connid_table_destory(&tls_ctx->ticket_keys[1].strikes);
+    tls_ctx->ticket_keys[1] = tls_ctx->ticket_keys[0];
+    tls_ctx->ticket_keys[0] = key;
+}
+
+static int quic_tls_ctx_ticket_key_cb(SSL *ssl, uint8_t *key_name, uint8_t *iv, EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *hmac_ctx, int encrypt) {
+    quic_sealer_module_t *const module = SSL_get_app_data(ssl);
+    quic_tls_ctx_t *const tls_ctx = quic_module_of_session(module)->cfg.tls_ctx;
+    int ret = 0;
+    int i;
+
+    if (!tls_ctx) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&tls_ctx->mtx);
+    quic_tls_ctx_rotate_ticket_keys(tls_ctx, quic_now());
+
+    if (encrypt) {
+        quic_tls_ticket_key_t *const key = &tls_ctx->ticket_keys[0];
+
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) > 0) {
+            memcpy(key_name, key->name, sizeof(key->name));
+            EVP_EncryptInit_ex(cipher_ctx, EVP_aes_128_cbc(), NULL, key->aes_key, iv);
+            HMAC_Init_ex(hmac_ctx, key->hmac_key, sizeof(key->hmac_key), EVP_sha256(), NULL);
+            ret = 1;
+        }
+    }
+    else {
+        for (i = 0; i < 2; i++) {
+            quic_tls_ticket_key_t *const key = &tls_ctx->ticket_keys[i];
+            if (!key->created_at || memcmp(key_name, key->name, sizeof(key->name)) != 0) {
+                continue;
+            }
+
+            // the strike is recorded for authentic tickets only, a forged one must not burn the iv of a real ticket
+            if (!module->ticket_verified || memcmp(iv, module->ticket_iv, EVP_MAX_IV_LENGTH) != 0) {
+                break;
+            }
+
+            // every ticket carries a random iv, a second use of it is a replay (RFC 8446 8.1)
+            quic_buf_t strike = { .buf = iv, .capa = EVP_MAX_IV_LENGTH };
+            quic_buf_setpl(&strike);
+            if (quic_connid_table_find(&key->strikes, &strike)) {
+                tls_ctx->replayed++;
+                break;
+            }
+            if (key->strikes.size >= QUIC_TLS_TICKET_STRIKES_MAX
+                || quic_connid_table_insert(&key->strikes, &strike, key) != quic_err_success) {
+                break;
+            }
+
+            EVP_DecryptInit_ex(cipher_ctx, EVP_aes_128_cbc(), NULL, key->aes_key, iv);
+            HMAC_Init_ex(hmac_ctx, key->hmac_key, sizeof(key->hmac_key), EVP_sha256(), NULL);
+            tls_ctx->resumed++;
+
+            // tickets of the previous key are renewed
+            ret = i == 0 ? 1 : 2;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tls_ctx->mtx);
+
+    return ret;
+}
+
+/*
+ * BoringSSL checks the HMAC of a ticket only after quic_tls_ctx_ticket_key_cb returned, so the ticket offered in the
+ * pre_shared_key extension (key name, iv, ciphertext, HMAC-SHA256 of the rest) is authenticated here beforehand
+ */
+static enum ssl_select_cert_result_t quic_tls_ctx_select_certificate_cb(const SSL_CLIENT_HELLO *client_hello) {
+    quic_sealer_module_t *const module = SSL_get_app_data(client_hello->ssl);
+    quic_tls_ctx_t *const tls_ctx = quic_module_of_session(module)->cfg.tls_ctx;
+    const uint8_t *ext = NULL;
+    size_t ext_len = 0;
+    uint8_t mac[EVP_MAX_MD_SIZE];
+    unsigned int mac_len = 0;
+    int i;
+
+    module->ticket_verified = false;
+    if (!tls_ctx || !SSL_early_callback_ctx_extension_get(client_hello, TLSEXT_TYPE_pre_shared_key, &ext, &ext_len)) {
+        return ssl_select_cert_success;
+    }
+
+    // identities length, then the first identity, the only one the server considers
+    if (ext_len < 4) {
+        return ssl_select_cert_success;
+    }
+    const size_t ticket_len = ((size_t) ext[2] << 8) | ext[3];
+    const uint8_t *const ticket = ext + 4;
+    if (ticket_len > ext_len - 4 || ticket_len < 16 + EVP_MAX_IV_LENGTH + SHA256_DIGEST_LENGTH) {
+        return ssl_select_cert_success;
+    }
+
+    pthread_mutex_lock(&tls_ctx->mtx);
+    for (i = 0; i < 2; i++) {
+        quic_tls_ticket_key_t *const key = &tls_ctx->ticket_keys[i];
+        if (!key->created_at || memcmp(ticket, key->name, sizeof(key->name)) != 0) {
+            continue;
+        }
+
+        if (HMAC(EVP_sha256(), key->hmac_key, sizeof(key->hmac_key), ticket, ticket_len - SHA256_DIGEST_LENGTH, mac, &mac_len)
+            && mac_len == SHA256_DIGEST_LENGTH
+            && CRYPTO_memcmp(mac, ticket + ticket_len - SHA256_DIGEST_LENGTH, SHA256_DIGEST_LENGTH) == 0) {
+            memcpy(module->ticket_iv, ticket + sizeof(key->name), EVP_MAX_IV_LENGTH);
+            module->ticket_verified = true;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&tls_ctx->mtx);
+
+    return ssl_select_cert_success;
+}
+
+static inline bool quic_tls_ctx_file_mtime(const char *const file, struct timespec *const mtime) {
+    struct stat st;
+
+    if (!file || stat(file, &st) != 0) {
+        return false;
+    }
+    *mtime = st.st_mtim;
+
+    return true;
+}
+
+quic_err_t quic_tls_ctx_load(quic_tls_ctx_t *const tls_ctx, const quic_config_t *const cfg) {
+    struct timespec cert_mtime = { 0 };
+    struct timespec key_mtime = { 0 };
+
+    // stat before reading, a rotation racing with the load is picked up by the next check
+    quic_tls_ctx_file_mtime(cfg->tls_cert_chain_file, &cert_mtime);
+    quic_tls_ctx_file_mtime(cfg->tls_key_file, &key_mtime);
+
+    SSL_CTX *const ssl_ctx = quic_sealer_ssl_ctx_new(cfg);
+    if (!ssl_ctx) {
+        return quic_err_internal_error;
+    }
+    SSL_CTX_set_session_id_context(ssl_ctx, (const uint8_t *) quic_ssl_session_id_context, sizeof(quic_ssl_session_id_context) - 1);
+    if (!cfg->is_cli) {
+        SSL_CTX_set_tlsext_ticket_key_cb(ssl_ctx, quic_tls_ctx_ticket_key_cb);
+        SSL_CTX_set_select_certificate_cb(ssl_ctx, quic_tls_ctx_select_certificate_cb);
+    }
+    EVP_PKEY *pkey = NULL;
+    if (quic_sealer_set_chains_and_key(ssl_ctx, cfg->tls_cert_chain_file, cfg->tls_key_file, cfg->tls_offload ? &pkey : NULL) != quic_err_success) {
+        SSL_CTX_free(ssl_ctx);
+        return quic_err_internal_error;
+    }
+
+    pthread_mutex_lock(&tls_ctx->mtx);
+    SSL_CTX *const prev = tls_ctx->ssl_ctx;
+    EVP_PKEY *const prev_pkey = tls_ctx->pkey;
+    tls_ctx->ssl_ctx = ssl_ctx;
+    tls_ctx->pkey = pkey;
+    tls_ctx->generation++;
+    tls_ctx->cfg = *cfg;
+    tls_ctx->cfg.tls_ctx = tls_ctx;
+    tls_ctx->cert_mtime = cert_mtime;
+    tls_ctx->key_mtime = key_mtime;
+    pthread_mutex_unlock(&tls_ctx->mtx);
+
+    SSL_CTX_free(prev);
+    EVP_PKEY_free(prev_pkey);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_tls_ctx_reload_if_changed(quic_tls_ctx_t *const tls_ctx, const uint64_t now) {
+    uint64_t checked_at = atomic_load_explicit(&tls_ctx->checked_at, memory_order_relaxed);
+    if (now < checked_at + QUIC_TLS_CTX_CHECK_INTERVAL
+        || !atomic_compare_exchange_strong_explicit(&tls_ctx->checked_at, &checked_at, now, memory_order_relaxed, memory_order_relaxed)) {
+        return quic_err_success;
+    }
+
+    struct timespec cert_mtime = { 0 };
+    struct timespec key_mtime = { 0 };
+
+    pthread_mutex_lock(&tls_ctx->mtx);
+    if (!tls_ctx->ssl_ctx) {
+        pthread_mutex_unlock(&tls_ctx->mtx);
+        return quic_err_success;
+    }
+    const quic_config_t cfg = tls_ctx->cfg;
+    const bool changed = (quic_tls_ctx_file_mtime(cfg.tls_cert_chain_file, &cert_mtime)
+                          && (cert_mtime.tv_sec != tls_ctx->cert_mtime.tv_sec || cert_mtime.tv_nsec != tls_ctx->cert_mtime.tv_nsec))
+        || (quic_tls_ctx_file_mtime(cfg.tls_key_file, &key_mtime)
+            && (key_mtime.tv_sec != tls_ctx->key_mtime.tv_sec || key_mtime.tv_nsec != tls_ctx->key_mtime.tv_nsec));
+    pthread_mutex_unlock(&tls_ctx->mtx);
+
+    if (!changed) {
+        return quic_err_success;
+    }
+
+    return quic_tls_ctx_load(tls_ctx, &cfg);
+}
+
+SSL_CTX *quic_tls_ctx_acquire(quic_tls_ctx_t *const tls_ctx, EVP_PKEY **const pkey) {
+    SSL_CTX *ssl_ctx = NULL;
+
+    pthread_mutex_lock(&tls_ctx->mtx);
+    if ((ssl_ctx = tls_ctx->ssl_ctx)) {
+        SSL_CTX_up_ref(ssl_ctx);
+    }
+    if (pkey && (*pkey = tls_ctx->pkey)) {
+        EVP_PKEY_up_ref(*pkey);
+    }
+    pthread_mutex_unlock(&tls_ctx->mtx);
+
+    return ssl_ctx;
+}
+
+quic_err_t quic_tls_ctx_destory(quic_tls_ctx_t *const tls_ctx) {
+    pthread_mutex_lock(&tls_ctx->mtx);
+    SSL_CTX *const ssl_ctx = tls_ctx->ssl_ctx;
+    EVP_PKEY *const pkey = tls_ctx->pkey;
+    tls_ctx->ssl_ctx = NULL;
+    tls_ctx->pkey = NULL;
+    pthread_mutex_unlock(&tls_ctx->mtx);
+
+    SSL_CTX_free(ssl_ctx);
+    EVP_PKEY_free(pkey);
+    pthread_mutex_destroy(&tls_ctx->mtx);
+
+    quic_connid_table_destory(&tls_ctx->ticket_keys[0].strikes);
+    quic_connid_table_destory(&tls_ctx->ticket_keys[1].strikes);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_tls_ticket_cache_init(quic_tls_ticket_cache_t *const cache) {
+    pthread_mutex_init(&cache->mtx, NULL);
+    liteco_rbt_init(cache->tickets);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_tls_ticket_cache_put(quic_tls_ticket_cache_t *const cache, const char *const server_name, SSL_SESSION *const session) {
+    const size_t name_len = strlen(server_name);
+    quic_buf_t key = { .buf = (void *) server_name, .capa = name_len };
+    quic_buf_setpl(&key);
+
+    // tickets which cannot resume are not worth keeping
+    if (!SSL_SESSION_is_resumable(session)) {
+        return quic_err_bad_format;
+    }
+
+    pthread_mutex_lock(&cache->mtx);
+    quic_tls_ticket_t *ticket = liteco_rbt_find(cache->tickets, &key);
+    if (liteco_rbt_is_not_nil(ticket)) {
+        SSL_SESSION_free(ticket->session);
+        ticket->session = session;
+        pthread_mutex_unlock(&cache->mtx);
+        return quic_err_success;
+    }
+
+    if (!(ticket = quic_malloc(sizeof(quic_tls_ticket_t) + name_len))) {
+        pthread_mutex_unlock(&cache->mtx);
+        return quic_err_internal_error;
+    }
+    liteco_rbt_node_init(ticket);
+    ticket->key.buf = ((uint8_t *) ticket) + sizeof(quic_tls_ticket_t);
+    ticket->key.capa = name_len;
+    memcpy(ticket->key.buf, server_name, name_len);
+    quic_buf_setpl(&ticket->key);
+    ticket->session = session;
+    liteco_rbt_insert(&cache->tickets, ticket);
+    pthread_mutex_unlock(&cache->mtx);
+
+    return quic_err_success;
+}
+
+SSL_SESSION *quic_tls_ticket_cache_take(quic_tls_ticket_cache_t *const cache, const char *const server_name) {
+    SSL_SESSION *session = NULL;
+    quic_buf_t key = { .buf = (void *) server_name, .capa = strlen(server_name) };
+    quic_buf_setpl(&key);
+
+    pthread_mutex_lock(&cache->mtx);
+    quic_tls_ticket_t *ticket = liteco_rbt_find(cache->tickets, &key);
+    if (liteco_rbt_is_not_nil(ticket)) {
+        liteco_rbt_remove(&cache->tickets, &ticket);
+        session = ticket->session;
+        quic_free(ticket);
+    }
+    pthread_mutex_unlock(&cache->mtx);
+
+    return session;
+}
+
+quic_err_t quic_tls_ticket_cache_destory(quic_tls_ticket_cache_t *const cache) {
+    pthread_mutex_lock(&cache->mtx);
+    while (liteco_rbt_is_not_nil(cache->tickets)) {
+        quic_tls_ticket_t *ticket = cache->tickets;
+        liteco_rbt_remove(&cache->tickets, &ticket);
+        SSL_SESSION_free(ticket->session);
+        quic_free(ticket);
+    }
+    pthread_mutex_unlock(&cache->mtx);
+    pthread_mutex_destroy(&cache->mtx);
+
+    return quic_err_success;
+}
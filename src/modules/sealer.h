@@ -15,13 +15,116 @@
 #include "format/frame.h"
 #include "modules/framer.h"
 #include "modules/ack_generator.h"
+#include "utils/connid_table.h"
+#include "utils/rbt_extend.h"
+#include "offload.h"
 #include "liteco.h"
 #include <openssl/ssl.h>
 #include <openssl/aes.h>
 #include <openssl/chacha.h>
+#include <openssl/cipher.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
 #define quic_ssl_session_id_context "OpenQUIC server"
 
+// minimum interval (us) between two checks of the certificate files for rotation
+#ifndef QUIC_TLS_CTX_CHECK_INTERVAL
+#define QUIC_TLS_CTX_CHECK_INTERVAL (1000 * 1000)
+#endif
+
+// a session ticket key encrypts new tickets for one lifetime, and decrypts them for one more
+#ifndef QUIC_TLS_TICKET_KEY_LIFETIME
+#define QUIC_TLS_TICKET_KEY_LIFETIME (12UL * 3600 * 1000 * 1000)
+#endif
+
+// redeemed tickets remembered per key, resumption is refused once it is full
+#ifndef QUIC_TLS_TICKET_STRIKES_MAX
+#define QUIC_TLS_TICKET_STRIKES_MAX (1 << 20)
+#endif
+
+// largest Retry packet (tag excluded) whose integrity tag is computed, with room for the original connection id
+#define QUIC_SEALER_RETRY_PSEUDO_MAX_SIZE 512
+
+typedef struct quic_tls_ticket_key_s quic_tls_ticket_key_t;
+struct quic_tls_ticket_key_s {
+    uint8_t name[16];
+    uint8_t aes_key[16];
+    uint8_t hmac_key[16];
+    uint64_t created_at;
+
+    // ivs of the tickets redeemed under this key, a ticket resumes (and carries 0-RTT data) only once
+    quic_connid_table_t strikes;
+};
+
+/*
+ * SSL_CTX shared by the sessions of a server, the certificate chain and the private key are parsed once per load.
+ * each session takes a reference of the current SSL_CTX, a reload swaps it for new handshakes only.
+ * session tickets are protected by ticket_keys[0] and accepted under ticket_keys[1] until it is rotated out
+ */
+struct quic_tls_ctx_s {
+    pthread_mutex_t mtx;
+    SSL_CTX *ssl_ctx;
+    // private key of ssl_ctx if its operations are offloaded (cfg.tls_offload)
+    EVP_PKEY *pkey;
+    uint64_t generation;
+
+    quic_config_t cfg;
+    struct timespec cert_mtime;
+    struct timespec key_mtime;
+    _Atomic uint64_t checked_at;
+
+    quic_tls_ticket_key_t ticket_keys[2];
+    uint64_t resumed;
+    uint64_t replayed;
+};
+
+quic_err_t quic_tls_ctx_init(quic_tls_ctx_t *const tls_ctx);
+
+/*
+ * build an SSL_CTX from the tls_ options of cfg and make it current, the previous one is released
+ * once its last session is gone. on failure the current SSL_CTX is kept
+ */
+quic_err_t quic_tls_ctx_load(quic_tls_ctx_t *const tls_ctx, const quic_config_t *const cfg);
+
+/*
+ * reload if the certificate chain or the private key file was modified, files are checked
+ * at most once per QUIC_TLS_CTX_CHECK_INTERVAL. may be called from any thread
+ */
+quic_err_t quic_tls_ctx_reload_if_changed(quic_tls_ctx_t *const tls_ctx, const uint64_t now);
+
+// a new reference of the current SSL_CTX (released by SSL_CTX_free), and of its offloaded private key if any
+SSL_CTX *quic_tls_ctx_acquire(quic_tls_ctx_t *const tls_ctx, EVP_PKEY **const pkey);
+
+quic_err_t quic_tls_ctx_destory(quic_tls_ctx_t *const tls_ctx);
+
+typedef struct quic_tls_ticket_s quic_tls_ticket_t;
+struct quic_tls_ticket_s {
+    QUIC_RBT_KEY_STRING_FIELDS
+
+    SSL_SESSION *session;
+};
+
+/*
+ * session tickets received by clients, keyed by server name. the cache outlives the clients resuming from it,
+ * a ticket is taken out by the handshake which uses it since servers redeem every ticket only once
+ */
+struct quic_tls_ticket_cache_s {
+    pthread_mutex_t mtx;
+    quic_tls_ticket_t *tickets;
+};
+
+quic_err_t quic_tls_ticket_cache_init(quic_tls_ticket_cache_t *const cache);
+
+// keeps the reference of session, a previous ticket of the server is released
+quic_err_t quic_tls_ticket_cache_put(quic_tls_ticket_cache_t *const cache, const char *const server_name, SSL_SESSION *const session);
+
+// the ticket of the server (released by SSL_SESSION_free) or NULL
+SSL_SESSION *quic_tls_ticket_cache_take(quic_tls_ticket_cache_t *const cache, const char *const server_name);
+
+quic_err_t quic_tls_ticket_cache_destory(quic_tls_ticket_cache_t *const cache);
+
 typedef struct quic_header_protector_s quic_header_protector_t;
 struct quic_header_protector_s {
     uint32_t suite_id;
@@ -77,6 +180,8 @@ __quic_header_inline quic_err_t quic_sealer_init(quic_sealer_t *const sealer) {
     return quic_err_success;
 }
 
+typedef struct quic_sealer_key_op_s quic_sealer_key_op_t;
+
 typedef struct quic_sealer_module_s quic_sealer_module_t;
 struct quic_sealer_module_s {
     QUIC_MODULE_FIELDS
@@ -85,6 +190,14 @@ struct quic_sealer_module_s {
     SSL_CTX *ssl_ctx;
     SSL *ssl;
 
+    // the handshake is parked while key_op signs with pkey on the offload pool
+    EVP_PKEY *pkey;
+    quic_sealer_key_op_t *key_op;
+
+    // iv of the ticket offered by the ClientHello, set once its HMAC verified under one of the ticket keys
+    bool ticket_verified;
+    uint8_t ticket_iv[EVP_MAX_IV_LENGTH];
+
     int tls_alert;
     uint32_t off;
 
@@ -94,6 +207,7 @@ struct quic_sealer_module_s {
     enum ssl_encryption_level_t level;
 
     quic_sealer_t initial_sealer;
+    quic_sealer_t early_sealer;
     quic_sealer_t handshake_sealer;
     quic_sealer_t app_sealer;
 
@@ -122,6 +236,9 @@ __quic_header_inline quic_err_t quic_sealer_set_level(quic_sealer_module_t *cons
         ag_module = quic_session_module(session, quic_handshake_ack_generator_module);
         r_module = quic_session_module(session, quic_handshake_retransmission_module);
 
+        if (module->level != ssl_encryption_application && session->handshake_completed) {
+            session->handshake_completed(session);
+        }
         if (module->handshake_done_cb) {
             module->handshake_done_cb(session);
         }
@@ -151,10 +268,11 @@ __quic_header_inline quic_err_t quic_sealer_handshake_process(quic_sealer_module
             quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
             quic_sealer_set_level(module, ssl_encryption_application);
 
-            quic_frame_handshake_done_t *frame = malloc(sizeof(quic_frame_handshake_done_t));
-            quic_frame_init(frame, quic_frame_handshake_done_type);
-
-            quic_framer_ctrl(f_module, (quic_frame_t *) frame);
+            quic_frame_handshake_done_t *frame = NULL;
+            quic_frame_create(frame, &session->frame_pool, quic_frame_handshake_done_type, sizeof(quic_frame_handshake_done_t));
+            if (frame) {
+                quic_framer_ctrl(f_module, (quic_frame_t *) frame);
+            }
             quic_module_activate(session, quic_sender_module);
         }
         return quic_err_success;
@@ -168,8 +286,15 @@ __quic_header_inline quic_err_t quic_sealer_handshake_process(quic_sealer_module
         break;
     case SSL_ERROR_WANT_X509_LOOKUP:
         break;
+    case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
+        // parked until the offloaded key operation activates the sealer module again
+        break;
     case SSL_ERROR_SSL:
         break;
+    case SSL_ERROR_EARLY_DATA_REJECTED:
+        // 0-RTT packets are never acknowledged, their frames are retransmitted in 1-RTT packets
+        SSL_reset_early_data_reject(module->ssl);
+        return quic_sealer_handshake_process(module);
     }
 
     return quic_err_success;
@@ -198,13 +323,14 @@ __quic_header_inline uint64_t quic_sealer_append_crypto_frame(liteco_linknode_t
     }
 
     // modify, same as generate max stream data
-    quic_frame_crypto_t *frame = malloc(sizeof(quic_frame_crypto_t) + len);
+    quic_frame_crypto_t *frame = NULL;
+    quic_frame_create(frame, &quic_module_of_session(module)->frame_pool, quic_frame_crypto_type, sizeof(quic_frame_crypto_t) + len);
     if (!frame) {
         return 0;
     }
-    quic_frame_init(frame, quic_frame_crypto_type);
     frame->len = len;
     frame->off = sorter->readed_size;
+    frame->ref = NULL;
 
     quic_sorter_read(sorter, len, frame->data);
     
@@ -224,12 +350,25 @@ __quic_header_inline bool quic_sealer_should_send(quic_sealer_module_t *const mo
     }
 }
 
+/*
+ * the client may send 0-RTT data: data written to streams now goes out in 0-RTT packets
+ */
+__quic_header_inline bool quic_sealer_in_early_data(quic_sealer_module_t *const module) {
+    return module->early_sealer.w_aead && !module->app_sealer.w_aead;
+}
+
 __quic_header_inline quic_err_t quic_sealer_handshake_done(quic_sealer_module_t *const module, quic_err_t (*handshake_done_cb) (quic_session_t *const)) {
     module->handshake_done_cb = handshake_done_cb;
     return quic_err_success;
 }
 
 quic_err_t quic_sealer_seal(quic_send_packet_t *const pkt, quic_sealer_t *const sealer, const quic_buf_t hdr, const size_t src_len);
-quic_err_t quic_sealer_open(quic_recv_packet_t *const pkt, quic_sealer_module_t *const module, const size_t src_len);
+quic_err_t quic_sealer_open(quic_buf_t *const pkt, quic_sealer_module_t *const module, const size_t src_len);
+
+// client: a Retry changed the destination connection id, the Initial keys are derived again from it
+quic_err_t quic_sealer_retry(quic_sealer_module_t *const module);
+
+// Retry Integrity Tag (RFC 9001, 5.8) of the Retry packet retry[0..len) (the tag itself excluded)
+quic_err_t quic_sealer_retry_integrity_tag(uint8_t *const tag, const quic_buf_t original_dst, const uint8_t *const retry, const size_t len);
 
 #endif
@@ -22,7 +22,7 @@
 static inline quic_err_t quic_sender_generate_long_header(quic_session_t *const session, const uint8_t type, quic_buf_t *const buf);
 static inline quic_err_t quic_sender_generate_initial_header(quic_session_t *const session, const uint64_t num, const uint64_t payload_len, quic_buf_t *const buf);
 static inline uint64_t quic_sender_initial_header_max_size(quic_session_t *const session, const uint64_t num, const uint64_t payload_max_len);
-static inline quic_err_t quic_sender_generate_0rtt_header(quic_sender_module_t *const sender, quic_buf_t *const buf);
+static inline quic_err_t quic_sender_generate_0rtt_header(quic_session_t *const session, const uint64_t num, const uint64_t payload_len, quic_buf_t *const buf);
 static inline quic_err_t quic_sender_generate_handshake_header(quic_session_t *const session, const uint64_t num, const uint64_t payload_len, quic_buf_t *const buf);
 static inline uint64_t quic_sender_handshake_header_max_size(quic_session_t *const session, const uint64_t num, const uint64_t payload_max_len);
 static inline quic_err_t quic_sender_generate_retry_header(quic_sender_module_t *const sender, quic_buf_t *const buf);
@@ -30,23 +30,30 @@ static inline quic_err_t quic_sender_generate_retry_header(quic_sender_module_t
 /* all fields of the short header are completely filled */
 static inline quic_err_t quic_sender_generate_short_header(quic_session_t *const session, const uint64_t num, quic_buf_t *const buf);
 
-static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t *const sender, const bool probe);
-static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_t *const sender, const bool probe);
-static quic_send_packet_t *quic_sender_pack_app_packet(quic_sender_module_t *const sender, const bool probe);
+static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu);
+static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu);
+static quic_send_packet_t *quic_sender_pack_0rtt_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu);
+static quic_send_packet_t *quic_sender_pack_app_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu);
 
 static quic_send_packet_t *quic_sender_pack_initial_connection_close(quic_sender_module_t *const sender, quic_frame_connection_close_t *const frame);
 static quic_send_packet_t *quic_sender_pack_handshake_connection_close(quic_sender_module_t *const sender, quic_frame_connection_close_t *const frame);
 static quic_send_packet_t *quic_sender_pack_app_connection_close(quic_sender_module_t *const sender, quic_frame_connection_close_t *const frame);
 
-static inline quic_err_t quic_sender_send_packet(quic_sender_module_t *const module, quic_send_packet_t *const pkt);
+static inline quic_send_packet_t *quic_sender_alloc_packet(quic_sender_module_t *const module, const uint32_t size);
+static inline void quic_sender_release_packet(quic_sender_module_t *const module, quic_send_packet_t *const pkt);
+
+static inline quic_err_t quic_sender_send_packet(quic_sender_module_t *const module, quic_send_packet_t *const pkt, const bool coalesced);
+static inline uint32_t quic_sender_append_probe_ping(quic_session_t *const session, quic_send_packet_t *const pkt);
+static bool quic_sender_send_datagram(quic_sender_module_t *const module, const bool probe);
 
 static quic_err_t quic_sender_module_init(void *const module);
 static quic_err_t quic_sender_module_loop(void *const module, const uint64_t now);
+static quic_err_t quic_sender_module_destory(void *const module);
 
 static inline quic_err_t  quic_sender_generate_long_header(quic_session_t *const session, const uint8_t type, quic_buf_t *const buf) {
     quic_long_header_t *const header = buf->pos;
     header->first_byte = type;
-    header->version = 0x00000000;
+    header->version = quic_bswap_32(QUIC_VERSION);
 
     quic_long_header_dst_conn_len(header) = quic_buf_size(&session->dst);
     memcpy(quic_long_header_dst_conn_off(header), session->dst.pos, quic_buf_size(&session->dst));
@@ -68,10 +75,14 @@ static inline quic_err_t quic_sender_generate_initial_header(quic_session_t *con
     uint8_t numlen = quic_packet_number_format_len(num);
     header->first_byte |= (uint8_t) (numlen - 1);
 
-    // TODO token
-    quic_varint_format_r(buf, 0);
+    // token
+    quic_varint_format_r(buf, quic_buf_size(&session->token));
+    if (!quic_buf_empty(&session->token)) {
+        memcpy(buf->pos, session->token.pos, quic_buf_size(&session->token));
+        buf->pos += quic_buf_size(&session->token);
+    }
 
-    // length
+    // length (packet number and AEAD tag included)
     quic_varint_format_r(buf, payload_len);
 
     // packet number
@@ -83,12 +94,26 @@ static inline quic_err_t quic_sender_generate_initial_header(quic_session_t *con
 
 static inline uint64_t quic_sender_initial_header_max_size(quic_session_t *const session, const uint64_t num, const uint64_t payload_max_len) {
     return 1 + 4 + 1 + quic_buf_size(&session->dst) + 1 + quic_buf_size(&session->src)
-        + quic_varint_format_len(0) + quic_varint_format_len(payload_max_len) + quic_packet_number_format_len(num);
+        + quic_varint_format_len(quic_buf_size(&session->token)) + quic_buf_size(&session->token)
+        + quic_varint_format_len(payload_max_len) + quic_packet_number_format_len(num);
 }
 
-static inline quic_err_t quic_sender_generate_0rtt_header(quic_sender_module_t *const sender, quic_buf_t *const buf) {
-    quic_session_t *const session = quic_module_of_session(sender);
+static inline quic_err_t quic_sender_generate_0rtt_header(quic_session_t *const session, const uint64_t num, const uint64_t payload_len, quic_buf_t *const buf) {
+    quic_long_header_t *header = buf->pos;
+
+    // first byte && version && dst conn id && src conn id
     quic_sender_generate_long_header(session, quic_packet_0rtt_type, buf);
+    // calc packet number length
+    uint8_t numlen = quic_packet_number_format_len(num);
+    header->first_byte |= (uint8_t) (numlen - 1);
+
+    // length (packet number and AEAD tag included)
+    quic_varint_format_r(buf, payload_len);
+
+    // packet number
+    quic_packet_number_format(buf->pos, num, numlen);
+    buf->pos += numlen;
+
     return quic_err_success;
 }
 
@@ -101,7 +126,7 @@ static inline quic_err_t quic_sender_generate_handshake_header(quic_session_t *c
     uint8_t numlen = quic_packet_number_format_len(num);
     header->first_byte |= (uint8_t) (numlen - 1);
 
-    // length
+    // length (packet number and AEAD tag included)
     quic_varint_format_r(buf, payload_len);
 
     // packet number
@@ -138,12 +163,8 @@ static inline quic_err_t quic_sender_generate_short_header(quic_session_t *const
 }
 
 
-static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t *const sender, const bool probe) {
+static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu) {
     quic_session_t *const session = quic_module_of_session(sender);
-    const uint32_t mtu = quic_session_path_mtu(session);
-    if (!mtu) {
-        return NULL;
-    }
 
     quic_packet_number_generator_module_t *const numgen = quic_session_module(session, quic_initial_packet_number_generator_module);
     quic_ack_generator_module_t *const ag_module = quic_session_module(session, quic_initial_ack_generator_module);
@@ -151,13 +172,18 @@ static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t
     quic_sealer_module_t *const s_module = quic_session_module(session, quic_sealer_module);
     quic_sealer_t *const sealer = &s_module->initial_sealer;
 
-    if (!quic_sealer_should_send(s_module, ssl_encryption_initial) && quic_retransmission_empty(r_module)) {
+    if (!quic_sealer_should_send(s_module, ssl_encryption_initial) && quic_retransmission_empty(r_module) && !r_module->probes) {
+        return NULL;
+    }
+    if (mtu <= quic_sender_initial_header_max_size(session, numgen->next, mtu) + sealer->w_aead_tag_size) {
         return NULL;
     }
 
     // init send_pkt
-    quic_send_packet_t *pkt = NULL;
-    quic_send_packet_init(pkt, mtu);
+    quic_send_packet_t *const pkt = quic_sender_alloc_packet(sender, mtu);
+    if (!pkt) {
+        return NULL;
+    }
     pkt->retransmission_module = quic_session_module(session, quic_initial_retransmission_module);
     pkt->num = numgen->next;
 
@@ -193,18 +219,31 @@ static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t
             pkt->included_unacked = true;
         }
     }
+    payload_len += quic_sender_append_probe_ping(session, pkt);
 
     if (liteco_link_empty(&pkt->frames)) {
-        free(pkt);
+        quic_sender_release_packet(sender, pkt);
         return NULL;
     }
 
+    // servers drop client Initial datagrams below QUIC_INITIAL_DATAGRAM_MIN_SIZE
+    const uint32_t pkt_size = quic_sender_initial_header_max_size(session, pkt->num, QUIC_INITIAL_DATAGRAM_MIN_SIZE) + payload_len + sealer->w_aead_tag_size;
+    if (session->cfg.is_cli && pkt_size < QUIC_INITIAL_DATAGRAM_MIN_SIZE && QUIC_INITIAL_DATAGRAM_MIN_SIZE <= mtu) {
+        quic_frame_padding_t *padding = NULL;
+        quic_frame_create(padding, &session->frame_pool, quic_frame_padding_type, sizeof(quic_frame_padding_t));
+        if (padding) {
+            padding->len = QUIC_INITIAL_DATAGRAM_MIN_SIZE - pkt_size;
+            liteco_link_insert_before(&pkt->frames, padding);
+            payload_len += padding->len;
+        }
+    }
+
     numgen->next++;
 
-    uint8_t hdr_slice[512 + 16] = { 0 };
-    quic_buf_t hdr = { .buf = hdr_slice, .capa = sizeof(hdr_slice) };
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
     quic_buf_setpl(&hdr);
-    quic_sender_generate_initial_header(session, pkt->num, payload_len, &hdr);
+    quic_sender_generate_initial_header(session, pkt->num, payload_len + quic_packet_number_format_len(pkt->num) + sealer->w_aead_tag_size, &hdr);
     quic_buf_write_complete(&hdr);
 
     quic_sealer_seal(pkt, sealer, hdr, quic_buf_size(&session->dst));
@@ -212,12 +251,8 @@ static quic_send_packet_t *quic_sender_pack_initial_packet(quic_sender_module_t
     return pkt;
 }
 
-static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_t *const sender, const bool probe) {
+static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu) {
     quic_session_t *const session = quic_module_of_session(sender);
-    const uint32_t mtu = quic_session_path_mtu(session);
-    if (!mtu) {
-        return NULL;
-    }
 
     quic_packet_number_generator_module_t *const numgen = quic_session_module(session, quic_handshake_packet_number_generator_module);
     quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
@@ -226,13 +261,18 @@ static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_
     quic_sealer_module_t *const s_module = quic_session_module(session, quic_sealer_module);
     quic_sealer_t *const sealer = &s_module->handshake_sealer;
 
-    if (!quic_sealer_should_send(s_module, ssl_encryption_handshake) && quic_framer_ctrl_empty(f_module) && quic_retransmission_empty(r_module)) {
+    if (!quic_sealer_should_send(s_module, ssl_encryption_handshake) && quic_framer_ctrl_empty(f_module) && quic_retransmission_empty(r_module) && !r_module->probes) {
+        return NULL;
+    }
+    if (mtu <= quic_sender_handshake_header_max_size(session, numgen->next, mtu) + sealer->w_aead_tag_size) {
         return NULL;
     }
 
     // init send_pkt
-    quic_send_packet_t *pkt = NULL;
-    quic_send_packet_init(pkt, mtu);
+    quic_send_packet_t *const pkt = quic_sender_alloc_packet(sender, mtu);
+    if (!pkt) {
+        return NULL;
+    }
     pkt->retransmission_module = quic_session_module(session, quic_handshake_retransmission_module);
     pkt->num = numgen->next;
 
@@ -279,19 +319,20 @@ static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_
             pkt->included_unacked = true;
         }
     }
+    payload_len += quic_sender_append_probe_ping(session, pkt);
 
     if (liteco_link_empty(&pkt->frames)) {
-        free(pkt);
+        quic_sender_release_packet(sender, pkt);
         return NULL;
     }
 
     numgen->next++;
 
-    uint8_t hdr_slice[512 + 16] = { 0 };
-    quic_buf_t hdr = { .buf = hdr_slice, .capa = sizeof(hdr_slice) };
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
     quic_buf_setpl(&hdr);
 
-    quic_sender_generate_handshake_header(session, pkt->num, payload_len, &hdr);
+    quic_sender_generate_handshake_header(session, pkt->num, payload_len + quic_packet_number_format_len(pkt->num) + sealer->w_aead_tag_size, &hdr);
     quic_buf_write_complete(&hdr);
 
     quic_sealer_seal(pkt, sealer, hdr, quic_buf_size(&session->dst));
@@ -299,12 +340,77 @@ static quic_send_packet_t *quic_sender_pack_handshake_packet(quic_sender_module_
     return pkt;
 }
 
-static quic_send_packet_t *quic_sender_pack_app_packet(quic_sender_module_t *const sender, const bool probe) {
+static quic_send_packet_t *quic_sender_pack_0rtt_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu) {
     quic_session_t *const session = quic_module_of_session(sender);
-    const uint32_t mtu = quic_session_path_mtu(session);
-    if (!mtu) {
+
+    quic_packet_number_generator_module_t *const numgen = quic_session_module(session, quic_app_packet_number_generator_module);
+    quic_framer_module_t *const f_module = quic_session_module(session, quic_framer_module);
+    quic_retransmission_module_t *const r_module = quic_session_module(session, quic_app_retransmission_module);
+    quic_sealer_t *const sealer = &((quic_sealer_module_t *) quic_session_module(session, quic_sealer_module))->early_sealer;
+
+    // 0-RTT packets carry no ACK frames, and nothing to probe with
+    if (probe || quic_framer_empty(f_module)) {
+        return NULL;
+    }
+    // the 0-RTT long header has the same layout as the handshake one
+    if (mtu <= quic_sender_handshake_header_max_size(session, numgen->next, mtu) + sealer->w_aead_tag_size) {
+        return NULL;
+    }
+
+    // init send_pkt
+    quic_send_packet_t *const pkt = quic_sender_alloc_packet(sender, mtu);
+    if (!pkt) {
         return NULL;
     }
+    pkt->retransmission_module = r_module;
+    pkt->num = numgen->next;
+
+    uint32_t max_bytes = pkt->buf.capa - quic_sender_handshake_header_max_size(session, pkt->num, mtu) - sealer->w_aead_tag_size;
+    uint32_t frame_len = 0;
+    uint32_t payload_len = 0;
+
+    // serialize ctrl frames
+    for ( ;; ) {
+        frame_len = quic_framer_append_ctrl_frame(&pkt->frames, max_bytes, f_module);
+        max_bytes -= frame_len;
+        payload_len += frame_len;
+        if (frame_len == 0) {
+            break;
+        }
+        pkt->included_unacked = true;
+    }
+    // serialize stream frames
+    for ( ;; ) {
+        frame_len = quic_framer_append_stream_frame(&pkt->frames, max_bytes, false, f_module, r_module);
+        max_bytes -= frame_len;
+        payload_len += frame_len;
+        if (frame_len == 0) {
+            break;
+        }
+        pkt->included_unacked = true;
+    }
+
+    if (liteco_link_empty(&pkt->frames)) {
+        quic_sender_release_packet(sender, pkt);
+        return NULL;
+    }
+
+    numgen->next++;
+
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
+    quic_buf_setpl(&hdr);
+
+    quic_sender_generate_0rtt_header(session, pkt->num, payload_len + quic_packet_number_format_len(pkt->num) + sealer->w_aead_tag_size, &hdr);
+    quic_buf_write_complete(&hdr);
+
+    quic_sealer_seal(pkt, sealer, hdr, quic_buf_size(&session->dst));
+
+    return pkt;
+}
+
+static quic_send_packet_t *quic_sender_pack_app_packet(quic_sender_module_t *const sender, const bool probe, const uint32_t mtu) {
+    quic_session_t *const session = quic_module_of_session(sender);
 
     quic_stream_module_t *const stream_module = quic_session_module(session, quic_stream_module);
     quic_packet_number_generator_module_t *const numgen = quic_session_module(session, quic_app_packet_number_generator_module);
@@ -316,18 +422,23 @@ static quic_send_packet_t *quic_sender_pack_app_packet(quic_sender_module_t *con
     // generate max stream data
     quic_stream_module_process_rwnd(stream_module);
 
-    if (quic_framer_empty(f_module) && quic_retransmission_empty(r_module) && !quic_ack_generator_should_send(ag_module)) {
+    if (quic_framer_empty(f_module) && quic_retransmission_empty(r_module) && !quic_ack_generator_should_send(ag_module) && !r_module->probes) {
+        return NULL;
+    }
+    if (mtu <= 1 + quic_buf_size(&session->dst) + quic_packet_number_format_len(numgen->next) + sealer->w_aead_tag_size) {
         return NULL;
     }
 
     // init send_pkt
-    quic_send_packet_t *pkt = NULL;
-    quic_send_packet_init(pkt, mtu);
+    quic_send_packet_t *const pkt = quic_sender_alloc_packet(sender, mtu);
+    if (!pkt) {
+        return NULL;
+    }
     pkt->retransmission_module = quic_session_module(session, quic_app_retransmission_module);
     pkt->num = numgen->next;
 
-    uint8_t hdr_slice[256 + 16] = { 0 };
-    quic_buf_t hdr = { .buf = hdr_slice, .capa = sizeof(hdr_slice) };
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
     quic_buf_setpl(&hdr);
 
     // generate short header
@@ -371,9 +482,10 @@ static quic_send_packet_t *quic_sender_pack_app_packet(quic_sender_module_t *con
             pkt->included_unacked = true;
         }
     }
+    quic_sender_append_probe_ping(session, pkt);
 
     if (liteco_link_empty(&pkt->frames)) {
-        free(pkt);
+        quic_sender_release_packet(sender, pkt);
         return NULL;
     }
 
@@ -388,19 +500,52 @@ static quic_err_t quic_sender_module_init(void *const module) {
     quic_sender_module_t *const s_module = module;
 
     s_module->next_send_time = 0;
+    s_module->spare = NULL;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_sender_module_destory(void *const module) {
+    quic_sender_module_t *const s_module = module;
+
+    if (s_module->spare) {
+        quic_free(s_module->spare);
+        s_module->spare = NULL;
+    }
 
     return quic_err_success;
 }
 
+static inline quic_send_packet_t *quic_sender_alloc_packet(quic_sender_module_t *const module, const uint32_t size) {
+    quic_send_packet_t *pkt = module->spare;
+
+    if (pkt && pkt->alloc_size >= size) {
+        module->spare = NULL;
+        quic_send_packet_reset(pkt, size);
+        return pkt;
+    }
+
+    quic_send_packet_init(pkt, size);
+    return pkt;
+}
+
+static inline void quic_sender_release_packet(quic_sender_module_t *const module, quic_send_packet_t *const pkt) {
+    if (module->spare && module->spare->alloc_size >= pkt->alloc_size) {
+        quic_free(pkt);
+        return;
+    }
+    if (module->spare) {
+        quic_free(module->spare);
+    }
+    module->spare = pkt;
+}
+
 static quic_err_t quic_sender_module_loop(void *const module, const uint64_t now) {
     quic_sender_module_t *const sender_module = module;
     quic_session_t *const session = quic_module_of_session(sender_module);
-    quic_sealer_module_t *const sealer_module = quic_session_module(session, quic_sealer_module);
-
-    bool probe = false;
 
     if (now < sender_module->next_send_time && sender_module->next_send_time != 0) {
-        quic_session_update_loop_deadline(session, sender_module->next_send_time);
+        quic_session_set_deadline(session, quic_session_deadline_pacing, sender_module->next_send_time);
         return quic_err_success;
     }
     sender_module->next_send_time = 0;
@@ -410,78 +555,173 @@ static quic_err_t quic_sender_module_loop(void *const module, const uint64_t now
     quic_retransmission_module_t *const init_r_module = quic_session_module(session, quic_initial_retransmission_module);
     quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
 
-    quic_send_packet_t *pkt = NULL;
+    // send up to send_burst_size datagrams per loop while the pacer allows it
+    const uint32_t burst_size = session->cfg.send_burst_size ? session->cfg.send_burst_size : 1;
+    uint32_t i;
+    for (i = 0; i < burst_size; i++) {
+        // PTO probes are sent whatever the congestion window and the pacer say
+        const bool probing = app_r_module->probes || hs_r_module->probes || init_r_module->probes;
+        const uint64_t unacked_pkt_count = app_r_module->sent_mem.count + hs_r_module->sent_mem.count + init_r_module->sent_mem.count;
+        if (!probing && unacked_pkt_count >= (25000 >> 2)) {
+            break;
+        }
+
+        const uint64_t unacked_bytes = app_r_module->unacked_len + hs_r_module->unacked_len + init_r_module->unacked_len;
+        const bool probe = !probing && (!quic_congestion_allow_send(c_module, unacked_bytes) || unacked_pkt_count >= 20000);
+
+        if (!probing && !quic_congestion_has_budget(c_module)) {
+            break;
+        }
+        if (!quic_sender_send_datagram(sender_module, probe)) {
+            // the window and the pacer were not the limit
+            if (!probe && !probing) {
+                quic_congestion_on_app_limited(c_module);
+            }
+            break;
+        }
+        if (probe) {
+            break;
+        }
+
+        sender_module->next_send_time = quic_congestion_next_send_time(c_module, unacked_bytes);
+        if (sender_module->next_send_time > quic_now()) {
+            quic_session_set_deadline(session, quic_session_deadline_pacing, sender_module->next_send_time);
+            break;
+        }
+        sender_module->next_send_time = 0;
+    }
 
-    uint64_t unacked_pkt_count = app_r_module->sent_pkt_count + hs_r_module->sent_pkt_count + init_r_module->sent_pkt_count;
-    if (unacked_pkt_count >= (25000 >> 2)) {
-        goto finished;
+    // the burst is exhausted, continue on the next loop so that the other modules get a chance to run
+    if (i == burst_size) {
+        quic_module_activate(session, quic_sender_module);
     }
 
-    uint64_t unacked_bytes = app_r_module->unacked_len + hs_r_module->unacked_len + init_r_module->unacked_len;
-    probe = !quic_congestion_allow_send(c_module, unacked_bytes) || unacked_pkt_count >= 20000;
+    return quic_err_success;
+}
+
+static bool quic_sender_send_datagram(quic_sender_module_t *const module, const bool probe) {
+    quic_session_t *const session = quic_module_of_session(module);
+    quic_sealer_module_t *const sealer_module = quic_session_module(session, quic_sealer_module);
+    quic_send_packet_t *pkt = NULL;
+    uint32_t remain = quic_session_path_mtu(session);
+    uint32_t count = 0;
 
-    if (!quic_congestion_has_budget(c_module)) {
-        goto finished;
+    if (!remain) {
+        return false;
     }
 
+    // coalesce the packets of every pending encryption level into one datagram
     switch (sealer_module->level) {
     case ssl_encryption_initial:
-        pkt = quic_sender_pack_initial_packet(sender_module, probe);
+        pkt = quic_sender_pack_initial_packet(module, probe, remain);
         if (pkt != NULL) {
-            break;
+            quic_sender_send_packet(module, pkt, count++ != 0);
+            remain -= quic_buf_size(&pkt->buf);
+            quic_sender_release_packet(module, pkt);
         }
     case ssl_encryption_handshake:
-        pkt = quic_sender_pack_handshake_packet(sender_module, probe);
+        pkt = remain >= QUIC_SENDER_COALESCE_MIN_SIZE ? quic_sender_pack_handshake_packet(module, probe, remain) : NULL;
         if (pkt != NULL) {
             quic_sealer_set_level(sealer_module, ssl_encryption_handshake);
+
+            quic_sender_send_packet(module, pkt, count++ != 0);
+            remain -= quic_buf_size(&pkt->buf);
+            quic_sender_release_packet(module, pkt);
+        }
+        if (!sealer_module->app_sealer.w_aead) {
+            // a resuming client sends its request data in 0-RTT until the 1-RTT keys are ready
+            pkt = quic_sealer_in_early_data(sealer_module) && remain >= QUIC_SENDER_COALESCE_MIN_SIZE
+                ? quic_sender_pack_0rtt_packet(module, probe, remain) : NULL;
+            if (pkt != NULL) {
+                quic_sender_send_packet(module, pkt, count++ != 0);
+                quic_sender_release_packet(module, pkt);
+            }
+            break;
         }
-        break;
     case ssl_encryption_application:
-        pkt = quic_sender_pack_app_packet(sender_module, probe);
+        pkt = remain >= QUIC_SENDER_COALESCE_MIN_SIZE ? quic_sender_pack_app_packet(module, probe, remain) : NULL;
+        if (pkt != NULL) {
+            quic_sender_send_packet(module, pkt, count++ != 0);
+            quic_sender_release_packet(module, pkt);
+        }
         break;
     case ssl_encryption_early_data:
         // ignore
         break;
     }
 
-finished:
-    if (pkt != NULL) {
-        quic_sender_send_packet(sender_module, pkt);
-        free(pkt);
+    return count != 0;
+}
 
-        if (!probe) {
-            sender_module->next_send_time = quic_congestion_next_send_time(c_module, unacked_bytes);
-            quic_session_update_loop_deadline(session, sender_module->next_send_time);
+static inline uint32_t quic_sender_append_probe_ping(quic_session_t *const session, quic_send_packet_t *const pkt) {
+    quic_ack_generator_module_t *const ag_module = quic_session_module(session, quic_app_ack_generator_module);
+
+    if (!pkt->retransmission_module->probes) {
+        return 0;
+    }
+
+    // the peer may be delaying its ACKs, a probe asks for one at once
+    if (pkt->retransmission_module == quic_session_module(session, quic_app_retransmission_module) && ag_module->peer_min_ack_delay) {
+        quic_frame_immediate_ack_t *immediate_ack = NULL;
+        quic_frame_create(immediate_ack, &session->frame_pool, quic_frame_immediate_ack_type, sizeof(quic_frame_immediate_ack_t));
+        if (immediate_ack) {
+            liteco_link_insert_before(&pkt->frames, immediate_ack);
+            pkt->included_unacked = true;
+            return quic_frame_size(immediate_ack);
         }
     }
 
-    return quic_err_success;
+    // a probe must be ack-eliciting, a PING is added when the packet carries nothing else
+    if (pkt->included_unacked) {
+        return 0;
+    }
+
+    quic_frame_ping_t *ping = NULL;
+    quic_frame_create(ping, &session->frame_pool, quic_frame_ping_type, sizeof(quic_frame_ping_t));
+    if (!ping) {
+        return 0;
+    }
+    liteco_link_insert_before(&pkt->frames, ping);
+    pkt->included_unacked = true;
+
+    return quic_frame_size(ping);
 }
 
-static inline quic_err_t quic_sender_send_packet(quic_sender_module_t *const module, quic_send_packet_t *const pkt) {
+static inline quic_err_t quic_sender_send_packet(quic_sender_module_t *const module, quic_send_packet_t *const pkt, const bool coalesced) {
     quic_session_t *const session = quic_module_of_session(module);
     quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
 
-    quic_sent_packet_rbt_t *sent_pkt = malloc(sizeof(quic_sent_packet_rbt_t));
-    if (sent_pkt) {
-        liteco_rbt_node_init(sent_pkt);
-        sent_pkt->key = pkt->num;
+    const uint64_t sent_time = quic_now();
+    const uint32_t pkt_len = pkt->buf.pos - pkt->buf.buf;
 
-        // note: linked lists have been transferred to 'mem', no need to release them
-        sent_pkt->frames.next = pkt->frames.next;
-        sent_pkt->frames.next->prev = &sent_pkt->frames;
-        sent_pkt->frames.prev = pkt->frames.prev;
-        sent_pkt->frames.prev->next = &sent_pkt->frames;
+    if (pkt->included_unacked && pkt->retransmission_module->probes) {
+        pkt->retransmission_module->probes--;
+    }
 
+    quic_sent_packet_t *const sent_pkt = quic_retransmission_sent_mem_push(pkt->retransmission_module, pkt->num, sent_time, pkt_len, pkt->included_unacked);
+    if (sent_pkt) {
+        // note: linked lists have been transferred to 'mem', no need to release them
+        if (!liteco_link_empty(&pkt->frames)) {
+            sent_pkt->frames.next = pkt->frames.next;
+            sent_pkt->frames.next->prev = &sent_pkt->frames;
+            sent_pkt->frames.prev = pkt->frames.prev;
+            sent_pkt->frames.prev->next = &sent_pkt->frames;
+        }
         sent_pkt->largest_ack = pkt->largest_ack;
-        sent_pkt->sent_time = quic_now();
-        sent_pkt->pkt_len = pkt->buf.pos - pkt->buf.buf;
-        sent_pkt->included_unacked = pkt->included_unacked;
 
-        quic_retransmission_sent_mem_push(pkt->retransmission_module, sent_pkt);
-        quic_congestion_on_sent(c_module, sent_pkt->sent_time, sent_pkt->key, sent_pkt->pkt_len, sent_pkt->included_unacked);
+        quic_congestion_on_sent(c_module, quic_retransmission_space(pkt->retransmission_module), sent_time, pkt->num, pkt_len, pkt->included_unacked);
+    }
+    else {
+        while (!liteco_link_empty(&pkt->frames)) {
+            quic_frame_t *frame = (quic_frame_t *) liteco_link_next(&pkt->frames);
+            liteco_link_remove(frame);
+            quic_frame_free(frame);
+        }
     }
 
+    if (coalesced) {
+        return quic_session_send_coalesced(session, pkt->data, quic_buf_size(&pkt->buf));
+    }
     return quic_session_send(session, pkt->data, quic_buf_size(&pkt->buf));
 }
 
@@ -492,18 +732,20 @@ quic_module_t quic_sender_module = {
     .start       = NULL,
     .process     = NULL,
     .loop        = quic_sender_module_loop,
-    .destory     = NULL
+    .destory     = quic_sender_module_destory
 };
 
 quic_send_packet_t *quic_sender_pack_connection_close(quic_sender_module_t *const sender, const uint64_t type, const uint64_t errcode, const quic_buf_t reason) {
     quic_session_t *const session = quic_module_of_session(sender);
     quic_sealer_module_t *const sealer = quic_session_module(session, quic_sealer_module);
 
-    quic_frame_connection_close_t *const frame = malloc(sizeof(quic_frame_connection_close_t) + quic_buf_size(&reason)); 
+    quic_frame_connection_close_t *frame = NULL;
+    quic_frame_create(frame, &session->frame_pool,
+                      session->quic_closed ? quic_frame_quic_connection_close_type : quic_frame_app_connection_close_type,
+                      sizeof(quic_frame_connection_close_t) + quic_buf_size(&reason));
     if (!frame) {
         return NULL;
     }
-    quic_frame_init(frame, session->quic_closed ? quic_frame_quic_connection_close_type : quic_frame_app_connection_close_type);
     frame->type = type;
     frame->err = errcode;
     frame->len = quic_buf_size(&reason);
@@ -525,7 +767,7 @@ quic_send_packet_t *quic_sender_pack_connection_close(quic_sender_module_t *cons
         break;
     }
 
-    free(frame);
+    quic_frame_free(frame);
 
     return pkt;
 }
@@ -547,11 +789,11 @@ static quic_send_packet_t *quic_sender_pack_initial_connection_close(quic_sender
 
     size_t payload_len = quic_frame_size(frame);
 
-    uint8_t hdr_slice[512 + 16] = { 0 };
-    quic_buf_t hdr = { .buf = hdr_slice, .capa = sizeof(hdr_slice) };
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
     quic_buf_setpl(&hdr);
 
-    quic_sender_generate_initial_header(session, pkt->num, payload_len, &hdr);
+    quic_sender_generate_initial_header(session, pkt->num, payload_len + quic_packet_number_format_len(pkt->num) + sealer->w_aead_tag_size, &hdr);
     quic_buf_write_complete(&hdr);
 
     liteco_link_insert_after(&pkt->frames, frame);
@@ -577,11 +819,11 @@ static quic_send_packet_t *quic_sender_pack_handshake_connection_close(quic_send
 
     size_t payload_len = quic_frame_size(frame);
 
-    uint8_t hdr_slice[512 + 16] = { 0 };
-    quic_buf_t hdr = { .buf = hdr_slice, .capa = sizeof(hdr_slice) };
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
     quic_buf_setpl(&hdr);
 
-    quic_sender_generate_handshake_header(session, pkt->num, payload_len, &hdr);
+    quic_sender_generate_handshake_header(session, pkt->num, payload_len + quic_packet_number_format_len(pkt->num) + sealer->w_aead_tag_size, &hdr);
     quic_buf_write_complete(&hdr);
 
     liteco_link_insert_after(&pkt->frames, frame);
@@ -604,8 +846,8 @@ static quic_send_packet_t *quic_sender_pack_app_connection_close(quic_sender_mod
     quic_send_packet_init(pkt, mtu);
     pkt->num = numgen->next;
 
-    uint8_t hdr_slice[256 + 16] = { 0 };
-    quic_buf_t hdr = { .buf = hdr_slice, .capa = sizeof(hdr_slice) };
+    // the header is generated in place, in front of the frames
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = pkt->buf.capa };
     quic_buf_setpl(&hdr);
 
     quic_sender_generate_short_header(session, pkt->num, &hdr);
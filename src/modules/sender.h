@@ -15,18 +15,27 @@
 #include "module.h"
 #include "liteco.h"
 
+#ifndef QUIC_SENDER_COALESCE_MIN_SIZE
+#define QUIC_SENDER_COALESCE_MIN_SIZE 256
+#endif
+
+#define quic_send_packet_reset(send_pkt, size) { \
+    liteco_link_init((send_pkt));               \
+    liteco_link_init(&(send_pkt)->frames);      \
+    (send_pkt)->buf.buf = (send_pkt)->data;     \
+    (send_pkt)->buf.capa = (size);              \
+    (send_pkt)->largest_ack = 0;                \
+    (send_pkt)->included_unacked = false;       \
+    quic_buf_setpl(&(send_pkt)->buf);           \
+}
+
 #define quic_send_packet_init(send_pkt, size) {                    \
     (send_pkt) = quic_malloc(sizeof(quic_send_packet_t) + (size)); \
     if ((send_pkt) == NULL) {                                      \
         return NULL;                                               \
     }                                                              \
-    liteco_link_init((send_pkt));                                  \
-    liteco_link_init(&(send_pkt)->frames);                         \
-    (send_pkt)->buf.buf = (send_pkt)->data;                        \
-    (send_pkt)->buf.capa = (size);                                 \
-    (send_pkt)->largest_ack = 0;                                   \
-    (send_pkt)->included_unacked = false;                          \
-    quic_buf_setpl(&(send_pkt)->buf);                              \
+    (send_pkt)->alloc_size = (size);                               \
+    quic_send_packet_reset((send_pkt), (size));                    \
 }
 
 typedef struct quic_send_packet_s quic_send_packet_t;
@@ -40,6 +49,7 @@ struct quic_send_packet_s {
 
     liteco_linknode_t frames;
     quic_buf_t buf;
+    uint32_t alloc_size;
 
     uint8_t data[0];
 };
@@ -49,6 +59,9 @@ struct quic_sender_module_s {
     QUIC_MODULE_FIELDS
 
     uint64_t next_send_time;
+
+    // the last released packet buffer, reused by the next packed packet
+    quic_send_packet_t *spare;
 };
 
 extern quic_module_t quic_sender_module;
@@ -152,9 +152,9 @@ quic_frame_stream_t *quic_send_stream_generate(quic_send_stream_t *const str, bo
     if (payload_size == 0 && !str->closed) {
         uint64_t max_data = 0;
         if (quic_stream_flowctrl_newly_blocked(flowctrl_module, &max_data, quic_stream_extend_flowctrl(p_str))) {
-            quic_frame_stream_data_blocked_t *blocked_frame = malloc(sizeof(quic_frame_stream_data_blocked_t));
+            quic_frame_stream_data_blocked_t *blocked_frame = NULL;
+            quic_frame_create(blocked_frame, &p_str->session->frame_pool, quic_frame_stream_data_blocked_type, sizeof(quic_frame_stream_data_blocked_t));
             if (blocked_frame) {
-                quic_frame_init(blocked_frame, quic_frame_stream_data_blocked_type);
                 blocked_frame->sid = p_str->key;
                 blocked_frame->max_data = max_data;
 
@@ -166,12 +166,12 @@ quic_frame_stream_t *quic_send_stream_generate(quic_send_stream_t *const str, bo
         return NULL;
     }
 
-    quic_frame_stream_t *frame = quic_malloc(sizeof(quic_frame_stream_t) + payload_size);
+    quic_frame_stream_t *frame = NULL;
+    quic_frame_create(frame, &p_str->session->frame_pool, quic_frame_stream_type, sizeof(quic_frame_stream_t) + payload_size);
     if (frame == NULL) {
         pthread_mutex_unlock(&str->mtx);
         return NULL;
     }
-    quic_frame_init(frame, quic_frame_stream_type);
     frame->on_acked = quic_send_stream_on_acked;
     frame->acked_obj = str;
 
@@ -184,6 +184,7 @@ quic_frame_stream_t *quic_send_stream_generate(quic_send_stream_t *const str, bo
     frame->sid = p_str->key;
     frame->off = str->off;
     frame->len = payload_size;
+    frame->ref = NULL;
     str->off += payload_size;
 
     if (str->reader_len == 0) {
@@ -262,7 +263,12 @@ static int quic_stream_read_co(void *const args) {
             if (readed) {
                 break;
             }
+            str->direct_buf = data;
+            str->direct_len = len;
+            str->direct_readed = 0;
             pthread_mutex_unlock(&str->mtx);
+
+            bool timeout = false;
             if (str->deadline) {
                 liteco_timer_chan_start(&io->tchan, str->deadline, 0);
                 liteco_case_t cases[] = {
@@ -270,14 +276,30 @@ static int quic_stream_read_co(void *const args) {
                     { .chan = &str->handled_chan, .type = liteco_casetype_pop, .ele = NULL }
                 };
 
-                if (liteco_select(cases, 2, true)->chan == liteco_timer_chan(&io->tchan)) {
-                    break;
-                }
+                timeout = liteco_select(cases, 2, true)->chan == liteco_timer_chan(&io->tchan);
             }
             else {
                 liteco_chan_pop(&str->handled_chan, true);
             }
+
             pthread_mutex_lock(&str->mtx);
+            uint64_t direct_readed = str->direct_readed;
+            str->direct_buf = NULL;
+            str->direct_len = 0;
+            str->direct_readed = 0;
+
+            if (direct_readed != 0) {
+                readed_len += direct_readed;
+                len -= direct_readed;
+                data = (uint8_t *) data + direct_readed;
+
+                quic_stream_flowctrl_read(sf_module, quic_stream_extend_flowctrl(p_str), p_str->key, direct_readed);
+                readed = true;
+                continue;
+            }
+            if (timeout) {
+                break;
+            }
         }
         uint64_t once_readed_len = quic_sorter_read(&str->sorter, len, data);
         if (once_readed_len == 0) {
@@ -569,6 +591,8 @@ static inline quic_err_t quic_stream_destory_push(quic_stream_module_t *const mo
     }
     pthread_mutex_unlock(&module->destory_mtx);
 
+    quic_module_activate(quic_module_of_session(module), quic_stream_module);
+
     return quic_err_success;
 }
 
@@ -623,7 +647,7 @@ static inline quic_err_t quic_stream_set_delete(quic_stream_module_t *const modu
 }
 
 static quic_err_t quic_send_stream_on_acked(void *const str_, const quic_frame_t *const frame_) {
-    free((void *) frame_);
+    quic_frame_free(frame_);
 
     quic_send_stream_t *const str = (quic_send_stream_t *) str_;
 
@@ -643,6 +667,7 @@ static quic_err_t quic_stream_module_loop(void *const module, const uint64_t now
     quic_session_t *const session = quic_module_of_session(module);
     quic_stream_destory_sid_t *d_sid = NULL;
     liteco_linknode_t destoryed_list;
+    uint64_t deadline = 0;
 
     liteco_link_init(&destoryed_list);
 
@@ -666,9 +691,15 @@ static quic_err_t quic_stream_module_loop(void *const module, const uint64_t now
                     str = liteco_rbt_find(stream_module->inuni.streams, &d_sid->key);
                 }
             }
-            if (liteco_rbt_is_nil(str) || !(quic_stream_destroable(str)
-                                            || (session->cfg.stream_destory_timeout != 0
-                                                && session->cfg.stream_destory_timeout + d_sid->destory_time >= now))) {
+            if (liteco_rbt_is_nil(str)) {
+                continue;
+            }
+            if (!quic_stream_destroable(str)
+                && (session->cfg.stream_destory_timeout == 0 || session->cfg.stream_destory_timeout + d_sid->destory_time > now)) {
+                if (session->cfg.stream_destory_timeout != 0
+                    && (!deadline || session->cfg.stream_destory_timeout + d_sid->destory_time < deadline)) {
+                    deadline = session->cfg.stream_destory_timeout + d_sid->destory_time;
+                }
                 continue;
             }
 
@@ -703,6 +734,8 @@ static quic_err_t quic_stream_module_loop(void *const module, const uint64_t now
     }
     pthread_mutex_unlock(&stream_module->destory_mtx);
 
+    quic_session_set_deadline(session, quic_session_deadline_stream_destory, deadline);
+
     return quic_err_success;
 }
 
@@ -761,9 +794,9 @@ quic_err_t quic_stream_module_process_rwnd(quic_stream_module_t *const module) {
         if (str && liteco_rbt_is_not_nil(str)) {
             quic_stream_flowctrl_t *const flowctrl = quic_stream_extend_flowctrl(str);
 
-            quic_frame_max_stream_data_t *frame = malloc(sizeof(quic_frame_max_stream_data_t));
+            quic_frame_max_stream_data_t *frame = NULL;
+            quic_frame_create(frame, &session->frame_pool, quic_frame_max_stream_data_type, sizeof(quic_frame_max_stream_data_t));
             if (frame) {
-                quic_frame_init(frame, quic_frame_max_stream_data_type);
                 frame->sid = str->key;
                 frame->max_data = flowctrl->rwnd;
 
@@ -837,12 +870,18 @@ static inline quic_err_t quic_recv_stream_handle_frame(quic_recv_stream_t *const
         return quic_err_success;
     }
 
+    const uint8_t *const payload = quic_frame_payload(frame);
     uint64_t readable_size = quic_sorter_readable(&str->sorter);
-    if ((err = quic_sorter_write(&str->sorter, frame->off, frame->len, frame->data)) != quic_err_success) {
+    uint64_t direct_readed = str->direct_readed;
+    if (str->direct_buf && str->direct_readed < str->direct_len) {
+        str->direct_readed += quic_sorter_read_through(&str->sorter, frame->off, frame->len, payload,
+                                                       (uint8_t *) str->direct_buf + str->direct_readed, str->direct_len - str->direct_readed);
+    }
+    if ((err = quic_sorter_write(&str->sorter, frame->off, frame->len, payload)) != quic_err_success) {
         pthread_mutex_unlock(&str->mtx);
         return quic_err_success;
     }
-    bool notify = readable_size != quic_sorter_readable(&str->sorter);
+    bool notify = readable_size != quic_sorter_readable(&str->sorter) || direct_readed != str->direct_readed;
 
     pthread_mutex_unlock(&str->mtx);
 
@@ -110,6 +110,11 @@ struct quic_recv_stream_s {
 
     uint64_t deadline;
 
+    // buffer of a reader waiting on an empty stream, in-order frames are copied straight into it
+    void *direct_buf;
+    uint64_t direct_len;
+    uint64_t direct_readed;
+
     bool closed;
 };
 
@@ -122,6 +127,9 @@ __quic_header_inline quic_err_t quic_recv_stream_init(quic_recv_stream_t *const
     str->final_off = QUIC_SORTER_MAX_SIZE;
     str->fin_flag = false;
     str->deadline = 0;
+    str->direct_buf = NULL;
+    str->direct_len = 0;
+    str->direct_readed = 0;
     str->closed = false;
 
     return quic_err_success;
@@ -228,8 +236,6 @@ struct quic_stream_module_s {
 
 __quic_header_inline quic_err_t quic_stream_module_update_rwnd(quic_stream_module_t *const module, const uint64_t sid) {
     quic_session_t *const session = quic_module_of_session(module);
-    quic_sender_module_t *s_module = quic_session_module(session, quic_sender_module);
-
     pthread_mutex_lock(&module->rwnd_updated_mtx);
     if (liteco_rbt_is_nil(liteco_rbt_find(module->rwnd_updated, &sid))) {
         quic_stream_rwnd_updated_sid_t *updated_sid = quic_malloc(sizeof(quic_stream_rwnd_updated_sid_t));
@@ -239,7 +245,7 @@ __quic_header_inline quic_err_t quic_stream_module_update_rwnd(quic_stream_modul
 
             liteco_rbt_insert(&module->rwnd_updated, updated_sid);
 
-            quic_module_activate(session, s_module);
+            quic_module_activate(session, quic_sender_module);
         }
     }
     pthread_mutex_unlock(&module->rwnd_updated_mtx);
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "offload.h"
+
+static void *quic_offload_thread(void *const args);
+static void quic_offload_port_cb(liteco_async_t *const event);
+
+quic_err_t quic_offload_init(quic_offload_t *const offload, const uint32_t threads_count) {
+    uint32_t i;
+
+    if (threads_count == 0 || threads_count > QUIC_OFFLOAD_MAX_THREADS) {
+        return quic_err_bad_format;
+    }
+
+    pthread_mutex_init(&offload->mtx, NULL);
+    pthread_cond_init(&offload->cond, NULL);
+    liteco_link_init(&offload->jobs);
+    offload->closed = false;
+    offload->threads_count = 0;
+    offload->submitted = 0;
+
+    for (i = 0; i < threads_count; i++) {
+        if (pthread_create(&offload->threads[i], NULL, quic_offload_thread, offload) != 0) {
+            quic_offload_destory(offload);
+            return quic_err_internal_error;
+        }
+        offload->threads_count++;
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_offload_destory(quic_offload_t *const offload) {
+    uint32_t i;
+
+    pthread_mutex_lock(&offload->mtx);
+    offload->closed = true;
+    pthread_cond_broadcast(&offload->cond);
+    pthread_mutex_unlock(&offload->mtx);
+
+    for (i = 0; i < offload->threads_count; i++) {
+        pthread_join(offload->threads[i], NULL);
+    }
+    offload->threads_count = 0;
+
+    pthread_cond_destroy(&offload->cond);
+    pthread_mutex_destroy(&offload->mtx);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_offload_port_init(quic_offload_port_t *const port, liteco_eloop_t *const eloop, quic_offload_t *const offload) {
+    port->offload = offload;
+    pthread_mutex_init(&port->mtx, NULL);
+    liteco_link_init(&port->done);
+    liteco_async_init(eloop, &port->event, quic_offload_port_cb);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_offload_submit(quic_offload_port_t *const port, quic_offload_job_t *const job) {
+    quic_offload_t *const offload = port->offload;
+
+    job->port = port;
+
+    pthread_mutex_lock(&offload->mtx);
+    if (offload->closed) {
+        pthread_mutex_unlock(&offload->mtx);
+        return quic_err_closed;
+    }
+    liteco_link_insert_before(&offload->jobs, job);
+    offload->submitted++;
+    pthread_cond_signal(&offload->cond);
+    pthread_mutex_unlock(&offload->mtx);
+
+    return quic_err_success;
+}
+
+static void *quic_offload_thread(void *const args) {
+    quic_offload_t *const offload = args;
+
+    for ( ;; ) {
+        pthread_mutex_lock(&offload->mtx);
+        while (liteco_link_empty(&offload->jobs) && !offload->closed) {
+            pthread_cond_wait(&offload->cond, &offload->mtx);
+        }
+        if (liteco_link_empty(&offload->jobs)) {
+            pthread_mutex_unlock(&offload->mtx);
+            break;
+        }
+        quic_offload_job_t *const job = (quic_offload_job_t *) liteco_link_next(&offload->jobs);
+        liteco_link_remove(job);
+        pthread_mutex_unlock(&offload->mtx);
+
+        job->run(job);
+
+        quic_offload_port_t *const port = job->port;
+        pthread_mutex_lock(&port->mtx);
+        liteco_link_insert_before(&port->done, job);
+        pthread_mutex_unlock(&port->mtx);
+
+        liteco_async_send(&port->event);
+    }
+
+    return NULL;
+}
+
+static void quic_offload_port_cb(liteco_async_t *const event) {
+    quic_offload_port_t *const port = ((void *) event) - offsetof(quic_offload_port_t, event);
+    liteco_linknode_t done;
+
+    liteco_link_init(&done);
+    pthread_mutex_lock(&port->mtx);
+    while (!liteco_link_empty(&port->done)) {
+        quic_offload_job_t *const job = (quic_offload_job_t *) liteco_link_next(&port->done);
+        liteco_link_remove(job);
+        liteco_link_insert_before(&done, job);
+    }
+    pthread_mutex_unlock(&port->mtx);
+
+    while (!liteco_link_empty(&done)) {
+        quic_offload_job_t *const job = (quic_offload_job_t *) liteco_link_next(&done);
+        liteco_link_remove(job);
+
+        job->done(job);
+    }
+}
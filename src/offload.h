@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_OFFLOAD_H__
+#define __OPENQUIC_OFFLOAD_H__
+
+#include "utils/errno.h"
+#include "platform/platform.h"
+#include "liteco.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef QUIC_OFFLOAD_MAX_THREADS
+#define QUIC_OFFLOAD_MAX_THREADS 64
+#endif
+
+typedef struct quic_offload_s quic_offload_t;
+typedef struct quic_offload_port_s quic_offload_port_t;
+
+typedef struct quic_offload_job_s quic_offload_job_t;
+struct quic_offload_job_s {
+    LITECO_LINKNODE_BASE
+
+    quic_offload_port_t *port;
+
+    // called on a thread of the pool
+    void (*run) (quic_offload_job_t *const);
+    // called on the eloop of the port once run returned
+    void (*done) (quic_offload_job_t *const);
+};
+
+/*
+ * worker threads running blocking or CPU heavy jobs (e.g. private key operations) off the eloops
+ */
+struct quic_offload_s {
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    liteco_linknode_t jobs;
+    bool closed;
+
+    uint32_t threads_count;
+    pthread_t threads[QUIC_OFFLOAD_MAX_THREADS];
+
+    uint64_t submitted;
+};
+
+/*
+ * the eloop side of a pool, finished jobs are handed back to it and completed on the eloop thread
+ */
+struct quic_offload_port_s {
+    quic_offload_t *offload;
+
+    liteco_async_t event;
+    pthread_mutex_t mtx;
+    liteco_linknode_t done;
+};
+
+quic_err_t quic_offload_init(quic_offload_t *const offload, const uint32_t threads_count);
+
+// stops the threads after the submitted jobs ran, jobs which are not done yet are never completed
+quic_err_t quic_offload_destory(quic_offload_t *const offload);
+
+quic_err_t quic_offload_port_init(quic_offload_port_t *const port, liteco_eloop_t *const eloop, quic_offload_t *const offload);
+
+quic_err_t quic_offload_submit(quic_offload_port_t *const port, quic_offload_job_t *const job);
+
+#endif
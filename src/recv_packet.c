@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "recv_packet.h"
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+quic_err_t quic_recv_packet_ring_init(quic_recv_packet_ring_t *const ring, const uint32_t capa, const uint32_t mtu, const bool hugepages) {
+    uint32_t i;
+
+    ring->mtu = mtu;
+    ring->slot_size = (sizeof(quic_recv_packet_t) + mtu + 7) & ~7;
+    ring->capa = 0;
+    ring->slots = NULL;
+    ring->slots_size = 0;
+    ring->mapped = false;
+    ring->high_water = 0;
+    ring->recovery_cb = NULL;
+    atomic_init(&ring->free_head, QUIC_RECV_PACKET_RING_NIL);
+    atomic_init(&ring->heap_inuse, 0);
+    atomic_init(&ring->exhausted, 0);
+    atomic_init(&ring->shed, 0);
+
+    if (!(ring->free_next = quic_malloc(sizeof(_Atomic uint32_t) * capa))) {
+        return quic_err_internal_error;
+    }
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if (hugepages) {
+        const size_t size = ((size_t) ring->slot_size * capa + QUIC_RECV_PACKET_RING_HUGEPAGE_SIZE - 1) & ~((size_t) QUIC_RECV_PACKET_RING_HUGEPAGE_SIZE - 1);
+        void *const slots = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (slots != MAP_FAILED) {
+            ring->slots = slots;
+            ring->slots_size = size;
+            ring->mapped = true;
+        }
+    }
+#else
+    (void) hugepages;
+#endif
+    if (!ring->slots && !(ring->slots = quic_malloc((size_t) ring->slot_size * capa))) {
+        quic_free(ring->free_next);
+        return quic_err_internal_error;
+    }
+    ring->capa = capa;
+
+    for (i = 0; i < capa; i++) {
+        atomic_init(&ring->free_next[i], i + 1 == capa ? QUIC_RECV_PACKET_RING_NIL : i + 1);
+    }
+    atomic_store(&ring->free_head, capa ? 0 : QUIC_RECV_PACKET_RING_NIL);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_recv_packet_ring_destory(quic_recv_packet_ring_t *const ring) {
+    if (ring->capa) {
+        quic_free(ring->free_next);
+#if defined(__linux__)
+        if (ring->mapped) {
+            munmap(ring->slots, ring->slots_size);
+        }
+        else {
+            quic_free(ring->slots);
+        }
+#else
+        quic_free(ring->slots);
+#endif
+    }
+    ring->capa = 0;
+    atomic_store(&ring->free_head, QUIC_RECV_PACKET_RING_NIL);
+
+    return quic_err_success;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020 Gscienty <gaoxiaochuan@hotmail.com>
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
  *
  * Distributed under the MIT software license, see the accompanying
  * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
@@ -13,6 +13,12 @@
 #include "platform/platform.h"
 #include "utils/errno.h"
 #include <netinet/in.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct quic_recv_packet_ring_s quic_recv_packet_ring_t;
 
 typedef struct quic_recv_packet_s quic_recv_packet_t;
 struct quic_recv_packet_s {
@@ -30,13 +36,157 @@ struct quic_recv_packet_s {
 
     uint64_t recv_time;
 
+    // ring which the packet is borrowed from (or counted against, if it lies outside of the slots), NULL means a private copy
+    quic_recv_packet_ring_t *ring;
+
     liteco_udp_chan_ele_t pkt;
 };
 
+#ifndef QUIC_RECV_PACKET_RING_HUGEPAGE_SIZE
+#define QUIC_RECV_PACKET_RING_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+#define QUIC_RECV_PACKET_RING_NIL 0xffffffff
+
+/*
+ * fixed-size packet buffers of a socket. the free slots form a lock-free stack, so a packet may be recovered
+ * from any thread. when the ring is empty up to high_water packets are malloced, beyond that the allocation is
+ * refused (shed) and the owner of the ring drops the datagram
+ */
+struct quic_recv_packet_ring_s {
+    uint32_t mtu;
+    uint32_t slot_size;
+    uint32_t capa;
+
+    // low 32 bits: first free slot, high 32 bits: tag against ABA
+    _Atomic uint64_t free_head;
+    _Atomic uint32_t *free_next;
+
+    uint8_t *slots;
+    size_t slots_size;
+    bool mapped;
+
+    uint32_t high_water;
+    _Atomic uint32_t heap_inuse;
+
+    // allocations which found the ring empty / which were refused at the high water mark
+    _Atomic uint64_t exhausted;
+    _Atomic uint64_t shed;
+
+    // slots of a ring owned by the kernel (io_uring provided buffers) are handed back by this callback
+    void (*recovery_cb) (quic_recv_packet_ring_t *const, quic_recv_packet_t *const);
+};
+
+#define quic_recv_packet_ring_slot(ring, idx) \
+    ((quic_recv_packet_t *) ((ring)->slots + (size_t) (idx) * (ring)->slot_size))
+
+#define quic_recv_packet_ring_idx(ring, recvpkt) \
+    ((uint32_t) ((((uint8_t *) (recvpkt)) - (ring)->slots) / (ring)->slot_size))
+
+#define quic_recv_packet_ring_owned(ring, recvpkt) \
+    (((uint8_t *) (recvpkt)) >= (ring)->slots && ((uint8_t *) (recvpkt)) < (ring)->slots + (size_t) (ring)->capa * (ring)->slot_size)
+
+/*
+ * slots are backed by huge pages if hugepages is set and the system has them reserved, otherwise by the heap
+ */
+quic_err_t quic_recv_packet_ring_init(quic_recv_packet_ring_t *const ring, const uint32_t capa, const uint32_t mtu, const bool hugepages);
+quic_err_t quic_recv_packet_ring_destory(quic_recv_packet_ring_t *const ring);
+
+__quic_header_inline void quic_recv_packet_ring_push(quic_recv_packet_ring_t *const ring, const uint32_t idx) {
+    uint64_t head = atomic_load_explicit(&ring->free_head, memory_order_relaxed);
+    uint64_t next;
+
+    do {
+        atomic_store_explicit(&ring->free_next[idx], (uint32_t) head, memory_order_relaxed);
+        next = (((head >> 32) + 1) << 32) | idx;
+    } while (!atomic_compare_exchange_weak_explicit(&ring->free_head, &head, next, memory_order_release, memory_order_relaxed));
+}
+
+__quic_header_inline quic_recv_packet_t *quic_recv_packet_ring_alloc(quic_recv_packet_ring_t *const ring) {
+    uint64_t head = atomic_load_explicit(&ring->free_head, memory_order_acquire);
+    uint64_t next;
+    uint32_t idx;
+
+    do {
+        idx = (uint32_t) head;
+        if (idx == QUIC_RECV_PACKET_RING_NIL) {
+            atomic_fetch_add_explicit(&ring->exhausted, 1, memory_order_relaxed);
+            return NULL;
+        }
+        next = (((head >> 32) + 1) << 32) | atomic_load_explicit(&ring->free_next[idx], memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&ring->free_head, &head, next, memory_order_acquire, memory_order_acquire));
+
+    quic_recv_packet_t *const recvpkt = quic_recv_packet_ring_slot(ring, idx);
+    recvpkt->ring = ring;
+    recvpkt->pkt.b_size = ring->mtu;
+    recvpkt->pkt.ret = 0;
+
+    return recvpkt;
+}
+
+/*
+ * a slot of the ring, or a malloced packet while the ring is empty and high_water is not reached, or NULL (shed)
+ */
+__quic_header_inline quic_recv_packet_t *quic_recv_packet_alloc(quic_recv_packet_ring_t *const ring) {
+    quic_recv_packet_t *recvpkt = quic_recv_packet_ring_alloc(ring);
+    if (recvpkt) {
+        return recvpkt;
+    }
+
+    if (atomic_fetch_add_explicit(&ring->heap_inuse, 1, memory_order_relaxed) >= ring->high_water
+        || !(recvpkt = quic_malloc(sizeof(quic_recv_packet_t) + ring->mtu))) {
+        atomic_fetch_sub_explicit(&ring->heap_inuse, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ring->shed, 1, memory_order_relaxed);
+        return NULL;
+    }
+    recvpkt->ring = ring;
+    recvpkt->pkt.b_size = ring->mtu;
+    recvpkt->pkt.ret = 0;
+
+    return recvpkt;
+}
+
 __quic_header_inline quic_err_t quic_recv_packet_recovery(quic_recv_packet_t *const recvpkt) {
-    quic_free(recvpkt);
+    quic_recv_packet_ring_t *const ring = recvpkt->ring;
+
+    if (!ring) {
+        quic_free(recvpkt);
+        return quic_err_success;
+    }
+    if (ring->recovery_cb) {
+        ring->recovery_cb(ring, recvpkt);
+        return quic_err_success;
+    }
+    if (!quic_recv_packet_ring_owned(ring, recvpkt)) {
+        atomic_fetch_sub_explicit(&ring->heap_inuse, 1, memory_order_relaxed);
+        quic_free(recvpkt);
+        return quic_err_success;
+    }
+
+    quic_recv_packet_ring_push(ring, quic_recv_packet_ring_idx(ring, recvpkt));
 
     return quic_err_success;
 }
 
+/*
+ * make the packet safe to be recovered by another thread. slots of a ring with a recovery_cb (io_uring provided
+ * buffers, which only the owning thread may hand back) are copied to the heap, returns NULL if the copy fails
+ */
+__quic_header_inline quic_recv_packet_t *quic_recv_packet_detach(quic_recv_packet_t *const recvpkt) {
+    if (!recvpkt->ring || !recvpkt->ring->recovery_cb) {
+        return recvpkt;
+    }
+
+    const size_t size = sizeof(quic_recv_packet_t) + recvpkt->pkt.ret;
+    quic_recv_packet_t *const detached = quic_malloc(size);
+    if (detached) {
+        memcpy(detached, recvpkt, size);
+        detached->ring = NULL;
+        detached->pkt.b_size = recvpkt->pkt.ret;
+    }
+    quic_recv_packet_recovery(recvpkt);
+
+    return detached;
+}
+
 #endif
@@ -9,14 +9,19 @@
 #include "format/header.h"
 #include "modules/recver.h"
 #include "modules/connid_gen.h"
+#include "modules/congestion.h"
+#include "modules/retransmission.h"
 #include "utils/time.h"
 #include "server.h"
 #include <openssl/rand.h>
+#include <openssl/hmac.h>
+#include <openssl/mem.h>
 
 const quic_config_t quic_server_default_config = {
     .is_cli = false,
     .stream_recv_timeout = 0,
     .active_connid_count = 2,
+    .congestion = quic_congestion_algorithm_cubic,
     .disable_prr = false,
     .initial_cwnd = 1460,
     .min_cwnd = 1460,
@@ -35,40 +40,131 @@ const quic_config_t quic_server_default_config = {
     .tls_verify_client_ca = NULL,
     .tls_ca = NULL,
     .tls_capath = NULL,
+    .tls_ctx = NULL,
+    .tls_server_name = NULL,
+    .tls_ticket_cache = NULL,
+    .tls_early_data = false,
+    .tls_offload = NULL,
     .stream_destory_timeout = 0,
     .disable_migrate = false,
+    .send_burst_size = 16,
+    .idle_timeout = 30 * 1000,
+    .idle_keepalive_percent = 0,
+    .ack_packet_tolerance = 2,
+    .ack_max_delay = 25 * 1000,
+    .ack_frequency = true,
 };
 
 static quic_err_t quic_server_transmission_recv_cb(quic_transmission_t *const transmission, quic_recv_packet_t *const recvpkt);
+static quic_err_t quic_server_transmission_recv_batch_cb(quic_transmission_t *const transmission, quic_recv_packet_t **const recvpkts, const size_t count);
 static int quic_server_session_free_st_cb(void *const args);
 
 static bool quic_server_new_connid_cb(quic_session_t *const session, const quic_buf_t connid);
 static void quic_server_retire_connid_cb(quic_session_t *const session, const quic_buf_t connid);
 static void quic_server_session_replace_close_cb(quic_session_t *const session, const quic_buf_t pkt);
+static void quic_server_session_handshake_completed_cb(quic_session_t *const session);
 
+static quic_err_t quic_server_connid_generate(quic_server_t *const server, uint8_t *const connid);
+static bool quic_server_initial_filter(const quic_recv_packet_t *const recvpkt);
+static bool quic_server_should_retry(quic_server_t *const server);
+static quic_err_t quic_server_send_retry(quic_server_t *const server, quic_recv_packet_t *const recvpkt, const quic_buf_t *const cli_dst, const quic_buf_t *const cli_src, const uint64_t now);
+static void quic_server_retry_token_mac(quic_server_t *const server, uint8_t *const mac,
+                                        const uint8_t *const token, const size_t token_len, const quic_buf_t *const retry_src, const liteco_addr_t addr);
+static bool quic_server_retry_token_validate(quic_server_t *const server, const quic_buf_t *const token, const quic_buf_t *const cli_dst,
+                                            const liteco_addr_t addr, const uint64_t now, quic_buf_t *const original_dst);
+
+static void quic_session_count_foreach_src_cb(const quic_buf_t connid, void *args);
 static void quic_session_close_foreach_src_cb(const quic_buf_t connid, void *args);
+static void quic_server_closed_session_expired_cb(quic_timer_t *const timer);
+static void quic_server_closed_session_free(quic_server_t *const server, quic_closed_session_t *const closed_session);
+static bool quic_server_closed_session_recv(quic_server_t *const server, const quic_buf_t *const connid);
+
+static void quic_server_eloop_close_cb(liteco_async_t *const event);
+
+static void *quic_sharded_server_worker_thread(void *const args);
+static void quic_sharded_server_worker_destory(quic_server_t *const server);
+static void quic_sharded_server_join(quic_sharded_server_t *const sserver);
+static quic_server_t *quic_sharded_server_initial_owner(quic_sharded_server_t *const sserver, const quic_buf_t *const connid);
+static quic_server_t *quic_sharded_server_initial_claim(quic_sharded_server_t *const sserver, const quic_buf_t *const connid, quic_server_t *const server);
+static void quic_sharded_server_initial_release(quic_sharded_server_t *const sserver, const quic_buf_t *const connid, quic_server_t *const server);
+static quic_err_t quic_sharded_server_handoff(quic_server_t *const server, quic_recv_packet_t *const recvpkt, const uint32_t worker_id);
+static void quic_server_handoff_cb(liteco_async_t *const event);
 
 quic_err_t quic_server_init(quic_server_t *const server, const size_t extends_size, const size_t st_size) {
     uint8_t rand = 0;
     /*if (RAND_bytes(&rand, 1) <= 0) {*/
         /*return quic_err_internal_error;*/
     /*}*/
+    uint8_t secret[16];
+    if (RAND_bytes(secret, sizeof(secret)) <= 0) {
+        return quic_err_internal_error;
+    }
 
     liteco_eloop_init(&server->eloop);
     liteco_runtime_init(&server->eloop, &server->rt);
-    quic_transmission_init(&server->transmission, &server->rt);
+    if (quic_timer_service_init(&server->timers, &server->eloop, &server->rt) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    if (quic_transmission_init(&server->transmission, &server->rt, QUIC_TRANSMISSION_DEFAULT_BACKEND) != quic_err_success) {
+        quic_timer_service_destory(&server->timers);
+        return quic_err_internal_error;
+    }
     quic_transmission_recv(&server->transmission, quic_server_transmission_recv_cb);
+    server->closed = false;
+    liteco_async_init(&server->eloop, &server->closed_event, quic_server_eloop_close_cb);
 
     server->st_size = st_size;
     server->connid_len = 8 + rand % 11;
     server->cfg = quic_server_default_config;
+    if (quic_tls_ctx_init(&server->tls_ctx) != quic_err_success) {
+        quic_transmission_destory(&server->transmission);
+        quic_timer_service_destory(&server->timers);
+        return quic_err_internal_error;
+    }
+
+    if (RAND_bytes(server->retry_key, sizeof(server->retry_key)) <= 0) {
+        quic_tls_ctx_destory(&server->tls_ctx);
+        quic_transmission_destory(&server->transmission);
+        quic_timer_service_destory(&server->timers);
+        return quic_err_internal_error;
+    }
+    server->retry = quic_server_retry_auto;
+    server->retry_accept_rate = QUIC_SERVER_RETRY_ACCEPT_RATE;
+    server->retry_pending_handshakes = QUIC_SERVER_RETRY_PENDING_HANDSHAKES;
+    server->accept_window = 0;
+    server->accept_count = 0;
+    server->pending_handshakes = 0;
+    server->filtered_pkts = 0;
+    server->retry_sent = 0;
+    server->invalid_tokens = 0;
 
-    liteco_rbt_init(server->sessions);
-    liteco_rbt_init(server->closed_sessions);
+    if (quic_connid_table_init(&server->sessions, secret) != quic_err_success) {
+        quic_tls_ctx_destory(&server->tls_ctx);
+        quic_transmission_destory(&server->transmission);
+        quic_timer_service_destory(&server->timers);
+        return quic_err_internal_error;
+    }
+    if (quic_connid_table_init(&server->closed_sessions, secret) != quic_err_success) {
+        quic_connid_table_destory(&server->sessions);
+        quic_tls_ctx_destory(&server->tls_ctx);
+        quic_transmission_destory(&server->transmission);
+        quic_timer_service_destory(&server->timers);
+        return quic_err_internal_error;
+    }
+    liteco_link_init(&server->closed_list);
+    server->closed_count = 0;
+    server->closed_evicted = 0;
 
     server->session_extends_size = extends_size;
     server->accept_cb = NULL;
 
+    server->sharded = NULL;
+    server->worker_id = 0;
+    server->workers_count = 1;
+    server->misrouted_pkts = 0;
+    server->handoff_sent = 0;
+    server->handoff_recv = 0;
+
     return quic_err_success;
 }
 
@@ -84,10 +180,81 @@ quic_err_t quic_server_key_file(quic_server_t *const server, const char *const k
     return quic_err_success;
 }
 
+quic_err_t quic_server_early_data(quic_server_t *const server, const bool enable) {
+    server->cfg.tls_early_data = enable;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_server_idle_timeout(quic_server_t *const server, const uint64_t timeout, const uint32_t keepalive_percent) {
+    server->cfg.idle_timeout = timeout;
+    server->cfg.idle_keepalive_percent = keepalive_percent;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_server_congestion(quic_server_t *const server, const quic_congestion_algorithm_t algorithm, const uint64_t initial_cwnd, const uint64_t max_cwnd) {
+    server->cfg.congestion = algorithm;
+    server->cfg.initial_cwnd = initial_cwnd;
+    server->cfg.max_cwnd = max_cwnd;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_server_ack_policy(quic_server_t *const server, const uint32_t packet_tolerance, const uint64_t max_delay, const bool ack_frequency) {
+    if (max_delay >= QUIC_TRANS_PARAM_MAX_ACK_DELAY_MAX * 1000) {
+        return quic_err_bad_format;
+    }
+    server->cfg.ack_packet_tolerance = packet_tolerance;
+    server->cfg.ack_max_delay = max_delay;
+    server->cfg.ack_frequency = ack_frequency;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_server_retry(quic_server_t *const server, const quic_server_retry_t retry, const uint32_t accept_rate, const uint32_t pending_handshakes) {
+    server->retry = retry;
+    server->retry_accept_rate = accept_rate;
+    server->retry_pending_handshakes = pending_handshakes;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_server_tls_offload(quic_server_t *const server, quic_offload_t *const offload) {
+    if (server->cfg.tls_offload) {
+        return quic_err_conflict;
+    }
+    if (quic_offload_port_init(&server->offload_port, &server->eloop, offload) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    server->cfg.tls_offload = &server->offload_port;
+
+    return quic_err_success;
+}
+
 quic_err_t quic_server_listen(quic_server_t *const server, const liteco_addr_t local_addr) {
+    if (!server->cfg.tls_ctx) {
+        if (quic_tls_ctx_load(&server->tls_ctx, &server->cfg) != quic_err_success) {
+            return quic_err_internal_error;
+        }
+        server->cfg.tls_ctx = &server->tls_ctx;
+    }
+
     return quic_transmission_listen(&server->eloop, &server->transmission, local_addr, 1460);
 }
 
+quic_err_t quic_server_reload_cert(quic_server_t *const server) {
+    if (!server->cfg.tls_ctx) {
+        return quic_err_success;
+    }
+
+    return quic_tls_ctx_load(server->cfg.tls_ctx, &server->cfg);
+}
+
+quic_err_t quic_server_recv_batch(quic_server_t *const server, const uint32_t batch_size) {
+    return quic_transmission_recv_batch(&server->transmission, batch_size, quic_server_transmission_recv_batch_cb);
+}
+
 quic_err_t quic_server_accept(quic_server_t *const server, quic_err_t (*accept_cb) (quic_session_t *const)) {
     server->accept_cb = accept_cb;
 
@@ -95,37 +262,445 @@ quic_err_t quic_server_accept(quic_server_t *const server, quic_err_t (*accept_c
 }
 
 quic_err_t quic_server_start_loop(quic_server_t *const server) {
-    for ( ;; ) {
+    while (!server->closed) {
         liteco_eloop_run(&server->eloop);
     }
+    quic_timer_service_destory(&server->timers);
     return quic_err_success;
 }
 
+quic_err_t quic_server_stop(quic_server_t *const server) {
+    liteco_async_send(&server->closed_event);
+
+    return quic_err_success;
+}
+
+static void quic_server_eloop_close_cb(liteco_async_t *const event) {
+    quic_server_t *const server = ((void *) event) - offsetof(quic_server_t, closed_event);
+    if (server->closed) {
+        return;
+    }
+
+    server->closed = true;
+    liteco_eloop_close(&server->eloop);
+}
+
 quic_server_t *quic_session_server(quic_session_t *const session) {
     return ((void *) session->transmission) - offsetof(quic_server_t, transmission);
 }
 
+quic_err_t quic_sharded_server_init(quic_sharded_server_t *const sserver, const uint32_t workers_count, const size_t extends_size, const size_t st_size) {
+    quic_err_t err = quic_err_success;
+    uint8_t secret[16];
+    uint32_t i;
+
+    if (workers_count == 0 || workers_count > QUIC_SERVER_MAX_WORKERS) {
+        return quic_err_bad_format;
+    }
+    if (RAND_bytes(secret, sizeof(secret)) <= 0) {
+        return quic_err_internal_error;
+    }
+    if (quic_connid_table_init(&sserver->initial_owners, secret) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    sserver->workers = quic_malloc(sizeof(quic_server_t) * workers_count);
+    if (!sserver->workers) {
+        quic_connid_table_destory(&sserver->initial_owners);
+        return quic_err_internal_error;
+    }
+    pthread_mutex_init(&sserver->initial_mtx, NULL);
+    sserver->workers_count = workers_count;
+    sserver->threads_count = 0;
+    sserver->steering = false;
+
+    for (i = 0; i < workers_count; i++) {
+        quic_server_t *const server = &sserver->workers[i];
+        if ((err = quic_server_init(server, extends_size, st_size)) != quic_err_success) {
+            while (i--) {
+                quic_sharded_server_worker_destory(&sserver->workers[i]);
+            }
+            quic_free(sserver->workers);
+            sserver->workers = NULL;
+            sserver->workers_count = 0;
+            pthread_mutex_destroy(&sserver->initial_mtx);
+            quic_connid_table_destory(&sserver->initial_owners);
+            return err;
+        }
+        server->sharded = sserver;
+        server->worker_id = i;
+        server->workers_count = workers_count;
+        server->connid_len = sserver->workers[0].connid_len;
+        // a token is accepted by whichever worker receives the next Initial
+        memcpy(server->retry_key, sserver->workers[0].retry_key, sizeof(server->retry_key));
+        quic_transmission_reuseport(&server->transmission, true);
+
+        pthread_mutex_init(&server->handoff_mtx, NULL);
+        liteco_link_init(&server->handoff_pkts);
+        liteco_async_init(&server->eloop, &server->handoff_event, quic_server_handoff_cb);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_cert_file(quic_sharded_server_t *const sserver, const char *const cert_file) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_cert_file(server, cert_file);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_key_file(quic_sharded_server_t *const sserver, const char *const key_file) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_key_file(server, key_file);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_early_data(quic_sharded_server_t *const sserver, const bool enable) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_early_data(server, enable);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_idle_timeout(quic_sharded_server_t *const sserver, const uint64_t timeout, const uint32_t keepalive_percent) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_idle_timeout(server, timeout, keepalive_percent);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_congestion(quic_sharded_server_t *const sserver, const quic_congestion_algorithm_t algorithm, const uint64_t initial_cwnd, const uint64_t max_cwnd) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_congestion(server, algorithm, initial_cwnd, max_cwnd);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_ack_policy(quic_sharded_server_t *const sserver, const uint32_t packet_tolerance, const uint64_t max_delay, const bool ack_frequency) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_err_t err = quic_server_ack_policy(server, packet_tolerance, max_delay, ack_frequency);
+        if (err != quic_err_success) {
+            return err;
+        }
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_retry(quic_sharded_server_t *const sserver, const quic_server_retry_t retry, const uint32_t accept_rate, const uint32_t pending_handshakes) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_retry(server, retry, accept_rate, pending_handshakes);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_tls_offload(quic_sharded_server_t *const sserver, quic_offload_t *const offload) {
+    quic_err_t err = quic_err_success;
+    quic_server_t *server = NULL;
+
+    // one pool, the completions go back to the eloop of each worker
+    quic_sharded_server_foreach(server, sserver) {
+        if ((err = quic_server_tls_offload(server, offload)) != quic_err_success) {
+            return err;
+        }
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_listen(quic_sharded_server_t *const sserver, const liteco_addr_t local_addr) {
+    quic_err_t err = quic_err_success;
+    quic_server_t *server = NULL;
+
+    // one SSL_CTX for all workers
+    if ((err = quic_tls_ctx_load(&sserver->workers[0].tls_ctx, &sserver->workers[0].cfg)) != quic_err_success) {
+        return err;
+    }
+    quic_sharded_server_foreach(server, sserver) {
+        server->cfg.tls_ctx = &sserver->workers[0].tls_ctx;
+    }
+
+    quic_sharded_server_foreach(server, sserver) {
+        if ((err = quic_server_listen(server, local_addr)) != quic_err_success) {
+            return err;
+        }
+    }
+
+    // the index of a socket in the reuseport group is its bind order, which is the worker index. every connection id
+    // chosen by a worker (source connection id of a session, Retry, NEW_CONNECTION_ID) carries it in the first byte
+    if (sserver->steering
+        && (sserver->workers_count == 1
+            || quic_transmission_steer_by_connid(&sserver->workers[0].transmission, local_addr) != quic_err_success)) {
+        sserver->steering = false;
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_reload_cert(quic_sharded_server_t *const sserver) {
+    return quic_server_reload_cert(&sserver->workers[0]);
+}
+
+quic_err_t quic_sharded_server_recv_batch(quic_sharded_server_t *const sserver, const uint32_t batch_size) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_err_t err = quic_server_recv_batch(server, batch_size);
+        if (err != quic_err_success) {
+            return err;
+        }
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_accept(quic_sharded_server_t *const sserver, quic_err_t (*accept_cb) (quic_session_t *const)) {
+    quic_server_t *server = NULL;
+    quic_sharded_server_foreach(server, sserver) {
+        quic_server_accept(server, accept_cb);
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_start_loop(quic_sharded_server_t *const sserver) {
+    uint32_t i;
+
+    for (i = 1; i < sserver->workers_count; i++) {
+        if (pthread_create(&sserver->workers[i].thread, NULL, quic_sharded_server_worker_thread, &sserver->workers[i]) != 0) {
+            quic_sharded_server_join(sserver);
+            return quic_err_internal_error;
+        }
+        sserver->threads_count = i;
+    }
+
+    // the first worker runs on the calling thread
+    sserver->workers[0].thread = pthread_self();
+    return quic_server_start_loop(&sserver->workers[0]);
+}
+
+quic_err_t quic_sharded_server_stop(quic_sharded_server_t *const sserver) {
+    quic_server_stop(&sserver->workers[0]);
+    quic_sharded_server_join(sserver);
+
+    return quic_err_success;
+}
+
+static void *quic_sharded_server_worker_thread(void *const args) {
+    quic_server_start_loop(args);
+
+    return NULL;
+}
+
+// stop the workers running on threads of their own and wait for them
+static void quic_sharded_server_join(quic_sharded_server_t *const sserver) {
+    uint32_t i;
+
+    for (i = 1; i <= sserver->threads_count; i++) {
+        quic_server_stop(&sserver->workers[i]);
+    }
+    for (i = 1; i <= sserver->threads_count; i++) {
+        pthread_join(sserver->workers[i].thread, NULL);
+    }
+    sserver->threads_count = 0;
+}
+
+static quic_server_t *quic_sharded_server_initial_owner(quic_sharded_server_t *const sserver, const quic_buf_t *const connid) {
+    pthread_mutex_lock(&sserver->initial_mtx);
+    quic_server_t *const owner = quic_connid_table_find(&sserver->initial_owners, connid);
+    pthread_mutex_unlock(&sserver->initial_mtx);
+
+    return owner;
+}
+
+// the worker which creates the session for the connection id, server unless another worker came first
+static quic_server_t *quic_sharded_server_initial_claim(quic_sharded_server_t *const sserver, const quic_buf_t *const connid, quic_server_t *const server) {
+    pthread_mutex_lock(&sserver->initial_mtx);
+    quic_server_t *owner = quic_connid_table_find(&sserver->initial_owners, connid);
+    if (!owner) {
+        // without an entry the packets of the session are only found by the worker which receives them
+        quic_connid_table_insert(&sserver->initial_owners, connid, server);
+        owner = server;
+    }
+    pthread_mutex_unlock(&sserver->initial_mtx);
+
+    return owner;
+}
+
+static void quic_sharded_server_initial_release(quic_sharded_server_t *const sserver, const quic_buf_t *const connid, quic_server_t *const server) {
+    pthread_mutex_lock(&sserver->initial_mtx);
+    if (quic_connid_table_find(&sserver->initial_owners, connid) == server) {
+        quic_connid_table_remove(&sserver->initial_owners, connid);
+    }
+    pthread_mutex_unlock(&sserver->initial_mtx);
+}
+
+// release a worker which never ran
+static void quic_sharded_server_worker_destory(quic_server_t *const server) {
+    pthread_mutex_destroy(&server->handoff_mtx);
+    quic_connid_table_destory(&server->closed_sessions);
+    quic_connid_table_destory(&server->sessions);
+    quic_tls_ctx_destory(&server->tls_ctx);
+    quic_transmission_destory(&server->transmission);
+    quic_timer_service_destory(&server->timers);
+}
+
+static quic_err_t quic_sharded_server_handoff(quic_server_t *const server, quic_recv_packet_t *const recvpkt, const uint32_t worker_id) {
+    quic_server_t *const owner = &server->sharded->workers[worker_id];
+
+    quic_recv_packet_t *const detached = quic_recv_packet_detach(recvpkt);
+    if (!detached) {
+        return quic_err_internal_error;
+    }
+
+    pthread_mutex_lock(&owner->handoff_mtx);
+    liteco_link_insert_before(&owner->handoff_pkts, detached);
+    pthread_mutex_unlock(&owner->handoff_mtx);
+    server->handoff_sent++;
+
+    liteco_async_send(&owner->handoff_event);
+
+    return quic_err_success;
+}
+
+static void quic_server_handoff_cb(liteco_async_t *const event) {
+    quic_server_t *const server = ((void *) event) - offsetof(quic_server_t, handoff_event);
+    liteco_linknode_t pkts;
+
+    liteco_link_init(&pkts);
+    pthread_mutex_lock(&server->handoff_mtx);
+    while (!liteco_link_empty(&server->handoff_pkts)) {
+        quic_recv_packet_t *const recvpkt = (quic_recv_packet_t *) liteco_link_next(&server->handoff_pkts);
+        liteco_link_remove(recvpkt);
+        liteco_link_insert_before(&pkts, recvpkt);
+    }
+    pthread_mutex_unlock(&server->handoff_mtx);
+
+    while (!liteco_link_empty(&pkts)) {
+        quic_recv_packet_t *const recvpkt = (quic_recv_packet_t *) liteco_link_next(&pkts);
+        liteco_link_remove(recvpkt);
+
+        server->handoff_recv++;
+        quic_server_transmission_recv_cb(&server->transmission, recvpkt);
+    }
+}
+
 static quic_err_t quic_server_transmission_recv_cb(quic_transmission_t *const transmission, quic_recv_packet_t *const recvpkt) {
     quic_server_t *const server = ((void *) transmission) - offsetof(quic_server_t, transmission);
 
     quic_header_t *const header = (quic_header_t *) recvpkt->pkt.buf;
     if (quic_packet_type(header) == quic_packet_initial_type) {
+        // nothing is allocated for a packet which cannot be the Initial of a client
+        if (!quic_server_initial_filter(recvpkt)) {
+            server->filtered_pkts++;
+            quic_recv_packet_recovery(recvpkt);
+            return quic_err_success;
+        }
+
         quic_buf_t cli_dst = quic_long_header_dst_conn(header);
         quic_buf_t cli_src = quic_long_header_src_conn(header);
         quic_buf_setpl(&cli_dst);
         quic_buf_setpl(&cli_src);
 
-        quic_session_t *const session = quic_session_create(&server->transmission, quic_server_default_config, server->session_extends_size);
-        quic_buf_copy(&session->src, &cli_dst);
+        quic_session_t *const exists = quic_connid_table_find(&server->sessions, &cli_dst);
+        if (exists) {
+            quic_recver_module_t *const r_module = quic_session_module(exists, quic_recver_module);
+            return quic_recver_push(r_module, recvpkt);
+        }
+        // a retransmitted Initial hashed to another worker than the first one, e.g. after a NAT rebinding
+        if (server->sharded) {
+            quic_server_t *const owner = quic_sharded_server_initial_owner(server->sharded, &cli_dst);
+            if (owner && owner != server) {
+                server->misrouted_pkts++;
+                return quic_sharded_server_handoff(server, recvpkt, owner->worker_id);
+            }
+        }
+        // a retransmitted Initial of a closed session must not open it again
+        if (quic_server_closed_session_recv(server, &cli_dst)) {
+            quic_recv_packet_recovery(recvpkt);
+            return quic_err_success;
+        }
+
+        const uint64_t now = quic_now();
+        if (now - server->accept_window >= 1000 * 1000) {
+            server->accept_window = now;
+            server->accept_count = 0;
+        }
+
+        const quic_initial_header_t initial = quic_initial_header(header);
+        quic_buf_t original_dst = cli_dst;
+        if (!quic_buf_empty(&initial.token)) {
+            if (!quic_server_retry_token_validate(server, &initial.token, &cli_dst, recvpkt->pkt.rmt_addr, now, &original_dst)) {
+                server->invalid_tokens++;
+                quic_recv_packet_recovery(recvpkt);
+                return quic_err_success;
+            }
+        }
+        else if (quic_server_should_retry(server)) {
+            quic_server_send_retry(server, recvpkt, &cli_dst, &cli_src, now);
+            quic_recv_packet_recovery(recvpkt);
+            return quic_err_success;
+        }
+
+        if (server->cfg.tls_ctx) {
+            quic_tls_ctx_reload_if_changed(server->cfg.tls_ctx, now);
+        }
+
+        // the connection id chosen by the server carries the worker index, so short header packets can be steered
+        uint8_t src_buf[QUIC_CONNID_MAX_LEN];
+        quic_buf_t src = { .buf = src_buf, .capa = server->connid_len, .ref = true };
+        do {
+            if (quic_server_connid_generate(server, src_buf) != quic_err_success) {
+                quic_recv_packet_recovery(recvpkt);
+                return quic_err_internal_error;
+            }
+            quic_buf_setpl(&src);
+        } while (quic_connid_table_find(&server->sessions, &src) || quic_connid_table_find(&server->closed_sessions, &src));
+
+        if (server->sharded) {
+            quic_server_t *const owner = quic_sharded_server_initial_claim(server->sharded, &cli_dst, server);
+            if (owner != server) {
+                server->misrouted_pkts++;
+                return quic_sharded_server_handoff(server, recvpkt, owner->worker_id);
+            }
+        }
+
+        // the coroutine stack is allocated first, then nothing needs to be undone on the session
+        void *const st = quic_malloc(server->st_size);
+        quic_session_t *const session = st ? quic_session_create(&server->transmission, quic_server_default_config, server->session_extends_size) : NULL;
+        if (!session) {
+            if (st) {
+                quic_free(st);
+            }
+            if (server->sharded) {
+                quic_sharded_server_initial_release(server->sharded, &cli_dst, server);
+            }
+            quic_recv_packet_recovery(recvpkt);
+            return quic_err_internal_error;
+        }
+        quic_buf_copy(&session->src, &src);
         quic_buf_copy(&session->dst, &cli_src);
+        quic_buf_copy(&session->original_dst, &original_dst);
+        quic_buf_copy(&session->initial_dst, &cli_dst);
+        session->retried = !quic_buf_empty(&initial.token);
         session->cfg = server->cfg;
         session->replace_close = quic_server_session_replace_close_cb;
+        session->handshake_completed = quic_server_session_handshake_completed_cb;
 
-        void *st = malloc(server->st_size);
-        if (!st) {
-            return quic_err_internal_error;
-        }
-        quic_session_init(session, &server->eloop, &server->rt, st, server->st_size);
+        quic_session_init(session, &server->eloop, &server->rt, &server->timers, st, server->st_size);
         quic_session_finished(session, quic_server_session_free_st_cb, st);
 
         quic_connid_gen_module_t *g_module = quic_session_module(session, quic_connid_gen_module);
@@ -134,6 +709,12 @@ static quic_err_t quic_server_transmission_recv_cb(quic_transmission_t *const tr
  
         liteco_runtime_join(&server->rt, &session->co);
 
+        // retransmitted Initial and 0-RTT packets of the client find the session until the handshake completes
+        quic_connid_table_insert(&server->sessions, &session->src, session);
+        quic_connid_table_insert(&server->sessions, &session->initial_dst, session);
+        server->accept_count++;
+        server->pending_handshakes++;
+
         quic_session_path_use(session, quic_path_addr(recvpkt->pkt.loc_addr, recvpkt->pkt.rmt_addr));
 
         if (server->accept_cb) {
@@ -156,18 +737,44 @@ static quic_err_t quic_server_transmission_recv_cb(quic_transmission_t *const tr
     }
     quic_buf_setpl(&target);
 
-    quic_session_store_t *store = liteco_rbt_find(server->sessions, &target);
-    if (liteco_rbt_is_nil(store)) {
+    quic_session_t *const session = quic_connid_table_find(&server->sessions, &target);
+    if (!session) {
+        if (quic_server_closed_session_recv(server, &target)) {
+            quic_recv_packet_recovery(recvpkt);
+            return quic_err_success;
+        }
+        if (server->sharded && !quic_buf_empty(&target)) {
+            // the kernel hashed the 4-tuple to another shard, e.g. after the client migrated. a 0-RTT packet still
+            // carries the connection id chosen by the client, any other one names its worker in the first byte
+            quic_server_t *owner = quic_header_is_long(header) ? quic_sharded_server_initial_owner(server->sharded, &target) : NULL;
+            if (!owner && quic_server_connid_worker(&target) < server->workers_count) {
+                owner = &server->sharded->workers[quic_server_connid_worker(&target)];
+            }
+            if (owner && owner != server) {
+                server->misrouted_pkts++;
+                return quic_sharded_server_handoff(server, recvpkt, owner->worker_id);
+            }
+        }
         quic_recv_packet_recovery(recvpkt);
         return quic_err_success;
     }
 
-    quic_recver_module_t *const r_module = quic_session_module(store->session, quic_recver_module);
+    quic_recver_module_t *const r_module = quic_session_module(session, quic_recver_module);
     return quic_recver_push(r_module, recvpkt);
 }
 
+static quic_err_t quic_server_transmission_recv_batch_cb(quic_transmission_t *const transmission, quic_recv_packet_t **const recvpkts, const size_t count) {
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        quic_server_transmission_recv_cb(transmission, recvpkts[i]);
+    }
+
+    return quic_err_success;
+}
+
 static int quic_server_session_free_st_cb(void *const args) {
-    free(args);
+    quic_free(args);
 
     return 0;
 }
@@ -175,71 +782,292 @@ static int quic_server_session_free_st_cb(void *const args) {
 static bool quic_server_new_connid_cb(quic_session_t *const session, const quic_buf_t connid) {
     quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
 
-    quic_session_store_t *store = liteco_rbt_find(server->sessions, &connid);
-    if (liteco_rbt_is_not_nil(store)) {
+    return quic_connid_table_insert(&server->sessions, &connid, session) == quic_err_success;
+}
+
+static void quic_server_retire_connid_cb(quic_session_t *const session, const quic_buf_t connid) {
+    quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
+
+    quic_connid_table_remove(&server->sessions, &connid);
+}
+
+static void quic_server_session_replace_close_cb(quic_session_t *const session, const quic_buf_t pkt) {
+    quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
+    quic_connid_gen_module_t *const g_module = quic_session_module(session, quic_connid_gen_module);
+    quic_sealer_module_t *const s_module = quic_session_module(session, quic_sealer_module);
+    quic_congestion_module_t *const c_module = quic_session_module(session, quic_congestion_module);
+    quic_retransmission_module_t *const r_module = quic_session_module(session, quic_app_retransmission_module);
+    const uint64_t now = quic_now();
+    uint32_t connids_count = 0;
+
+    if (s_module->level != ssl_encryption_application) {
+        quic_server_session_handshake_completed_cb(session);
+    }
+    // closed silently, nothing to answer the peer with
+    if (quic_buf_empty(&pkt)) {
+        return;
+    }
+
+    quic_transmission_send(session->transmission, session->path, pkt.buf, quic_buf_size(&pkt));
+
+    if (server->closed_count >= QUIC_SERVER_CLOSED_SESSIONS_MAX) {
+        quic_server_closed_session_free(server, (quic_closed_session_t *) liteco_link_next(&server->closed_list));
+        server->closed_evicted++;
+    }
+
+    quic_connid_gen_foreach_src(g_module, quic_session_count_foreach_src_cb, &connids_count);
+
+    // connection ids and the CONNECTION_CLOSE packet share the allocation of the closed session
+    quic_closed_session_t *const closed_session = quic_malloc(sizeof(quic_closed_session_t)
+                                                              + sizeof(quic_closed_connid_t) * connids_count + quic_buf_size(&pkt));
+    if (!closed_session) {
+        return;
+    }
+    liteco_link_init(closed_session);
+    quic_timer_init(&closed_session->timer);
+    closed_session->closed_at = now;
+    closed_session->transmission = &server->transmission;
+    closed_session->path = session->path;
+    closed_session->pkt.ref = true;
+    closed_session->pkt.buf = (void *) (closed_session->connids + connids_count);
+    closed_session->pkt.capa = quic_buf_size(&pkt);
+    memcpy(closed_session->pkt.buf, pkt.pos, closed_session->pkt.capa);
+    quic_buf_setpl(&closed_session->pkt);
+    closed_session->recv_count = 0;
+    closed_session->next_reply = 1;
+    closed_session->connids_count = 0;
+
+    quic_connid_gen_foreach_src(g_module, quic_session_close_foreach_src_cb, closed_session);
+    if (!closed_session->connids_count) {
+        quic_free(closed_session);
+        return;
+    }
+
+    liteco_link_insert_before(&server->closed_list, closed_session);
+    server->closed_count++;
+
+    const uint64_t pto = c_module->pto ? quic_congestion_pto(c_module, r_module->max_delay) : QUIC_SERVER_CLOSED_DEFAULT_PTO;
+    quic_timer_service_add(&server->timers, &closed_session->timer, now + 3 * pto, quic_server_closed_session_expired_cb);
+}
+
+static void quic_server_session_handshake_completed_cb(quic_session_t *const session) {
+    quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
+
+    // the client moved to the connection ids of the server
+    if (quic_connid_table_find(&server->sessions, &session->initial_dst) == session) {
+        quic_connid_table_remove(&server->sessions, &session->initial_dst);
+        if (server->sharded) {
+            quic_sharded_server_initial_release(server->sharded, &session->initial_dst, server);
+        }
+    }
+
+    if (server->pending_handshakes) {
+        server->pending_handshakes--;
+    }
+}
+
+// a random connection id of connid_len bytes, the first byte of which is the worker index in a sharded server
+static quic_err_t quic_server_connid_generate(quic_server_t *const server, uint8_t *const connid) {
+    if (RAND_bytes(connid, server->connid_len) <= 0) {
+        return quic_err_internal_error;
+    }
+    if (server->workers_count > 1) {
+        connid[0] = server->worker_id;
+    }
+
+    return quic_err_success;
+}
+
+static bool quic_server_initial_filter(const quic_recv_packet_t *const recvpkt) {
+    const uint8_t *const buf = recvpkt->pkt.buf;
+    const size_t size = recvpkt->pkt.ret;
+
+    // a client pads its Initial datagrams, shorter ones would let the server amplify a spoofed source
+    if (size < QUIC_INITIAL_DATAGRAM_MIN_SIZE || !quic_long_header_check(buf, size)) {
         return false;
     }
-    store = malloc(sizeof(quic_session_store_t));
-    if (!store) {
+
+    quic_long_header_t *const header = (quic_long_header_t *) buf;
+    if (quic_bswap_32(header->version) != QUIC_VERSION) {
+        return false;
+    }
+    // the destination connection id of a first Initial is chosen randomly and is at least 8 bytes long
+    if (quic_long_header_dst_conn_len(header) < 8) {
         return false;
     }
-    liteco_rbt_node_init(store);
-    store->key = connid;
-    store->session = session;
 
-    liteco_rbt_insert(&server->sessions, store);
+    return quic_header_packet_size(buf, size) != 0;
+}
 
-    return true;
+static bool quic_server_should_retry(quic_server_t *const server) {
+    switch (server->retry) {
+    case quic_server_retry_off:
+        return false;
+    case quic_server_retry_always:
+        return true;
+    default:
+        return server->accept_count >= server->retry_accept_rate || server->pending_handshakes >= server->retry_pending_handshakes;
+    }
 }
 
-static void quic_server_retire_connid_cb(quic_session_t *const session, const quic_buf_t connid) {
-    quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
+static quic_err_t quic_server_send_retry(quic_server_t *const server, quic_recv_packet_t *const recvpkt, const quic_buf_t *const cli_dst, const quic_buf_t *const cli_src, const uint64_t now) {
+    uint8_t pkt[1 + 4 + 1 + QUIC_CONNID_MAX_LEN + 1 + QUIC_CONNID_MAX_LEN + QUIC_SERVER_RETRY_TOKEN_MAX_LEN + QUIC_RETRY_INTEGRITY_TAG_LEN];
+    quic_long_header_t *const header = (quic_long_header_t *) pkt;
+    uint8_t unused = 0;
 
-    quic_session_store_t *store = liteco_rbt_find(server->sessions, &connid);
-    if (liteco_rbt_is_nil(store)) {
-        return;
+    if (RAND_bytes(&unused, 1) <= 0) {
+        return quic_err_internal_error;
+    }
+    header->first_byte = quic_packet_retry_type | (unused & 0x0f);
+    header->version = quic_bswap_32(QUIC_VERSION);
+
+    quic_long_header_dst_conn_len(header) = quic_buf_size(cli_src);
+    memcpy(quic_long_header_dst_conn_off(header), cli_src->pos, quic_buf_size(cli_src));
+
+    // the next Initial of the client is sent to this connection id
+    quic_long_header_src_conn_len(header) = server->connid_len;
+    if (quic_server_connid_generate(server, quic_long_header_src_conn_off(header)) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    quic_buf_t retry_src = quic_long_header_src_conn(header);
+    quic_buf_setpl(&retry_src);
+
+    uint8_t *const token = quic_long_header_payload(header);
+    memcpy(token, &now, 8);
+    token[8] = quic_buf_size(cli_dst);
+    memcpy(token + 8 + 1, cli_dst->pos, quic_buf_size(cli_dst));
+    const size_t token_len = 8 + 1 + quic_buf_size(cli_dst);
+    quic_server_retry_token_mac(server, token + token_len, token, token_len, &retry_src, recvpkt->pkt.rmt_addr);
+
+    const size_t len = (token + token_len + QUIC_SERVER_RETRY_TOKEN_MAC_LEN) - pkt;
+    if (quic_sealer_retry_integrity_tag(pkt + len, *cli_dst, pkt, len) != quic_err_success) {
+        return quic_err_internal_error;
     }
+    server->retry_sent++;
 
-    liteco_rbt_remove(&server->sessions, &store);
-    free(store);
+    return quic_transmission_send(&server->transmission, quic_path_addr(recvpkt->pkt.loc_addr, recvpkt->pkt.rmt_addr),
+                                  pkt, len + QUIC_RETRY_INTEGRITY_TAG_LEN);
 }
 
-typedef struct quic_connid_gen_foreach_src_param_s quic_connid_gen_foreach_src_param_t;
-struct quic_connid_gen_foreach_src_param_s {
-    quic_session_t *const session;
-    const quic_buf_t *const pkt;
-};
+static void quic_server_retry_token_mac(quic_server_t *const server, uint8_t *const mac,
+                                        const uint8_t *const token, const size_t token_len, const quic_buf_t *const retry_src, const liteco_addr_t addr) {
+    uint8_t msg[QUIC_SERVER_RETRY_TOKEN_MAX_LEN + QUIC_CONNID_MAX_LEN + sizeof(struct in6_addr)];
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    unsigned int digest_len = 0;
+    size_t len = 0;
 
-static void quic_server_session_replace_close_cb(quic_session_t *const session, const quic_buf_t pkt) {
-    quic_connid_gen_module_t *const g_module = quic_session_module(session, quic_connid_gen_module);
+    // the token is bound to the address of the client (not its port, which a NAT may change) and to the Retry
+    memcpy(msg, token, token_len);
+    len += token_len;
+    memcpy(msg + len, retry_src->pos, quic_buf_size(retry_src));
+    len += quic_buf_size(retry_src);
 
-    quic_connid_gen_foreach_src_param_t params = { .session = session, .pkt = &pkt };
-    quic_connid_gen_foreach_src(g_module, quic_session_close_foreach_src_cb, &params);
+    const struct sockaddr *const sa = (const struct sockaddr *) &addr;
+    if (sa->sa_family == AF_INET) {
+        memcpy(msg + len, &((const struct sockaddr_in *) sa)->sin_addr, sizeof(struct in_addr));
+        len += sizeof(struct in_addr);
+    }
+    else if (sa->sa_family == AF_INET6) {
+        memcpy(msg + len, &((const struct sockaddr_in6 *) sa)->sin6_addr, sizeof(struct in6_addr));
+        len += sizeof(struct in6_addr);
+    }
 
-    quic_transmission_send(session->transmission, session->path, pkt.buf, quic_buf_size(&pkt));
+    HMAC(EVP_sha256(), server->retry_key, sizeof(server->retry_key), msg, len, digest, &digest_len);
+    memcpy(mac, digest, QUIC_SERVER_RETRY_TOKEN_MAC_LEN);
 }
 
+static bool quic_server_retry_token_validate(quic_server_t *const server, const quic_buf_t *const token, const quic_buf_t *const cli_dst,
+                                             const liteco_addr_t addr, const uint64_t now, quic_buf_t *const original_dst) {
+    const uint8_t *const ptr = token->pos;
+    uint8_t mac[QUIC_SERVER_RETRY_TOKEN_MAC_LEN];
+    uint64_t issued_at = 0;
 
-static void quic_session_close_foreach_src_cb(const quic_buf_t connid, void *args) {
-    quic_connid_gen_foreach_src_param_t *const param = args;
-    quic_session_t *const session = param->session;
-    const quic_buf_t *const pkt = param->pkt;
+    if (quic_buf_size(token) < 8 + 1 + QUIC_SERVER_RETRY_TOKEN_MAC_LEN) {
+        return false;
+    }
+    const size_t token_len = 8 + 1 + ptr[8];
+    if (ptr[8] > QUIC_CONNID_MAX_LEN || (size_t) quic_buf_size(token) != token_len + QUIC_SERVER_RETRY_TOKEN_MAC_LEN) {
+        return false;
+    }
 
-    quic_server_t *const server = ((void *) session->transmission) - offsetof(quic_server_t, transmission);
+    memcpy(&issued_at, ptr, 8);
+    if (issued_at > now || now - issued_at > QUIC_SERVER_RETRY_TOKEN_LIFETIME) {
+        return false;
+    }
 
-    quic_closed_session_t *const closed_session = malloc(sizeof(quic_closed_session_t));
-    if (!closed_session) {
+    quic_server_retry_token_mac(server, mac, ptr, token_len, cli_dst, addr);
+    if (CRYPTO_memcmp(mac, ptr + token_len, QUIC_SERVER_RETRY_TOKEN_MAC_LEN) != 0) {
+        return false;
+    }
+
+    original_dst->ref = true;
+    original_dst->buf = (void *) (ptr + 8 + 1);
+    original_dst->capa = ptr[8];
+    quic_buf_setpl(original_dst);
+
+    return true;
+}
+
+static void quic_session_count_foreach_src_cb(const quic_buf_t connid, void *args) {
+    (void) connid;
+
+    (*(uint32_t *) args)++;
+}
+
+static void quic_session_close_foreach_src_cb(const quic_buf_t connid, void *args) {
+    quic_closed_session_t *const closed_session = args;
+    quic_server_t *const server = ((void *) closed_session->transmission) - offsetof(quic_server_t, transmission);
+    quic_closed_connid_t *const closed_connid = &closed_session->connids[closed_session->connids_count];
+
+    const size_t len = quic_buf_size(&connid);
+    if (len > QUIC_CONNID_MAX_LEN) {
+        return;
+    }
+    if (quic_connid_table_insert(&server->closed_sessions, &connid, closed_session) != quic_err_success) {
         return;
     }
-    liteco_rbt_node_init(closed_session);
+    closed_connid->len = len;
+    memcpy(closed_connid->buf, connid.pos, len);
+    closed_session->connids_count++;
+}
 
-    closed_session->closed_at = quic_now();
-    quic_buf_init(&closed_session->key);
-    quic_buf_copy(&closed_session->key, &connid);
-    closed_session->transmission = &server->transmission;
-    closed_session->path = session->path;
-    quic_buf_init(&closed_session->pkt);
-    quic_buf_copy(&closed_session->pkt, pkt);
+static void quic_server_closed_session_expired_cb(quic_timer_t *const timer) {
+    quic_closed_session_t *const closed_session = ((void *) timer) - offsetof(quic_closed_session_t, timer);
+    quic_server_t *const server = ((void *) closed_session->transmission) - offsetof(quic_server_t, transmission);
+
+    quic_server_closed_session_free(server, closed_session);
+}
+
+static void quic_server_closed_session_free(quic_server_t *const server, quic_closed_session_t *const closed_session) {
+    uint32_t i;
+
+    for (i = 0; i < closed_session->connids_count; i++) {
+        quic_buf_t key = {
+            .buf = closed_session->connids[i].buf,
+            .capa = closed_session->connids[i].len,
+            .ref = true
+        };
+        quic_buf_setpl(&key);
+        quic_connid_table_remove(&server->closed_sessions, &key);
+    }
+
+    quic_timer_service_remove(&server->timers, &closed_session->timer);
+    liteco_link_remove(closed_session);
+    server->closed_count--;
 
-    liteco_rbt_insert(&server->closed_sessions, closed_session);
+    quic_free(closed_session);
+}
+
+static bool quic_server_closed_session_recv(quic_server_t *const server, const quic_buf_t *const connid) {
+    if (!server->closed_count) {
+        return false;
+    }
+
+    quic_closed_session_t *const closed_session = quic_connid_table_find(&server->closed_sessions, connid);
+    if (!closed_session) {
+        return false;
+    }
+    quic_closed_session_recv_packet(closed_session);
+
+    return true;
 }
@@ -9,22 +9,66 @@
 #ifndef __OPENQUIC_SERVER_H__
 #define __OPENQUIC_SERVER_H__
 
-#include "utils/rbt_extend.h"
+#include "utils/connid_table.h"
+#include "format/header.h"
+#include "modules/sealer.h"
 #include "session.h"
 #include "transmission.h"
 #include "liteco.h"
+#include <pthread.h>
 
-typedef struct quic_session_store_s quic_session_store_t;
-struct quic_session_store_s {
-    QUIC_RBT_KEY_STRING_FIELDS
+#ifndef QUIC_SERVER_MAX_WORKERS
+#define QUIC_SERVER_MAX_WORKERS 256
+#endif
+
+// lifetime (us) of an address validation token carried by a Retry
+#ifndef QUIC_SERVER_RETRY_TOKEN_LIFETIME
+#define QUIC_SERVER_RETRY_TOKEN_LIFETIME (10 * 1000 * 1000)
+#endif
+
+// quic_server_retry_auto thresholds: sessions accepted in the last second / sessions still in their handshake
+#ifndef QUIC_SERVER_RETRY_ACCEPT_RATE
+#define QUIC_SERVER_RETRY_ACCEPT_RATE 1000
+#endif
 
-    quic_session_t *session;
+#ifndef QUIC_SERVER_RETRY_PENDING_HANDSHAKES
+#define QUIC_SERVER_RETRY_PENDING_HANDSHAKES 256
+#endif
+
+// closed connections kept in the draining state, the oldest one is dropped to make room for another
+#ifndef QUIC_SERVER_CLOSED_SESSIONS_MAX
+#define QUIC_SERVER_CLOSED_SESSIONS_MAX 4096
+#endif
+
+// PTO (us) of a closed connection whose congestion controller does not estimate one
+#ifndef QUIC_SERVER_CLOSED_DEFAULT_PTO
+#define QUIC_SERVER_CLOSED_DEFAULT_PTO (1000 * 1000)
+#endif
+
+// issued_at (8 bytes) || original destination connection id length (1 byte) || original destination connection id || mac
+#define QUIC_SERVER_RETRY_TOKEN_MAC_LEN 16
+#define QUIC_SERVER_RETRY_TOKEN_MAX_LEN (8 + 1 + QUIC_CONNID_MAX_LEN + QUIC_SERVER_RETRY_TOKEN_MAC_LEN)
+
+typedef enum quic_server_retry_e quic_server_retry_t;
+enum quic_server_retry_e {
+    quic_server_retry_off = 0,
+    // only while the accept rate or the pending handshakes are above their thresholds
+    quic_server_retry_auto,
+    quic_server_retry_always,
 };
 
+// worker index carried by a connection id issued by a sharded server
+#define quic_server_connid_worker(connid) \
+    (((uint8_t *) (connid)->pos)[0])
+
+typedef struct quic_sharded_server_s quic_sharded_server_t;
+
 typedef struct quic_server_s quic_server_t;
 struct quic_server_s {
     liteco_eloop_t eloop;
     liteco_runtime_t rt;
+    // deadlines of the sessions of this server
+    quic_timer_service_t timers;
 
     quic_transmission_t transmission;
 
@@ -32,25 +76,192 @@ struct quic_server_s {
     quic_config_t cfg;
     size_t connid_len;
 
-    quic_session_store_t *sessions;
-    quic_closed_session_t *closed_sessions;
+    // loaded by quic_server_listen, cfg.tls_ctx points to it (or to the one of the first worker when sharded)
+    quic_tls_ctx_t tls_ctx;
+    // completions of the private key operations offloaded by the sessions of this server (quic_server_tls_offload)
+    quic_offload_port_t offload_port;
+
+    // connection id -> quic_session_t / quic_closed_session_t
+    quic_connid_table_t sessions;
+    quic_connid_table_t closed_sessions;
+
+    // draining connections in closing order, expired on timers 3 PTO after closing
+    liteco_linknode_t closed_list;
+    size_t closed_count;
+    uint64_t closed_evicted;
+
+    // address validation of new clients by stateless Retry, tokens are authenticated by HMAC-SHA256 under retry_key
+    quic_server_retry_t retry;
+    uint8_t retry_key[32];
+    uint32_t retry_accept_rate;
+    uint32_t retry_pending_handshakes;
+
+    // sessions created since accept_window (reset every second), sessions which have not finished the handshake
+    uint64_t accept_window;
+    uint32_t accept_count;
+    uint32_t pending_handshakes;
+
+    // Initial packets dropped before a session was created, Retry packets sent, Initial packets with a bad token
+    uint64_t filtered_pkts;
+    uint64_t retry_sent;
+    uint64_t invalid_tokens;
 
     size_t session_extends_size;
     quic_err_t (*accept_cb) (quic_session_t *const);
+
+    // shard of a quic_sharded_server_t (workers_count is 1 for a standalone server)
+    quic_sharded_server_t *sharded;
+    uint32_t worker_id;
+    uint32_t workers_count;
+    pthread_t thread;
+    uint64_t misrouted_pkts;
+
+    // signaled by quic_server_stop, the eloop is closed on its own thread and quic_server_start_loop returns
+    liteco_async_t closed_event;
+    bool closed;
+
+    // packets received by other workers for sessions of this worker, drained on handoff_event
+    pthread_mutex_t handoff_mtx;
+    liteco_linknode_t handoff_pkts;
+    liteco_async_t handoff_event;
+    uint64_t handoff_sent;
+    uint64_t handoff_recv;
+};
+
+/*
+ * N independent servers, each one runs its own eloop, runtime, session table and SO_REUSEPORT socket
+ * on its own thread. server-chosen connection ids carry the worker index (quic_server_connid_worker),
+ * accept callbacks are invoked on the worker thread which owns the session
+ */
+struct quic_sharded_server_s {
+    uint32_t workers_count;
+    quic_server_t *workers;
+    // workers 1 .. threads_count run on the threads created by quic_sharded_server_start_loop
+    uint32_t threads_count;
+
+    bool steering;
+
+    // Initial destination connection ids chosen by clients -> worker (quic_server_t) of the session, until the
+    // handshake completes. long header packets which carry them do not name their worker in the first byte
+    pthread_mutex_t initial_mtx;
+    quic_connid_table_t initial_owners;
 };
 
+#define quic_sharded_server_foreach(server, sserver) \
+    for ((server) = (sserver)->workers; (server) != (sserver)->workers + (sserver)->workers_count; (server)++)
+
 quic_err_t quic_server_init(quic_server_t *const server, const size_t extends_size, const size_t st_size);
 
 quic_err_t quic_server_cert_file(quic_server_t *const server, const char *const cert_file);
 
 quic_err_t quic_server_key_file(quic_server_t *const server, const char *const key_file);
 
+/*
+ * accept 0-RTT data from resuming clients, which is replayable by the network only within the single use
+ * of its session ticket. must be called before quic_server_listen
+ */
+quic_err_t quic_server_early_data(quic_server_t *const server, const bool enable);
+
+/*
+ * sessions are closed silently after timeout (ms, 0 disables) without traffic, or the smaller timeout of the client.
+ * with keepalive_percent, a PING is sent once that percent of the timeout passed. must be called before quic_server_listen
+ */
+quic_err_t quic_server_idle_timeout(quic_server_t *const server, const uint64_t timeout, const uint32_t keepalive_percent);
+
+/*
+ * congestion controller of the sessions, initial_cwnd and max_cwnd (bytes) bound the window of either algorithm.
+ * bbr needs a max_cwnd above the bandwidth-delay product of the path. must be called before quic_server_listen
+ */
+quic_err_t quic_server_congestion(quic_server_t *const server, const quic_congestion_algorithm_t algorithm, const uint64_t initial_cwnd, const uint64_t max_cwnd);
+
+/*
+ * 1-RTT packets are acknowledged once packet_tolerance ack-eliciting packets arrived or max_delay (us) passed, and at
+ * once on reordering. with ack_frequency, ACK_FREQUENCY frames of the client may change them, and the server sends
+ * its own tuned from cwnd and RTT. max_delay is advertised as max_ack_delay and must stay below 2^14 ms, otherwise
+ * quic_err_bad_format is returned. must be called before quic_server_listen
+ */
+quic_err_t quic_server_ack_policy(quic_server_t *const server, const uint32_t packet_tolerance, const uint64_t max_delay, const bool ack_frequency);
+
+/*
+ * sign with the private key on the threads of offload instead of the eloop, the handshake of a session is parked
+ * until its signature is done. the pool is shared and outlives the server. must be called before quic_server_listen
+ */
+quic_err_t quic_server_tls_offload(quic_server_t *const server, quic_offload_t *const offload);
+
+/*
+ * answer the Initial packets of new clients with a stateless Retry, a session is only created for a client which
+ * echoes the token from its address. accept_rate / pending_handshakes are the thresholds of quic_server_retry_auto
+ */
+quic_err_t quic_server_retry(quic_server_t *const server, const quic_server_retry_t retry, const uint32_t accept_rate, const uint32_t pending_handshakes);
+
 quic_err_t quic_server_listen(quic_server_t *const server, const liteco_addr_t local_addr);
 
+/*
+ * re-read the certificate chain and the private key (quic_server_cert_file / quic_server_key_file) for new handshakes,
+ * established sessions keep their SSL_CTX. modified files are also picked up automatically on incoming Initial packets
+ */
+quic_err_t quic_server_reload_cert(quic_server_t *const server);
+
+// receive up to batch_size datagrams per wakeup, quic_err_conflict once quic_server_listen has been called
+quic_err_t quic_server_recv_batch(quic_server_t *const server, const uint32_t batch_size);
+
 quic_err_t quic_server_accept(quic_server_t *const server, quic_err_t (*accept_cb) (quic_session_t *const));
 
 quic_err_t quic_server_start_loop(quic_server_t *const server);
 
+// make quic_server_start_loop return, may be called from any thread
+quic_err_t quic_server_stop(quic_server_t *const server);
+
 quic_server_t *quic_session_server(quic_session_t *const session);
 
+quic_err_t quic_sharded_server_init(quic_sharded_server_t *const sserver, const uint32_t workers_count, const size_t extends_size, const size_t st_size);
+
+quic_err_t quic_sharded_server_cert_file(quic_sharded_server_t *const sserver, const char *const cert_file);
+
+quic_err_t quic_sharded_server_key_file(quic_sharded_server_t *const sserver, const char *const key_file);
+
+/*
+ * steer short header packets to the owning worker in the kernel (quic_transmission_steer_by_connid),
+ * must be called before quic_sharded_server_listen. packets which still land on a wrong worker
+ * (no kernel support, long header after migration) are handed off to the owner through its queue,
+ * the owner of a client-chosen Initial destination connection id is looked up in initial_owners
+ */
+__quic_header_inline quic_err_t quic_sharded_server_steering(quic_sharded_server_t *const sserver, const bool steering) {
+    sserver->steering = steering;
+    return quic_err_success;
+}
+
+quic_err_t quic_sharded_server_early_data(quic_sharded_server_t *const sserver, const bool enable);
+
+quic_err_t quic_sharded_server_idle_timeout(quic_sharded_server_t *const sserver, const uint64_t timeout, const uint32_t keepalive_percent);
+
+quic_err_t quic_sharded_server_congestion(quic_sharded_server_t *const sserver, const quic_congestion_algorithm_t algorithm, const uint64_t initial_cwnd, const uint64_t max_cwnd);
+
+quic_err_t quic_sharded_server_ack_policy(quic_sharded_server_t *const sserver, const uint32_t packet_tolerance, const uint64_t max_delay, const bool ack_frequency);
+
+quic_err_t quic_sharded_server_tls_offload(quic_sharded_server_t *const sserver, quic_offload_t *const offload);
+
+// the thresholds apply to each worker, tokens are valid on every worker
+quic_err_t quic_sharded_server_retry(quic_sharded_server_t *const sserver, const quic_server_retry_t retry, const uint32_t accept_rate, const uint32_t pending_handshakes);
+
+quic_err_t quic_sharded_server_listen(quic_sharded_server_t *const sserver, const liteco_addr_t local_addr);
+
+quic_err_t quic_sharded_server_reload_cert(quic_sharded_server_t *const sserver);
+
+quic_err_t quic_sharded_server_recv_batch(quic_sharded_server_t *const sserver, const uint32_t batch_size);
+
+quic_err_t quic_sharded_server_accept(quic_sharded_server_t *const sserver, quic_err_t (*accept_cb) (quic_session_t *const));
+
+/*
+ * run the workers 1 .. N-1 on their own threads and the first worker on the calling thread, returns once
+ * the first worker is stopped. if a thread cannot be created, the started ones are stopped and joined
+ */
+quic_err_t quic_sharded_server_start_loop(quic_sharded_server_t *const sserver);
+
+/*
+ * stop every worker and join the threads of quic_sharded_server_start_loop, which returns on its own thread.
+ * must not be called from a worker thread
+ */
+quic_err_t quic_sharded_server_stop(quic_sharded_server_t *const sserver);
+
 #endif
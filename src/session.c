@@ -12,6 +12,10 @@
 #include "modules/sealer.h"
 #include "modules/migrate.h"
 #include "modules/connid_gen.h"
+#include "modules/idle.h"
+#include "modules/sender.h"
+#include "modules/ack_generator.h"
+#include "modules/retransmission.h"
 #include "utils/time.h"
 #include "session.h"
 #include "module.h"
@@ -21,6 +25,19 @@ static int quic_session_destory(void *const session_);
 
 static quic_err_t quic_session_close_procedure(quic_session_t *const session);
 
+static void quic_session_deadline_cb(quic_timer_t *const timer);
+static void quic_session_deadlines_clear(quic_session_t *const session);
+
+static quic_module_t *const quic_session_deadline_modules[quic_session_deadlines_count] = {
+    [quic_session_deadline_ack_delay]      = &quic_app_ack_generator_module,
+    [quic_session_deadline_initial_pto]    = &quic_initial_retransmission_module,
+    [quic_session_deadline_handshake_pto]  = &quic_handshake_retransmission_module,
+    [quic_session_deadline_app_pto]        = &quic_app_retransmission_module,
+    [quic_session_deadline_pacing]         = &quic_sender_module,
+    [quic_session_deadline_stream_destory] = &quic_stream_module,
+    [quic_session_deadline_idle]           = &quic_idle_module,
+};
+
 quic_session_t *quic_session_create(quic_transmission_t *const transmission, const quic_config_t cfg, const size_t extends_size) {
     uint32_t modules_size = quic_modules_size();
 
@@ -30,31 +47,55 @@ quic_session_t *quic_session_create(quic_transmission_t *const transmission, con
     }
     quic_buf_init(&session->src);
     quic_buf_init(&session->dst);
+    quic_buf_init(&session->token);
+    quic_buf_init(&session->original_dst);
+    session->retried = false;
+    quic_buf_init(&session->initial_dst);
 
     session->cfg = cfg;
-    session->loop_deadline = 0;
+
+    session->timers = NULL;
+    atomic_init(&session->activated, 0);
+    atomic_init(&session->due, 0);
+    atomic_init(&session->woken, false);
+    session->sched_wakeups = 0;
+    session->sched_process_calls = 0;
+    session->sched_loop_calls = 0;
+    session->sched_recv_pkts = 0;
+
+    quic_frame_pool_init(&session->frame_pool);
 
     session->transmission = transmission;
 
     session->on_close = NULL;
     session->replace_close = NULL;
+    session->handshake_completed = NULL;
     session->quic_closed = true;
     session->remote_closed = false;
+    session->silent_closed = false;
 
     return session;
 }
 
-quic_err_t quic_session_init(quic_session_t *const session, liteco_eloop_t *const eloop, liteco_runtime_t *const rt, void *const st, const size_t st_len) {
+quic_err_t quic_session_init(quic_session_t *const session, liteco_eloop_t *const eloop, liteco_runtime_t *const rt,
+                             quic_timer_service_t *const timers, void *const st, const size_t st_len) {
     session->eloop = eloop;
     session->rt = rt;
     session->st = st;
 
+    session->timers = timers;
+    uint32_t deadline;
+    for (deadline = 0; deadline < quic_session_deadlines_count; deadline++) {
+        quic_timer_init(&session->deadlines[deadline].timer);
+        session->deadlines[deadline].session = session;
+        session->deadlines[deadline].deadline = deadline;
+    }
+
     liteco_chan_init(&session->mod_chan, 0, rt);
 
     liteco_co_init(&session->co, quic_session_run_co, session, st, st_len);
     liteco_co_finished(&session->co, quic_session_destory, session);
 
-    liteco_timer_chan_init(session->eloop, rt, &session->tchan);
 
     uint32_t i;
     for (i = 0; quic_modules[i]; i++) {
@@ -70,9 +111,19 @@ quic_err_t quic_session_init(quic_session_t *const session, liteco_eloop_t *cons
 static int quic_session_destory(void *const session_) {
     quic_session_t *const session = session_;
 
-    liteco_timer_chan_close(&session->tchan);
+    quic_session_deadlines_clear(session);
     liteco_chan_destory(&session->mod_chan);
 
+    quic_frame_pool_destory(&session->frame_pool);
+    if (session->token.buf) {
+        free(session->token.buf);
+    }
+    if (session->original_dst.buf) {
+        free(session->original_dst.buf);
+    }
+    if (session->initial_dst.buf) {
+        free(session->initial_dst.buf);
+    }
     free(session);
 
     return 0;
@@ -95,50 +146,41 @@ static int quic_session_run_co(void *const session_) {
         quic_module_start(module);
     }
 
-    // event loop
+    // event loop, a wakeup runs only the modules which were activated or whose deadline fired
     for ( ;; ) {
-        quic_module_t *active_module = NULL;
-        uint64_t now = quic_now();
-        if (session->loop_deadline) {
-            int timeout = session->loop_deadline - now;
-            if (timeout <= 0) {
-                quic_session_reset_loop_deadline(session);
-
-                active_module = liteco_chan_pop(&session->mod_chan, false);
-                if (active_module == liteco_chan_pop_failed) {
-                    active_module = NULL;
-                }
-                goto module_loop;
-            }
-
-            liteco_timer_chan_start(&session->tchan, timeout, 0);
-        }
         liteco_case_t cases[] = {
-            { .chan = &session->mod_chan, .type = liteco_casetype_pop, .ele = NULL },
-            { .chan = liteco_timer_chan(&session->tchan), .type = liteco_casetype_pop, .ele = NULL }
+            { .chan = &session->mod_chan, .type = liteco_casetype_pop, .ele = NULL }
         };
-        liteco_case_t *choosed_case = liteco_select(cases, 2, true);
-        if (choosed_case->chan == &session->mod_chan) {
-            active_module = choosed_case->ele;
-        }
+        liteco_select(cases, 1, true);
 
-module_loop:
         if (session->mod_chan.closed) {
             break;
         }
 
-        quic_session_reset_loop_deadline(session);
-
-        if (active_module) {
-            void *module = quic_session_module(session, *active_module);
-            quic_module_process(module);
-        }
+        atomic_store(&session->woken, false);
+        const uint64_t activated = atomic_exchange(&session->activated, 0);
+        const uint64_t due = atomic_exchange(&session->due, 0);
+        const uint64_t now = quic_now();
+        session->sched_wakeups++;
 
-        now = quic_now();
         for (i = 0; quic_modules[i]; i++) {
+            const uint64_t bit = ((uint64_t) 1) << i;
+            if (!((activated | due) & bit)) {
+                continue;
+            }
             void *module = quic_session_module(session, *quic_modules[i]);
-            quic_module_loop(module, now);
+
+            if ((activated & bit) && quic_modules[i]->process) {
+                session->sched_process_calls++;
+                quic_module_process(module);
+            }
+            if (quic_modules[i]->loop) {
+                session->sched_loop_calls++;
+                quic_module_loop(module, now);
+            }
         }
+
+        quic_transmission_flush(session->transmission);
     }
 
     quic_session_close_procedure(session);
@@ -151,20 +193,26 @@ static quic_err_t quic_session_close_procedure(quic_session_t *const session) {
     quic_connid_gen_module_t *const connid_gen = quic_session_module(session, quic_connid_gen_module);
     quic_buf_t reason = {};
     quic_buf_init(&reason);
+    quic_buf_t silent = {};
+    quic_buf_init(&silent);
 
     if (session->on_close) {
         session->on_close(session);
     }
 
-    quic_send_packet_t *const close_pkt = quic_sender_pack_connection_close(sender, 0, 0, reason);
+    quic_send_packet_t *const close_pkt = session->silent_closed ? NULL : quic_sender_pack_connection_close(sender, 0, 0, reason);
 
     quic_connid_gen_retire_all(connid_gen);
 
+    quic_transmission_flush(session->transmission);
+
     if (session->replace_close) {
-        session->replace_close(session, close_pkt->buf);
+        session->replace_close(session, close_pkt ? close_pkt->buf : silent);
     }
 
-    free(close_pkt);
+    if (close_pkt) {
+        free(close_pkt);
+    }
 
     int i;
     for (i = 0; quic_modules[i]; i++) {
@@ -172,9 +220,45 @@ static quic_err_t quic_session_close_procedure(quic_session_t *const session) {
         quic_module_destory(module);
     }
 
+    quic_session_deadlines_clear(session);
+
     return quic_err_success;
 }
 
+quic_err_t quic_session_set_deadline(quic_session_t *const session, const quic_session_deadline_t deadline, const uint64_t at) {
+    quic_session_timer_t *const timer = &session->deadlines[deadline];
+
+    if (!at) {
+        return quic_timer_service_remove(session->timers, &timer->timer);
+    }
+    if (timer->timer.pending && timer->timer.expires_at == at) {
+        return quic_err_success;
+    }
+
+    return quic_timer_service_add(session->timers, &timer->timer, at, quic_session_deadline_cb);
+}
+
+static void quic_session_deadline_cb(quic_timer_t *const timer) {
+    quic_session_timer_t *const s_timer = (quic_session_timer_t *) timer;
+    quic_session_t *const session = s_timer->session;
+
+    if (session->mod_chan.closed) {
+        return;
+    }
+    quic_session_schedule(session, quic_session_deadline_modules[s_timer->deadline]->index, true);
+}
+
+static void quic_session_deadlines_clear(quic_session_t *const session) {
+    uint32_t deadline;
+
+    if (!session->timers) {
+        return;
+    }
+    for (deadline = 0; deadline < quic_session_deadlines_count; deadline++) {
+        quic_timer_service_remove(session->timers, &session->deadlines[deadline].timer);
+    }
+}
+
 quic_err_t quic_session_close(quic_session_t *const session) {
     if (session->mod_chan.closed) {
         return quic_err_success;
@@ -194,11 +278,13 @@ quic_err_t quic_session_on_close(quic_session_t *const session, void (*cb) (quic
 
 quic_err_t quic_session_cert_file(quic_session_t *const session, const char *const cert_file) {
     session->cfg.tls_cert_chain_file = cert_file;
+    session->cfg.tls_ctx = NULL;
     return quic_err_success;
 }
 
 quic_err_t quic_session_key_file(quic_session_t *const session, const char *const key_file) {
     session->cfg.tls_key_file = key_file;
+    session->cfg.tls_ctx = NULL;
     return quic_err_success;
 }
 
@@ -212,6 +298,16 @@ quic_err_t quic_session_handshake_done(quic_session_t *const session, quic_err_t
     return quic_sealer_handshake_done(module, handshake_done_cb);
 }
 
+bool quic_session_in_early_data(quic_session_t *const session) {
+    quic_sealer_module_t *const module = quic_session_module(session, quic_sealer_module);
+    return quic_sealer_in_early_data(module);
+}
+
+bool quic_session_early_data_accepted(quic_session_t *const session) {
+    quic_sealer_module_t *const module = quic_session_module(session, quic_sealer_module);
+    return module->ssl && SSL_early_data_accepted(module->ssl);
+}
+
 quic_stream_t *quic_session_open(quic_session_t *const session, const size_t extends_size, const bool bidi) {
     quic_stream_module_t *const module = quic_session_module(session, quic_stream_module);
     return quic_stream_open(module, extends_size, bidi);
@@ -246,7 +342,11 @@ quic_err_t quic_session_path_target_use(quic_session_t *const session, const lit
 }
 
 quic_err_t quic_session_send(quic_session_t *const session, const void *const data, const uint32_t len) {
-    return quic_transmission_send(session->transmission, session->path, data, len);
+    return quic_transmission_push(session->transmission, session->path, data, len);
+}
+
+quic_err_t quic_session_send_coalesced(quic_session_t *const session, const void *const data, const uint32_t len) {
+    return quic_transmission_append(session->transmission, session->path, data, len);
 }
 
 quic_transport_parameter_t quic_session_get_transport_parameter(quic_session_t *const session) {
@@ -255,6 +355,16 @@ quic_transport_parameter_t quic_session_get_transport_parameter(quic_session_t *
 
     params.active_connid = session->cfg.active_connid_count;
     params.disable_migration = session->cfg.disable_migrate;
+    params.idle_timeout = session->cfg.idle_timeout;
+    // rounded up, the peer must not expect ACKs sooner than they are sent
+    params.max_ack_delay = (session->cfg.ack_max_delay + 999) / 1000;
+    params.min_ack_delay = session->cfg.ack_frequency ? QUIC_ACK_GENERATOR_MIN_ACK_DELAY : 0;
+    if (!session->cfg.is_cli) {
+        params.original_connid = session->original_dst;
+        if (session->retried) {
+            params.retry_connid = session->initial_dst;
+        }
+    }
 
     // TODO
 
@@ -263,6 +373,9 @@ quic_transport_parameter_t quic_session_get_transport_parameter(quic_session_t *
 
 quic_err_t quic_session_set_transport_parameter(quic_session_t *const session, const quic_transport_parameter_t params) {
     // TODO
+    if (params.max_ack_delay >= QUIC_TRANS_PARAM_MAX_ACK_DELAY_MAX) {
+        return quic_err_bad_format;
+    }
     if (params.active_connid) {
         quic_connid_gen_module_t *const c_module = quic_session_module(session, quic_connid_gen_module);
 
@@ -274,6 +387,9 @@ quic_err_t quic_session_set_transport_parameter(quic_session_t *const session, c
     if (params.disable_migration) {
         session->cfg.disable_migrate = true;
     }
+    quic_idle_negotiate(quic_session_module(session, quic_idle_module), params.idle_timeout);
+    quic_ack_generator_negotiate(quic_session_module(session, quic_app_ack_generator_module), params.min_ack_delay);
+    quic_retransmission_max_delay(quic_session_module(session, quic_app_retransmission_module), params.max_ack_delay * 1000);
 
     return quic_err_success;
 }
@@ -286,6 +402,16 @@ quic_err_t quic_closed_session_send_packet(quic_closed_session_t *const session)
     return quic_transmission_send(session->transmission, session->path, session->pkt.buf, quic_buf_size(&session->pkt));
 }
 
+quic_err_t quic_closed_session_recv_packet(quic_closed_session_t *const session) {
+    session->recv_count++;
+    if (session->recv_count < session->next_reply) {
+        return quic_err_success;
+    }
+    session->next_reply = session->recv_count << 1;
+
+    return quic_closed_session_send_packet(session);
+}
+
 quic_err_t quic_session_handle_connection_close_frame(quic_session_t *const session, const quic_frame_t *const frame) {
     quic_frame_connection_close_t *const c_frame = (quic_frame_connection_close_t *) frame;
     if (session->mod_chan.closed) {
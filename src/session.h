@@ -14,17 +14,32 @@
 #include "utils/buf.h"
 #include "utils/errno.h"
 #include "utils/addr.h"
+#include "format/header.h"
 #include "format/frame.h"
 #include "format/transport_parameter.h"
 #include "module.h"
 #include "liteco.h"
 #include "utils/rbt_extend.h"
+#include "utils/timer_wheel.h"
+#include "timer_service.h"
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <sys/time.h>
 #include <netinet/in.h>
 #include <pthread.h>
 
 typedef struct quic_stream_s quic_stream_t;
+typedef struct quic_tls_ctx_s quic_tls_ctx_t;
+typedef struct quic_tls_ticket_cache_s quic_tls_ticket_cache_t;
+typedef struct quic_offload_port_s quic_offload_port_t;
+
+typedef enum quic_congestion_algorithm_e quic_congestion_algorithm_t;
+enum quic_congestion_algorithm_e {
+    // loss based, with PRR and token bucket pacing
+    quic_congestion_algorithm_cubic = 0,
+    // model based, paced at the estimated bottleneck bandwidth
+    quic_congestion_algorithm_bbr,
+};
 
 typedef struct quic_config_s quic_config_t;
 struct quic_config_s {
@@ -34,6 +49,7 @@ struct quic_config_s {
 
     uint32_t active_connid_count;
 
+    quic_congestion_algorithm_t congestion;
     bool disable_prr;
     uint64_t initial_cwnd;
     uint64_t max_cwnd;
@@ -58,16 +74,73 @@ struct quic_config_s {
     const char **tls_ca;
     const char **tls_capath;
 
+    // preloaded SSL_CTX shared with other sessions, NULL means the session builds its own from the tls_ options
+    quic_tls_ctx_t *tls_ctx;
+
+    // client: SNI, and the key of the session ticket in tls_ticket_cache
+    const char *tls_server_name;
+    quic_tls_ticket_cache_t *tls_ticket_cache;
+    // send (client) / accept (server) 0-RTT data on resumed sessions
+    bool tls_early_data;
+    // private key operations of the shared tls_ctx run on the pool of this port, NULL means inline
+    quic_offload_port_t *tls_offload;
+
     uint64_t stream_destory_timeout;
 
     bool disable_migrate;
+
+    uint32_t send_burst_size;
+
+    // max_idle_timeout (ms) sent to the peer, 0 means none. with idle_keepalive_percent, a PING is sent
+    // once that percent of the effective idle timeout passed without receiving anything
+    uint64_t idle_timeout;
+    uint32_t idle_keepalive_percent;
+
+    // 1-RTT packets are acknowledged after ack_packet_tolerance ack-eliciting packets or ack_max_delay (us), and at
+    // once on reordering. with ack_frequency the peer may change them, and ours are tuned from cwnd and RTT
+    uint32_t ack_packet_tolerance;
+    uint64_t ack_max_delay;
+    bool ack_frequency;
+};
+
+/*
+ * named deadlines of a session, each one belongs to a module whose loop is called once it is reached
+ */
+typedef enum quic_session_deadline_e quic_session_deadline_t;
+enum quic_session_deadline_e {
+    quic_session_deadline_ack_delay = 0,
+    quic_session_deadline_initial_pto,
+    quic_session_deadline_handshake_pto,
+    quic_session_deadline_app_pto,
+    quic_session_deadline_pacing,
+    quic_session_deadline_stream_destory,
+    quic_session_deadline_idle,
+
+    quic_session_deadlines_count
 };
 
 typedef struct quic_session_s quic_session_t;
+
+typedef struct quic_session_timer_s quic_session_timer_t;
+struct quic_session_timer_s {
+    quic_timer_t timer;
+    quic_session_t *session;
+    quic_session_deadline_t deadline;
+};
+
 struct quic_session_s {
     quic_buf_t src;
     quic_buf_t dst;
 
+    // client: address validation token carried by the Initial packets, taken from a Retry
+    quic_buf_t token;
+    // server: destination connection id of the first Initial of the client, retried if that Initial was answered by a Retry
+    quic_buf_t original_dst;
+    bool retried;
+    // server: destination connection id of the Initial packets of the client (the Retry source connection id if retried),
+    // the Initial keys derive from it. src is chosen by the server
+    quic_buf_t initial_dst;
+
     quic_config_t cfg;
 
     liteco_eloop_t *eloop;
@@ -76,17 +149,37 @@ struct quic_session_s {
     liteco_co_t co;
     void *st;
     liteco_chan_t mod_chan;
-    liteco_timer_chan_t tchan;
+
+    // deadlines are timers of the eloop wide service, a fired one marks its module due
+    quic_timer_service_t *timers;
+    quic_session_timer_t deadlines[quic_session_deadlines_count];
+
+    // bits of quic_module_t.index: activated modules are processed and looped, due modules are looped.
+    // mod_chan holds at most one wakeup, pushed when woken turns true
+    _Atomic uint64_t activated;
+    _Atomic uint64_t due;
+    atomic_bool woken;
+
+    // wakeups of the session coroutine, process / loop calls of modules, and datagrams received
+    uint64_t sched_wakeups;
+    uint64_t sched_process_calls;
+    uint64_t sched_loop_calls;
+    uint64_t sched_recv_pkts;
 
     quic_transmission_t *transmission;
     quic_path_t path;
 
+    // frame objects of this session, frame_pool.hit / frame_pool.miss count the reused and the malloced frames
+    quic_frame_pool_t frame_pool;
+
     void (*on_close) (quic_session_t *const);
     void (*replace_close) (quic_session_t *const, const quic_buf_t);
+    void (*handshake_completed) (quic_session_t *const);
     bool quic_closed;
     bool remote_closed;
+    // closed without sending a CONNECTION_CLOSE (idle timeout), replace_close receives an empty packet
+    bool silent_closed;
 
-    uint64_t loop_deadline;
     uint8_t modules[0];
 };
 
@@ -97,20 +190,24 @@ struct quic_session_s {
     ((quic_session_t *) (((void *) (module)) - ((quic_base_module_t *) (module))->module_declare->off - offsetof(quic_session_t, modules)))
 
 #define quic_module_activate(session, module) \
-    (liteco_chan_unenforceable_push(&(session)->mod_chan, &(module)))
-
-#define quic_session_reset_loop_deadline(session) \
-    (session)->loop_deadline = 0;
+    quic_session_schedule((session), (module).index, false)
 
-#define quic_session_update_loop_deadline(session, deadline)                                       \
-    if ((!(session)->loop_deadline || (deadline) < (session)->loop_deadline) && (deadline) != 0) { \
-        (session)->loop_deadline = (deadline);                                                     \
+// repeated activations before the session coroutine runs are coalesced into a single wakeup
+__quic_header_inline void quic_session_schedule(quic_session_t *const session, const uint32_t index, const bool due) {
+    atomic_fetch_or(due ? &session->due : &session->activated, ((uint64_t) 1) << index);
+    if (!atomic_exchange(&session->woken, true)) {
+        liteco_chan_unenforceable_push(&session->mod_chan, session);
     }
+}
+
+// arms the deadline at the time (us), or disarms it when at is 0
+quic_err_t quic_session_set_deadline(quic_session_t *const session, const quic_session_deadline_t deadline, const uint64_t at);
 
 typedef quic_err_t (*quic_session_handler_t) (quic_session_t *const, const quic_frame_t *const);
 
 quic_session_t *quic_session_create(quic_transmission_t *const transmission, const quic_config_t cfg, const size_t extends_size);
-quic_err_t quic_session_init(quic_session_t *const session, liteco_eloop_t *const eloop, liteco_runtime_t *const rt, void *const st, const size_t st_len);
+quic_err_t quic_session_init(quic_session_t *const session, liteco_eloop_t *const eloop, liteco_runtime_t *const rt,
+                             quic_timer_service_t *const timers, void *const st, const size_t st_len);
 quic_err_t quic_session_finished(quic_session_t *const session, int (*finished_cb) (void *const args), void *const args);
 
 quic_err_t quic_session_close(quic_session_t *const session);
@@ -121,12 +218,18 @@ quic_err_t quic_session_key_file(quic_session_t *const session, const char *cons
 
 quic_err_t quic_session_accept(quic_session_t *const session, const size_t extends_size, quic_err_t (*accept_cb) (quic_stream_t *const));
 quic_err_t quic_session_handshake_done(quic_session_t *const session, quic_err_t (*handshake_done_cb) (quic_session_t *const));
+
+// the client holds 0-RTT keys and no 1-RTT keys yet: data written now is sent as early data
+bool quic_session_in_early_data(quic_session_t *const session);
+// after the handshake: whether the peer accepted the early data
+bool quic_session_early_data_accepted(quic_session_t *const session);
 quic_stream_t *quic_session_open(quic_session_t *const session, const size_t extends_size, const bool bidi);
 
 uint32_t quic_session_path_mtu(quic_session_t *const session);
 quic_err_t quic_session_path_use(quic_session_t *const session, const quic_path_t path);
 quic_err_t quic_session_path_target_use(quic_session_t *const session, const liteco_addr_t remote_addr);
 quic_err_t quic_session_send(quic_session_t *const session, const void *const data, const uint32_t len);
+quic_err_t quic_session_send_coalesced(quic_session_t *const session, const void *const data, const uint32_t len);
 
 quic_transport_parameter_t quic_session_get_transport_parameter(quic_session_t *const session);
 quic_err_t quic_session_set_transport_parameter(quic_session_t *const session, const quic_transport_parameter_t params);
@@ -135,22 +238,36 @@ quic_err_t quic_session_set_transport_parameter(quic_session_t *const session, c
     (*(type *) quic_session_extends_inner(session))
 void *quic_session_extends_inner(quic_session_t *const session);
 
+typedef struct quic_closed_connid_s quic_closed_connid_t;
+struct quic_closed_connid_s {
+    uint8_t len;
+    uint8_t buf[QUIC_CONNID_MAX_LEN];
+};
+
+/*
+ * draining state of a closed connection, shared by the entries of all its connection ids.
+ * the CONNECTION_CLOSE packet is sent again on the 1st, 2nd, 4th, 8th ... packet received
+ */
 typedef struct quic_closed_session_s quic_closed_session_t;
 struct quic_closed_session_s {
-    QUIC_RBT_KEY_STRING_FIELDS
+    LITECO_LINKNODE_BASE
+
+    quic_timer_t timer;
 
     uint64_t closed_at;
     quic_transmission_t *transmission;
     quic_path_t path;
     quic_buf_t pkt;
-};
+    uint64_t recv_count;
+    uint64_t next_reply;
 
-#define quic_closed_sessions_insert(store, session) \
-    quic_rbt_insert((store), (session), quic_rbt_string_comparer)
-
-#define quic_closed_sessions_find(store, key) \
-    ((quic_closed_session_t *) quic_rbt_find((store), (key), quic_rbt_string_key_comparer))
+    uint32_t connids_count;
+    quic_closed_connid_t connids[0];
+};
 
 quic_err_t quic_closed_session_send_packet(quic_closed_session_t *const session);
 
+// counts a packet received by the closed connection, resends the CONNECTION_CLOSE packet when the backoff allows it
+quic_err_t quic_closed_session_recv_packet(quic_closed_session_t *const session);
+
 #endif
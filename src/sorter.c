@@ -134,6 +134,48 @@ uint64_t quic_sorter_read(quic_sorter_t *const sorter, uint64_t len, void *data)
     return readed;
 }
 
+uint64_t quic_sorter_read_through(quic_sorter_t *const sorter, uint64_t off, uint64_t len, const void *data, void *dst, uint64_t dst_len) {
+    if (!quic_sorter_empty(sorter) || off > sorter->readed_size || off + len <= sorter->readed_size) {
+        return 0;
+    }
+    quic_sorter_gap_t *const gap = (quic_sorter_gap_t *) liteco_link_next(&sorter->gaps);
+
+    uint64_t skip = sorter->readed_size - off;
+    len -= skip;
+    if (len > dst_len) {
+        len = dst_len;
+    }
+    if (len > gap->len) {
+        len = gap->len;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    memcpy(dst, (const uint8_t *) data + skip, len);
+
+    // the cluster holding the old read position will never be read again if it is crossed
+    uint64_t cluster_key = sorter->readed_size / QUIC_SORTER_CLUSTER_SIZE;
+    if (cluster_key != (sorter->readed_size + len) / QUIC_SORTER_CLUSTER_SIZE) {
+        quic_sorter_cluster_t *cluster = liteco_rbt_find(sorter->clusters, &cluster_key);
+        if (liteco_rbt_is_not_nil(cluster)) {
+            liteco_rbt_remove(&sorter->clusters, &cluster);
+            free(cluster);
+        }
+    }
+
+    gap->off += len;
+    gap->len -= len;
+    if (gap->len == 0) {
+        liteco_link_remove(gap);
+        free(gap);
+    }
+
+    sorter->readed_size += len;
+    sorter->avail_size = ((quic_sorter_gap_t *) liteco_link_next(&sorter->gaps))->off;
+
+    return len;
+}
+
 uint64_t quic_sorter_peek(quic_sorter_t *const sorter, uint64_t len, void *data) {
     if (quic_sorter_readable(sorter) < len) {
         len = quic_sorter_readable(sorter);
@@ -58,6 +58,12 @@ quic_err_t quic_sorter_write(quic_sorter_t *const sorter, uint64_t off, uint64_t
 uint64_t quic_sorter_read(quic_sorter_t *const sorter, uint64_t len, void *data);
 uint64_t quic_sorter_peek(quic_sorter_t *const sorter, uint64_t len, void *data);
 
+/*
+ * hand in-order data straight to a reader (dst) without buffering it in clusters,
+ * only when nothing is readable yet; returns the bytes copied and consumed
+ */
+uint64_t quic_sorter_read_through(quic_sorter_t *const sorter, uint64_t off, uint64_t len, const void *data, void *dst, uint64_t dst_len);
+
 __quic_header_inline quic_err_t quic_sorter_append(quic_sorter_t *const sorter, uint64_t len, const void *data) {
     return quic_sorter_write(sorter, sorter->avail_size, len, data);
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "timer_service.h"
+#include "platform/platform.h"
+#include "utils/time.h"
+
+static int quic_timer_service_run_co(void *const service_);
+
+quic_err_t quic_timer_service_init(quic_timer_service_t *const service, liteco_eloop_t *const eloop, liteco_runtime_t *const rt) {
+    const uint64_t now = quic_now();
+
+    if (quic_timer_wheel_init(&service->wheel, QUIC_TIMER_SERVICE_TICK, now) != quic_err_success) {
+        return quic_err_internal_error;
+    }
+    if (!(service->st = quic_malloc(QUIC_TIMER_SERVICE_STACK_SIZE))) {
+        return quic_err_internal_error;
+    }
+    service->woken = false;
+    service->sleep_until = 0;
+    service->wakeups = 0;
+
+    liteco_chan_init(&service->wake, 0, rt);
+    liteco_timer_chan_init(eloop, rt, &service->tchan);
+    liteco_co_init(&service->co, quic_timer_service_run_co, service, service->st, QUIC_TIMER_SERVICE_STACK_SIZE);
+    liteco_runtime_join(rt, &service->co);
+
+    return quic_err_success;
+}
+
+void quic_timer_service_destory(quic_timer_service_t *const service) {
+    if (!service->st) {
+        return;
+    }
+
+    liteco_timer_chan_close(&service->tchan);
+    quic_free(service->st);
+    service->st = NULL;
+}
+
+quic_err_t quic_timer_service_add(quic_timer_service_t *const service, quic_timer_t *const timer, const uint64_t expires_at, void (*cb) (quic_timer_t *const)) {
+    quic_timer_wheel_add(&service->wheel, timer, expires_at, cb);
+
+    if (!service->woken && (!service->sleep_until || expires_at < service->sleep_until)) {
+        service->woken = true;
+        liteco_chan_unenforceable_push(&service->wake, service);
+    }
+
+    return quic_err_success;
+}
+
+static int quic_timer_service_run_co(void *const service_) {
+    quic_timer_service_t *const service = service_;
+
+    for ( ;; ) {
+        const uint64_t now = quic_now();
+        quic_timer_wheel_expire(&service->wheel, now);
+
+        service->woken = false;
+        service->sleep_until = quic_timer_wheel_next(&service->wheel);
+        if (service->sleep_until) {
+            liteco_timer_chan_start(&service->tchan, service->sleep_until > now ? service->sleep_until - now : 0, 0);
+        }
+        else {
+            liteco_timer_chan_stop(&service->tchan);
+        }
+
+        liteco_case_t cases[] = {
+            { .chan = &service->wake, .type = liteco_casetype_pop, .ele = NULL },
+            { .chan = liteco_timer_chan(&service->tchan), .type = liteco_casetype_pop, .ele = NULL }
+        };
+        liteco_select(cases, 2, true);
+        service->wakeups++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_TIMER_SERVICE_H__
+#define __OPENQUIC_TIMER_SERVICE_H__
+
+#include "utils/timer_wheel.h"
+#include "utils/errno.h"
+#include "liteco.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// granularity (us) of the session deadlines
+#ifndef QUIC_TIMER_SERVICE_TICK
+#define QUIC_TIMER_SERVICE_TICK 1000
+#endif
+
+#ifndef QUIC_TIMER_SERVICE_STACK_SIZE
+#define QUIC_TIMER_SERVICE_STACK_SIZE (32 * 1024)
+#endif
+
+/*
+ * one timer wheel shared by the sessions of an eloop, driven by a single coroutine sleeping on a single
+ * timer channel until the earliest tick holding a timer. timer callbacks run on that coroutine
+ */
+typedef struct quic_timer_service_s quic_timer_service_t;
+struct quic_timer_service_s {
+    quic_timer_wheel_t wheel;
+
+    liteco_co_t co;
+    uint8_t *st;
+    liteco_timer_chan_t tchan;
+    // wakes the coroutine up when a timer is added before sleep_until
+    liteco_chan_t wake;
+    bool woken;
+    uint64_t sleep_until;
+
+    uint64_t wakeups;
+};
+
+quic_err_t quic_timer_service_init(quic_timer_service_t *const service, liteco_eloop_t *const eloop, liteco_runtime_t *const rt);
+
+// release the coroutine stack once the eloop stopped running, the pending timers are never fired
+void quic_timer_service_destory(quic_timer_service_t *const service);
+
+quic_err_t quic_timer_service_add(quic_timer_service_t *const service, quic_timer_t *const timer, const uint64_t expires_at, void (*cb) (quic_timer_t *const));
+
+__quic_header_inline quic_err_t quic_timer_service_remove(quic_timer_service_t *const service, quic_timer_t *const timer) {
+    return quic_timer_wheel_remove(&service->wheel, timer);
+}
+
+#endif
@@ -6,11 +6,30 @@
  *
  */
 
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <netinet/udp.h>
+#include <linux/filter.h>
+#include <errno.h>
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#endif
+
 #include "liteco.h"
 #include "utils/rbt_extend.h"
 #include "utils/time.h"
 #include "utils/container_of.h"
 #include "transmission.h"
+#include "transmission_uring.h"
+#include <string.h>
+#include <unistd.h>
 
 typedef struct quic_transmission_recver_s quic_treansmission_recver_t;
 struct quic_transmission_recver_s {
@@ -19,26 +38,96 @@ struct quic_transmission_recver_s {
     quic_transmission_t *trans;
     quic_err_t (*cb) (quic_transmission_t *const, quic_recv_packet_t *const);
 
+    uint32_t batch_capa;
+    quic_recv_packet_t **batch;
+#if defined(__linux__)
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+#endif
+
     uint8_t st[0];
 };
 
+// the messages of a flush, msgs[k] carries the pendings from firsts[k] to lasts[k]
+struct quic_transmission_send_ctx_s {
+#if defined(__linux__)
+    struct mmsghdr msgs[QUIC_TRANSMISSION_SEND_BATCH_SIZE];
+    struct iovec iovs[QUIC_TRANSMISSION_SEND_BATCH_SIZE];
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } cmsgs[QUIC_TRANSMISSION_SEND_BATCH_SIZE];
+
+    uint32_t firsts[QUIC_TRANSMISSION_SEND_BATCH_SIZE];
+    uint32_t lasts[QUIC_TRANSMISSION_SEND_BATCH_SIZE];
+#else
+    int placeholder;
+#endif
+};
+
 static int quic_transmission_recver_process_co(void *const args);
 static int quic_transmission_recver_process_finish(void *const args);
 static void quic_transmission_recv_alloc(liteco_udp_chan_t *const uchan, liteco_udp_chan_ele_t **const ele);
 static void quic_transmission_recv_recovery(liteco_udp_chan_t *const uchan, liteco_udp_chan_ele_t *const ele);
+static quic_recv_packet_t *quic_transmission_recv_shed_alloc(quic_transmission_socket_t *const socket);
+static void quic_transmission_recv_shed_recovery(quic_recv_packet_ring_t *const ring, quic_recv_packet_t *const recvpkt);
+
+static quic_err_t quic_transmission_recver_batch_reserve(quic_treansmission_recver_t *const recver, const uint32_t capa);
+static size_t quic_transmission_recver_drain(quic_treansmission_recver_t *const recver, quic_transmission_socket_t *const socket, const size_t count);
+static inline quic_err_t quic_transmission_recver_dispatch(quic_treansmission_recver_t *const recver, const size_t count);
+
+static inline quic_err_t quic_transmission_send_pending(quic_transmission_t *const trans, const uint32_t first, const uint32_t last);
+static void quic_transmission_free_send_batch(quic_transmission_t *const trans);
+#if defined(__linux__)
+static uint32_t quic_transmission_flush_socket(quic_transmission_t *const trans, quic_transmission_socket_t *const socket, uint32_t i);
+#endif
 
-quic_err_t quic_transmission_init(quic_transmission_t *const trans, liteco_runtime_t *const rt) {
+quic_err_t quic_transmission_init(quic_transmission_t *const trans, liteco_runtime_t *const rt, const quic_transmission_backend_t backend) {
+#if !defined(__linux__) || !defined(QUIC_TRANSMISSION_IO_URING)
+    if (backend == quic_transmission_backend_io_uring) {
+        return quic_err_not_implemented;
+    }
+#endif
+    trans->backend = backend;
+    trans->uring = NULL;
 
     liteco_chan_init(&trans->rchan, 1, rt);
 
     trans->cb = NULL;
+    trans->batch_cb = NULL;
+    trans->batch_size = 0;
+    trans->reuseport = false;
+    trans->ring_size = QUIC_TRANSMISSION_RING_SIZE;
+    trans->ring_high_water = QUIC_TRANSMISSION_RING_HIGH_WATER;
+    trans->ring_hugepages = false;
+    trans->recv_batches = 0;
+    trans->recv_pkts = 0;
     liteco_rbt_init(trans->sockets);
 
+    trans->pendings_count = 0;
+    trans->send_buf_used = 0;
+    trans->send_syscalls = 0;
+    trans->send_pkts = 0;
+    trans->pendings = quic_malloc(sizeof(quic_transmission_pending_t) * QUIC_TRANSMISSION_SEND_BATCH_SIZE);
+    trans->send_buf = quic_malloc(QUIC_TRANSMISSION_SEND_BUF_SIZE);
+    trans->send_ctx = quic_malloc(sizeof(quic_transmission_send_ctx_t));
+    if (!trans->pendings || !trans->send_buf || !trans->send_ctx) {
+        quic_transmission_free_send_batch(trans);
+        return quic_err_internal_error;
+    }
+
     quic_treansmission_recver_t *const recver = malloc(sizeof(quic_treansmission_recver_t) + 4096);
     if (!recver) {
+        quic_transmission_free_send_batch(trans);
         return quic_err_internal_error;
     }
     recver->trans = trans;
+    recver->batch_capa = 0;
+    recver->batch = NULL;
+#if defined(__linux__)
+    recver->msgs = NULL;
+    recver->iovs = NULL;
+#endif
     liteco_co_init(&recver->co, quic_transmission_recver_process_co, recver, recver->st, 4096);
     liteco_co_finished(&recver->co, quic_transmission_recver_process_finish, recver);
 
@@ -47,24 +136,84 @@ quic_err_t quic_transmission_init(quic_transmission_t *const trans, liteco_runti
     return quic_err_success;
 }
 
+quic_err_t quic_transmission_destory(quic_transmission_t *const trans) {
+    quic_transmission_socket_t *socket = NULL;
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+    quic_transmission_uring_destory(trans);
+#endif
+
+    while (liteco_rbt_is_not_nil(trans->sockets)) {
+        socket = trans->sockets;
+        liteco_rbt_remove(&trans->sockets, &socket);
+
+        close(quic_transmission_socket_fd(socket));
+        quic_recv_packet_ring_destory(&socket->ring);
+        while (!liteco_link_empty(&socket->shed_pkts)) {
+            quic_recv_packet_t *const recvpkt = (quic_recv_packet_t *) liteco_link_next(&socket->shed_pkts);
+            liteco_link_remove(recvpkt);
+            quic_free(recvpkt);
+        }
+        quic_free(socket);
+    }
+
+    quic_transmission_free_send_batch(trans);
+
+    return quic_err_success;
+}
+
+static void quic_transmission_free_send_batch(quic_transmission_t *const trans) {
+    if (trans->pendings) {
+        quic_free(trans->pendings);
+        trans->pendings = NULL;
+    }
+    if (trans->send_buf) {
+        quic_free(trans->send_buf);
+        trans->send_buf = NULL;
+    }
+    if (trans->send_ctx) {
+        quic_free(trans->send_ctx);
+        trans->send_ctx = NULL;
+    }
+}
+
 static int quic_transmission_recver_process_co(void *const args) {
     quic_treansmission_recver_t *const recver = args;
+    quic_transmission_t *const trans = recver->trans;
 
     for ( ;; ) {
-        liteco_udp_chan_ele_t *const pkt = liteco_chan_pop(&recver->trans->rchan, true);
+        liteco_udp_chan_ele_t *const pkt = liteco_chan_pop(&trans->rchan, true);
         if (pkt == liteco_chan_pop_failed) {
             return 0;
         }
 
         quic_recv_packet_t *recvpkt = ((void *) pkt) - offsetof(quic_recv_packet_t, pkt);
+        // shed at the high water mark, the datagram was only read to drain the socket
+        if (recvpkt->ring && recvpkt->ring->recovery_cb == quic_transmission_recv_shed_recovery) {
+            quic_recv_packet_recovery(recvpkt);
+            continue;
+        }
         recvpkt->recv_time = quic_now();
 
-        if (recver->trans->cb) {
-            recver->trans->cb(recver->trans, recvpkt);
+        size_t count = 1;
+        if (trans->batch_size > 1 && quic_transmission_recver_batch_reserve(recver, trans->batch_size) == quic_err_success) {
+            recver->batch[0] = recvpkt;
+
+            quic_transmission_socket_t *const socket = liteco_rbt_find(trans->sockets, &pkt->loc_addr);
+            if (liteco_rbt_is_not_nil(socket)) {
+                count += quic_transmission_recver_drain(recver, socket, trans->batch_size - 1);
+            }
+            quic_transmission_recver_dispatch(recver, count);
+        }
+        else if (trans->cb) {
+            trans->cb(trans, recvpkt);
         }
         else {
-            free(recvpkt);
+            quic_recv_packet_recovery(recvpkt);
         }
+
+        trans->recv_batches++;
+        trans->recv_pkts += count;
     }
 
     return 0;
@@ -72,10 +221,134 @@ static int quic_transmission_recver_process_co(void *const args) {
 
 static int quic_transmission_recver_process_finish(void *const args) {
     quic_treansmission_recver_t *const recver = args;
+
+    if (recver->batch) {
+        quic_free(recver->batch);
+    }
+#if defined(__linux__)
+    if (recver->msgs) {
+        quic_free(recver->msgs);
+    }
+    if (recver->iovs) {
+        quic_free(recver->iovs);
+    }
+#endif
+
     free(recver);
     return 0;
 }
 
+static quic_err_t quic_transmission_recver_batch_reserve(quic_treansmission_recver_t *const recver, const uint32_t capa) {
+    if (recver->batch_capa >= capa) {
+        return quic_err_success;
+    }
+
+    quic_recv_packet_t **const batch = quic_malloc(sizeof(quic_recv_packet_t *) * capa);
+    if (!batch) {
+        return quic_err_internal_error;
+    }
+#if defined(__linux__)
+    struct mmsghdr *const msgs = quic_malloc(sizeof(struct mmsghdr) * capa);
+    struct iovec *const iovs = quic_malloc(sizeof(struct iovec) * capa);
+    if (!msgs || !iovs) {
+        quic_free(batch);
+        if (msgs) {
+            quic_free(msgs);
+        }
+        if (iovs) {
+            quic_free(iovs);
+        }
+        return quic_err_internal_error;
+    }
+    if (recver->msgs) {
+        quic_free(recver->msgs);
+    }
+    if (recver->iovs) {
+        quic_free(recver->iovs);
+    }
+    recver->msgs = msgs;
+    recver->iovs = iovs;
+#endif
+    if (recver->batch) {
+        quic_free(recver->batch);
+    }
+    recver->batch = batch;
+    recver->batch_capa = capa;
+
+    return quic_err_success;
+}
+
+static size_t quic_transmission_recver_drain(quic_treansmission_recver_t *const recver, quic_transmission_socket_t *const socket, const size_t count) {
+#if defined(__linux__)
+    quic_recv_packet_t **const pkts = recver->batch + 1;
+    size_t prepared = 0;
+    size_t i;
+
+    for (prepared = 0; prepared < count; prepared++) {
+        quic_recv_packet_t *const recvpkt = quic_recv_packet_ring_alloc(&socket->ring);
+        if (!recvpkt) {
+            break;
+        }
+        pkts[prepared] = recvpkt;
+
+        recver->iovs[prepared].iov_base = recvpkt->pkt.buf;
+        recver->iovs[prepared].iov_len = recvpkt->pkt.b_size;
+
+        memset(&recver->msgs[prepared], 0, sizeof(struct mmsghdr));
+        recver->msgs[prepared].msg_hdr.msg_name = &recvpkt->pkt.rmt_addr;
+        recver->msgs[prepared].msg_hdr.msg_namelen = sizeof(liteco_addr_t);
+        recver->msgs[prepared].msg_hdr.msg_iov = &recver->iovs[prepared];
+        recver->msgs[prepared].msg_hdr.msg_iovlen = 1;
+    }
+    if (prepared == 0) {
+        return 0;
+    }
+
+    int ret = recvmmsg(quic_transmission_socket_fd(socket), recver->msgs, prepared, MSG_DONTWAIT, NULL);
+    if (ret < 0) {
+        ret = 0;
+    }
+
+    const uint64_t now = quic_now();
+    for (i = 0; i < (size_t) ret; i++) {
+        pkts[i]->pkt.ret = recver->msgs[i].msg_len;
+        pkts[i]->pkt.loc_addr = socket->key;
+        pkts[i]->recv_time = now;
+    }
+    for (i = prepared; i > (size_t) ret; i--) {
+        quic_recv_packet_recovery(pkts[i - 1]);
+    }
+
+    return ret;
+#else
+    (void) recver;
+    (void) socket;
+    (void) count;
+
+    return 0;
+#endif
+}
+
+static inline quic_err_t quic_transmission_recver_dispatch(quic_treansmission_recver_t *const recver, const size_t count) {
+    quic_transmission_t *const trans = recver->trans;
+    size_t i;
+
+    if (trans->batch_cb) {
+        return trans->batch_cb(trans, recver->batch, count);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (trans->cb) {
+            trans->cb(trans, recver->batch[i]);
+        }
+        else {
+            quic_recv_packet_recovery(recver->batch[i]);
+        }
+    }
+
+    return quic_err_success;
+}
+
 quic_err_t quic_transmission_listen(liteco_eloop_t *const eloop, quic_transmission_t *const trans, const liteco_addr_t local_addr, const uint32_t mtu) {
     if (liteco_rbt_is_not_nil(liteco_rbt_find(trans->sockets, &local_addr))) {
         return quic_err_conflict;
@@ -86,29 +359,347 @@ quic_err_t quic_transmission_listen(liteco_eloop_t *const eloop, quic_transmissi
     }
     liteco_rbt_node_init(socket);
 
-    liteco_udp_chan_init(eloop, &socket->udp);
-    liteco_udp_chan_bind(&socket->udp, (struct sockaddr *) &local_addr, &trans->rchan);
-    liteco_udp_chan_recv(&socket->udp, quic_transmission_recv_alloc, quic_transmission_recv_recovery);
     socket->key = local_addr;
     socket->mtu = mtu;
+    socket->gso = false;
+
+    memset(&socket->shed_ring, 0, sizeof(quic_recv_packet_ring_t));
+    atomic_init(&socket->shed_ring.free_head, QUIC_RECV_PACKET_RING_NIL);
+    socket->shed_ring.recovery_cb = quic_transmission_recv_shed_recovery;
+    liteco_link_init(&socket->shed_pkts);
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+    if (trans->backend == quic_transmission_backend_io_uring) {
+        // datagrams land in the provided buffers of the io_uring instance, the ring of the socket stays empty
+        memset(&socket->ring, 0, sizeof(quic_recv_packet_ring_t));
+        atomic_init(&socket->ring.free_head, QUIC_RECV_PACKET_RING_NIL);
+        if (quic_transmission_uring_listen(eloop, trans, socket) != quic_err_success) {
+            quic_free(socket);
+            return quic_err_internal_error;
+        }
+        goto bound;
+    }
+#endif
+
+    uint32_t capa = trans->ring_size;
+    if (capa < trans->batch_size) {
+        capa = trans->batch_size;
+    }
+    if (quic_recv_packet_ring_init(&socket->ring, capa, mtu, trans->ring_hugepages) != quic_err_success) {
+        quic_free(socket);
+        return quic_err_internal_error;
+    }
+    socket->ring.high_water = trans->ring_high_water;
+
+    liteco_udp_chan_init(eloop, &socket->udp);
+    // the socket options below need the descriptor before the socket is bound
+    socket->fd = socket->udp.fd;
+#if defined(SO_REUSEPORT)
+    if (trans->reuseport) {
+        int on = 1;
+        if (setsockopt(quic_transmission_socket_fd(socket), SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+            close(quic_transmission_socket_fd(socket));
+            quic_recv_packet_ring_destory(&socket->ring);
+            quic_free(socket);
+            return quic_err_internal_error;
+        }
+    }
+#endif
+    if (liteco_udp_chan_bind(&socket->udp, (struct sockaddr *) &local_addr, &trans->rchan) != 0) {
+        close(quic_transmission_socket_fd(socket));
+        quic_recv_packet_ring_destory(&socket->ring);
+        quic_free(socket);
+        return quic_err_internal_error;
+    }
+    liteco_udp_chan_recv(&socket->udp, quic_transmission_recv_alloc, quic_transmission_recv_recovery);
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+bound:
+#endif
+#if defined(__linux__)
+    int gso_size = 0;
+    socklen_t gso_size_len = sizeof(gso_size);
+    socket->gso = getsockopt(quic_transmission_socket_fd(socket), SOL_UDP, UDP_SEGMENT, &gso_size, &gso_size_len) == 0;
+#endif
 
     liteco_rbt_insert(&trans->sockets, socket);
 
     return quic_err_success;
 }
 
+quic_err_t quic_transmission_steer_by_connid(quic_transmission_t *const trans, const liteco_addr_t local_addr) {
+    quic_transmission_socket_t *const socket = liteco_rbt_find(trans->sockets, &local_addr);
+    if (liteco_rbt_is_nil(socket)) {
+        return quic_err_not_implemented;
+    }
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    // the reuseport program runs on the UDP payload and returns the index of the socket in the group
+    static struct sock_filter code[] = {
+        // first byte of the QUIC packet
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+        // long header packets (which carry client-chosen connection ids) keep the 4-tuple hash
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 2, 0),
+        // first byte of the destination connection id
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 1),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+        // out of range, the kernel falls back to the 4-tuple hash
+        BPF_STMT(BPF_RET | BPF_K, 0xffffffff),
+    };
+    struct sock_fprog prog = { .len = sizeof(code) / sizeof(code[0]), .filter = code };
+
+    if (setsockopt(quic_transmission_socket_fd(socket), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) != 0) {
+        return quic_err_internal_error;
+    }
+
+    return quic_err_success;
+#else
+    return quic_err_not_implemented;
+#endif
+}
+
 static void quic_transmission_recv_alloc(liteco_udp_chan_t *const uchan, liteco_udp_chan_ele_t **const ele) {
     quic_transmission_socket_t *const socket = ((void *) uchan) - offsetof(quic_transmission_socket_t, udp);
-    quic_recv_packet_t *const recvpkt = malloc(sizeof(quic_recv_packet_t) + socket->mtu);
+    quic_recv_packet_t *recvpkt = quic_recv_packet_alloc(&socket->ring);
 
-    *ele = &recvpkt->pkt;
-    (*ele)->b_size = socket->mtu;
-    (*ele)->ret = 0;
+    // shed: the datagram is read into a scratch packet anyway, so the socket does not stay readable
+    if (!recvpkt) {
+        recvpkt = quic_transmission_recv_shed_alloc(socket);
+    }
+    *ele = recvpkt ? &recvpkt->pkt : NULL;
 }
 
 static void quic_transmission_recv_recovery(liteco_udp_chan_t *const uchan, liteco_udp_chan_ele_t *const ele) {
-    (void) uchan;
+    quic_transmission_socket_t *const socket = ((void *) uchan) - offsetof(quic_transmission_socket_t, udp);
     quic_recv_packet_t *const recvpkt = container_of(ele, quic_recv_packet_t, pkt);
 
-    quic_free(recvpkt);
+    // nothing was read into the scratch packet, no datagram was shed
+    if (recvpkt->ring == &socket->shed_ring) {
+        atomic_fetch_sub_explicit(&socket->ring.shed, 1, memory_order_relaxed);
+    }
+    quic_recv_packet_recovery(recvpkt);
+}
+
+static quic_recv_packet_t *quic_transmission_recv_shed_alloc(quic_transmission_socket_t *const socket) {
+    quic_recv_packet_t *recvpkt = NULL;
+
+    // the scratch packets are kept, there are as many as datagrams were shed between two runs of the recver
+    if (!liteco_link_empty(&socket->shed_pkts)) {
+        recvpkt = (quic_recv_packet_t *) liteco_link_next(&socket->shed_pkts);
+        liteco_link_remove(recvpkt);
+    }
+    else if (!(recvpkt = quic_malloc(sizeof(quic_recv_packet_t) + socket->ring.mtu))) {
+        return NULL;
+    }
+    recvpkt->ring = &socket->shed_ring;
+    recvpkt->pkt.b_size = socket->ring.mtu;
+    recvpkt->pkt.ret = 0;
+
+    return recvpkt;
+}
+
+static void quic_transmission_recv_shed_recovery(quic_recv_packet_ring_t *const ring, quic_recv_packet_t *const recvpkt) {
+    quic_transmission_socket_t *const socket = container_of(ring, quic_transmission_socket_t, shed_ring);
+
+    liteco_link_insert_before(&socket->shed_pkts, recvpkt);
+}
+
+quic_err_t quic_transmission_push(quic_transmission_t *const trans, const quic_path_t path, const void *const data, const uint32_t len) {
+    if (len > QUIC_TRANSMISSION_SEND_BUF_SIZE) {
+        return quic_transmission_send(trans, path, data, len);
+    }
+    if (trans->pendings_count == QUIC_TRANSMISSION_SEND_BATCH_SIZE || trans->send_buf_used + len > QUIC_TRANSMISSION_SEND_BUF_SIZE) {
+        quic_transmission_flush(trans);
+    }
+
+    quic_transmission_pending_t *const pending = &trans->pendings[trans->pendings_count++];
+    pending->path = path;
+    pending->off = trans->send_buf_used;
+    pending->len = len;
+
+    memcpy(trans->send_buf + pending->off, data, len);
+    trans->send_buf_used += len;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_transmission_append(quic_transmission_t *const trans, const quic_path_t path, const void *const data, const uint32_t len) {
+    if (!trans->pendings_count
+        || trans->send_buf_used + len > QUIC_TRANSMISSION_SEND_BUF_SIZE
+        || quic_path_cmp(trans->pendings[trans->pendings_count - 1].path, path) != 0) {
+        return quic_transmission_push(trans, path, data, len);
+    }
+
+    quic_transmission_pending_t *const pending = &trans->pendings[trans->pendings_count - 1];
+
+    memcpy(trans->send_buf + trans->send_buf_used, data, len);
+    pending->len += len;
+    trans->send_buf_used += len;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_transmission_flush(quic_transmission_t *const trans) {
+    uint32_t i = 0;
+
+    while (i < trans->pendings_count) {
+        quic_transmission_socket_t *const socket = liteco_rbt_find(trans->sockets, &trans->pendings[i].path.loc_addr);
+        if (liteco_rbt_is_nil(socket)) {
+            i++;
+            continue;
+        }
+
+#if defined(__linux__)
+        i = quic_transmission_flush_socket(trans, socket, i);
+#else
+        quic_transmission_send_pending(trans, i, i);
+        i++;
+#endif
+    }
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+    // the submitted batch belongs to the io_uring instance until its sends completed, the next one is filled meanwhile
+    if (trans->uring) {
+        quic_transmission_uring_submit(trans);
+    }
+#endif
+
+    trans->pendings_count = 0;
+    trans->send_buf_used = 0;
+
+    return quic_err_success;
+}
+
+static inline quic_err_t quic_transmission_send_pending(quic_transmission_t *const trans, const uint32_t first, const uint32_t last) {
+    uint32_t i;
+
+    for (i = first; i <= last; i++) {
+        const quic_transmission_pending_t *const pending = &trans->pendings[i];
+
+        quic_transmission_send(trans, pending->path, trans->send_buf + pending->off, pending->len);
+        trans->send_syscalls++;
+        trans->send_pkts++;
+    }
+
+    return quic_err_success;
+}
+
+#if defined(__linux__)
+static uint32_t quic_transmission_flush_socket(quic_transmission_t *const trans, quic_transmission_socket_t *const socket, uint32_t i) {
+    quic_transmission_send_ctx_t *const ctx = trans->send_ctx;
+    quic_transmission_pending_t *const pendings = trans->pendings;
+    // a message takes at least the pending it starts with, so the messages of every socket get their own slots
+    const uint32_t base = i;
+    uint32_t msgs_count = 0;
+    uint32_t sent = 0;
+
+    // build one message per run of packets which share the path and the segment size
+    while (i < trans->pendings_count && quic_addr_cmp(pendings[i].path.loc_addr, socket->key) == 0) {
+        const uint32_t seg_size = pendings[i].len;
+        uint32_t total = seg_size;
+        uint32_t j = i;
+
+        if (socket->gso) {
+            while (j + 1 < trans->pendings_count
+                   && j + 1 - i < QUIC_TRANSMISSION_GSO_MAX_SEGMENTS
+                   && pendings[j + 1].len <= seg_size
+                   && total + pendings[j + 1].len <= QUIC_TRANSMISSION_GSO_MAX_SIZE
+                   && quic_path_cmp(pendings[j + 1].path, pendings[i].path) == 0) {
+                j++;
+                total += pendings[j].len;
+
+                // only the last segment may be shorter than the segment size
+                if (pendings[j].len < seg_size) {
+                    break;
+                }
+            }
+        }
+
+        const uint32_t k = base + msgs_count;
+        struct mmsghdr *const msg = &ctx->msgs[k];
+        memset(msg, 0, sizeof(struct mmsghdr));
+
+        ctx->iovs[k].iov_base = trans->send_buf + pendings[i].off;
+        ctx->iovs[k].iov_len = total;
+
+        msg->msg_hdr.msg_name = &pendings[i].path.rmt_addr;
+        msg->msg_hdr.msg_namelen = liteco_addr_type_size(&pendings[i].path.rmt_addr);
+        msg->msg_hdr.msg_iov = &ctx->iovs[k];
+        msg->msg_hdr.msg_iovlen = 1;
+
+        if (j != i) {
+            msg->msg_hdr.msg_control = ctx->cmsgs[k].buf;
+            msg->msg_hdr.msg_controllen = sizeof(ctx->cmsgs[k].buf);
+
+            struct cmsghdr *const cmsg = CMSG_FIRSTHDR(&msg->msg_hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            *(uint16_t *) CMSG_DATA(cmsg) = seg_size;
+        }
+
+        ctx->firsts[k] = i;
+        ctx->lasts[k] = j;
+        msgs_count++;
+        i = j + 1;
+    }
+
+#if defined(QUIC_TRANSMISSION_IO_URING)
+    if (trans->uring) {
+        quic_transmission_uring_sendmsgs(trans, socket, ctx->msgs, base, msgs_count);
+        return i;
+    }
+#endif
+
+    while (sent < msgs_count) {
+        int ret = sendmmsg(quic_transmission_socket_fd(socket), ctx->msgs + base + sent, msgs_count - sent, 0);
+        if (ret > 0) {
+            trans->send_syscalls++;
+            trans->send_pkts += ctx->lasts[base + sent + ret - 1] - ctx->firsts[base + sent] + 1;
+            sent += ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+
+        // GSO rejected by the kernel or the NIC, disable it and send the rest one by one
+        if (ret < 0 && (errno == EIO || errno == EINVAL)) {
+            socket->gso = false;
+        }
+        quic_transmission_send_pending(trans, ctx->firsts[base + sent], ctx->lasts[base + msgs_count - 1]);
+        break;
+    }
+
+    return i;
+}
+#endif
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+quic_transmission_send_ctx_t *quic_transmission_uring_send_ctx_alloc() {
+    return quic_malloc(sizeof(quic_transmission_send_ctx_t));
+}
+
+void quic_transmission_uring_sent(quic_transmission_t *const trans, const quic_transmission_pending_t *const pendings, const uint8_t *const send_buf,
+                                  const quic_transmission_send_ctx_t *const ctx, const uint32_t msg, const int res) {
+    uint32_t i;
+
+    if (res >= 0) {
+        trans->send_pkts += ctx->lasts[msg] - ctx->firsts[msg] + 1;
+        return;
+    }
+
+    // GSO rejected by the kernel or the NIC, disable it and send the packets of the message one by one
+    if (res == -EIO || res == -EINVAL) {
+        quic_transmission_socket_t *const socket = liteco_rbt_find(trans->sockets, &pendings[ctx->firsts[msg]].path.loc_addr);
+        if (liteco_rbt_is_not_nil(socket)) {
+            socket->gso = false;
+        }
+    }
+    for (i = ctx->firsts[msg]; i <= ctx->lasts[msg]; i++) {
+        quic_transmission_send(trans, pendings[i].path, send_buf + pendings[i].off, pendings[i].len);
+        trans->send_syscalls++;
+        trans->send_pkts++;
+    }
 }
+#endif
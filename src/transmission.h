@@ -16,6 +16,47 @@
 #include "utils/errno.h"
 #include "liteco.h"
 #include <netinet/in.h>
+#include <sys/socket.h>
+
+#ifndef QUIC_TRANSMISSION_RING_SIZE
+#define QUIC_TRANSMISSION_RING_SIZE 256
+#endif
+
+// malloced packets allowed per socket while its ring is empty
+#ifndef QUIC_TRANSMISSION_RING_HIGH_WATER
+#define QUIC_TRANSMISSION_RING_HIGH_WATER 256
+#endif
+
+#ifndef QUIC_TRANSMISSION_BATCH_SIZE
+#define QUIC_TRANSMISSION_BATCH_SIZE 32
+#endif
+
+#ifndef QUIC_TRANSMISSION_SEND_BATCH_SIZE
+#define QUIC_TRANSMISSION_SEND_BATCH_SIZE 64
+#endif
+
+#ifndef QUIC_TRANSMISSION_SEND_BUF_SIZE
+#define QUIC_TRANSMISSION_SEND_BUF_SIZE (QUIC_TRANSMISSION_SEND_BATCH_SIZE * 1500)
+#endif
+
+#define QUIC_TRANSMISSION_GSO_MAX_SEGMENTS 64
+#define QUIC_TRANSMISSION_GSO_MAX_SIZE 65000
+
+/*
+ * io_uring backend (linux, built with QUIC_TRANSMISSION_IO_URING and liburing >= 2.4): datagrams are received
+ * by one multishot recvmsg per socket into a ring of provided buffers, and every flush is submitted as one batch
+ */
+typedef enum quic_transmission_backend_e quic_transmission_backend_t;
+enum quic_transmission_backend_e {
+    quic_transmission_backend_liteco = 0,
+    quic_transmission_backend_io_uring
+};
+
+#ifndef QUIC_TRANSMISSION_DEFAULT_BACKEND
+#define QUIC_TRANSMISSION_DEFAULT_BACKEND quic_transmission_backend_liteco
+#endif
+
+typedef struct quic_transmission_uring_s quic_transmission_uring_t;
 
 typedef struct quic_transmission_socket_s quic_transmission_socket_t;
 struct quic_transmission_socket_s {
@@ -23,24 +64,156 @@ struct quic_transmission_socket_s {
 
     uint32_t mtu;
     liteco_udp_chan_t udp;
+    int fd;
+    bool gso;
+    // the multishot recv of the io_uring backend stopped and waits to be armed again
+    bool rearm;
+
+    quic_recv_packet_ring_t ring;
+    // datagrams shed at the high water mark are still read, into scratch packets which the recver drops at once.
+    // the recovery_cb of shed_ring puts them back onto shed_pkts
+    quic_recv_packet_ring_t shed_ring;
+    liteco_linknode_t shed_pkts;
 };
 
+#define quic_transmission_socket_fd(socket) \
+    ((socket)->fd)
+
+typedef struct quic_transmission_pending_s quic_transmission_pending_t;
+struct quic_transmission_pending_s {
+    quic_path_t path;
+    uint32_t off;
+    uint32_t len;
+};
+
+typedef struct quic_transmission_send_ctx_s quic_transmission_send_ctx_t;
+
 typedef struct quic_transmission_s quic_transmission_t;
 struct quic_transmission_s {
+    quic_transmission_backend_t backend;
+    quic_transmission_uring_t *uring;
+
     quic_transmission_socket_t *sockets;
 
     liteco_chan_t rchan;
 
     quic_err_t (*cb) (quic_transmission_t *const, quic_recv_packet_t *const);
+    quic_err_t (*batch_cb) (quic_transmission_t *const, quic_recv_packet_t **const, const size_t);
+
+    uint32_t batch_size;
+    bool reuseport;
+
+    uint32_t ring_size;
+    uint32_t ring_high_water;
+    bool ring_hugepages;
+
+    uint64_t recv_batches;
+    uint64_t recv_pkts;
+
+    quic_transmission_pending_t *pendings;
+    uint32_t pendings_count;
+    uint8_t *send_buf;
+    uint32_t send_buf_used;
+    quic_transmission_send_ctx_t *send_ctx;
+
+    uint64_t send_syscalls;
+    uint64_t send_pkts;
 };
 
-quic_err_t quic_transmission_init(quic_transmission_t *const trans, liteco_runtime_t *const rt);
+quic_err_t quic_transmission_init(quic_transmission_t *const trans, liteco_runtime_t *const rt, const quic_transmission_backend_t backend);
 quic_err_t quic_transmission_listen(liteco_eloop_t *const eloop, quic_transmission_t *const trans, const liteco_addr_t local_addr, const uint32_t mtu);
 
+/*
+ * close the sockets and release the receive rings, the io_uring instance and the send batch.
+ * the eloop of the transmission must not run anymore
+ */
+quic_err_t quic_transmission_destory(quic_transmission_t *const trans);
+
+/*
+ * attach a reuseport program to the SO_REUSEPORT group of the socket bound to local_addr: a short header
+ * packet is delivered to the socket whose index in the group equals the first byte of its destination
+ * connection id, everything else keeps the kernel 4-tuple hash. linux only (SO_ATTACH_REUSEPORT_CBPF)
+ */
+quic_err_t quic_transmission_steer_by_connid(quic_transmission_t *const trans, const liteco_addr_t local_addr);
+
+/*
+ * queue a packet into the send batch of the transmission, the packet is copied and will be sent by quic_transmission_flush.
+ * consecutive packets which share a path and a size are sent as one UDP_SEGMENT (GSO) datagram on linux
+ */
+quic_err_t quic_transmission_push(quic_transmission_t *const trans, const quic_path_t path, const void *const data, const uint32_t len);
+
+/*
+ * append a packet to the last queued datagram when it targets the same path, so that several QUIC packets
+ * are coalesced into one UDP datagram. otherwise the packet is queued as a new datagram
+ */
+quic_err_t quic_transmission_append(quic_transmission_t *const trans, const quic_path_t path, const void *const data, const uint32_t len);
+quic_err_t quic_transmission_flush(quic_transmission_t *const trans);
+
 __quic_header_inline quic_err_t quic_transmission_recv(quic_transmission_t *const trans, quic_err_t (*cb) (quic_transmission_t *const, quic_recv_packet_t *const)) {
     trans->cb = cb;
     return quic_err_success;
 }
+
+/*
+ * enable batched receive, every wakeup of the socket drains up to batch_size datagrams (by recvmmsg on linux)
+ * into the preallocated ring of the socket. must be called before quic_transmission_listen, quic_err_conflict otherwise
+ */
+__quic_header_inline quic_err_t quic_transmission_recv_batch(quic_transmission_t *const trans, const uint32_t batch_size,
+                                                            quic_err_t (*batch_cb) (quic_transmission_t *const, quic_recv_packet_t **const, const size_t)) {
+    // the rings of the bound sockets were sized without the batch
+    if (liteco_rbt_is_not_nil(trans->sockets)) {
+        return quic_err_conflict;
+    }
+    trans->batch_size = batch_size;
+    trans->batch_cb = batch_cb;
+    return quic_err_success;
+}
+
+/*
+ * size the packet ring of every socket: ring_size fixed buffers (backed by huge pages if possible),
+ * plus up to high_water malloced packets when the ring runs out, further datagrams are read and dropped (shed).
+ * must be called before quic_transmission_listen
+ */
+__quic_header_inline quic_err_t quic_transmission_recv_ring(quic_transmission_t *const trans,
+                                                           const uint32_t ring_size, const uint32_t high_water, const bool hugepages) {
+    trans->ring_size = ring_size;
+    trans->ring_high_water = high_water;
+    trans->ring_hugepages = hugepages;
+    return quic_err_success;
+}
+
+/*
+ * bind the sockets of the transmission with SO_REUSEPORT, so that several transmissions (one per worker thread)
+ * can listen on the same address. must be called before quic_transmission_listen
+ */
+__quic_header_inline quic_err_t quic_transmission_reuseport(quic_transmission_t *const trans, const bool reuseport) {
+    trans->reuseport = reuseport;
+    return quic_err_success;
+}
+
+__quic_header_inline double quic_transmission_recv_avg_batch(quic_transmission_t *const trans) {
+    if (trans->recv_batches == 0) {
+        return 0;
+    }
+    return (double) trans->recv_pkts / trans->recv_batches;
+}
+
+/*
+ * sum of the ring counters of all sockets: allocations which found a ring empty, and datagrams which were shed
+ */
+__quic_header_inline quic_err_t quic_transmission_recv_ring_stats(quic_transmission_t *const trans, uint64_t *const exhausted, uint64_t *const shed) {
+    quic_transmission_socket_t *socket = NULL;
+
+    *exhausted = 0;
+    *shed = 0;
+    liteco_rbt_foreach(socket, trans->sockets) {
+        *exhausted += atomic_load_explicit(&socket->ring.exhausted, memory_order_relaxed);
+        *shed += atomic_load_explicit(&socket->ring.shed, memory_order_relaxed);
+    }
+
+    return quic_err_success;
+}
+
 __quic_header_inline bool quic_transmission_exist(quic_transmission_t *const trans, const liteco_addr_t addr) {
     return liteco_rbt_is_not_nil(liteco_rbt_find(trans->sockets, &addr));
 }
@@ -51,7 +224,12 @@ __quic_header_inline quic_err_t quic_transmission_send(quic_transmission_t *cons
         return quic_err_not_implemented;
     }
 
-    liteco_udp_chan_sendto(&socket->udp, (struct sockaddr *) &path.rmt_addr, data, len);
+    if (trans->backend == quic_transmission_backend_io_uring) {
+        sendto(quic_transmission_socket_fd(socket), data, len, 0, (struct sockaddr *) &path.rmt_addr, liteco_addr_type_size(&path.rmt_addr));
+    }
+    else {
+        liteco_udp_chan_sendto(&socket->udp, (struct sockaddr *) &path.rmt_addr, data, len);
+    }
 
     return quic_err_success;
 }
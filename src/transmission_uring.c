@@ -0,0 +1,478 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <liburing.h>
+
+#include "utils/time.h"
+#include "utils/container_of.h"
+#include "transmission_uring.h"
+#include <string.h>
+
+// send completions carry this tag, the send batch and the message index, recv completions carry the socket
+#define QUIC_TRANSMISSION_URING_SEND_TAG (1ULL << 63)
+#define QUIC_TRANSMISSION_URING_SEND_DATA(batch, msg) (QUIC_TRANSMISSION_URING_SEND_TAG | ((uint64_t) (batch) << 32) | (msg))
+
+// a send batch of the transmission (pendings, send_buf and send_ctx) with the messages not completed yet
+typedef struct quic_transmission_uring_send_s quic_transmission_uring_send_t;
+struct quic_transmission_uring_send_s {
+    quic_transmission_pending_t *pendings;
+    uint8_t *send_buf;
+    quic_transmission_send_ctx_t *send_ctx;
+    uint32_t inflight;
+};
+
+struct quic_transmission_uring_s {
+    struct io_uring ring;
+    quic_transmission_t *trans;
+
+    struct io_uring_buf_ring *br;
+    quic_recv_packet_ring_t bufs;
+    // io_uring_recvmsg_out and the peer address are written in front of the payload
+    uint32_t prefix;
+    struct msghdr recv_msg;
+    // a multishot recv stopped with -ENOBUFS, the receives wait for recycled buffers
+    bool nobufs;
+    uint32_t recycled;
+
+    // completions are signaled to the eventfd, a waiter thread wakes the eloop up
+    int efd;
+    pthread_t waiter;
+    _Atomic bool closing;
+    liteco_async_t event;
+
+    liteco_linknode_t received;
+    quic_recv_packet_t **batch;
+
+    // the transmission fills sends[current], the others are free once nothing of them is in flight
+    quic_transmission_uring_send_t sends[QUIC_TRANSMISSION_URING_SEND_BATCHES];
+    uint32_t sends_count;
+    uint32_t current;
+};
+
+static quic_err_t quic_transmission_uring_init(liteco_eloop_t *const eloop, quic_transmission_t *const trans, const uint32_t mtu);
+static int quic_transmission_uring_bind(const liteco_addr_t *const local_addr, const bool reuseport);
+static quic_err_t quic_transmission_uring_arm(quic_transmission_uring_t *const uring, quic_transmission_socket_t *const socket);
+static struct io_uring_sqe *quic_transmission_uring_sqe(quic_transmission_uring_t *const uring);
+static void quic_transmission_uring_reap(quic_transmission_uring_t *const uring);
+static bool quic_transmission_uring_send_alloc(quic_transmission_uring_t *const uring);
+static void quic_transmission_uring_rearm(quic_transmission_uring_t *const uring);
+static void quic_transmission_uring_received(quic_transmission_uring_t *const uring, quic_transmission_socket_t *const socket, const struct io_uring_cqe *const cqe, const uint64_t now);
+static void quic_transmission_uring_dispatch(quic_transmission_uring_t *const uring);
+static void quic_transmission_uring_recycle(quic_recv_packet_ring_t *const ring, quic_recv_packet_t *const recvpkt);
+static void quic_transmission_uring_event_cb(liteco_async_t *const event);
+static void *quic_transmission_uring_waiter(void *const args);
+
+quic_err_t quic_transmission_uring_listen(liteco_eloop_t *const eloop, quic_transmission_t *const trans, quic_transmission_socket_t *const socket) {
+    quic_err_t err = quic_err_success;
+
+    if (!trans->uring && (err = quic_transmission_uring_init(eloop, trans, socket->mtu)) != quic_err_success) {
+        return err;
+    }
+
+    if ((socket->fd = quic_transmission_uring_bind(&socket->key, trans->reuseport)) < 0) {
+        return quic_err_internal_error;
+    }
+    socket->rearm = false;
+
+    if (quic_transmission_uring_arm(trans->uring, socket) != quic_err_success) {
+        close(socket->fd);
+        return quic_err_internal_error;
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_transmission_uring_sendmsgs(quic_transmission_t *const trans, quic_transmission_socket_t *const socket,
+                                            struct mmsghdr *const msgs, const uint32_t first, const uint32_t count) {
+    quic_transmission_uring_t *const uring = trans->uring;
+    quic_transmission_uring_send_t *const send = &uring->sends[uring->current];
+    uint32_t k;
+
+    for (k = first; k < first + count; k++) {
+        struct io_uring_sqe *const sqe = quic_transmission_uring_sqe(uring);
+        if (!sqe) {
+            quic_transmission_uring_sent(trans, send->pendings, send->send_buf, send->send_ctx, k, -EBUSY);
+            continue;
+        }
+        io_uring_prep_sendmsg(sqe, socket->fd, &msgs[k].msg_hdr, 0);
+        io_uring_sqe_set_data64(sqe, QUIC_TRANSMISSION_URING_SEND_DATA(uring->current, k));
+        send->inflight++;
+    }
+
+    return quic_err_success;
+}
+
+quic_err_t quic_transmission_uring_submit(quic_transmission_t *const trans) {
+    quic_transmission_uring_t *const uring = trans->uring;
+
+    if (!uring->sends[uring->current].inflight) {
+        return quic_err_success;
+    }
+    io_uring_submit(&uring->ring);
+    trans->send_syscalls++;
+
+    // the completions are reaped on the eventfd wakeup. only when every batch is in flight, wait for one of them
+    while (!quic_transmission_uring_send_alloc(uring)) {
+        io_uring_submit_and_wait(&uring->ring, 1);
+        quic_transmission_uring_reap(uring);
+    }
+
+    quic_transmission_uring_send_t *const send = &uring->sends[uring->current];
+    trans->pendings = send->pendings;
+    trans->send_buf = send->send_buf;
+    trans->send_ctx = send->send_ctx;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_transmission_uring_destory(quic_transmission_t *const trans) {
+    quic_transmission_uring_t *const uring = trans->uring;
+    uint32_t i;
+
+    if (!uring) {
+        return quic_err_success;
+    }
+
+    atomic_store(&uring->closing, true);
+    eventfd_write(uring->efd, 1);
+    pthread_join(uring->waiter, NULL);
+
+    io_uring_unregister_eventfd(&uring->ring);
+    close(uring->efd);
+    io_uring_free_buf_ring(&uring->ring, uring->br, QUIC_TRANSMISSION_URING_BUFS, QUIC_TRANSMISSION_URING_BGID);
+    io_uring_queue_exit(&uring->ring);
+
+    // the batch being filled is released with the transmission
+    for (i = 0; i < uring->sends_count; i++) {
+        if (i == uring->current) {
+            continue;
+        }
+        quic_free(uring->sends[i].pendings);
+        quic_free(uring->sends[i].send_buf);
+        quic_free(uring->sends[i].send_ctx);
+    }
+
+    // received datagrams which were never dispatched live in the slots as well
+    quic_recv_packet_ring_destory(&uring->bufs);
+    quic_free(uring->batch);
+    quic_free(uring);
+    trans->uring = NULL;
+
+    return quic_err_success;
+}
+
+static quic_err_t quic_transmission_uring_init(liteco_eloop_t *const eloop, quic_transmission_t *const trans, const uint32_t mtu) {
+    quic_transmission_uring_t *const uring = quic_malloc(sizeof(quic_transmission_uring_t));
+    uint32_t i;
+    int ret = 0;
+
+    if (!uring) {
+        return quic_err_internal_error;
+    }
+    memset(uring, 0, sizeof(quic_transmission_uring_t));
+    uring->trans = trans;
+    atomic_init(&uring->closing, false);
+    liteco_link_init(&uring->received);
+
+    // the batch the transmission fills right now is the first one
+    uring->sends[0].pendings = trans->pendings;
+    uring->sends[0].send_buf = trans->send_buf;
+    uring->sends[0].send_ctx = trans->send_ctx;
+    uring->sends_count = 1;
+    uring->current = 0;
+
+    uring->recv_msg.msg_namelen = sizeof(liteco_addr_t);
+    uring->prefix = sizeof(struct io_uring_recvmsg_out) + uring->recv_msg.msg_namelen;
+    if (uring->prefix > offsetof(quic_recv_packet_t, pkt.buf)) {
+        quic_free(uring);
+        return quic_err_not_implemented;
+    }
+
+    if (!(uring->batch = quic_malloc(sizeof(quic_recv_packet_t *) * QUIC_TRANSMISSION_BATCH_SIZE))) {
+        quic_free(uring);
+        return quic_err_internal_error;
+    }
+    if (io_uring_queue_init(QUIC_TRANSMISSION_URING_ENTRIES, &uring->ring, 0) < 0) {
+        quic_free(uring->batch);
+        quic_free(uring);
+        return quic_err_internal_error;
+    }
+
+    // the slots of the ring are the provided buffers, the kernel owns every slot which is not being processed
+    if (quic_recv_packet_ring_init(&uring->bufs, QUIC_TRANSMISSION_URING_BUFS, mtu, trans->ring_hugepages) != quic_err_success) {
+        goto failed;
+    }
+    atomic_store(&uring->bufs.free_head, QUIC_RECV_PACKET_RING_NIL);
+    uring->bufs.recovery_cb = quic_transmission_uring_recycle;
+
+    uring->br = io_uring_setup_buf_ring(&uring->ring, QUIC_TRANSMISSION_URING_BUFS, QUIC_TRANSMISSION_URING_BGID, 0, &ret);
+    if (!uring->br) {
+        goto failed;
+    }
+    for (i = 0; i < QUIC_TRANSMISSION_URING_BUFS; i++) {
+        quic_recv_packet_t *const recvpkt = quic_recv_packet_ring_slot(&uring->bufs, i);
+        io_uring_buf_ring_add(uring->br, recvpkt->pkt.buf - uring->prefix, uring->prefix + mtu,
+                              i, io_uring_buf_ring_mask(QUIC_TRANSMISSION_URING_BUFS), i);
+    }
+    io_uring_buf_ring_advance(uring->br, QUIC_TRANSMISSION_URING_BUFS);
+
+    if ((uring->efd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        goto failed;
+    }
+    if (io_uring_register_eventfd(&uring->ring, uring->efd) != 0) {
+        close(uring->efd);
+        goto failed;
+    }
+    liteco_async_init(eloop, &uring->event, quic_transmission_uring_event_cb);
+    if (pthread_create(&uring->waiter, NULL, quic_transmission_uring_waiter, uring) != 0) {
+        close(uring->efd);
+        goto failed;
+    }
+
+    trans->uring = uring;
+    return quic_err_success;
+
+failed:
+    if (uring->br) {
+        io_uring_free_buf_ring(&uring->ring, uring->br, QUIC_TRANSMISSION_URING_BUFS, QUIC_TRANSMISSION_URING_BGID);
+    }
+    io_uring_queue_exit(&uring->ring);
+    quic_recv_packet_ring_destory(&uring->bufs);
+    quic_free(uring->batch);
+    quic_free(uring);
+    return quic_err_internal_error;
+}
+
+static int quic_transmission_uring_bind(const liteco_addr_t *const local_addr, const bool reuseport) {
+    const struct sockaddr *const addr = (const struct sockaddr *) local_addr;
+    const int fd = socket(addr->sa_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+#if defined(SO_REUSEPORT)
+    if (reuseport) {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    }
+#endif
+    if (bind(fd, addr, liteco_addr_type_size(local_addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static quic_err_t quic_transmission_uring_arm(quic_transmission_uring_t *const uring, quic_transmission_socket_t *const socket) {
+    struct io_uring_sqe *const sqe = quic_transmission_uring_sqe(uring);
+    if (!sqe) {
+        return quic_err_internal_error;
+    }
+
+    io_uring_prep_recvmsg_multishot(sqe, socket->fd, &uring->recv_msg, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = QUIC_TRANSMISSION_URING_BGID;
+    io_uring_sqe_set_data64(sqe, (uint64_t) (uintptr_t) socket);
+
+    io_uring_submit(&uring->ring);
+
+    return quic_err_success;
+}
+
+static struct io_uring_sqe *quic_transmission_uring_sqe(quic_transmission_uring_t *const uring) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&uring->ring);
+    if (!sqe) {
+        io_uring_submit(&uring->ring);
+        sqe = io_uring_get_sqe(&uring->ring);
+    }
+
+    return sqe;
+}
+
+static void quic_transmission_uring_reap(quic_transmission_uring_t *const uring) {
+    struct io_uring_cqe *cqe = NULL;
+    const uint64_t now = quic_now();
+
+    while (io_uring_peek_cqe(&uring->ring, &cqe) == 0) {
+        const uint64_t data = io_uring_cqe_get_data64(cqe);
+
+        if (data & QUIC_TRANSMISSION_URING_SEND_TAG) {
+            quic_transmission_uring_send_t *const send = &uring->sends[(data & ~QUIC_TRANSMISSION_URING_SEND_TAG) >> 32];
+            send->inflight--;
+            quic_transmission_uring_sent(uring->trans, send->pendings, send->send_buf, send->send_ctx, data & 0xffffffff, cqe->res);
+        }
+        else {
+            quic_transmission_socket_t *const socket = (quic_transmission_socket_t *) (uintptr_t) data;
+            quic_transmission_uring_received(uring, socket, cqe, now);
+
+            // the multishot recv stopped, it is armed again once the received packets were dispatched.
+            // without provided buffers (-ENOBUFS) it would fail right away, wait for enough of them to come back
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                socket->rearm = true;
+                if (cqe->res == -ENOBUFS) {
+                    uring->nobufs = true;
+                    uring->recycled = 0;
+                }
+            }
+        }
+
+        io_uring_cqe_seen(&uring->ring, cqe);
+    }
+}
+
+static bool quic_transmission_uring_send_alloc(quic_transmission_uring_t *const uring) {
+    uint32_t i;
+
+    for (i = 0; i < uring->sends_count; i++) {
+        if (!uring->sends[i].inflight) {
+            uring->current = i;
+            return true;
+        }
+    }
+    if (uring->sends_count == QUIC_TRANSMISSION_URING_SEND_BATCHES) {
+        return false;
+    }
+
+    quic_transmission_uring_send_t *const send = &uring->sends[uring->sends_count];
+    send->pendings = quic_malloc(sizeof(quic_transmission_pending_t) * QUIC_TRANSMISSION_SEND_BATCH_SIZE);
+    send->send_buf = quic_malloc(QUIC_TRANSMISSION_SEND_BUF_SIZE);
+    send->send_ctx = quic_transmission_uring_send_ctx_alloc();
+    send->inflight = 0;
+    if (!send->pendings || !send->send_buf || !send->send_ctx) {
+        quic_free(send->pendings);
+        quic_free(send->send_buf);
+        quic_free(send->send_ctx);
+        return false;
+    }
+    uring->current = uring->sends_count++;
+
+    return true;
+}
+
+static void quic_transmission_uring_rearm(quic_transmission_uring_t *const uring) {
+    quic_transmission_socket_t *socket = NULL;
+
+    if (uring->nobufs) {
+        return;
+    }
+
+    liteco_rbt_foreach(socket, uring->trans->sockets) {
+        if (socket->rearm && quic_transmission_uring_arm(uring, socket) == quic_err_success) {
+            socket->rearm = false;
+        }
+    }
+}
+
+static void quic_transmission_uring_received(quic_transmission_uring_t *const uring, quic_transmission_socket_t *const socket, const struct io_uring_cqe *const cqe, const uint64_t now) {
+    if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+        return;
+    }
+    quic_recv_packet_t *const recvpkt = quic_recv_packet_ring_slot(&uring->bufs, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    if (cqe->res < 0) {
+        quic_transmission_uring_recycle(&uring->bufs, recvpkt);
+        return;
+    }
+
+    struct io_uring_recvmsg_out *const out = io_uring_recvmsg_validate(recvpkt->pkt.buf - uring->prefix, cqe->res, &uring->recv_msg);
+    if (!out || (out->flags & MSG_TRUNC)) {
+        quic_transmission_uring_recycle(&uring->bufs, recvpkt);
+        return;
+    }
+    liteco_addr_t rmt_addr;
+    memcpy(&rmt_addr, io_uring_recvmsg_name(out), sizeof(liteco_addr_t));
+    const uint32_t len = io_uring_recvmsg_payload_length(out, cqe->res, &uring->recv_msg);
+
+    // the recvmsg header overlapped the fields in front of the payload, rebuild them
+    recvpkt->ring = &uring->bufs;
+    recvpkt->recv_time = now;
+    recvpkt->pkt.loc_addr = socket->key;
+    recvpkt->pkt.rmt_addr = rmt_addr;
+    recvpkt->pkt.b_size = uring->bufs.mtu;
+    recvpkt->pkt.ret = len;
+
+    liteco_link_insert_before(&uring->received, recvpkt);
+}
+
+static void quic_transmission_uring_dispatch(quic_transmission_uring_t *const uring) {
+    quic_transmission_t *const trans = uring->trans;
+
+    while (!liteco_link_empty(&uring->received)) {
+        size_t count = 0;
+        size_t i;
+
+        while (count < QUIC_TRANSMISSION_BATCH_SIZE && !liteco_link_empty(&uring->received)) {
+            quic_recv_packet_t *const recvpkt = (quic_recv_packet_t *) liteco_link_next(&uring->received);
+            liteco_link_remove(recvpkt);
+            uring->batch[count++] = recvpkt;
+        }
+
+        trans->recv_batches++;
+        trans->recv_pkts += count;
+
+        if (trans->batch_cb) {
+            trans->batch_cb(trans, uring->batch, count);
+            continue;
+        }
+        for (i = 0; i < count; i++) {
+            if (trans->cb) {
+                trans->cb(trans, uring->batch[i]);
+            }
+            else {
+                quic_recv_packet_recovery(uring->batch[i]);
+            }
+        }
+    }
+}
+
+static void quic_transmission_uring_recycle(quic_recv_packet_ring_t *const ring, quic_recv_packet_t *const recvpkt) {
+    quic_transmission_uring_t *const uring = container_of(ring, quic_transmission_uring_t, bufs);
+
+    io_uring_buf_ring_add(uring->br, recvpkt->pkt.buf - uring->prefix, uring->prefix + ring->mtu,
+                          quic_recv_packet_ring_idx(ring, recvpkt), io_uring_buf_ring_mask(ring->capa), 0);
+    io_uring_buf_ring_advance(uring->br, 1);
+
+    if (uring->nobufs && ++uring->recycled >= QUIC_TRANSMISSION_URING_REARM_BUFS) {
+        uring->nobufs = false;
+        quic_transmission_uring_rearm(uring);
+    }
+}
+
+static void quic_transmission_uring_event_cb(liteco_async_t *const event) {
+    quic_transmission_uring_t *const uring = container_of(event, quic_transmission_uring_t, event);
+
+    quic_transmission_uring_reap(uring);
+    quic_transmission_uring_dispatch(uring);
+    quic_transmission_uring_rearm(uring);
+}
+
+static void *quic_transmission_uring_waiter(void *const args) {
+    quic_transmission_uring_t *const uring = args;
+    uint64_t val;
+
+    for ( ;; ) {
+        if (read(uring->efd, &val, sizeof(val)) < 0 && errno != EINTR) {
+            break;
+        }
+        if (atomic_load(&uring->closing)) {
+            break;
+        }
+        liteco_async_send(&uring->event);
+    }
+
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_TRANSMISSION_URING_H__
+#define __OPENQUIC_TRANSMISSION_URING_H__
+
+#include "transmission.h"
+
+#if defined(__linux__) && defined(QUIC_TRANSMISSION_IO_URING)
+
+#ifndef QUIC_TRANSMISSION_URING_ENTRIES
+#define QUIC_TRANSMISSION_URING_ENTRIES 256
+#endif
+
+// provided receive buffers shared by the sockets of a transmission, must be a power of two
+#ifndef QUIC_TRANSMISSION_URING_BUFS
+#define QUIC_TRANSMISSION_URING_BUFS 1024
+#endif
+
+#define QUIC_TRANSMISSION_URING_BGID 0
+
+// send batches which may be in flight at once, a flush waits for completions when all of them are
+#ifndef QUIC_TRANSMISSION_URING_SEND_BATCHES
+#define QUIC_TRANSMISSION_URING_SEND_BATCHES 4
+#endif
+
+// after running out of provided buffers, the multishot receives are armed again once this many buffers came back
+#ifndef QUIC_TRANSMISSION_URING_REARM_BUFS
+#define QUIC_TRANSMISSION_URING_REARM_BUFS 64
+#endif
+
+/*
+ * open, bind and arm a socket of the transmission, the io_uring instance is created by the first socket.
+ * received datagrams are dispatched to the transmission callbacks from the eloop of the transmission
+ */
+quic_err_t quic_transmission_uring_listen(liteco_eloop_t *const eloop, quic_transmission_t *const trans, quic_transmission_socket_t *const socket);
+
+/*
+ * queue the messages first to first + count - 1 of the send batch of the transmission, nothing is submitted yet
+ */
+quic_err_t quic_transmission_uring_sendmsgs(quic_transmission_t *const trans, quic_transmission_socket_t *const socket,
+                                            struct mmsghdr *const msgs, const uint32_t first, const uint32_t count);
+
+/*
+ * submit the queued messages with a single io_uring_enter without waiting for them. the send batch stays with the
+ * io_uring instance until its completions were reaped, the transmission continues with a free batch
+ */
+quic_err_t quic_transmission_uring_submit(quic_transmission_t *const trans);
+
+/*
+ * the messages of a send batch are laid out by transmission.c, which allocates them for the further batches as well
+ */
+quic_transmission_send_ctx_t *quic_transmission_uring_send_ctx_alloc();
+
+/*
+ * completion of the message msg of a send batch (res is the sent bytes or -errno), implemented by transmission.c:
+ * the packets of the message are counted, or sent one by one when the message failed
+ */
+void quic_transmission_uring_sent(quic_transmission_t *const trans, const quic_transmission_pending_t *const pendings, const uint8_t *const send_buf,
+                                  const quic_transmission_send_ctx_t *const ctx, const uint32_t msg, const int res);
+
+/*
+ * stop and join the waiter thread, then release the io_uring instance with its provided buffers.
+ * the multishot receives go away with the ring, the sockets are closed by the caller
+ */
+quic_err_t quic_transmission_uring_destory(quic_transmission_t *const trans);
+
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "utils/connid_table.h"
+#include "platform/platform.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define quic_siphash_rotl(x, b) \
+    (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define quic_siphash_round(v0, v1, v2, v3)                                    \
+    {                                                                         \
+        (v0) += (v1); (v1) = quic_siphash_rotl((v1), 13); (v1) ^= (v0);       \
+        (v0) = quic_siphash_rotl((v0), 32);                                   \
+        (v2) += (v3); (v3) = quic_siphash_rotl((v3), 16); (v3) ^= (v2);       \
+        (v0) += (v3); (v3) = quic_siphash_rotl((v3), 21); (v3) ^= (v0);       \
+        (v2) += (v1); (v1) = quic_siphash_rotl((v1), 17); (v1) ^= (v2);       \
+        (v2) = quic_siphash_rotl((v2), 32);                                   \
+    }
+
+static inline uint64_t quic_siphash_read64(const uint8_t *const p);
+static inline bool quic_connid_table_entry_match(const quic_connid_table_entry_t *const entry, const uint64_t hash, const quic_buf_t *const key);
+static quic_connid_table_entry_t *quic_connid_table_lookup(quic_connid_table_t *const table, const uint64_t hash, const quic_buf_t *const key);
+static quic_err_t quic_connid_table_resize(quic_connid_table_t *const table, const size_t capa);
+static void quic_connid_table_place(quic_connid_table_t *const table, const quic_connid_table_entry_t *const entry);
+
+uint64_t quic_siphash(const uint64_t k0, const uint64_t k1, const void *const data, const size_t len) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+    const uint8_t *p = data;
+    const uint8_t *const end = p + (len & ~7UL);
+    uint64_t m;
+    size_t i;
+
+    for ( ; p != end; p += 8) {
+        m = quic_siphash_read64(p);
+        v3 ^= m;
+        quic_siphash_round(v0, v1, v2, v3);
+        quic_siphash_round(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    // the remaining bytes little endian, the length in the top byte
+    m = ((uint64_t) len) << 56;
+    for (i = 0; i < (len & 7); i++) {
+        m |= ((uint64_t) p[i]) << (8 * i);
+    }
+    v3 ^= m;
+    quic_siphash_round(v0, v1, v2, v3);
+    quic_siphash_round(v0, v1, v2, v3);
+    v0 ^= m;
+
+    v2 ^= 0xff;
+    quic_siphash_round(v0, v1, v2, v3);
+    quic_siphash_round(v0, v1, v2, v3);
+    quic_siphash_round(v0, v1, v2, v3);
+    quic_siphash_round(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+quic_err_t quic_connid_table_init(quic_connid_table_t *const table, const uint8_t secret[16]) {
+    table->k0 = quic_siphash_read64(secret);
+    table->k1 = quic_siphash_read64(secret + 8);
+    table->size = 0;
+    table->capa = QUIC_CONNID_TABLE_INIT_CAPA;
+    table->entries = quic_malloc(sizeof(quic_connid_table_entry_t) * table->capa);
+    if (!table->entries) {
+        table->capa = 0;
+        return quic_err_internal_error;
+    }
+    memset(table->entries, 0, sizeof(quic_connid_table_entry_t) * table->capa);
+
+    return quic_err_success;
+}
+
+quic_err_t quic_connid_table_destory(quic_connid_table_t *const table) {
+    if (table->entries) {
+        quic_free(table->entries);
+    }
+    table->entries = NULL;
+    table->capa = 0;
+    table->size = 0;
+
+    return quic_err_success;
+}
+
+void *quic_connid_table_find(quic_connid_table_t *const table, const quic_buf_t *const key) {
+    if (quic_buf_size(key) > QUIC_CONNID_TABLE_KEY_MAX) {
+        return NULL;
+    }
+    const uint64_t hash = quic_siphash(table->k0, table->k1, key->pos, quic_buf_size(key));
+    quic_connid_table_entry_t *const entry = quic_connid_table_lookup(table, hash, key);
+
+    return entry->value;
+}
+
+quic_err_t quic_connid_table_insert(quic_connid_table_t *const table, const quic_buf_t *const key, void *const value) {
+    if (!value || quic_buf_size(key) > QUIC_CONNID_TABLE_KEY_MAX) {
+        return quic_err_bad_format;
+    }
+
+    // keep the load factor under 1/2, probe sequences stay short with linear probing
+    if ((table->size + 1) * 2 > table->capa) {
+        quic_err_t err = quic_connid_table_resize(table, table->capa * 2);
+        if (err != quic_err_success) {
+            return err;
+        }
+    }
+
+    const uint64_t hash = quic_siphash(table->k0, table->k1, key->pos, quic_buf_size(key));
+    quic_connid_table_entry_t *const entry = quic_connid_table_lookup(table, hash, key);
+    if (entry->value) {
+        return quic_err_conflict;
+    }
+
+    entry->hash = hash;
+    entry->value = value;
+    entry->len = quic_buf_size(key);
+    memcpy(entry->key, key->pos, entry->len);
+    table->size++;
+
+    return quic_err_success;
+}
+
+void *quic_connid_table_remove(quic_connid_table_t *const table, const quic_buf_t *const key) {
+    if (quic_buf_size(key) > QUIC_CONNID_TABLE_KEY_MAX) {
+        return NULL;
+    }
+    const uint64_t hash = quic_siphash(table->k0, table->k1, key->pos, quic_buf_size(key));
+    quic_connid_table_entry_t *entry = quic_connid_table_lookup(table, hash, key);
+    void *const value = entry->value;
+    if (!value) {
+        return NULL;
+    }
+
+    // backward shift: pull following entries of the probe run into the hole, no tombstones are left behind
+    const size_t mask = table->capa - 1;
+    size_t hole = entry - table->entries;
+    size_t i = hole;
+    for ( ;; ) {
+        i = (i + 1) & mask;
+        quic_connid_table_entry_t *const next = &table->entries[i];
+        if (!next->value) {
+            break;
+        }
+        const size_t home = next->hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            table->entries[hole] = *next;
+            hole = i;
+        }
+    }
+    table->entries[hole].value = NULL;
+    table->size--;
+
+    return value;
+}
+
+static inline uint64_t quic_siphash_read64(const uint8_t *const p) {
+    return ((uint64_t) p[0]) | ((uint64_t) p[1] << 8) | ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24)
+        | ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40) | ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+}
+
+static inline bool quic_connid_table_entry_match(const quic_connid_table_entry_t *const entry, const uint64_t hash, const quic_buf_t *const key) {
+    return entry->hash == hash && entry->len == quic_buf_size(key) && memcmp(entry->key, key->pos, entry->len) == 0;
+}
+
+static quic_connid_table_entry_t *quic_connid_table_lookup(quic_connid_table_t *const table, const uint64_t hash, const quic_buf_t *const key) {
+    const size_t mask = table->capa - 1;
+    size_t i = hash & mask;
+
+    while (table->entries[i].value && !quic_connid_table_entry_match(&table->entries[i], hash, key)) {
+        i = (i + 1) & mask;
+    }
+
+    return &table->entries[i];
+}
+
+static quic_err_t quic_connid_table_resize(quic_connid_table_t *const table, const size_t capa) {
+    quic_connid_table_entry_t *const entries = table->entries;
+    const size_t old_capa = table->capa;
+    size_t i;
+
+    table->entries = quic_malloc(sizeof(quic_connid_table_entry_t) * capa);
+    if (!table->entries) {
+        table->entries = entries;
+        return quic_err_internal_error;
+    }
+    memset(table->entries, 0, sizeof(quic_connid_table_entry_t) * capa);
+    table->capa = capa;
+
+    for (i = 0; i < old_capa; i++) {
+        if (entries[i].value) {
+            quic_connid_table_place(table, &entries[i]);
+        }
+    }
+    quic_free(entries);
+
+    return quic_err_success;
+}
+
+static void quic_connid_table_place(quic_connid_table_t *const table, const quic_connid_table_entry_t *const entry) {
+    const size_t mask = table->capa - 1;
+    size_t i = entry->hash & mask;
+
+    while (table->entries[i].value) {
+        i = (i + 1) & mask;
+    }
+    table->entries[i] = *entry;
+}
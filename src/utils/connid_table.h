@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_CONNID_TABLE_H__
+#define __OPENQUIC_CONNID_TABLE_H__
+
+#include "utils/buf.h"
+#include "utils/errno.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef QUIC_CONNID_TABLE_KEY_MAX
+#define QUIC_CONNID_TABLE_KEY_MAX 20
+#endif
+
+// must be a power of two
+#ifndef QUIC_CONNID_TABLE_INIT_CAPA
+#define QUIC_CONNID_TABLE_INIT_CAPA 1024
+#endif
+
+/*
+ * connection id keys are copied into the slot, a slot is empty when its value is NULL
+ */
+typedef struct quic_connid_table_entry_s quic_connid_table_entry_t;
+struct quic_connid_table_entry_s {
+    uint64_t hash;
+    void *value;
+    uint8_t len;
+    uint8_t key[QUIC_CONNID_TABLE_KEY_MAX];
+};
+
+/*
+ * open addressing (linear probing, backward shift deletion) table keyed by connection id,
+ * slots are located by SipHash-2-4 under a per-table secret so peers cannot force collisions
+ */
+typedef struct quic_connid_table_s quic_connid_table_t;
+struct quic_connid_table_s {
+    quic_connid_table_entry_t *entries;
+    size_t capa;
+    size_t size;
+
+    uint64_t k0;
+    uint64_t k1;
+};
+
+quic_err_t quic_connid_table_init(quic_connid_table_t *const table, const uint8_t secret[16]);
+quic_err_t quic_connid_table_destory(quic_connid_table_t *const table);
+
+void *quic_connid_table_find(quic_connid_table_t *const table, const quic_buf_t *const key);
+quic_err_t quic_connid_table_insert(quic_connid_table_t *const table, const quic_buf_t *const key, void *const value);
+void *quic_connid_table_remove(quic_connid_table_t *const table, const quic_buf_t *const key);
+
+uint64_t quic_siphash(const uint64_t k0, const uint64_t k1, const void *const data, const size_t len);
+
+#define quic_connid_table_foreach(entry, table) \
+    for ((entry) = (table)->entries; (entry) != (table)->entries + (table)->capa; (entry)++) if ((entry)->value)
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "utils/sent_packet_ring.h"
+
+static quic_err_t quic_sent_packet_ring_grow(quic_sent_packet_ring_t *const ring, const uint64_t need);
+
+static quic_err_t quic_sent_packet_ring_grow(quic_sent_packet_ring_t *const ring, const uint64_t need) {
+    uint64_t capa = ring->capa ? ring->capa : QUIC_SENT_PACKET_RING_INIT_CAPA;
+    while (capa < need) {
+        capa <<= 1;
+    }
+    if (capa > UINT32_MAX) {
+        return quic_err_internal_error;
+    }
+
+    quic_sent_packet_t *const slots = quic_malloc(sizeof(quic_sent_packet_t) * capa);
+    if (!slots) {
+        return quic_err_internal_error;
+    }
+
+    uint64_t num;
+    for (num = 0; num < capa; num++) {
+        slots[num].in_flight = false;
+    }
+    for (num = ring->base; num < ring->end; num++) {
+        quic_sent_packet_t *const src = quic_sent_packet_ring_at(ring, num);
+        if (!src->in_flight) {
+            continue;
+        }
+        quic_sent_packet_t *const dst = &slots[num & (capa - 1)];
+        *dst = *src;
+
+        // the frames list is linked through its head, relink it at the new address
+        if (liteco_link_empty(&src->frames)) {
+            liteco_link_init(&dst->frames);
+        }
+        else {
+            dst->frames.next->prev = &dst->frames;
+            dst->frames.prev->next = &dst->frames;
+        }
+    }
+
+    if (ring->slots) {
+        quic_free(ring->slots);
+    }
+    ring->slots = slots;
+    ring->capa = capa;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sent_packet_ring_destory(quic_sent_packet_ring_t *const ring) {
+    if (ring->slots) {
+        quic_free(ring->slots);
+    }
+    return quic_sent_packet_ring_init(ring);
+}
+
+quic_sent_packet_t *quic_sent_packet_ring_push(quic_sent_packet_ring_t *const ring, const uint64_t num) {
+    if (ring->end != 0 && num < ring->end) {
+        return NULL;
+    }
+    if (ring->count == 0) {
+        ring->base = num;
+        ring->end = num;
+    }
+    if (num - ring->base >= ring->capa && quic_sent_packet_ring_grow(ring, num - ring->base + 1) != quic_err_success) {
+        return NULL;
+    }
+
+    // skipped packet numbers are never in flight
+    for (; ring->end < num; ring->end++) {
+        quic_sent_packet_ring_at(ring, ring->end)->in_flight = false;
+    }
+
+    quic_sent_packet_t *const pkt = quic_sent_packet_ring_at(ring, num);
+    pkt->num = num;
+    pkt->largest_ack = 0;
+    pkt->sent_time = 0;
+    pkt->pkt_len = 0;
+    pkt->included_unacked = false;
+    pkt->in_flight = true;
+    liteco_link_init(&pkt->frames);
+
+    ring->end = num + 1;
+    ring->count++;
+
+    return pkt;
+}
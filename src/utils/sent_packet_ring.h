@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_SENT_PACKET_RING_H__
+#define __OPENQUIC_SENT_PACKET_RING_H__
+
+#include "utils/errno.h"
+#include "platform/platform.h"
+#include "liteco.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// slots allocated by the first push, a power of two
+#ifndef QUIC_SENT_PACKET_RING_INIT_CAPA
+#define QUIC_SENT_PACKET_RING_INIT_CAPA 64
+#endif
+
+typedef struct quic_sent_packet_s quic_sent_packet_t;
+struct quic_sent_packet_s {
+    uint64_t num;
+    uint64_t largest_ack;
+    uint64_t sent_time;
+    uint32_t pkt_len;
+    bool included_unacked;
+    // cleared once the packet is acknowledged or declared lost
+    bool in_flight;
+    liteco_linknode_t frames;
+};
+
+/*
+ * packets of one packet number space in flight, the slot of a packet is its distance from base (the smallest
+ * packet number not yet acknowledged or lost). packet numbers are pushed in ascending order, so finding a packet
+ * is an index and an ACK range only visits the slots it covers. slots move when the ring grows, a returned packet
+ * is valid until the next push
+ */
+typedef struct quic_sent_packet_ring_s quic_sent_packet_ring_t;
+struct quic_sent_packet_ring_s {
+    quic_sent_packet_t *slots;
+    uint32_t capa;
+
+    uint64_t base;
+    // one past the largest packet number pushed
+    uint64_t end;
+    uint32_t count;
+};
+
+__quic_header_inline quic_err_t quic_sent_packet_ring_init(quic_sent_packet_ring_t *const ring) {
+    ring->slots = NULL;
+    ring->capa = 0;
+    ring->base = 0;
+    ring->end = 0;
+    ring->count = 0;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_sent_packet_ring_destory(quic_sent_packet_ring_t *const ring);
+
+// returns the slot of num with the frames list initialized, NULL when num is not above every pushed packet number
+quic_sent_packet_t *quic_sent_packet_ring_push(quic_sent_packet_ring_t *const ring, const uint64_t num);
+
+__quic_header_inline quic_sent_packet_t *quic_sent_packet_ring_at(quic_sent_packet_ring_t *const ring, const uint64_t num) {
+    return &ring->slots[num & (ring->capa - 1)];
+}
+
+__quic_header_inline quic_sent_packet_t *quic_sent_packet_ring_find(quic_sent_packet_ring_t *const ring, const uint64_t num) {
+    if (num < ring->base || num >= ring->end) {
+        return NULL;
+    }
+    quic_sent_packet_t *const pkt = quic_sent_packet_ring_at(ring, num);
+    return pkt->in_flight ? pkt : NULL;
+}
+
+// the oldest packet in flight, NULL when the ring is empty
+__quic_header_inline quic_sent_packet_t *quic_sent_packet_ring_first(quic_sent_packet_ring_t *const ring) {
+    return ring->count ? quic_sent_packet_ring_at(ring, ring->base) : NULL;
+}
+
+// the frames of pkt must have been taken out, base skips the packets no longer in flight
+__quic_header_inline void quic_sent_packet_ring_remove(quic_sent_packet_ring_t *const ring, quic_sent_packet_t *const pkt) {
+    pkt->in_flight = false;
+    if (--ring->count == 0) {
+        ring->base = ring->end;
+        return;
+    }
+    while (!quic_sent_packet_ring_at(ring, ring->base)->in_flight) {
+        ring->base++;
+    }
+}
+
+#define quic_sent_packet_ring_foreach(pkt, ring)                                                                  \
+    for (uint64_t __num = (ring)->base; __num < (ring)->end; __num++)                                           \
+        if (((pkt) = quic_sent_packet_ring_at((ring), __num))->in_flight)
+
+#endif
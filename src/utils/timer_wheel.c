@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#include "utils/timer_wheel.h"
+
+#define QUIC_TIMER_WHEEL_MASK (QUIC_TIMER_WHEEL_SLOTS - 1)
+
+#define quic_timer_wheel_span(level) \
+    (((uint64_t) 1) << (QUIC_TIMER_WHEEL_BITS * (level)))
+
+static inline void quic_timer_wheel_link(quic_timer_wheel_t *const wheel, quic_timer_t *const timer);
+static inline void quic_timer_wheel_cascade(quic_timer_wheel_t *const wheel, const uint32_t level);
+
+quic_err_t quic_timer_wheel_init(quic_timer_wheel_t *const wheel, const uint64_t tick, const uint64_t now) {
+    uint32_t level;
+    uint32_t i;
+
+    if (!tick) {
+        return quic_err_bad_format;
+    }
+    wheel->tick = tick;
+    wheel->curr_tick = now / tick;
+    wheel->count = 0;
+    for (level = 0; level < QUIC_TIMER_WHEEL_LEVELS; level++) {
+        for (i = 0; i < QUIC_TIMER_WHEEL_SLOTS; i++) {
+            liteco_link_init(&wheel->slots[level][i]);
+        }
+    }
+
+    return quic_err_success;
+}
+
+static inline void quic_timer_wheel_link(quic_timer_wheel_t *const wheel, quic_timer_t *const timer) {
+    // rounded up, a timer never fires before expires_at
+    uint64_t tick = (timer->expires_at + wheel->tick - 1) / wheel->tick;
+    uint32_t level;
+
+    if (tick < wheel->curr_tick) {
+        tick = wheel->curr_tick;
+    }
+    if (tick - wheel->curr_tick >= quic_timer_wheel_span(QUIC_TIMER_WHEEL_LEVELS)) {
+        tick = wheel->curr_tick + quic_timer_wheel_span(QUIC_TIMER_WHEEL_LEVELS) - 1;
+    }
+
+    for (level = 0; level + 1 < QUIC_TIMER_WHEEL_LEVELS; level++) {
+        if (tick - wheel->curr_tick < quic_timer_wheel_span(level + 1)) {
+            break;
+        }
+    }
+
+    liteco_link_insert_before(&wheel->slots[level][(tick >> (QUIC_TIMER_WHEEL_BITS * level)) & QUIC_TIMER_WHEEL_MASK], timer);
+}
+
+quic_err_t quic_timer_wheel_add(quic_timer_wheel_t *const wheel, quic_timer_t *const timer, const uint64_t expires_at, void (*cb) (quic_timer_t *const)) {
+    if (timer->pending) {
+        quic_timer_wheel_remove(wheel, timer);
+    }
+
+    timer->expires_at = expires_at;
+    timer->cb = cb;
+    timer->pending = true;
+    quic_timer_wheel_link(wheel, timer);
+    wheel->count++;
+
+    return quic_err_success;
+}
+
+quic_err_t quic_timer_wheel_remove(quic_timer_wheel_t *const wheel, quic_timer_t *const timer) {
+    if (!timer->pending) {
+        return quic_err_success;
+    }
+
+    liteco_link_remove(timer);
+    liteco_link_init(timer);
+    timer->pending = false;
+    wheel->count--;
+
+    return quic_err_success;
+}
+
+static inline void quic_timer_wheel_cascade(quic_timer_wheel_t *const wheel, const uint32_t level) {
+    liteco_linknode_t *const slot = &wheel->slots[level][(wheel->curr_tick >> (QUIC_TIMER_WHEEL_BITS * level)) & QUIC_TIMER_WHEEL_MASK];
+    liteco_linknode_t moved;
+
+    if (liteco_link_empty(slot)) {
+        return;
+    }
+
+    liteco_link_init(&moved);
+    while (!liteco_link_empty(slot)) {
+        quic_timer_t *const timer = (quic_timer_t *) slot->next;
+        liteco_link_remove(timer);
+        liteco_link_insert_before(&moved, timer);
+    }
+    while (!liteco_link_empty(&moved)) {
+        quic_timer_t *const timer = (quic_timer_t *) moved.next;
+        liteco_link_remove(timer);
+        quic_timer_wheel_link(wheel, timer);
+    }
+}
+
+size_t quic_timer_wheel_expire(quic_timer_wheel_t *const wheel, const uint64_t now) {
+    const uint64_t now_tick = now / wheel->tick;
+    size_t fired = 0;
+    liteco_linknode_t expired;
+    uint32_t level;
+
+    while (wheel->curr_tick <= now_tick) {
+        if (!wheel->count) {
+            wheel->curr_tick = now_tick + 1;
+            break;
+        }
+
+        // entering a new slot of the levels above, their timers move closer
+        for (level = 1; level < QUIC_TIMER_WHEEL_LEVELS; level++) {
+            if (wheel->curr_tick & (quic_timer_wheel_span(level) - 1)) {
+                break;
+            }
+            quic_timer_wheel_cascade(wheel, level);
+        }
+
+        liteco_linknode_t *const slot = &wheel->slots[0][wheel->curr_tick & QUIC_TIMER_WHEEL_MASK];
+        wheel->curr_tick++;
+        if (liteco_link_empty(slot)) {
+            continue;
+        }
+
+        // unlink first, callbacks may add timers into this slot again
+        liteco_link_init(&expired);
+        while (!liteco_link_empty(slot)) {
+            quic_timer_t *const timer = (quic_timer_t *) slot->next;
+            liteco_link_remove(timer);
+            liteco_link_insert_before(&expired, timer);
+        }
+
+        while (!liteco_link_empty(&expired)) {
+            quic_timer_t *const timer = (quic_timer_t *) expired.next;
+            liteco_link_remove(timer);
+            liteco_link_init(timer);
+            timer->pending = false;
+            wheel->count--;
+            fired++;
+
+            timer->cb(timer);
+        }
+    }
+
+    return fired;
+}
+
+uint64_t quic_timer_wheel_next(quic_timer_wheel_t *const wheel) {
+    uint64_t tick = wheel->curr_tick;
+
+    if (!wheel->count) {
+        return 0;
+    }
+
+    // up to the next wrap around of the first level, where the levels above may cascade timers into it
+    do {
+        if (!liteco_link_empty(&wheel->slots[0][tick & QUIC_TIMER_WHEEL_MASK])) {
+            break;
+        }
+        tick++;
+    } while (tick & QUIC_TIMER_WHEEL_MASK);
+
+    return tick * wheel->tick;
+}
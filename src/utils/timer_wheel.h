@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020-2021 Gscienty <gaoxiaochuan@hotmail.com>
+ *
+ * Distributed under the MIT software license, see the accompanying
+ * file LICENSE or https://www.opensource.org/licenses/mit-license.php .
+ *
+ */
+
+#ifndef __OPENQUIC_TIMER_WHEEL_H__
+#define __OPENQUIC_TIMER_WHEEL_H__
+
+#include "utils/errno.h"
+#include "platform/platform.h"
+#include "liteco.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// slots of a level are 1 << QUIC_TIMER_WHEEL_BITS ticks of the level below
+#ifndef QUIC_TIMER_WHEEL_BITS
+#define QUIC_TIMER_WHEEL_BITS 6
+#endif
+
+#ifndef QUIC_TIMER_WHEEL_LEVELS
+#define QUIC_TIMER_WHEEL_LEVELS 4
+#endif
+
+#define QUIC_TIMER_WHEEL_SLOTS (1 << QUIC_TIMER_WHEEL_BITS)
+
+typedef struct quic_timer_s quic_timer_t;
+struct quic_timer_s {
+    LITECO_LINKNODE_BASE
+
+    uint64_t expires_at;
+    bool pending;
+
+    // called by quic_timer_wheel_expire once the timer is unlinked, the timer may be freed or added again
+    void (*cb) (quic_timer_t *const);
+};
+
+/*
+ * hierarchical timer wheel, adding and removing a timer are O(1). a timer is linked into the level covering
+ * its distance from curr_tick and moved one level down each time the level below wraps around. timers fire
+ * on the first tick boundary at or after expires_at, timers beyond the last level wait in its farthest slot
+ */
+typedef struct quic_timer_wheel_s quic_timer_wheel_t;
+struct quic_timer_wheel_s {
+    uint64_t tick;
+    // every tick before curr_tick has been expired
+    uint64_t curr_tick;
+    size_t count;
+
+    liteco_linknode_t slots[QUIC_TIMER_WHEEL_LEVELS][QUIC_TIMER_WHEEL_SLOTS];
+};
+
+quic_err_t quic_timer_wheel_init(quic_timer_wheel_t *const wheel, const uint64_t tick, const uint64_t now);
+
+__quic_header_inline void quic_timer_init(quic_timer_t *const timer) {
+    liteco_link_init(timer);
+    timer->expires_at = 0;
+    timer->pending = false;
+    timer->cb = NULL;
+}
+
+quic_err_t quic_timer_wheel_add(quic_timer_wheel_t *const wheel, quic_timer_t *const timer, const uint64_t expires_at, void (*cb) (quic_timer_t *const));
+
+quic_err_t quic_timer_wheel_remove(quic_timer_wheel_t *const wheel, quic_timer_t *const timer);
+
+// fires the timers expired at now, returns how many fired
+size_t quic_timer_wheel_expire(quic_timer_wheel_t *const wheel, const uint64_t now);
+
+// the wheel need not be expired before the returned time (us), 0 when no timer is pending
+uint64_t quic_timer_wheel_next(quic_timer_wheel_t *const wheel);
+
+#endif
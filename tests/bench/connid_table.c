@@ -0,0 +1,86 @@
+#include "utils/connid_table.h"
+#include "utils/rbt_extend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef BENCH_MAX_CONNS
+#define BENCH_MAX_CONNS 1000000
+#endif
+#define BENCH_LOOKUPS 1000000
+#define BENCH_CONNID_LEN 8
+
+static uint64_t bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static void bench_connid(uint8_t *const connid, const size_t i) {
+    uint64_t x = (i + 1) * 0x9e3779b97f4a7c15UL;
+    x ^= x >> 31;
+    memcpy(connid, &x, BENCH_CONNID_LEN);
+}
+
+int main() {
+    static const uint8_t secret[16] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10 };
+    uint8_t *const connids = malloc(BENCH_MAX_CONNS * BENCH_CONNID_LEN);
+    quic_string_rbt_t *const nodes = malloc(BENCH_MAX_CONNS * sizeof(quic_string_rbt_t));
+    size_t conns;
+    size_t i;
+
+    for (i = 0; i < BENCH_MAX_CONNS; i++) {
+        bench_connid(connids + i * BENCH_CONNID_LEN, i);
+    }
+
+    printf("conns\trbt ns/lookup\ttable ns/lookup\n");
+    for (conns = 1000; conns <= BENCH_MAX_CONNS; conns *= 10) {
+        quic_connid_table_t table;
+        quic_string_rbt_t *root;
+        size_t found = 0;
+
+        quic_connid_table_init(&table, secret);
+        liteco_rbt_init(root);
+        for (i = 0; i < conns; i++) {
+            quic_buf_t key = { .buf = connids + i * BENCH_CONNID_LEN, .capa = BENCH_CONNID_LEN };
+            quic_buf_setpl(&key);
+
+            quic_connid_table_insert(&table, &key, &nodes[i]);
+
+            liteco_rbt_node_init(&nodes[i]);
+            nodes[i].key = key;
+            liteco_rbt_insert(&root, &nodes[i]);
+        }
+
+        uint64_t start = bench_now();
+        for (i = 0; i < BENCH_LOOKUPS; i++) {
+            quic_buf_t key = { .buf = connids + (i * 7919 % conns) * BENCH_CONNID_LEN, .capa = BENCH_CONNID_LEN };
+            quic_buf_setpl(&key);
+            found += liteco_rbt_is_not_nil(liteco_rbt_find(root, &key));
+        }
+        uint64_t rbt_ns = bench_now() - start;
+
+        start = bench_now();
+        for (i = 0; i < BENCH_LOOKUPS; i++) {
+            quic_buf_t key = { .buf = connids + (i * 7919 % conns) * BENCH_CONNID_LEN, .capa = BENCH_CONNID_LEN };
+            quic_buf_setpl(&key);
+            found += quic_connid_table_find(&table, &key) != NULL;
+        }
+        uint64_t table_ns = bench_now() - start;
+
+        printf("%ld\t%.1f\t%.1f\t(found %ld)\n", conns, (double) rbt_ns / BENCH_LOOKUPS, (double) table_ns / BENCH_LOOKUPS, found);
+
+        for (i = 0; i < conns; i++) {
+            quic_buf_t key = { .buf = connids + i * BENCH_CONNID_LEN, .capa = BENCH_CONNID_LEN };
+            quic_buf_setpl(&key);
+            quic_connid_table_remove(&table, &key);
+        }
+        printf("removed, left %ld\n", table.size);
+        quic_connid_table_destory(&table);
+    }
+
+    free(nodes);
+    free(connids);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "modules/sealer.h"
+#include "modules/sender.h"
+#include "format/frame.h"
+#include "format/header.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS 1000000
+#define BENCH_PAYLOAD_SIZE 1100
+#define BENCH_CONNID_LEN 8
+
+static uint8_t key[16] = { 0 };
+static uint8_t iv[12] = { 0 };
+
+static uint64_t bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+// the opening path before in-place decryption: a scratch buffer per packet and a copy back
+static quic_err_t bench_open_copy(quic_buf_t *const pkt, quic_sealer_t *const sealer, const size_t hdr_size) {
+    const size_t payload_size = pkt->capa - hdr_size;
+    uint8_t *const payload_off = (uint8_t *) pkt->buf + hdr_size;
+
+    uint8_t *opened_payload = quic_malloc(payload_size);
+    size_t opened_outlen = 0;
+    if (!opened_payload) {
+        return quic_err_internal_error;
+    }
+    EVP_AEAD_CTX_open(&sealer->r_ctx,
+                      opened_payload, &opened_outlen, payload_size,
+                      sealer->r_iv.pos, quic_buf_size(&sealer->r_iv),
+                      payload_off, payload_size,
+                      pkt->buf, hdr_size);
+    memcpy(payload_off, opened_payload, opened_outlen);
+    quic_free(opened_payload);
+
+    return quic_err_success;
+}
+
+int main() {
+    static quic_sealer_module_t module;
+    quic_sealer_t *const sealer = &module.app_sealer;
+    memset(&module, 0, sizeof(module));
+
+    // 1-RTT keys without header protection, both directions share the same key
+    sealer->w_aead_tag_size = EVP_AEAD_max_tag_len(EVP_aead_aes_128_gcm());
+    sealer->r_aead_tag_size = sealer->w_aead_tag_size;
+    EVP_AEAD_CTX_init(&sealer->w_ctx, EVP_aead_aes_128_gcm(), key, sizeof(key), sealer->w_aead_tag_size, NULL);
+    EVP_AEAD_CTX_init(&sealer->r_ctx, EVP_aead_aes_128_gcm(), key, sizeof(key), sealer->r_aead_tag_size, NULL);
+    sealer->w_iv = (quic_buf_t) { .buf = iv, .capa = sizeof(iv) };
+    quic_buf_setpl(&sealer->w_iv);
+    sealer->r_iv = sealer->w_iv;
+
+    quic_send_packet_t *pkt = malloc(sizeof(quic_send_packet_t) + 1500);
+    quic_send_packet_reset(pkt, 1500);
+
+    quic_frame_crypto_t *frame = malloc(sizeof(quic_frame_crypto_t) + BENCH_PAYLOAD_SIZE);
+    quic_frame_init(frame, quic_frame_crypto_type);
+    frame->off = 0;
+    frame->len = BENCH_PAYLOAD_SIZE;
+    frame->ref = NULL;
+    memset(frame->data, 0x5a, BENCH_PAYLOAD_SIZE);
+    liteco_link_insert_before(&pkt->frames, frame);
+
+    // short header: first byte, dst connid, 2 bytes packet number
+    quic_buf_t hdr = { .buf = pkt->buf.pos, .capa = 1 + BENCH_CONNID_LEN + 2 };
+    quic_buf_setpl(&hdr);
+    *(uint8_t *) hdr.pos = quic_packet_short_type | 0x01;
+    memset(hdr.pos + 1, 0x11, BENCH_CONNID_LEN);
+    const uint64_t num = 0x1234;
+    quic_packet_number_format(hdr.pos + 1 + BENCH_CONNID_LEN, num, 2);
+    const size_t hdr_size = quic_buf_size(&hdr);
+
+    quic_sealer_seal(pkt, sealer, hdr, BENCH_CONNID_LEN);
+    const size_t sealed_size = quic_buf_size(&pkt->buf);
+
+    uint8_t datagram[1500];
+    uint64_t start;
+    uint64_t in_place_ns;
+    uint64_t copy_ns;
+    int i;
+
+    start = bench_now();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        memcpy(datagram, pkt->data, sealed_size);
+        quic_buf_t recv = { .buf = datagram, .capa = sealed_size };
+        quic_buf_setpl(&recv);
+        bench_open_copy(&recv, sealer, hdr_size);
+    }
+    copy_ns = bench_now() - start;
+
+    start = bench_now();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        memcpy(datagram, pkt->data, sealed_size);
+        quic_buf_t recv = { .buf = datagram, .capa = sealed_size };
+        quic_buf_setpl(&recv);
+        quic_sealer_open(&recv, &module, BENCH_CONNID_LEN);
+    }
+    in_place_ns = bench_now() - start;
+
+    printf("packet size: %zu\n", sealed_size);
+    printf("copy open: %.0f pkts/sec\n", BENCH_ROUNDS * 1e9 / copy_ns);
+    printf("in-place open: %.0f pkts/sec\n", BENCH_ROUNDS * 1e9 / in_place_ns);
+    printf("payload check: %02x\n", datagram[hdr_size + 4]);
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "utils/sent_packet_ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_IN_FLIGHT 10000
+#define BENCH_ACKS 10000
+// every ACK frame acknowledges BENCH_ACK_RANGES ranges of one packet, the next frame fills the gaps
+#define BENCH_ACK_RANGES 4
+
+typedef struct bench_sent_rbt_s bench_sent_rbt_t;
+struct bench_sent_rbt_s {
+    LITECO_RBT_KEY_UINT64_FIELDS
+
+    uint64_t sent_time;
+    uint32_t pkt_len;
+};
+
+static uint64_t bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+// the packet acknowledged by a range of the i-th ACK frame, the oldest packets are acknowledged first
+static uint64_t bench_acked(const int i, const int range) {
+    return (i >> 1) * (BENCH_ACK_RANGES << 1) + (i & 1) + (BENCH_ACK_RANGES - 1 - range) * 2;
+}
+
+int main() {
+    bench_sent_rbt_t *const nodes = malloc(sizeof(bench_sent_rbt_t) * (BENCH_IN_FLIGHT + BENCH_ACKS * BENCH_ACK_RANGES));
+    bench_sent_rbt_t *root;
+    quic_sent_packet_ring_t ring;
+    uint64_t num = 0;
+    uint64_t acked = 0;
+    uint64_t bytes = 0;
+    int i;
+    int range;
+
+    liteco_rbt_init(root);
+    quic_sent_packet_ring_init(&ring);
+    for (num = 0; num < BENCH_IN_FLIGHT; num++) {
+        liteco_rbt_node_init(&nodes[num]);
+        nodes[num].key = num;
+        nodes[num].pkt_len = 1200;
+        liteco_rbt_insert(&root, &nodes[num]);
+
+        quic_sent_packet_ring_push(&ring, num)->pkt_len = 1200;
+    }
+
+    // the tree is walked for every ACK frame and each packet is tested against every range
+    uint64_t start = bench_now();
+    for (i = 0; i < BENCH_ACKS; i++) {
+        bench_sent_rbt_t *pkt = NULL;
+        bench_sent_rbt_t *next = NULL;
+        const uint64_t sent = num + i * BENCH_ACK_RANGES;
+        int j;
+        for (j = 0; j < BENCH_ACK_RANGES; j++) {
+            bench_sent_rbt_t *const node = &nodes[sent + j];
+            liteco_rbt_node_init(node);
+            node->key = sent + j;
+            node->pkt_len = 1200;
+            liteco_rbt_insert(&root, node);
+        }
+
+        for (pkt = (bench_sent_rbt_t *) liteco_rbt_min(root); liteco_rbt_is_not_nil(pkt); pkt = next) {
+            next = (bench_sent_rbt_t *) liteco_rbt_next(pkt);
+            for (range = 0; range < BENCH_ACK_RANGES; range++) {
+                if (pkt->key == bench_acked(i, range)) {
+                    bytes += pkt->pkt_len;
+                    acked++;
+                    liteco_rbt_remove(&root, &pkt);
+                    break;
+                }
+            }
+        }
+    }
+    uint64_t rbt_ns = bench_now() - start;
+
+    // only the slots covered by the ranges are visited
+    start = bench_now();
+    for (i = 0; i < BENCH_ACKS; i++) {
+        const uint64_t sent = num + i * BENCH_ACK_RANGES;
+        int j;
+        for (j = 0; j < BENCH_ACK_RANGES; j++) {
+            quic_sent_packet_ring_push(&ring, sent + j)->pkt_len = 1200;
+        }
+
+        for (range = 0; range < BENCH_ACK_RANGES; range++) {
+            quic_sent_packet_t *const pkt = quic_sent_packet_ring_find(&ring, bench_acked(i, range));
+            if (pkt) {
+                bytes += pkt->pkt_len;
+                acked++;
+                quic_sent_packet_ring_remove(&ring, pkt);
+            }
+        }
+    }
+    uint64_t ring_ns = bench_now() - start;
+
+    printf("in flight\trbt ns/ack\tring ns/ack\n");
+    printf("%d\t%.1f\t%.1f\t(acked %ld, %ld bytes, ring capa %u)\n",
+           BENCH_IN_FLIGHT, (double) rbt_ns / BENCH_ACKS, (double) ring_ns / BENCH_ACKS, acked, bytes, ring.capa);
+
+    quic_sent_packet_ring_destory(&ring);
+    free(nodes);
+    return 0;
+}
@@ -37,7 +37,7 @@ void common_ack() {
     buf.pos = buf.buf;
     quic_frame_ack_t *frame = NULL;
 
-    quic_frame_parse(frame, &buf);
+    quic_frame_parse(frame, &buf, NULL);
     printf("%lx\n", frame->largest_ack);
     printf("%lx\n", frame->delay);
     printf("%lx\n", frame->first_range);
@@ -88,7 +88,7 @@ void ecn_ack() {
     buf.pos = buf.buf;
     quic_frame_ack_t *frame = NULL;
 
-    quic_frame_parse(frame, &buf);
+    quic_frame_parse(frame, &buf, NULL);
     printf("%lx\n", frame->largest_ack);
     printf("%lx\n", frame->delay);
     printf("%lx\n", frame->first_range);
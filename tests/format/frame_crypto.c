@@ -25,7 +25,7 @@ int main() {
 
     quic_buf_setpl(&buf);
     quic_frame_crypto_t *frame = NULL;
-    quic_frame_parse(frame, &buf);
+    quic_frame_parse(frame, &buf, NULL);
 
     printf("%lx\n", crypto->off);
     printf("%lx\n", crypto->len);
@@ -23,7 +23,7 @@ int main() {
 
     quic_buf_setpl(&buf);
     quic_frame_new_token_t *frame = NULL;
-    quic_frame_parse(frame, &buf);
+    quic_frame_parse(frame, &buf, NULL);
 
     printf("%lx\n", frame->len);
     for (i = 0; i < 32; i++) {
@@ -0,0 +1,35 @@
+#include "format/frame.h"
+#include <stdio.h>
+
+int main() {
+    quic_frame_padding_t padding;
+
+    padding.first_byte = quic_frame_padding_type;
+    padding.len = 5;
+
+    uint8_t data[128];
+    quic_buf_t buf;
+    buf.buf = data;
+    buf.pos = buf.buf;
+    buf.last = buf.buf + 128;
+
+    quic_frame_format(&buf, (quic_frame_t *) &padding);
+    quic_frame_ping_t ping;
+    ping.first_byte = quic_frame_ping_type;
+    quic_frame_format(&buf, (quic_frame_t *) &ping);
+
+    printf("%ld\n", buf.pos - buf.buf);
+
+    buf.last = buf.pos;
+    buf.pos = data;
+    quic_frame_t *frame;
+    quic_frame_parse(frame, &buf, NULL);
+
+    // a run of PADDING bytes is parsed as one frame
+    printf("%x %ld\n", frame->first_byte, ((quic_frame_padding_t *) frame)->len);
+
+    quic_frame_parse(frame, &buf, NULL);
+    printf("%x\n", frame->first_byte);
+
+    return 0;
+}
@@ -18,7 +18,7 @@ int main() {
 
     buf.pos = data;
     quic_frame_t *frame;
-    quic_frame_parse(frame, &buf);
+    quic_frame_parse(frame, &buf, NULL);
 
     printf("%x\n", frame->first_byte);
 
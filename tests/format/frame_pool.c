@@ -0,0 +1,30 @@
+#include "format/frame.h"
+#include <stdio.h>
+
+int main() {
+    quic_frame_pool_t pool;
+    quic_frame_pool_init(&pool);
+
+    quic_frame_ping_t *ping = NULL;
+    quic_frame_create(ping, &pool, quic_frame_ping_type, sizeof(quic_frame_ping_t));
+    printf("%ld %ld\n", pool.hit, pool.miss);
+    quic_frame_free(ping);
+
+    quic_frame_create(ping, &pool, quic_frame_ping_type, sizeof(quic_frame_ping_t));
+    printf("%ld %ld\n", pool.hit, pool.miss);
+    printf("%02x\n", ping->first_byte);
+    quic_frame_free(ping);
+
+    quic_frame_crypto_t *crypto = NULL;
+    quic_frame_create(crypto, &pool, quic_frame_crypto_type, sizeof(quic_frame_crypto_t) + 1200);
+    printf("%ld %ld\n", pool.hit, pool.miss);
+    quic_frame_free(crypto);
+
+    quic_frame_create(crypto, &pool, quic_frame_crypto_type, sizeof(quic_frame_crypto_t) + 1000);
+    printf("%ld %ld\n", pool.hit, pool.miss);
+    quic_frame_free(crypto);
+
+    quic_frame_pool_destory(&pool);
+
+    return 0;
+}
@@ -20,7 +20,7 @@ int main() {
 
     buf.pos = buf.buf;
     quic_frame_reset_stream_t *frame = NULL;
-    quic_frame_parse(frame, &buf);
+    quic_frame_parse(frame, &buf, NULL);
 
     printf("%lx\n", frame->sid);
     printf("%lx\n", frame->app_err);
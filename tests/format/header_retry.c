@@ -0,0 +1,36 @@
+#include "format/header.h"
+#include <stdio.h>
+
+int main() {
+    uint8_t bytes[] = {
+        0xf0,
+        0x00, 0x00, 0x00, 0x00,
+        0x04,
+        0x05, 0x06, 0x07, 0x08,
+        0x02,
+        0x09, 0x0a,
+
+        // token
+        0x10, 0x11, 0x12,
+
+        // integrity tag
+        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+        0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f
+    };
+
+    quic_header_t *header = (quic_header_t *) bytes;
+
+    printf("%d\n", quic_long_header_check(bytes, sizeof(bytes)));
+
+    quic_retry_header_t retry = quic_retry_header(header, sizeof(bytes));
+    printf("%ld %x %x\n", quic_buf_size(&retry.token), *(uint8_t *) retry.token.pos, retry.tag[0]);
+
+    // truncated in the source connection id
+    printf("%d\n", quic_long_header_check(bytes, 12));
+
+    // connection id longer than 20 bytes
+    bytes[5] = 21;
+    printf("%d\n", quic_long_header_check(bytes, sizeof(bytes)));
+
+    return 0;
+}
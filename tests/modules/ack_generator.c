@@ -0,0 +1,84 @@
+#include "modules/ack_generator.h"
+#include "session.h"
+#include <stdio.h>
+
+static void print_ranges(quic_ack_generator_module_t *const module) {
+    uint32_t i;
+    for (i = 0; i < module->ranges_count; i++) {
+        printf("[%lu, %lu] ", quic_ack_generator_range(module, i)->start, quic_ack_generator_range(module, i)->end);
+    }
+    printf("count: %u, evicted: %lu, ignore: %lu\n", module->ranges_count, module->ranges_evicted, module->ignore_threhold);
+}
+
+static void insert(quic_ack_generator_module_t *const module, const uint64_t num) {
+    printf("insert %lu: %d, ", num, quic_ack_generator_insert_ranges(module, num));
+    print_ranges(module);
+}
+
+int main() {
+    quic_config_t cfg = { };
+    quic_session_t *const session = quic_session_create(NULL, cfg, 0);
+    quic_ack_generator_module_t *const module = quic_session_module(session, quic_initial_ack_generator_module);
+    module->module_declare = &quic_initial_ack_generator_module;
+    quic_module_init(module);
+
+    // in order, then a gap filled from both sides
+    insert(module, 1);
+    insert(module, 2);
+    insert(module, 3);
+    insert(module, 6);
+    insert(module, 5);
+    insert(module, 4);
+
+    // reordered packets open ranges below the largest one
+    insert(module, 12);
+    insert(module, 8);
+    insert(module, 10);
+    insert(module, 10);
+    printf("lost 9: %d, lost 10: %d, lost 11: %d, lost 13: %d\n",
+           quic_ack_generator_check_is_lost(module, 9), quic_ack_generator_check_is_lost(module, 10),
+           quic_ack_generator_check_is_lost(module, 11), quic_ack_generator_check_is_lost(module, 13));
+
+    // the frame lists the ranges from the largest down
+    module->should_send = true;
+    quic_frame_ack_t *const ack = quic_ack_generator_generate(module);
+    printf("largest: %lu, first_range: %lu, ranges: %u\n", ack->largest_ack, ack->first_range, ack->ranges.count);
+    uint64_t i;
+    for (i = 0; i < ack->ranges.count; i++) {
+        printf("gap: %lu, len: %lu\n", quic_arr(&ack->ranges, i, quic_ack_range_t)->gap, quic_arr(&ack->ranges, i, quic_ack_range_t)->len);
+    }
+    printf("should_send: %d\n", module->should_send);
+
+    // the delay depends on the clock, the bytes should not
+    ack->delay = 0;
+    uint8_t data[128];
+    quic_buf_t buf;
+    buf.buf = data;
+    buf.pos = buf.buf;
+    buf.last = buf.buf + sizeof(data);
+    quic_frame_format(&buf, ack);
+    printf("size: %lu, formated: %ld\n", quic_frame_size(ack), buf.pos - buf.buf);
+    uint8_t *c;
+    for (c = data; c < (uint8_t *) buf.pos; c++) {
+        printf("%02x ", *c);
+    }
+    printf("\n");
+    quic_frame_free(ack);
+
+    // one gap too many gives up the smallest range
+    quic_module_init(module);
+    for (i = 0; i <= QUIC_ACK_GENERATOR_MAX_RANGES; i++) {
+        quic_ack_generator_insert_ranges(module, 2 + 2 * i);
+    }
+    printf("count: %u, evicted: %lu, ignore: %lu, smallest: %lu, largest: %lu\n",
+           module->ranges_count, module->ranges_evicted, module->ignore_threhold,
+           quic_ack_generator_range(module, 0)->start, quic_ack_generator_range(module, module->ranges_count - 1)->end);
+    // below the smallest range there is no room, a packet joining two ranges needs none
+    printf("insert 1 at the cap: %d\n", quic_ack_generator_insert_ranges(module, 1));
+    printf("insert 5 at the cap: %d, evicted: %lu, smallest: %lu\n",
+           quic_ack_generator_insert_ranges(module, 5), module->ranges_evicted, quic_ack_generator_range(module, 0)->start);
+    quic_ack_generator_set_ignore_threhold(module, 9);
+    print_ranges(module);
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+// white box, built in place of src/modules/congestion.c
+#include "modules/congestion.c"
+#include <stdio.h>
+
+#define PKT_LEN 1200
+// a link of 1.2 MB/s and 50 ms, every packet is delivered
+#define LINK_BW 1200
+#define LINK_RTT (50 * 1000)
+#define LINK_PKTS 20000
+
+static const char *const states[] = {
+    "startup", "drain", "probe_bw_down", "probe_bw_cruise", "probe_bw_refill", "probe_bw_up", "probe_rtt"
+};
+
+static quic_congestion_module_t *bbr_create() {
+    quic_config_t cfg = { };
+    cfg.initial_cwnd = 10 * PKT_LEN;
+    cfg.min_cwnd = 2 * PKT_LEN;
+    cfg.max_cwnd = 10000 * PKT_LEN;
+    cfg.congestion = quic_congestion_algorithm_bbr;
+
+    quic_session_t *const session = quic_session_create(NULL, cfg, 0);
+    quic_congestion_module_t *const module = quic_session_module(session, quic_congestion_module);
+    module->module_declare = &quic_congestion_module;
+    quic_module_init(module);
+    quic_module_start(module);
+
+    quic_path_t path = { };
+    quic_congestion_migrate(module, path);
+
+    return module;
+}
+
+static void minmax() {
+    const uint64_t samples[][2] = { { 1, 80 }, { 3, 90 }, { 6, 70 }, { 11, 60 }, { 14, 50 }, { 15, 40 }, { 17, 120 }, { 40, 10 } };
+    quic_congestion_minmax_t minmax;
+    uint32_t i;
+
+    quic_congestion_minmax_reset(&minmax, 0, 100);
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        printf("round %lu, val %lu: max %lu\n", samples[i][0], samples[i][1],
+               quic_congestion_minmax_running_max(&minmax, 10, samples[i][0], samples[i][1]));
+    }
+}
+
+static void print_sample(const char *const name, const bool sampled, const quic_congestion_rate_sample_t *const sample) {
+    printf("%s: sampled %d, bw %lu, app_limited %d\n", name, sampled, sampled ? sample->bw : 0, sampled && sample->app_limited);
+}
+
+static void delivery_rate() {
+    quic_congestion_module_t *const module = bbr_create();
+    quic_congestion_rate_t *const rate = &quic_congestion_instance(module)->active_instance->rate;
+    quic_congestion_rate_sample_t sample;
+    const uint64_t t = 1000 * 1000;
+    uint64_t num;
+    bool sampled;
+
+    // ten packets sent 1 ms apart and acknowledged 100 ms later, the first flight is measured over the whole RTT
+    for (num = 0; num < 10; num++) {
+        quic_congestion_rate_on_sent(rate, quic_space_app, t + num * 1000, num, PKT_LEN);
+    }
+    for (num = 0; num < 10; num++) {
+        sampled = quic_congestion_rate_on_acked(rate, quic_space_app, num, PKT_LEN, t + 100 * 1000 + num * 1000, 100 * 1000, &sample);
+        if (num == 0 || num == 9) {
+            print_sample(num ? "steady 9" : "steady 0", sampled, &sample);
+        }
+    }
+    printf("delivered %lu, inflight %lu\n", rate->delivered, rate->inflight);
+
+    // the sender ran out of data, the next packet only shows the rate is at least that
+    quic_congestion_bbr_on_app_limited(module);
+    quic_congestion_rate_on_sent(rate, quic_space_app, t + 200 * 1000, 10, PKT_LEN);
+    sampled = quic_congestion_rate_on_acked(rate, quic_space_app, 10, PKT_LEN, t + 300 * 1000, 100 * 1000, &sample);
+    print_sample("app limited", sampled, &sample);
+    printf("app_limited cleared %d\n", rate->app_limited == 0);
+    quic_congestion_rate_on_sent(rate, quic_space_app, t + 300 * 1000, 11, PKT_LEN);
+    sampled = quic_congestion_rate_on_acked(rate, quic_space_app, 11, PKT_LEN, t + 400 * 1000, 100 * 1000, &sample);
+    print_sample("not app limited", sampled, &sample);
+
+    // an ACK compressed below min_rtt after an idle period gives no bandwidth sample
+    quic_congestion_rate_on_sent(rate, quic_space_app, t + 1000 * 1000, 12, PKT_LEN);
+    sampled = quic_congestion_rate_on_acked(rate, quic_space_app, 12, PKT_LEN, t + 1050 * 1000, 100 * 1000, &sample);
+    print_sample("compressed", sampled, &sample);
+
+    // a packet of another packet number space takes the slot over, the sampler does not grow for it
+    quic_congestion_rate_on_sent(rate, quic_space_app, t + 2000 * 1000, 20, PKT_LEN);
+    quic_congestion_rate_on_sent(rate, quic_space_initial, t + 2000 * 1000, 20, PKT_LEN);
+    printf("capa %u\n", rate->capa);
+    sampled = quic_congestion_rate_on_acked(rate, quic_space_app, 20, PKT_LEN, t + 2100 * 1000, 100 * 1000, &sample);
+    print_sample("overwritten app 20", sampled, &sample);
+    sampled = quic_congestion_rate_on_acked(rate, quic_space_initial, 20, PKT_LEN, t + 2100 * 1000, 100 * 1000, &sample);
+    print_sample("initial 20", sampled, &sample);
+
+    // two packets of the same space on one slot grow the sampler
+    quic_congestion_rate_on_sent(rate, quic_space_app, t + 3000 * 1000, 21, PKT_LEN);
+    quic_congestion_rate_on_sent(rate, quic_space_app, t + 3000 * 1000, 21 + rate->capa, PKT_LEN);
+    printf("capa %u, app 21 %d, app %u %d\n", rate->capa, quic_congestion_rate_find(rate, quic_space_app, 21) != NULL,
+           21 + (rate->capa >> 1), quic_congestion_rate_find(rate, quic_space_app, 21 + (rate->capa >> 1)) != NULL);
+
+    // the packets of a dropped space leave inflight and the sampler
+    quic_congestion_rate_on_sent(rate, quic_space_handshake, t + 3000 * 1000, 30, PKT_LEN);
+    quic_congestion_rate_on_sent(rate, quic_space_handshake, t + 3000 * 1000, 31, PKT_LEN);
+    printf("inflight %lu\n", rate->inflight);
+    quic_congestion_on_discarded(module, quic_space_handshake, 2 * PKT_LEN);
+    printf("inflight %lu, handshake 30 %d, app 21 %d\n", rate->inflight,
+           quic_congestion_rate_find(rate, quic_space_handshake, 30) != NULL, quic_congestion_rate_find(rate, quic_space_app, 21) != NULL);
+}
+
+static void state_machine() {
+    static uint64_t sent_time[LINK_PKTS];
+    static uint64_t acked_time[LINK_PKTS];
+    quic_congestion_module_t *const module = bbr_create();
+    quic_congestion_status_store_t *const status = quic_congestion_instance(module)->active_instance;
+    uint64_t t = 1000 * 1000;
+    const uint64_t end = t + 4 * 1000 * 1000;
+    uint64_t num = 0;
+    uint64_t acked = 0;
+    uint64_t inflight = 0;
+    uint64_t link_free = 0;
+    quic_congestion_bbr_state_t state = status->bbr.state;
+
+    printf("%s\n", states[state]);
+    for (; t < end && num < LINK_PKTS; t += 100) {
+        // the link serializes the packets at LINK_BW bytes per ms, the ACK comes back after LINK_RTT
+        while (acked < num && acked_time[acked] <= t) {
+            quic_congestion_update(module, acked_time[acked], sent_time[acked], 0);
+            inflight -= PKT_LEN;
+            quic_congestion_on_acked(module, quic_space_app, acked, PKT_LEN, inflight, acked_time[acked]);
+            acked++;
+        }
+        while (num < LINK_PKTS && quic_congestion_allow_send(module, inflight) && status->bbr.next_send_time <= t + 1000) {
+            link_free = (link_free > t ? link_free : t) + PKT_LEN * 1000 / LINK_BW;
+            sent_time[num] = t;
+            acked_time[num] = link_free + LINK_RTT;
+            inflight += PKT_LEN;
+            quic_congestion_on_sent(module, quic_space_app, t, num, PKT_LEN, true);
+            num++;
+        }
+
+        if (state != status->bbr.state) {
+            state = status->bbr.state;
+            printf("%s\n", states[state]);
+        }
+    }
+    printf("bw %lu, min_rtt %lu, filled_pipe %d\n", quic_congestion_bbr_bw(&status->bbr), status->bbr.min_rtt, status->bbr.filled_pipe);
+}
+
+int main() {
+    minmax();
+    delivery_rate();
+    state_machine();
+
+    return 0;
+}
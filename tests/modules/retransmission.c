@@ -0,0 +1,142 @@
+#include "modules/retransmission.h"
+#include "modules/congestion.h"
+#include "timer_service.h"
+#include "client.h"
+#include "utils/time.h"
+#include "session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define RTT (100 * 1000)
+
+extern quic_session_handler_t quic_session_handler[256];
+
+static liteco_eloop_t eloop;
+static liteco_runtime_t rt;
+static quic_timer_service_t timers;
+// the sessions belong to a client which is never started
+static quic_client_t client;
+
+static quic_session_t *session_create() {
+    quic_config_t cfg = { };
+    cfg.is_cli = true;
+    cfg.initial_cwnd = 10 * 1460;
+    cfg.min_cwnd = 2 * 1460;
+    cfg.max_cwnd = 1000 * 1460;
+
+    quic_session_t *const session = quic_session_create(&client.transmission, cfg, 0);
+    quic_session_init(session, &eloop, &rt, &timers, malloc(8192), 8192);
+
+    quic_path_t path = { };
+    quic_congestion_migrate((quic_congestion_module_t *) quic_session_module(session, quic_congestion_module), path);
+
+    return session;
+}
+
+static void sent(quic_retransmission_module_t *const module, const uint64_t num, const uint64_t sent_time) {
+    quic_retransmission_sent_mem_push(module, num, sent_time, 1200, true);
+}
+
+static void ack(quic_session_t *const session, const uint64_t largest, const uint64_t first_range, const uint64_t recv_time) {
+    quic_frame_ack_t frame = { };
+    frame.first_byte = quic_frame_ack_type;
+    frame.packet_type = quic_packet_short_type;
+    frame.recv_time = recv_time;
+    frame.largest_ack = largest;
+    frame.first_range = first_range;
+    frame.ranges.count = 0;
+    frame.ranges.size = sizeof(quic_ack_range_t);
+
+    quic_session_handler[quic_frame_ack_type](session, (quic_frame_t *) &frame);
+}
+
+static void print_inflight(quic_retransmission_module_t *const module, const uint64_t first, const uint64_t last) {
+    uint64_t num;
+    for (num = first; num <= last; num++) {
+        printf("%lu: %s, ", num, quic_sent_packet_ring_find(&module->sent_mem, num) ? "inflight" : "gone");
+    }
+    printf("unacked_len: %u\n", module->unacked_len);
+}
+
+static void reorder_threshold() {
+    quic_session_t *const session = session_create();
+    quic_retransmission_module_t *const module = quic_session_module(session, quic_app_retransmission_module);
+    const uint64_t now = quic_now();
+
+    // 0, 1 and 2 are three packets behind the acknowledged one, 3 and 4 are not
+    uint64_t num;
+    for (num = 0; num < 6; num++) {
+        sent(module, num, now - RTT);
+    }
+    ack(session, 5, 0, now);
+    print_inflight(module, 0, 5);
+    printf("loss_time: %lu, alarm is loss_time: %d\n", module->loss_time - (now - RTT), module->alarm == module->loss_time);
+
+    // the loss timer fires 9/8 RTT after they were sent
+    usleep(RTT / 8 + 20 * 1000);
+    module->module_declare->loop(module, quic_now());
+    print_inflight(module, 0, 5);
+    printf("loss_time: %lu, alarm: %lu\n", module->loss_time, module->alarm);
+}
+
+static void time_threshold() {
+    quic_session_t *const session = session_create();
+    quic_retransmission_module_t *const module = quic_session_module(session, quic_app_retransmission_module);
+    const uint64_t now = quic_now();
+
+    // 10 is a single packet behind, it is lost only because it was sent more than 9/8 RTT ago
+    sent(module, 10, now - 3 * RTT);
+    sent(module, 11, now - RTT);
+    ack(session, 11, 0, now);
+    print_inflight(module, 10, 11);
+    printf("loss_time: %lu\n", module->loss_time);
+}
+
+static void pto_backoff() {
+    quic_session_t *const session = session_create();
+    quic_retransmission_module_t *const module = quic_session_module(session, quic_app_retransmission_module);
+    const uint64_t now = quic_now();
+
+    // the peer may delay its ACKs by 25 ms, the probe timeout waits for them
+    quic_transport_parameter_t params;
+    quic_transport_parameter_init(&params);
+    params.max_ack_delay = 25;
+    quic_session_set_transport_parameter(session, params);
+    printf("max_delay: %lu\n", module->max_delay);
+
+    // smoothed_rtt RTT and rttvar RTT / 2 after the first sample
+    sent(module, 0, now - RTT);
+    ack(session, 0, 0, now);
+    sent(module, 1, now);
+    printf("pto: %lu, pto_count: %u\n", module->alarm - now, module->pto_count);
+
+    // each probe timeout doubles the next one, the packet stays in flight
+    int i;
+    for (i = 0; i < 3; i++) {
+        module->module_declare->loop(module, module->alarm);
+        printf("pto: %lu, pto_count: %u, probes: %u\n", module->alarm - now, module->pto_count, module->probes);
+    }
+    print_inflight(module, 1, 1);
+
+    // an acknowledgement resets the backoff
+    sent(module, 2, now);
+    ack(session, 2, 1, now + RTT);
+    printf("pto_count: %u, alarm: %lu\n", module->pto_count, module->alarm);
+
+    // a max_ack_delay of 2^14 ms or more is invalid
+    params.max_ack_delay = QUIC_TRANS_PARAM_MAX_ACK_DELAY_MAX;
+    printf("max_ack_delay 2^14: %d\n", quic_session_set_transport_parameter(session, params) == quic_err_bad_format);
+}
+
+int main() {
+    liteco_eloop_init(&eloop);
+    liteco_runtime_init(&eloop, &rt);
+    quic_timer_service_init(&timers, &eloop, &rt);
+
+    reorder_threshold();
+    time_threshold();
+    pto_backoff();
+
+    return 0;
+}
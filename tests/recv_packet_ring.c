@@ -0,0 +1,59 @@
+#include "recv_packet.h"
+#include <pthread.h>
+#include <stdio.h>
+
+#define RING_CAPA 4
+#define RING_HIGH_WATER 2
+#define RING_ROUNDS 100000
+
+static void *recovery_thread(void *const arg) {
+    quic_recv_packet_ring_t *const ring = arg;
+    int i;
+
+    for (i = 0; i < RING_ROUNDS; i++) {
+        quic_recv_packet_t *const recvpkt = quic_recv_packet_alloc(ring);
+        if (recvpkt) {
+            quic_recv_packet_recovery(recvpkt);
+        }
+    }
+
+    return NULL;
+}
+
+int main() {
+    quic_recv_packet_ring_t ring;
+    quic_recv_packet_t *pkts[RING_CAPA + RING_HIGH_WATER + 1];
+    int i;
+
+    quic_recv_packet_ring_init(&ring, RING_CAPA, 1500, false);
+    ring.high_water = RING_HIGH_WATER;
+
+    // the slots, then the malloced packets, then shed
+    for (i = 0; i < RING_CAPA + RING_HIGH_WATER + 1; i++) {
+        pkts[i] = quic_recv_packet_alloc(&ring);
+        printf("%d: %s\n", i, !pkts[i] ? "shed" : quic_recv_packet_ring_owned(&ring, pkts[i]) ? "slot" : "heap");
+    }
+    printf("heap_inuse: %u, exhausted: %lu, shed: %lu\n", ring.heap_inuse, ring.exhausted, ring.shed);
+
+    for (i = 0; i < RING_CAPA + RING_HIGH_WATER; i++) {
+        quic_recv_packet_recovery(pkts[i]);
+    }
+    printf("heap_inuse: %u\n", ring.heap_inuse);
+
+    // packets are allocated and recovered from several threads at once
+    pthread_t threads[4];
+    for (i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, recovery_thread, &ring);
+    }
+    for (i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < RING_CAPA; i++) {
+        pkts[i] = quic_recv_packet_ring_alloc(&ring);
+    }
+    printf("slots back: %d, heap_inuse: %u\n", pkts[RING_CAPA - 1] != NULL && quic_recv_packet_ring_alloc(&ring) == NULL, ring.heap_inuse);
+
+    quic_recv_packet_ring_destory(&ring);
+    return 0;
+}
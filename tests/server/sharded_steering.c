@@ -0,0 +1,145 @@
+#include "server.h"
+#include "client.h"
+#include "modules/stream.h"
+#include "liteco.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#define WORKERS 4
+#define CLIENTS 8
+
+static quic_sharded_server_t sserver;
+static uint8_t ser_buf[256];
+static uint8_t cli_buf[256];
+
+// 1-RTT packets processed by the worker whose index their connection id carries, and by any other worker
+static _Atomic uint32_t owned;
+static _Atomic uint32_t foreign;
+
+static quic_err_t server_write_done(quic_stream_t *const str, void *data, const size_t capa, const size_t len) {
+    (void) data;
+    (void) capa;
+    (void) len;
+
+    quic_stream_close(str, NULL);
+
+    return quic_err_success;
+}
+
+static quic_err_t server_read_done(quic_stream_t *const str, void *const data, const size_t capa, const size_t len) {
+    (void) data;
+    (void) capa;
+    (void) len;
+    quic_session_t *const session = quic_stream_session(str);
+
+    // the stream data is carried by short header packets, which are addressed to the source connection id of the session
+    if (quic_server_connid_worker(&session->src) == quic_session_server(session)->worker_id) {
+        owned++;
+    }
+    else {
+        foreign++;
+    }
+
+    quic_stream_write(str, "pong", 5, server_write_done);
+
+    return quic_err_success;
+}
+
+static quic_err_t server_accept_stream(quic_stream_t *const str) {
+    quic_stream_read(str, ser_buf, sizeof(ser_buf), server_read_done);
+
+    return quic_err_success;
+}
+
+static quic_err_t server_handshake_done(quic_session_t *const session) {
+    quic_session_accept(session, 0, server_accept_stream);
+
+    return quic_err_success;
+}
+
+static quic_err_t server_accept(quic_session_t *const session) {
+    quic_session_handshake_done(session, server_handshake_done);
+
+    return quic_err_success;
+}
+
+static quic_err_t client_read_done(quic_stream_t *const str, void *const data, const size_t capa, const size_t len) {
+    (void) data;
+    (void) capa;
+    (void) len;
+
+    quic_stream_close(str, NULL);
+    quic_session_close(quic_stream_session(str));
+
+    return quic_err_success;
+}
+
+static quic_err_t client_write_done(quic_stream_t *const str, void *data, const size_t capa, const size_t len) {
+    (void) data;
+    (void) capa;
+    (void) len;
+
+    quic_stream_read(str, cli_buf, sizeof(cli_buf), client_read_done);
+
+    return quic_err_success;
+}
+
+static quic_err_t client_handshake_done(quic_session_t *const session) {
+    quic_stream_t *const str = quic_session_open(session, 0, true);
+    quic_stream_write(str, "ping", 5, client_write_done);
+
+    return quic_err_success;
+}
+
+static void *server_loop(void *const args) {
+    (void) args;
+
+    quic_sharded_server_start_loop(&sserver);
+
+    return NULL;
+}
+
+int main() {
+    pthread_t thread;
+    uint64_t misrouted = 0;
+    uint64_t handoff = 0;
+    uint32_t i;
+
+    quic_sharded_server_init(&sserver, WORKERS, 0, 8192);
+    quic_sharded_server_cert_file(&sserver, "./tests/crt.crt");
+    quic_sharded_server_key_file(&sserver, "./tests/key.key");
+    // every session is created from the first Initial of its client, its source connection id is chosen without a Retry
+    quic_sharded_server_retry(&sserver, quic_server_retry_off, 0, 0);
+    quic_sharded_server_steering(&sserver, true);
+    quic_sharded_server_accept(&sserver, server_accept);
+    quic_sharded_server_listen(&sserver, liteco_ipv4("127.0.0.1", 11011));
+    printf("steering: %d\n", sserver.steering);
+
+    pthread_create(&thread, NULL, server_loop, NULL);
+
+    // distinct source ports, so the kernel hashes the handshakes of the clients to different workers
+    for (i = 0; i < CLIENTS; i++) {
+        quic_client_t client;
+        quic_client_init(&client, 0, 8192);
+        quic_client_path_use(&client, quic_path_addr(liteco_ipv4("127.0.0.1", 11020 + i), liteco_ipv4("127.0.0.1", 11011)));
+        quic_client_handshake_done(&client, client_handshake_done);
+        quic_client_start_loop(&client);
+    }
+
+    quic_sharded_server_stop(&sserver);
+    pthread_join(thread, NULL);
+
+    for (i = 0; i < WORKERS; i++) {
+        misrouted += sserver.workers[i].misrouted_pkts;
+        handoff += sserver.workers[i].handoff_recv;
+    }
+
+    // with steering in the kernel, no packet of an established connection is handed off between the workers
+    printf("owned: %u, foreign: %u\n", owned, foreign);
+    printf("misrouted: %" PRIu64 ", handoff: %" PRIu64 "\n", misrouted, handoff);
+    printf("%s\n", owned == CLIENTS && foreign == 0 && (!sserver.steering || misrouted == 0) ? "ok" : "failed");
+
+    return 0;
+}
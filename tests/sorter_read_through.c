@@ -0,0 +1,36 @@
+#include "sorter.h"
+#include <stdio.h>
+
+int main() {
+    quic_sorter_t sorter;
+
+    quic_sorter_init(&sorter);
+
+    uint8_t data1[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    uint8_t data2[] = { 0x0b, 0x0c, 0x0d, 0x0e };
+    uint8_t dst[6] = { 0 };
+
+    // out of order data is still buffered
+    printf("%ld\n", quic_sorter_read_through(&sorter, 10, sizeof(data2), data2, dst, sizeof(dst)));
+    quic_sorter_write(&sorter, 10, sizeof(data2), data2);
+
+    // in order data goes straight to the reader, the rest is buffered
+    uint64_t readed = quic_sorter_read_through(&sorter, 0, sizeof(data1), data1, dst, sizeof(dst));
+    quic_sorter_write(&sorter, 0, sizeof(data1), data1);
+    printf("readed: %ld, readed_size: %ld, readable: %ld\n", readed, sorter.readed_size, quic_sorter_readable(&sorter));
+
+    int i;
+    for (i = 0; i < 6; i++) {
+        printf("%02x ", dst[i]);
+    }
+    printf("\n");
+
+    // nothing readable is skipped
+    printf("%ld\n", quic_sorter_read_through(&sorter, 0, sizeof(data1), data1, dst, sizeof(dst)));
+
+    uint8_t buf[2];
+    readed = quic_sorter_read(&sorter, sizeof(buf), buf);
+    printf("readed: %ld, %02x %02x\n", readed, buf[0], buf[1]);
+
+    return 0;
+}
@@ -32,6 +32,7 @@ void *thread(void *const args) {
     frame1->off = 0;
     frame1->len = 5;
     frame1->sid = 1;
+    frame1->ref = NULL;
     memcpy(frame1->data, line, 5);
 
     quic_frame_stream_t *frame2 = malloc(sizeof(quic_frame_stream_t) + sizeof(line) - 5);
@@ -39,6 +40,7 @@ void *thread(void *const args) {
     frame2->off = 5; 
     frame2->len = sizeof(line) - 5;
     frame2->sid = 1;
+    frame2->ref = NULL;
     memcpy(frame2->data, (uint8_t *) line + 5, sizeof(line) - 5);
 
     quic_recv_stream_handle_frame(str, frame1);
@@ -0,0 +1,48 @@
+#include "transmission.h"
+#include "liteco.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <stdio.h>
+
+#define WORKERS 2
+
+static liteco_eloop_t eloop;
+static liteco_runtime_t rt;
+
+int main() {
+    quic_transmission_t trans[WORKERS];
+    int i;
+
+    liteco_eloop_init(&eloop);
+    liteco_runtime_init(&eloop, &rt);
+
+    // every worker of a sharded server binds its own socket to the same port
+    for (i = 0; i < WORKERS; i++) {
+        quic_transmission_init(&trans[i], &rt, quic_transmission_backend_liteco);
+        quic_transmission_reuseport(&trans[i], true);
+        printf("listen %d: %d\n", i, quic_transmission_listen(&eloop, &trans[i], liteco_ipv4("127.0.0.1", 11030), 1500));
+    }
+
+    for (i = 0; i < WORKERS; i++) {
+        const liteco_addr_t local_addr = liteco_ipv4("127.0.0.1", 11030);
+        quic_transmission_socket_t *const socket = liteco_rbt_find(trans[i].sockets, &local_addr);
+        if (liteco_rbt_is_nil(socket)) {
+            printf("socket %d: missing\n", i);
+            continue;
+        }
+
+        int reuseport = 0;
+        socklen_t reuseport_len = sizeof(reuseport);
+        getsockopt(quic_transmission_socket_fd(socket), SOL_SOCKET, SO_REUSEPORT, &reuseport, &reuseport_len);
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        getsockname(quic_transmission_socket_fd(socket), (struct sockaddr *) &addr, &addr_len);
+        printf("socket %d: reuseport %d, port %u\n", i, reuseport != 0, ntohs(addr.sin_port));
+    }
+
+    for (i = 0; i < WORKERS; i++) {
+        quic_transmission_destory(&trans[i]);
+    }
+
+    return 0;
+}
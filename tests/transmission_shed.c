@@ -0,0 +1,79 @@
+#include "transmission.h"
+#include "liteco.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <stdio.h>
+
+#define RING_CAPA 2
+#define RING_HIGH_WATER 1
+#define DGRAMS 6
+#define ROUNDS 1000
+
+static liteco_eloop_t eloop;
+static liteco_runtime_t rt;
+static quic_transmission_t trans;
+
+// the received packets are held, so the ring and the malloced packets run out
+static quic_recv_packet_t *held[DGRAMS];
+static uint32_t held_count;
+
+static quic_err_t recv_cb(quic_transmission_t *const trans, quic_recv_packet_t *const recvpkt) {
+    (void) trans;
+
+    held[held_count++] = recvpkt;
+
+    return quic_err_success;
+}
+
+static void send_dgrams(const int fd, const liteco_addr_t addr, const int count) {
+    char data[100] = { };
+    int i;
+
+    for (i = 0; i < count; i++) {
+        sendto(fd, data, sizeof(data), 0, (struct sockaddr *) &addr, liteco_addr_type_size(&addr));
+    }
+}
+
+static void run(const uint32_t expected_held, const uint64_t expected_shed) {
+    uint64_t exhausted;
+    uint64_t shed;
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        quic_transmission_recv_ring_stats(&trans, &exhausted, &shed);
+        if (held_count >= expected_held && shed >= expected_shed) {
+            break;
+        }
+        liteco_eloop_run(&eloop);
+    }
+    printf("held: %u, shed: %lu, heap_inuse: %u\n", held_count, shed,
+           ((quic_transmission_socket_t *) liteco_rbt_min(trans.sockets))->ring.heap_inuse);
+}
+
+int main() {
+    const liteco_addr_t addr = liteco_ipv4("127.0.0.1", 11050);
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    uint32_t i;
+
+    liteco_eloop_init(&eloop);
+    liteco_runtime_init(&eloop, &rt);
+
+    quic_transmission_init(&trans, &rt, quic_transmission_backend_liteco);
+    quic_transmission_recv_ring(&trans, RING_CAPA, RING_HIGH_WATER, false);
+    quic_transmission_recv(&trans, recv_cb);
+    quic_transmission_listen(&eloop, &trans, addr, 1500);
+
+    // the slots, then the malloced packet, then the datagrams are read and dropped
+    send_dgrams(fd, addr, DGRAMS);
+    run(RING_CAPA + RING_HIGH_WATER, DGRAMS - RING_CAPA - RING_HIGH_WATER);
+
+    // once the packets come back, the datagrams are received again
+    for (i = 0; i < held_count; i++) {
+        quic_recv_packet_recovery(held[i]);
+    }
+    held_count = 0;
+    send_dgrams(fd, addr, RING_CAPA);
+    run(RING_CAPA, DGRAMS - RING_CAPA - RING_HIGH_WATER);
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "utils/timer_wheel.h"
+#include <stdio.h>
+
+static int fired_count = 0;
+
+static void expired_cb(quic_timer_t *const timer) {
+    fired_count++;
+    printf("fired %ld\n", timer->expires_at);
+}
+
+int main() {
+    quic_timer_wheel_t wheel;
+    quic_timer_t timers[8];
+    int i;
+
+    quic_timer_wheel_init(&wheel, 10, 0);
+    for (i = 0; i < 8; i++) {
+        quic_timer_init(&timers[i]);
+    }
+
+    quic_timer_wheel_add(&wheel, &timers[0], 5, expired_cb);
+    quic_timer_wheel_add(&wheel, &timers[1], 25, expired_cb);
+    // cascaded from the second and the third level
+    quic_timer_wheel_add(&wheel, &timers[2], 10 * 1000, expired_cb);
+    quic_timer_wheel_add(&wheel, &timers[3], 10 * 100000, expired_cb);
+    quic_timer_wheel_add(&wheel, &timers[4], 41, expired_cb);
+    quic_timer_wheel_remove(&wheel, &timers[4]);
+
+    printf("next %ld\n", quic_timer_wheel_next(&wheel));
+    printf("expire 4: %ld\n", quic_timer_wheel_expire(&wheel, 4));
+    printf("expire 30: %ld\n", quic_timer_wheel_expire(&wheel, 30));
+    printf("pending %ld next %ld\n", wheel.count, quic_timer_wheel_next(&wheel));
+
+    printf("expire 9999: %ld\n", quic_timer_wheel_expire(&wheel, 9999));
+    printf("expire 10000: %ld\n", quic_timer_wheel_expire(&wheel, 10000));
+    printf("expire 2000000: %ld\n", quic_timer_wheel_expire(&wheel, 2000000));
+    printf("pending %ld fired %d\n", wheel.count, fired_count);
+
+    // added in the past, fires on the next expire
+    quic_timer_wheel_add(&wheel, &timers[5], 10, expired_cb);
+    printf("expire 2000010: %ld\n", quic_timer_wheel_expire(&wheel, 2000010));
+
+    return 0;
+}